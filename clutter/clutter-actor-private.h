@@ -243,6 +243,15 @@ ClutterTransition *             _clutter_actor_create_transition
 ClutterTransition *             _clutter_actor_get_transition                           (ClutterActor *self,
                                                                                          GParamSpec   *pspec);
 
+gboolean                        _clutter_actor_has_fast_animatable_property             (ClutterActor       *self,
+                                                                                         GParamSpec         *pspec);
+void                            _clutter_actor_set_fast_animatable_double               (ClutterActor       *self,
+                                                                                         GParamSpec         *pspec,
+                                                                                         gdouble             value);
+void                            _clutter_actor_set_fast_animatable_color                (ClutterActor       *self,
+                                                                                         GParamSpec         *pspec,
+                                                                                         const ClutterColor *color);
+
 gboolean                        _clutter_actor_foreach_child                            (ClutterActor *self,
                                                                                          ClutterForeachCallback callback,
                                                                                          gpointer user_data);
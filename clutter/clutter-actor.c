@@ -3321,6 +3321,39 @@ _clutter_actor_paint_cull_result (ClutterActor *self,
     }
 }
 
+/* tints the actor from green to red, depending on how much of the
+ * time of the last frame it took, compared to the most expensive actor
+ */
+static void
+_clutter_actor_draw_cost_overlay (ClutterActor *self)
+{
+  ClutterActor *stage;
+  gfloat fraction, width, height;
+  guint8 red, green, alpha;
+
+  stage = _clutter_actor_get_stage_internal (self);
+  if (stage == NULL)
+    return;
+
+  fraction = _clutter_stage_get_actor_cost_fraction (CLUTTER_STAGE (stage),
+                                                     self);
+  if (fraction <= 0.f)
+    return;
+
+  alpha = 32 + fraction * 160;
+  red = 255 * fraction;
+  green = 255 * (1.f - fraction);
+
+  clutter_actor_box_get_size (&self->priv->allocation, &width, &height);
+
+  /* the source color is premultiplied */
+  cogl_set_source_color4ub (red * alpha / 255,
+                            green * alpha / 255,
+                            0,
+                            alpha);
+  cogl_rectangle (0, 0, width, height);
+}
+
 static int clone_paint_level = 0;
 
 void
@@ -3631,6 +3664,8 @@ clutter_actor_paint (ClutterActor *self)
   ClutterPickMode pick_mode;
   gboolean clip_set = FALSE;
   gboolean shader_applied = FALSE;
+  gint64 trace_start = 0;
+  gint64 cost_start = 0;
 
   CLUTTER_STATIC_COUNTER (actor_paint_counter,
                           "Actor real-paint counter",
@@ -3670,6 +3705,13 @@ clutter_actor_paint (ClutterActor *self)
   if (!CLUTTER_ACTOR_IS_MAPPED (self))
     return;
 
+  if (G_UNLIKELY (_clutter_trace_enabled))
+    trace_start = g_get_monotonic_time ();
+
+  /* the picks are accounted by the frame statistics of the stage */
+  if (pick_mode == CLUTTER_PICK_NONE)
+    cost_start = _clutter_stage_actor_cost_begin ();
+
   /* mark that we are in the paint process */
   CLUTTER_SET_PRIVATE_FLAGS (self, CLUTTER_IN_PAINT);
 
@@ -3804,9 +3846,15 @@ clutter_actor_paint (ClutterActor *self)
       if (G_UNLIKELY (clutter_paint_debug_flags & CLUTTER_DEBUG_REDRAWS))
         _clutter_actor_paint_cull_result (self, success, result);
       else if (result == CLUTTER_CULL_RESULT_OUT && success)
-        goto done;
+        {
+          _clutter_stage_count_painted_actor (TRUE);
+          goto done;
+        }
     }
 
+  if (pick_mode == CLUTTER_PICK_NONE)
+    _clutter_stage_count_painted_actor (FALSE);
+
   if (priv->effects == NULL)
     {
       if (pick_mode == CLUTTER_PICK_NONE &&
@@ -3831,6 +3879,10 @@ clutter_actor_paint (ClutterActor *self)
                   pick_mode == CLUTTER_PICK_NONE))
     _clutter_actor_draw_paint_volume (self);
 
+  if (G_UNLIKELY (clutter_paint_debug_flags & CLUTTER_DEBUG_COST_OVERLAY &&
+                  pick_mode == CLUTTER_PICK_NONE))
+    _clutter_actor_draw_cost_overlay (self);
+
 done:
   /* If we make it here then the actor has run through a complete
      paint run including all the effects so it's no longer dirty */
@@ -3844,6 +3896,13 @@ done:
 
   /* paint sequence complete */
   CLUTTER_UNSET_PRIVATE_FLAGS (self, CLUTTER_IN_PAINT);
+
+  _clutter_stage_actor_cost_end (self, CLUTTER_ACTOR_COST_PAINT, cost_start);
+
+  if (trace_start != 0)
+    _clutter_trace_span (pick_mode == CLUTTER_PICK_NONE ? "paint" : "pick",
+                         _clutter_actor_get_debug_name (self),
+                         trace_start);
 }
 
 /**
@@ -9295,6 +9354,7 @@ clutter_actor_get_preferred_width (ClutterActor *self,
     {
       gfloat minimum_width, natural_width;
       ClutterActorClass *klass;
+      gint64 cost_start;
 
       minimum_width = natural_width = 0;
 
@@ -9308,11 +9368,17 @@ clutter_actor_get_preferred_width (ClutterActor *self,
 
       CLUTTER_NOTE (LAYOUT, "Width request for %.2f px", for_height);
 
+      cost_start = _clutter_stage_actor_cost_begin ();
+
       klass = CLUTTER_ACTOR_GET_CLASS (self);
       klass->get_preferred_width (self, for_height,
                                   &minimum_width,
                                   &natural_width);
 
+      _clutter_stage_actor_cost_end (self,
+                                     CLUTTER_ACTOR_COST_PREFERRED_SIZE,
+                                     cost_start);
+
       /* adjust for the margin */
       minimum_width += (info->margin.left + info->margin.right);
       natural_width += (info->margin.left + info->margin.right);
@@ -9431,6 +9497,7 @@ clutter_actor_get_preferred_height (ClutterActor *self,
     {
       gfloat minimum_height, natural_height;
       ClutterActorClass *klass;
+      gint64 cost_start;
 
       minimum_height = natural_height = 0;
 
@@ -9444,11 +9511,17 @@ clutter_actor_get_preferred_height (ClutterActor *self,
             for_width = 0;
         }
 
+      cost_start = _clutter_stage_actor_cost_begin ();
+
       klass = CLUTTER_ACTOR_GET_CLASS (self);
       klass->get_preferred_height (self, for_width,
                                    &minimum_height,
                                    &natural_height);
 
+      _clutter_stage_actor_cost_end (self,
+                                     CLUTTER_ACTOR_COST_PREFERRED_SIZE,
+                                     cost_start);
+
       /* adjust for margin */
       minimum_height += (info->margin.top + info->margin.bottom);
       natural_height += (info->margin.top + info->margin.bottom);
@@ -9689,6 +9762,13 @@ clutter_actor_allocate_internal (ClutterActor           *self,
                                  ClutterAllocationFlags  flags)
 {
   ClutterActorClass *klass;
+  gint64 trace_start = 0;
+  gint64 cost_start;
+
+  if (G_UNLIKELY (_clutter_trace_enabled))
+    trace_start = g_get_monotonic_time ();
+
+  cost_start = _clutter_stage_actor_cost_begin ();
 
   CLUTTER_SET_PRIVATE_FLAGS (self, CLUTTER_IN_RELAYOUT);
 
@@ -9700,6 +9780,13 @@ clutter_actor_allocate_internal (ClutterActor           *self,
 
   CLUTTER_UNSET_PRIVATE_FLAGS (self, CLUTTER_IN_RELAYOUT);
 
+  _clutter_stage_actor_cost_end (self, CLUTTER_ACTOR_COST_ALLOCATE, cost_start);
+
+  if (trace_start != 0)
+    _clutter_trace_span ("allocate",
+                         _clutter_actor_get_debug_name (self),
+                         trace_start);
+
   clutter_actor_queue_redraw (self);
 }
 
@@ -14788,6 +14875,217 @@ clutter_actor_set_final_state (ClutterAnimatable *animatable,
   g_free (p_name);
 }
 
+/*< private >
+ * _clutter_actor_has_fast_animatable_property:
+ * @self: a #ClutterActor
+ * @pspec: the #GParamSpec of an animatable property
+ *
+ * Checks whether @pspec can be animated on @self without going through
+ * the #ClutterAnimatable interface, using the fast path setters
+ * _clutter_actor_set_fast_animatable_double() and
+ * _clutter_actor_set_fast_animatable_color().
+ *
+ * This is only possible for the properties of #ClutterActor that are
+ * stored as plain values, on actors that do not override the way
+ * properties are animated or notified.
+ *
+ * Return value: %TRUE if the fast path can be used
+ */
+gboolean
+_clutter_actor_has_fast_animatable_property (ClutterActor *self,
+                                             GParamSpec   *pspec)
+{
+  static GObjectClass *object_class = NULL;
+  ClutterAnimatableIface *iface;
+  GObjectClass *klass;
+
+  if (pspec->owner_type != CLUTTER_TYPE_ACTOR)
+    return FALSE;
+
+  iface = CLUTTER_ANIMATABLE_GET_IFACE (self);
+  if (iface->set_final_state != clutter_actor_set_final_state ||
+      iface->interpolate_value != NULL)
+    return FALSE;
+
+  if (G_UNLIKELY (object_class == NULL))
+    object_class = g_type_class_ref (G_TYPE_OBJECT);
+
+  klass = G_OBJECT_GET_CLASS (self);
+  if (klass->notify != NULL ||
+      klass->dispatch_properties_changed != object_class->dispatch_properties_changed)
+    return FALSE;
+
+  switch (pspec->param_id)
+    {
+    case PROP_OPACITY:
+    case PROP_Z_POSITION:
+    case PROP_PIVOT_POINT_Z:
+    case PROP_TRANSLATION_X:
+    case PROP_TRANSLATION_Y:
+    case PROP_TRANSLATION_Z:
+    case PROP_SCALE_X:
+    case PROP_SCALE_Y:
+    case PROP_SCALE_Z:
+    case PROP_ROTATION_ANGLE_X:
+    case PROP_ROTATION_ANGLE_Y:
+    case PROP_ROTATION_ANGLE_Z:
+    case PROP_BACKGROUND_COLOR:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/*< private >
+ * _clutter_actor_set_fast_animatable_double:
+ * @self: a #ClutterActor
+ * @pspec: the #GParamSpec of the property
+ * @value: the new value of the property
+ *
+ * Sets a numeric property for which
+ * _clutter_actor_has_fast_animatable_property() returned %TRUE.
+ *
+ * The effect is the same as going through
+ * clutter_actor_set_animatable_property(), except that no #GValue is
+ * involved.
+ */
+void
+_clutter_actor_set_fast_animatable_double (ClutterActor *self,
+                                           GParamSpec   *pspec,
+                                           gdouble       value)
+{
+  ClutterActorPrivate *priv = self->priv;
+  ClutterTransformInfo *info;
+
+  switch (pspec->param_id)
+    {
+    case PROP_OPACITY:
+      {
+        guint8 opacity = (guint) value;
+
+        if (priv->opacity == opacity)
+          return;
+
+        priv->opacity = opacity;
+
+        /* see clutter_actor_set_opacity_internal() */
+        _clutter_actor_queue_redraw_full (self,
+                                          0, /* flags */
+                                          NULL, /* clip */
+                                          priv->flatten_effect);
+        g_object_notify_by_pspec (G_OBJECT (self), pspec);
+      }
+      return;
+
+    case PROP_Z_POSITION:
+      {
+        float z_position = value;
+
+        info = _clutter_actor_get_transform_info (self);
+
+        if (memcmp (&info->z_position, &z_position, sizeof (float)) == 0)
+          return;
+
+        info->z_position = z_position;
+      }
+      break;
+
+    case PROP_PIVOT_POINT_Z:
+      info = _clutter_actor_get_transform_info (self);
+      info->pivot_z = value;
+      break;
+
+    case PROP_TRANSLATION_X:
+      info = _clutter_actor_get_transform_info (self);
+      info->translation.x = value;
+      break;
+
+    case PROP_TRANSLATION_Y:
+      info = _clutter_actor_get_transform_info (self);
+      info->translation.y = value;
+      break;
+
+    case PROP_TRANSLATION_Z:
+      info = _clutter_actor_get_transform_info (self);
+      info->translation.z = value;
+      break;
+
+    case PROP_SCALE_X:
+      info = _clutter_actor_get_transform_info (self);
+      info->scale_x = value;
+      break;
+
+    case PROP_SCALE_Y:
+      info = _clutter_actor_get_transform_info (self);
+      info->scale_y = value;
+      break;
+
+    case PROP_SCALE_Z:
+      info = _clutter_actor_get_transform_info (self);
+      info->scale_z = value;
+      break;
+
+    case PROP_ROTATION_ANGLE_X:
+      info = _clutter_actor_get_transform_info (self);
+      info->rx_angle = value;
+      break;
+
+    case PROP_ROTATION_ANGLE_Y:
+      info = _clutter_actor_get_transform_info (self);
+      info->ry_angle = value;
+      break;
+
+    case PROP_ROTATION_ANGLE_Z:
+      info = _clutter_actor_get_transform_info (self);
+      info->rz_angle = value;
+      break;
+
+    default:
+      g_assert_not_reached ();
+      return;
+    }
+
+  priv->transform_valid = FALSE;
+
+  clutter_actor_queue_redraw (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), pspec);
+}
+
+/*< private >
+ * _clutter_actor_set_fast_animatable_color:
+ * @self: a #ClutterActor
+ * @pspec: the #GParamSpec of the property
+ * @color: the new value of the property
+ *
+ * Sets a color property for which
+ * _clutter_actor_has_fast_animatable_property() returned %TRUE.
+ *
+ * See also: _clutter_actor_set_fast_animatable_double()
+ */
+void
+_clutter_actor_set_fast_animatable_color (ClutterActor       *self,
+                                          GParamSpec         *pspec,
+                                          const ClutterColor *color)
+{
+  ClutterActorPrivate *priv = self->priv;
+
+  g_assert (pspec->param_id == PROP_BACKGROUND_COLOR);
+
+  /* see clutter_actor_set_background_color_internal() */
+  if (priv->bg_color_set && clutter_color_equal (color, &priv->bg_color))
+    return;
+
+  priv->bg_color = *color;
+  priv->bg_color_set = TRUE;
+
+  clutter_actor_queue_redraw (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_BACKGROUND_COLOR_SET]);
+  g_object_notify_by_pspec (G_OBJECT (self), pspec);
+}
+
 static void
 clutter_animatable_iface_init (ClutterAnimatableIface *iface)
 {
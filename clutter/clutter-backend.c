@@ -86,6 +86,9 @@
 #ifdef CLUTTER_INPUT_WAYLAND
 #include "wayland/clutter-device-manager-wayland.h"
 #endif
+#ifdef CLUTTER_INPUT_HEADLESS
+#include "headless/clutter-backend-headless.h"
+#endif
 
 #ifdef HAVE_CLUTTER_WAYLAND_COMPOSITOR
 #include <cogl/cogl-wayland-server.h>
@@ -532,6 +535,14 @@ clutter_backend_real_init_events (ClutterBackend *backend)
       _clutter_events_wayland_init (backend);
     }
   else
+#endif
+#ifdef CLUTTER_INPUT_HEADLESS
+  if (clutter_check_windowing_backend (CLUTTER_WINDOWING_HEADLESS) &&
+      (input_backend == NULL || input_backend == I_(CLUTTER_INPUT_HEADLESS)))
+    {
+      _clutter_backend_headless_events_init (backend);
+    }
+  else
 #endif
   if (input_backend != NULL)
     {
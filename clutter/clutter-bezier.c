@@ -21,43 +21,42 @@
  * License along with this library. If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include <glib.h>
 #include <string.h>
+#include <math.h>
 #include "clutter-bezier.h"
 #include "clutter-debug.h"
 
-/*
- * We have some experimental code here to allow for constant velocity
- * movement of actors along the bezier path, this macro enables it.
- */
-#undef CBZ_L2T_INTERPOLATION
-
 /****************************************************************************
  * ClutterBezier -- represenation of a cubic bezier curve                   *
  * (private; a building block for the public bspline object)                *
  ****************************************************************************/
 
 /*
- * The t parameter of the bezier is from interval <0,1>, so we can use
- * 14.18 format and special multiplication functions that preserve
- * more of the least significant bits but would overflow if the value
- * is > 1
+ * The curve is flattened by recursive subdivision until each piece is
+ * within CBZ_FLATNESS pixels of a straight line, and the lengths of
+ * the pieces are used to build a table mapping the relative length
+ * along the curve to the t parameter of the bezier, sampled at
+ * CBZ_L2T_SAMPLES equidistant lengths; this allows moving along the
+ * curve at constant speed with a table lookup and a linear
+ * interpolation, without any search.
  */
-#define CBZ_T_Q 18
-#define CBZ_T_ONE (1 << CBZ_T_Q)
-#define CBZ_T_MUL(x,y) ((((x) >> 3) * ((y) >> 3)) >> 12)
-#define CBZ_T_POW2(x) CBZ_T_MUL (x, x)
-#define CBZ_T_POW3(x) CBZ_T_MUL (CBZ_T_POW2 (x), x)
-#define CBZ_T_DIV(x,y) ((((x) << 9)/(y)) << 9)
+#define CBZ_FLATNESS 0.25f
+#define CBZ_MAX_DEPTH 10
+#define CBZ_MAX_PIECES (1 << CBZ_MAX_DEPTH)
+#define CBZ_L2T_SAMPLES 64
 
-/*
- * Constants for sampling of the bezier
- */
-#define CBZ_T_SAMPLES 128
-#define CBZ_T_STEP (CBZ_T_ONE / CBZ_T_SAMPLES)
-#define CBZ_L_STEP (CBZ_T_ONE / CBZ_T_SAMPLES)
+typedef struct _BezierSample BezierSample;
 
-typedef gint32 _FixedT;
+struct _BezierSample
+{
+  /* the value of t at the end of a piece of the flattened curve, and
+   * the length of the curve up to it
+   */
+  gfloat t;
+  gfloat length;
+};
 
 /*
  * This is a private type representing a single cubic bezier
@@ -65,34 +64,23 @@ typedef gint32 _FixedT;
 struct _ClutterBezier
 {
   /*
-   * bezier coefficients -- these are calculated using multiplication and
-   * addition from integer input, so these are also integers
+   * bezier coefficients, so that x(t) = ax * t^3 + bx * t^2 + cx * t + dx
    */
-  gint ax;
-  gint bx;
-  gint cx;
-  gint dx;
-
-  gint ay;
-  gint by;
-  gint cy;
-  gint dy;
-    
+  gfloat ax;
+  gfloat bx;
+  gfloat cx;
+  gfloat dx;
+
+  gfloat ay;
+  gfloat by;
+  gfloat cy;
+  gfloat dy;
+
   /* length of the bezier */
-  guint length;
+  gfloat length;
 
-#ifdef CBZ_L2T_INTERPOLATION
-  /*
-   * coefficients for the L -> t bezier; these are calculated from fixed
-   * point input, and more specifically numbers that have been normalised
-   * to fit <0,1>, so these are also fixed point, and we can used the
-   * _FixedT type here.
-   */
-  _FixedT La;
-  _FixedT Lb;
-  _FixedT Lc;
-  /*  _FixedT Ld; == 0 */
-#endif
+  /* the value of t at the relative length i / CBZ_L2T_SAMPLES */
+  gfloat l2t[CBZ_L2T_SAMPLES + 1];
 };
 
 ClutterBezier *
@@ -110,106 +98,99 @@ _clutter_bezier_free (ClutterBezier * b)
     }
 }
 
-ClutterBezier *
-_clutter_bezier_clone_and_move (const ClutterBezier *b, gint x, gint y)
+static void
+_clutter_bezier_flatten (const gfloat *x,
+                         const gfloat *y,
+                         gfloat        t_0,
+                         gfloat        t_1,
+                         guint         depth,
+                         BezierSample *samples,
+                         guint        *n_samples)
 {
-  ClutterBezier * b2 = _clutter_bezier_new ();
-  memcpy (b2, b, sizeof (ClutterBezier));
+  gfloat ux, uy, vx, vy;
+  gfloat lx[4], ly[4], rx[4], ry[4];
 
-  b2->dx += x;
-  b2->dy += y;
+  /*
+   * The distance of the control points from the chord is bounded by
+   * this expression; see "Piecewise Linear Approximation of Bézier
+   * Curves" by Roger Willcocks
+   */
+  ux = 3.f * x[1] - 2.f * x[0] - x[3];
+  uy = 3.f * y[1] - 2.f * y[0] - y[3];
+  vx = 3.f * x[2] - x[0] - 2.f * x[3];
+  vy = 3.f * y[2] - y[0] - 2.f * y[3];
+
+  ux *= ux;
+  uy *= uy;
+  vx *= vx;
+  vy *= vy;
+
+  if (depth == CBZ_MAX_DEPTH ||
+      MAX (ux, vx) + MAX (uy, vy) <= 16.f * CBZ_FLATNESS * CBZ_FLATNESS)
+    {
+      gfloat chord, polygon;
+      BezierSample *sample;
 
-  return b2;
-}
+      /* the length of a flat piece is somewhere between its chord
+       * and the length of its control polygon
+       */
+      chord = hypotf (x[3] - x[0], y[3] - y[0]);
+      polygon = hypotf (x[1] - x[0], y[1] - y[0])
+              + hypotf (x[2] - x[1], y[2] - y[1])
+              + hypotf (x[3] - x[2], y[3] - y[2]);
 
-#ifdef CBZ_L2T_INTERPOLATION
-/*
- * L is relative advance along the bezier curve from interval <0,1>
- */
-static _FixedT
-_clutter_bezier_L2t (const ClutterBezier *b, _FixedT L)
-{
-  _FixedT t = CBZ_T_MUL (b->La, CBZ_T_POW3(L))
-    +  CBZ_T_MUL (b->Lb, CBZ_T_POW2(L))
-    +  CBZ_T_MUL (b->Lc, L);
-  
-  if (t > CBZ_T_ONE)
-    t = CBZ_T_ONE;
-  else if (t < 0)
-    t = 0;
-  
-  return t;
-}
-#endif
+      sample = samples + *n_samples;
+      sample->t = t_1;
+      sample->length = sample[-1].length + (chord + polygon) / 2.f;
 
-static gint
-_clutter_bezier_t2x (const ClutterBezier * b, _FixedT t)
-{
-  /*
-   * NB -- the int coefficients can be at most 8192 for the multiplication
-   * to work in this fashion due to the limits of the 14.18 fixed.
-   */
-  return ((b->ax*CBZ_T_POW3(t) + b->bx*CBZ_T_POW2(t) + b->cx*t) >> CBZ_T_Q)
-    + b->dx;
-}
+      *n_samples += 1;
 
-static gint
-_clutter_bezier_t2y (const ClutterBezier * b, _FixedT t)
-{
-  /*
-   * NB -- the int coefficients can be at most 8192 for the multiplication
-   * to work in this fashion due to the limits of the 14.18 fixed.
-   */
-  return ((b->ay*CBZ_T_POW3(t) + b->by*CBZ_T_POW2(t) + b->cy*t) >> CBZ_T_Q)
-    + b->dy;
-}
+      return;
+    }
 
-/*
- * Advances along the bezier to relative length L and returns the coordinances
- * in knot
- */
-void
-_clutter_bezier_advance (const ClutterBezier *b, gint L, ClutterKnot * knot)
-{
-#ifdef CBZ_L2T_INTERPOLATION
-  _FixedT t = clutter_bezier_L2t (b, L);
-#else
-  _FixedT t = L;
-#endif
-  
-  knot->x = _clutter_bezier_t2x (b, t);
-  knot->y = _clutter_bezier_t2y (b, t);
-  
-  CLUTTER_NOTE (MISC, "advancing to relative pt %f: t %f, {%d,%d}",
-                (double) L / (double) CBZ_T_ONE,
-                (double) t / (double) CBZ_T_ONE,
-                knot->x, knot->y);
+  /* split the curve in two halves with de Casteljau's algorithm */
+  lx[0] = x[0];
+  ly[0] = y[0];
+  lx[1] = (x[0] + x[1]) / 2.f;
+  ly[1] = (y[0] + y[1]) / 2.f;
+  rx[2] = (x[2] + x[3]) / 2.f;
+  ry[2] = (y[2] + y[3]) / 2.f;
+  rx[3] = x[3];
+  ry[3] = y[3];
+
+  ux = (x[1] + x[2]) / 2.f;
+  uy = (y[1] + y[2]) / 2.f;
+
+  lx[2] = (lx[1] + ux) / 2.f;
+  ly[2] = (ly[1] + uy) / 2.f;
+  rx[1] = (ux + rx[2]) / 2.f;
+  ry[1] = (uy + ry[2]) / 2.f;
+
+  lx[3] = rx[0] = (lx[2] + rx[1]) / 2.f;
+  ly[3] = ry[0] = (ly[2] + ry[1]) / 2.f;
+
+  _clutter_bezier_flatten (lx, ly,
+                           t_0, (t_0 + t_1) / 2.f,
+                           depth + 1,
+                           samples, n_samples);
+  _clutter_bezier_flatten (rx, ry,
+                           (t_0 + t_1) / 2.f, t_1,
+                           depth + 1,
+                           samples, n_samples);
 }
 
 void
 _clutter_bezier_init (ClutterBezier *b,
-		     gint x_0, gint y_0,
-		     gint x_1, gint y_1,
-		     gint x_2, gint y_2,
-		     gint x_3, gint y_3)
+                      gfloat x_0, gfloat y_0,
+                      gfloat x_1, gfloat y_1,
+                      gfloat x_2, gfloat y_2,
+                      gfloat x_3, gfloat y_3)
 {
-  _FixedT t;
-  int i;
-  int xp = x_0;
-  int yp = y_0;
-  _FixedT length [CBZ_T_SAMPLES + 1];
-
-#ifdef CBZ_L2T_INTERPOLATION
-  int j, k;
-  _FixedT L;
-  _FixedT t_equalized [CBZ_T_SAMPLES + 1];
-#endif
-
-#if 0
-  g_debug ("Initializing bezier at {{%d,%d},{%d,%d},{%d,%d},{%d,%d}}",
-           x0, y0, x1, y1, x2, y2, x3, y3);
-#endif
-  
+  BezierSample samples[CBZ_MAX_PIECES + 1];
+  const gfloat x[4] = { x_0, x_1, x_2, x_3 };
+  const gfloat y[4] = { y_0, y_1, y_2, y_3 };
+  guint n_samples, i, j;
+
   b->dx = x_0;
   b->dy = y_0;
 
@@ -222,203 +203,106 @@ _clutter_bezier_init (ClutterBezier *b,
   b->ax = x_3 - 3 * x_2 + 3 * x_1 - x_0;
   b->ay = y_3 - 3 * y_2 + 3 * y_1 - y_0;
 
-#if 0
-  g_debug ("Cooeficients {{%d,%d},{%d,%d},{%d,%d},{%d,%d}}",
-           b->ax, b->ay, b->bx, b->by, b->cx, b->cy, b->dx, b->dy);
-#endif
-  
-  /*
-   * Because of the way we do the multiplication in bezeir_t2x,y
-   * these coefficients need to be at most 0x1fff; this should be the case,
-   * I think, but have added this warning to catch any problems -- if it
-   * triggers, we need to change those two functions a bit.
-   */
-  if (b->ax > 0x1fff || b->bx > 0x1fff || b->cx > 0x1fff)
-    g_warning ("Calculated coefficents will result in multiplication "
-               "overflow in clutter_bezier_t2x and clutter_bezier_t2y.");
-
-  /*
-   * Sample the bezier with CBZ_T_SAMPLES and calculate length at
-   * each point.
-   *
-   * We are working with integers here, so we use the fast sqrti function.
-   */
-  length[0] = 0;
-    
-  for (t = CBZ_T_STEP, i = 1; i <= CBZ_T_SAMPLES; ++i, t += CBZ_T_STEP)
-    {
-      int x = _clutter_bezier_t2x (b, t);
-      int y = _clutter_bezier_t2y (b, t);
-	
-      guint l = cogl_sqrti ((y - yp)*(y - yp) + (x - xp)*(x - xp));
-
-      l += length[i-1];
-
-      length[i] = l;
+  samples[0].t = 0.f;
+  samples[0].length = 0.f;
+  n_samples = 1;
 
-      xp = x;
-      yp = y;
-    }
-
-  b->length = length[CBZ_T_SAMPLES];
+  _clutter_bezier_flatten (x, y, 0.f, 1.f, 0, samples, &n_samples);
 
-#if 0
-  g_debug ("length %d", b->length);
-#endif
-  
-#ifdef CBZ_L2T_INTERPOLATION
-  /*
-   * Now normalize the length values, converting them into _FixedT
-   */
-  for (i = 0; i <= CBZ_T_SAMPLES; ++i)
-    {
-      length[i] = (length[i] << CBZ_T_Q) / b->length;
-    }
+  b->length = samples[n_samples - 1].length;
 
   /*
-   * Now generate a L -> t table such that the L will equidistant
+   * Now generate a L -> t table such that the L will be equidistant
    * over <0,1>
    */
-  t_equalized[0] = 0;
-    
-  for (i = 1, j = 1, L = CBZ_L_STEP; i < CBZ_T_SAMPLES; ++i, L += CBZ_L_STEP)
+  b->l2t[0] = 0.f;
+  b->l2t[CBZ_L2T_SAMPLES] = 1.f;
+
+  for (i = 1, j = 1; i < CBZ_L2T_SAMPLES; i++)
     {
-      _FixedT l1, l2;
-      _FixedT d1, d2, d;
-      _FixedT t1, t2;
-	
-      /* find the band for our L */
-      for (k = j; k < CBZ_T_SAMPLES; ++k)
-	{
-          if (L < length[k])
-            break;
-	}
-
-      /*
-       * Now we know that L is from (length[k-1],length[k]>
-       * We remember k-1 in order not to have to iterate over the
-       * whole length array in the next iteration of the main loop
-       */
-      j = k - 1;
+      gfloat L = b->length * i / CBZ_L2T_SAMPLES;
+      gfloat l_0, l_1;
 
-      /*
-       * Now interpolate equlised t as a weighted average
-       */
-      l1 = length[k-1];
-      l2 = length[k];
-      d1 = l2 - L;
-      d2 = L - l1;
-      d = l2 - l1;
-      t1 = (k - 1) * CBZ_T_STEP;
-      t2 = k * CBZ_T_STEP;
-	
-      t_equalized[i] = (t1*d1 + t2*d2)/d;
-
-      if (t_equalized[i] < t_equalized[i-1])
-        g_debug ("wrong t: L %f, l1 %f, l2 %f, t1 %f, t2 %f",
-                 (double) (L)/(double)CBZ_T_ONE,
-                 (double) (l1)/(double)CBZ_T_ONE,
-                 (double) (l2)/(double)CBZ_T_ONE,
-                 (double) (t1)/(double)CBZ_T_ONE,                 
-                 (double) (t2)/(double)CBZ_T_ONE);
-      
-    }
+      if (b->length <= 0.f)
+        {
+          b->l2t[i] = (gfloat) i / CBZ_L2T_SAMPLES;
+          continue;
+        }
 
-  t_equalized[CBZ_T_SAMPLES] = CBZ_T_ONE;
+      /* find the piece containing L; L only grows, so we can start
+       * from the piece we found in the previous iteration
+       */
+      while (j < n_samples - 1 && samples[j].length < L)
+        j++;
 
-  /* We now fit a bezier -- at this stage, do a single fit through our values
-   * at 0, 1/3, 2/3 and 1
-   *
-   * FIXME -- do we need to  use a better fitting approach to choose the best
-   * beziere. The actual curve we acquire this way is not too bad shapwise,
-   * but (probably due to rounding errors) the resulting curve no longer
-   * satisfies the necessary condition that for L2 > L1, t2 > t1, which 
-   * causes oscilation.
-   */
+      l_0 = samples[j - 1].length;
+      l_1 = samples[j].length;
 
-#if 0
-  /*
-   * These are the control points we use to calculate the curve coefficients
-   * for bezier t(L); these are not needed directly, but are implied in the
-   * calculations below.
-   *
-   * (p0 is 0,0, and p3 is 1,1)
-   */
-  p1 = (18 * t_equalized[CBZ_T_SAMPLES/3] -
-        9 * t_equalized[2*CBZ_T_SAMPLES/3] +
-        2 << CBZ_T_Q) / 6;
-
-  p2 = (18 * t_equalized[2*CBZ_T_SAMPLES/3] -
-        9 * t_equalized[CBZ_T_SAMPLES/3] -
-        (5 << CBZ_T_Q)) / 6;
-#endif
-    
-  b->Lc = (18 * t_equalized[CBZ_T_SAMPLES/3] -
-           9 * t_equalized[2*CBZ_T_SAMPLES/3] +
-           (2 << CBZ_T_Q)) >> 1;
-    
-  b->Lb = (36 * t_equalized[2*CBZ_T_SAMPLES/3] -
-           45 * t_equalized[CBZ_T_SAMPLES/3] -
-           (9 << CBZ_T_Q)) >> 1;
-
-  b->La = ((27 * (t_equalized[CBZ_T_SAMPLES/3] -
-                 t_equalized[2*CBZ_T_SAMPLES/3]) +
-            (7 << CBZ_T_Q)) >> 1) + CBZ_T_ONE;
-
-  g_debug ("t(1/3) %f, t(2/3) %f",
-           (double)t_equalized[CBZ_T_SAMPLES/3]/(double)CBZ_T_ONE,
-           (double)t_equalized[2*CBZ_T_SAMPLES/3]/(double)CBZ_T_ONE);
-
-  g_debug ("L -> t coefficients: %f, %f, %f",
-           (double)b->La/(double)CBZ_T_ONE,
-           (double)b->Lb/(double)CBZ_T_ONE,
-           (double)b->Lc/(double)CBZ_T_ONE);
+      b->l2t[i] = samples[j - 1].t;
+      if (l_1 > l_0)
+        b->l2t[i] += (samples[j].t - samples[j - 1].t) * (L - l_0) / (l_1 - l_0);
+    }
 
+  CLUTTER_NOTE (MISC, "bezier {%.1f,%.1f}-{%.1f,%.1f}: length %.2f, %u pieces",
+                x_0, y_0, x_3, y_3,
+                b->length,
+                n_samples - 1);
+}
 
-  /*
-   * For debugging, you can load these values into a spreadsheet and graph
-   * them to see how well the approximation matches the data
-   */
-  for (i = 0; i < CBZ_T_SAMPLES; ++i)
-    {
-      g_print ("%f, %f, %f\n",
-               (double)(i*CBZ_T_STEP)/(double)CBZ_T_ONE,
-               (double)(t_equalized[i])/(double)CBZ_T_ONE,
-               (double)(clutter_bezier_L2t(b,i*CBZ_T_STEP))/(double)CBZ_T_ONE);
-    }
-#endif
+gfloat
+_clutter_bezier_get_length (const ClutterBezier *b)
+{
+  return b->length;
 }
 
 /*
- * Moves a control point at indx to location represented by knot
+ * Evaluates the bezier at the relative length L along the curve, from
+ * interval <0,1>, and stores the position in point and the normalized
+ * direction of the curve in tangent, if not NULL
  */
 void
-_clutter_bezier_adjust (ClutterBezier * b, ClutterKnot * knot, guint indx)
+_clutter_bezier_get_point (const ClutterBezier *b,
+                           gfloat               L,
+                           ClutterPoint        *point,
+                           ClutterPoint        *tangent)
 {
-  guint x[4], y[4];
+  gfloat f, t, dx, dy, d;
+  guint i;
 
-  g_assert (indx < 4);
-    
-  x[0] = b->dx;
-  y[0] = b->dy;
+  f = CLAMP (L, 0.f, 1.f) * CBZ_L2T_SAMPLES;
+  i = MIN ((guint) f, CBZ_L2T_SAMPLES - 1);
+  f -= i;
 
-  x[1] = b->cx / 3 + x[0];
-  y[1] = b->cy / 3 + y[0];
+  t = b->l2t[i] + (b->l2t[i + 1] - b->l2t[i]) * f;
 
-  x[2] = b->bx / 3 + b->cx + x[1];
-  y[2] = b->by / 3 + b->cy + y[1];
+  point->x = ((b->ax * t + b->bx) * t + b->cx) * t + b->dx;
+  point->y = ((b->ay * t + b->by) * t + b->cy) * t + b->dy;
 
-  x[3] = b->ax + x[0] + b->cx + b->bx;
-  y[3] = b->ay + y[0] + b->cy + b->by;
+  if (tangent == NULL)
+    return;
 
-  x[indx] = knot->x;
-  y[indx] = knot->y;
+  dx = (3 * b->ax * t + 2 * b->bx) * t + b->cx;
+  dy = (3 * b->ay * t + 2 * b->by) * t + b->cy;
 
-  _clutter_bezier_init (b, x[0], y[0], x[1], y[1], x[2], y[2], x[3], y[3]);
-}
+  /* the derivative vanishes at the ends if the control points
+   * coincide with them, so fall back to the direction of the chord
+   */
+  if (dx == 0 && dy == 0)
+    {
+      dx = b->ax + b->bx + b->cx;
+      dy = b->ay + b->by + b->cy;
+    }
 
-guint
-_clutter_bezier_get_length (const ClutterBezier *b)
-{
-  return b->length;
+  d = sqrtf (dx * dx + dy * dy);
+
+  if (d > 0)
+    {
+      tangent->x = dx / d;
+      tangent->y = dy / d;
+    }
+  else
+    {
+      tangent->x = 1.f;
+      tangent->y = 0.f;
+    }
 }
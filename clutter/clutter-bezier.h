@@ -29,36 +29,24 @@
 
 G_BEGIN_DECLS
 
-/* This is used in _clutter_bezier_advance to represent the full
-   length of the bezier curve. Anything less than that represents a
-   fraction of the length */
-#define CLUTTER_BEZIER_MAX_LENGTH (1 << 18)
-
 typedef struct _ClutterBezier ClutterBezier;
 
 ClutterBezier *_clutter_bezier_new ();
 
 void           _clutter_bezier_free (ClutterBezier * b);
 
-ClutterBezier *_clutter_bezier_clone_and_move (const ClutterBezier *b,
-                                               gint           x,
-                                               gint           y);
-
-void           _clutter_bezier_advance (const ClutterBezier *b,
-                                        gint           L,
-                                        ClutterKnot   *knot);
-
 void           _clutter_bezier_init (ClutterBezier *b,
-                                     gint x_0, gint y_0,
-                                     gint x_1, gint y_1,
-                                     gint x_2, gint y_2,
-                                     gint x_3, gint y_3);
+                                     gfloat x_0, gfloat y_0,
+                                     gfloat x_1, gfloat y_1,
+                                     gfloat x_2, gfloat y_2,
+                                     gfloat x_3, gfloat y_3);
 
-void           _clutter_bezier_adjust (ClutterBezier *b,
-                                       ClutterKnot   *knot,
-                                       guint          indx);
+gfloat         _clutter_bezier_get_length (const ClutterBezier *b);
 
-guint          _clutter_bezier_get_length (const ClutterBezier *b);
+void           _clutter_bezier_get_point (const ClutterBezier *b,
+                                          gfloat               L,
+                                          ClutterPoint        *point,
+                                          ClutterPoint        *tangent);
 
 G_END_DECLS
 
@@ -915,6 +915,21 @@ clutter_color_progress (const GValue *a,
   return TRUE;
 }
 
+/*< private >
+ * _clutter_color_has_default_progress:
+ *
+ * Checks whether the progress function used by #ClutterInterval for
+ * colors is still the one installed by Clutter, i.e. whether colors
+ * are interpolated by clutter_color_interpolate().
+ *
+ * Return value: %TRUE if the default progress function is in use
+ */
+gboolean
+_clutter_color_has_default_progress (void)
+{
+  return _clutter_get_progress_function (CLUTTER_TYPE_COLOR) == clutter_color_progress;
+}
+
 /**
  * clutter_color_copy:
  * @color: a #ClutterColor
@@ -553,3 +553,220 @@ clutter_easing_for_mode (ClutterAnimationMode mode,
 
   return _clutter_animation_modes[mode].func (t, d);
 }
+
+/*< private >
+ * EASING_TABLE_SIZE:
+ *
+ * The number of intervals in which an easing function is sampled; the
+ * linear interpolation between samples is within 1e-3 of the analytic
+ * value even for the elastic modes and steep cubic beziers.
+ */
+#define EASING_TABLE_SIZE       512
+
+struct _ClutterEasingTable
+{
+  /* the parameters of a cubic bezier table; also its key in
+   * the cubic_bezier_tables hash table
+   */
+  double x_1, y_1, x_2, y_2;
+
+  int ref_count;
+
+  float values[EASING_TABLE_SIZE + 1];
+};
+
+/* the tables of the animation modes are created on demand, and live
+ * for as long as the process; the cubic bezier tables are shared while
+ * they are in use by at least one timeline
+ */
+static ClutterEasingTable *mode_tables[CLUTTER_ANIMATION_LAST] = { NULL, };
+static GHashTable *cubic_bezier_tables = NULL;
+
+static guint
+cubic_bezier_table_hash (gconstpointer key)
+{
+  const ClutterEasingTable *table = key;
+
+  return g_double_hash (&table->x_1)
+       ^ (g_double_hash (&table->y_1) << 1)
+       ^ (g_double_hash (&table->x_2) << 2)
+       ^ (g_double_hash (&table->y_2) << 3);
+}
+
+static gboolean
+cubic_bezier_table_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const ClutterEasingTable *table_a = a;
+  const ClutterEasingTable *table_b = b;
+
+  return table_a->x_1 == table_b->x_1 &&
+         table_a->y_1 == table_b->y_1 &&
+         table_a->x_2 == table_b->x_2 &&
+         table_a->y_2 == table_b->y_2;
+}
+
+/*< private >
+ * clutter_easing_table_for_mode:
+ * @mode: an animation mode
+ *
+ * Retrieves the shared table for the easing function of @mode.
+ *
+ * The parametrized modes, %CLUTTER_LINEAR, and the modes that cannot
+ * be approximated by a table do not have one; cubic bezier tables are
+ * available through clutter_easing_table_for_cubic_bezier().
+ *
+ * Return value: (transfer full): a reference on the table, or %NULL;
+ *   use clutter_easing_table_unref() to release it
+ */
+ClutterEasingTable *
+clutter_easing_table_for_mode (ClutterAnimationMode mode)
+{
+  ClutterEasingTable *table;
+  ClutterEasingFunc func;
+  int i;
+
+  switch (mode)
+    {
+    /* the circular modes have an infinite slope at their ends, and the
+     * bounce modes have corners, neither of which can be followed by
+     * the linear interpolation; they are cheap to evaluate anyway
+     */
+    case CLUTTER_EASE_IN_CIRC:
+    case CLUTTER_EASE_OUT_CIRC:
+    case CLUTTER_EASE_IN_OUT_CIRC:
+    case CLUTTER_EASE_IN_BOUNCE:
+    case CLUTTER_EASE_OUT_BOUNCE:
+    case CLUTTER_EASE_IN_OUT_BOUNCE:
+      return NULL;
+
+    default:
+      if (mode <= CLUTTER_LINEAR || mode >= CLUTTER_STEPS)
+        return NULL;
+      break;
+    }
+
+  table = mode_tables[mode];
+  if (table == NULL)
+    {
+      func = clutter_get_easing_func_for_mode (mode);
+
+      table = g_slice_new0 (ClutterEasingTable);
+      table->ref_count = 1;
+
+      for (i = 0; i <= EASING_TABLE_SIZE; i++)
+        table->values[i] = func (i, EASING_TABLE_SIZE);
+
+      mode_tables[mode] = table;
+    }
+
+  table->ref_count += 1;
+
+  return table;
+}
+
+/*< private >
+ * clutter_easing_table_for_cubic_bezier:
+ * @x_1: the X coordinate of the first control point
+ * @y_1: the Y coordinate of the first control point
+ * @x_2: the X coordinate of the second control point
+ * @y_2: the Y coordinate of the second control point
+ *
+ * Retrieves the shared table for the cubic bezier easing function
+ * with the given control points.
+ *
+ * Return value: (transfer full): a reference on the table; use
+ *   clutter_easing_table_unref() to release it
+ */
+ClutterEasingTable *
+clutter_easing_table_for_cubic_bezier (double x_1,
+                                       double y_1,
+                                       double x_2,
+                                       double y_2)
+{
+  ClutterEasingTable key, *table;
+  int i;
+
+  if (cubic_bezier_tables == NULL)
+    cubic_bezier_tables = g_hash_table_new (cubic_bezier_table_hash,
+                                            cubic_bezier_table_equal);
+
+  key.x_1 = x_1;
+  key.y_1 = y_1;
+  key.x_2 = x_2;
+  key.y_2 = y_2;
+
+  table = g_hash_table_lookup (cubic_bezier_tables, &key);
+  if (table != NULL)
+    {
+      table->ref_count += 1;
+      return table;
+    }
+
+  table = g_slice_new (ClutterEasingTable);
+  table->x_1 = x_1;
+  table->y_1 = y_1;
+  table->x_2 = x_2;
+  table->y_2 = y_2;
+  table->ref_count = 1;
+
+  for (i = 0; i <= EASING_TABLE_SIZE; i++)
+    table->values[i] = clutter_ease_cubic_bezier (i, EASING_TABLE_SIZE,
+                                                  x_1, y_1,
+                                                  x_2, y_2);
+
+  g_hash_table_insert (cubic_bezier_tables, table, table);
+
+  return table;
+}
+
+ClutterEasingTable *
+clutter_easing_table_ref (ClutterEasingTable *table)
+{
+  table->ref_count += 1;
+
+  return table;
+}
+
+void
+clutter_easing_table_unref (ClutterEasingTable *table)
+{
+  table->ref_count -= 1;
+
+  /* the mode tables are never released, since the mode_tables
+   * array holds a reference on them
+   */
+  if (table->ref_count == 0)
+    {
+      g_hash_table_remove (cubic_bezier_tables, table);
+      g_slice_free (ClutterEasingTable, table);
+    }
+}
+
+/*< private >
+ * clutter_easing_table_evaluate:
+ * @table: a #ClutterEasingTable
+ * @t: elapsed time
+ * @d: total duration
+ *
+ * Evaluates the sampled easing function of @table.
+ *
+ * Return value: the interpolated value
+ */
+double
+clutter_easing_table_evaluate (const ClutterEasingTable *table,
+                               double                    t,
+                               double                    d)
+{
+  double p;
+  int i;
+
+  /* this also takes care of a zero duration */
+  if (t >= d)
+    return table->values[EASING_TABLE_SIZE];
+
+  p = MAX (t / d, 0.0) * EASING_TABLE_SIZE;
+  i = MIN ((int) p, EASING_TABLE_SIZE - 1);
+
+  return table->values[i] + (table->values[i + 1] - table->values[i]) * (p - i);
+}
@@ -137,6 +137,30 @@ double  clutter_ease_cubic_bezier       (double t,
                                          double x_2,
                                          double y_2);
 
+/*< private >
+ * ClutterEasingTable:
+ *
+ * An easing function sampled at regular intervals, for evaluation
+ * using a table lookup and a linear interpolation.
+ */
+typedef struct _ClutterEasingTable      ClutterEasingTable;
+
+G_GNUC_INTERNAL
+ClutterEasingTable *    clutter_easing_table_for_mode           (ClutterAnimationMode mode);
+G_GNUC_INTERNAL
+ClutterEasingTable *    clutter_easing_table_for_cubic_bezier   (double               x_1,
+                                                                 double               y_1,
+                                                                 double               x_2,
+                                                                 double               y_2);
+G_GNUC_INTERNAL
+ClutterEasingTable *    clutter_easing_table_ref                (ClutterEasingTable  *table);
+G_GNUC_INTERNAL
+void                    clutter_easing_table_unref              (ClutterEasingTable  *table);
+G_GNUC_INTERNAL
+double                  clutter_easing_table_evaluate           (const ClutterEasingTable *table,
+                                                                 double               t,
+                                                                 double               d);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_EASING_H__ */
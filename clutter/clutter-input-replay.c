@@ -0,0 +1,939 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:clutter-input-replay
+ * @Title: Input recording
+ * @Short_Description: Recording and replaying input events
+ *
+ * Clutter can record the input events received by its stages into a
+ * file, and replay them later on a stage, so that an interaction, like
+ * a drag, a scroll or some typing, can be reproduced identically on
+ * every run; combined with clutter_stage_get_frame_stats(), this can
+ * be used to write interaction benchmarks.
+ *
+ * A recording stores every key, pointer, scroll, crossing and touch
+ * event queued on any stage between the calls to
+ * clutter_input_record_start() and clutter_input_record_stop(), with
+ * the time it was received, its input devices, its touch sequence and
+ * its axes. Events of the window system, like the changes of state of
+ * the stages, are not recorded. If the <envar>CLUTTER_INPUT_RECORD</envar>
+ * environment variable is set to the name of a file, the events are
+ * recorded for the whole life time of the application.
+ *
+ * A recording is replayed on a stage using clutter_input_replay_start(),
+ * either with the timing of the recording, or as fast as possible: in
+ * the latter case, the events received during each frame of the
+ * recording are injected before each frame drawn by Clutter. The
+ * input devices of the recording are looked up by identifier, and
+ * replaced by the core devices when they do not exist.
+ *
+ * Recording is available since Clutter 1.16
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "clutter-input-replay.h"
+
+#include "clutter-debug.h"
+#include "clutter-device-manager.h"
+#include "clutter-event.h"
+#include "clutter-input-device.h"
+#include "clutter-main.h"
+#include "clutter-private.h"
+#include "clutter-stage.h"
+
+#define RECORD_MAGIC            "CLTINPUT"
+#define RECORD_MAGIC_LEN        8
+#define RECORD_VERSION          1
+
+/* the length of the frames replayed when not replaying in real time,
+ * in microseconds
+ */
+#define REPLAY_FRAME_INTERVAL   16667
+
+typedef struct _ReplayEvent     ReplayEvent;
+typedef struct _Replay          Replay;
+
+/* an event of a recording; the meaning of the detail fields depends on
+ * the type of the event:
+ *
+ *  - key events: the key symbol, the unicode value and the key code
+ *  - button events: the button and the click count
+ *  - scroll events: the direction
+ */
+struct _ReplayEvent
+{
+  /* the time the event was queued, since the start of the recording,
+   * in microseconds
+   */
+  gint64 offset;
+
+  /* the time of the event, since the first recorded event, in
+   * milliseconds
+   */
+  guint32 time;
+
+  ClutterEventType type;
+  ClutterEventFlags flags;
+  ClutterModifierType modifier_state;
+
+  gint device_id;
+  gint source_device_id;
+
+  guint sequence;
+
+  gfloat x;
+  gfloat y;
+
+  guint32 detail1;
+  guint32 detail2;
+  guint16 detail3;
+
+  gdouble delta_x;
+  gdouble delta_y;
+
+  guint n_axes;
+  gdouble *axes;
+};
+
+struct _Replay
+{
+  ClutterStage *stage;
+
+  GArray *events;
+  guint next_event;
+
+  gboolean realtime;
+  gint64 start_time;
+  guint32 time_base;
+
+  guint source_id;
+  guint repaint_id;
+
+  ClutterInputReplayFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+};
+
+static FILE *record_file = NULL;
+static gint64 record_last_time = 0;
+static gboolean record_has_time_base = FALSE;
+static guint32 record_time_base = 0;
+static guint record_n_events = 0;
+
+/* maps the touch sequences being recorded to small integers */
+static GHashTable *record_sequences = NULL;
+static guint record_last_sequence = 0;
+
+static Replay *replay = NULL;
+
+static void
+write_uint8 (guint8 value)
+{
+  fwrite (&value, sizeof (value), 1, record_file);
+}
+
+static void
+write_uint16 (guint16 value)
+{
+  value = GUINT16_TO_LE (value);
+  fwrite (&value, sizeof (value), 1, record_file);
+}
+
+static void
+write_uint32 (guint32 value)
+{
+  value = GUINT32_TO_LE (value);
+  fwrite (&value, sizeof (value), 1, record_file);
+}
+
+static void
+write_float (gfloat value)
+{
+  union { gfloat f; guint32 i; } u;
+
+  u.f = value;
+  write_uint32 (u.i);
+}
+
+static void
+write_double (gdouble value)
+{
+  union { gdouble d; guint64 i; } u;
+
+  u.d = value;
+  u.i = GUINT64_TO_LE (u.i);
+  fwrite (&u.i, sizeof (u.i), 1, record_file);
+}
+
+static guint
+record_get_sequence (const ClutterEvent *event)
+{
+  ClutterEventSequence *sequence;
+  guint id;
+
+  sequence = clutter_event_get_event_sequence (event);
+  if (sequence == NULL)
+    return 0;
+
+  if (record_sequences == NULL)
+    record_sequences = g_hash_table_new (NULL, NULL);
+
+  id = GPOINTER_TO_UINT (g_hash_table_lookup (record_sequences, sequence));
+  if (id == 0)
+    {
+      id = ++record_last_sequence;
+      g_hash_table_insert (record_sequences, sequence, GUINT_TO_POINTER (id));
+    }
+
+  if (event->type == CLUTTER_TOUCH_END || event->type == CLUTTER_TOUCH_CANCEL)
+    g_hash_table_remove (record_sequences, sequence);
+
+  return id;
+}
+
+/*< private >
+ * _clutter_input_record_event:
+ * @event: an event queued on a stage
+ *
+ * Writes @event to the recording started by clutter_input_record_start(),
+ * if any.
+ */
+void
+_clutter_input_record_event (const ClutterEvent *event)
+{
+  ClutterInputDevice *device, *source_device;
+  guint32 detail1 = 0, detail2 = 0;
+  guint16 detail3 = 0;
+  gdouble *axes = NULL;
+  guint n_axes = 0, i;
+  gint64 now, delta;
+  gfloat x, y;
+
+  if (G_LIKELY (record_file == NULL))
+    return;
+
+  switch (event->type)
+    {
+    case CLUTTER_KEY_PRESS:
+    case CLUTTER_KEY_RELEASE:
+      detail1 = clutter_event_get_key_symbol (event);
+      detail2 = clutter_event_get_key_unicode (event);
+      detail3 = clutter_event_get_key_code (event);
+      break;
+
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+      detail1 = clutter_event_get_button (event);
+      detail2 = clutter_event_get_click_count (event);
+      break;
+
+    case CLUTTER_SCROLL:
+      detail1 = clutter_event_get_scroll_direction (event);
+      break;
+
+    case CLUTTER_MOTION:
+    case CLUTTER_ENTER:
+    case CLUTTER_LEAVE:
+    case CLUTTER_TOUCH_BEGIN:
+    case CLUTTER_TOUCH_UPDATE:
+    case CLUTTER_TOUCH_END:
+    case CLUTTER_TOUCH_CANCEL:
+      break;
+
+    default:
+      /* the events of the window system are not recorded */
+      return;
+    }
+
+  now = g_get_monotonic_time ();
+  delta = CLAMP (now - record_last_time, 0, G_MAXUINT32);
+  record_last_time = now;
+
+  if (!record_has_time_base)
+    {
+      record_time_base = clutter_event_get_time (event);
+      record_has_time_base = TRUE;
+    }
+
+  device = clutter_event_get_device (event);
+  source_device = clutter_event_get_source_device (event);
+
+  if (event->type != CLUTTER_ENTER && event->type != CLUTTER_LEAVE)
+    axes = clutter_event_get_axes (event, &n_axes);
+
+  if (axes == NULL)
+    n_axes = 0;
+
+  n_axes = MIN (n_axes, G_MAXUINT8);
+
+  clutter_event_get_coords (event, &x, &y);
+
+  write_uint32 (delta);
+  write_uint32 (clutter_event_get_time (event) - record_time_base);
+  write_uint8 (event->type);
+  write_uint8 (n_axes);
+  write_uint16 (clutter_event_get_flags (event));
+  write_uint32 (device != NULL
+                ? clutter_input_device_get_device_id (device)
+                : -1);
+  write_uint32 (source_device != NULL
+                ? clutter_input_device_get_device_id (source_device)
+                : -1);
+  write_uint32 (clutter_event_get_state (event));
+  write_uint32 (record_get_sequence (event));
+  write_float (x);
+  write_float (y);
+  write_uint32 (detail1);
+  write_uint32 (detail2);
+  write_uint16 (detail3);
+
+  if (event->type == CLUTTER_SCROLL && detail1 == CLUTTER_SCROLL_SMOOTH)
+    {
+      gdouble dx, dy;
+
+      clutter_event_get_scroll_delta (event, &dx, &dy);
+      write_double (dx);
+      write_double (dy);
+    }
+
+  for (i = 0; i < n_axes; i++)
+    write_double (axes[i]);
+
+  record_n_events += 1;
+}
+
+static void
+record_stop_at_exit (void)
+{
+  clutter_input_record_stop ();
+}
+
+/**
+ * clutter_input_record_start:
+ * @filename: the name of the file to write
+ * @error: return location for a #GError, or %NULL
+ *
+ * Starts recording the input events queued on every stage into
+ * @filename, until clutter_input_record_stop() is called.
+ *
+ * If a recording is already in progress, this function does nothing.
+ *
+ * Return value: %TRUE if the recording was started, and %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_input_record_start (const gchar  *filename,
+                            GError      **error)
+{
+  static gboolean atexit_installed = FALSE;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (record_file != NULL)
+    return TRUE;
+
+  record_file = g_fopen (filename, "wb");
+  if (record_file == NULL)
+    {
+      int saved_errno = errno;
+
+      g_set_error (error, G_FILE_ERROR,
+                   g_file_error_from_errno (saved_errno),
+                   "Unable to open the recording '%s': %s",
+                   filename,
+                   g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  fwrite (RECORD_MAGIC, 1, RECORD_MAGIC_LEN, record_file);
+  write_uint32 (RECORD_VERSION);
+
+  record_last_time = g_get_monotonic_time ();
+  record_has_time_base = FALSE;
+  record_n_events = 0;
+  record_last_sequence = 0;
+
+  if (!atexit_installed)
+    {
+      atexit (record_stop_at_exit);
+      atexit_installed = TRUE;
+    }
+
+  CLUTTER_NOTE (EVENT, "Recording the input events into '%s'", filename);
+
+  return TRUE;
+}
+
+/**
+ * clutter_input_record_stop:
+ *
+ * Stops the recording started with clutter_input_record_start(),
+ * and closes the file.
+ *
+ * Since: 1.16
+ */
+void
+clutter_input_record_stop (void)
+{
+  if (record_file == NULL)
+    return;
+
+  fclose (record_file);
+  record_file = NULL;
+
+  if (record_sequences != NULL)
+    {
+      g_hash_table_destroy (record_sequences);
+      record_sequences = NULL;
+    }
+
+  CLUTTER_NOTE (EVENT, "Recorded %u input events", record_n_events);
+}
+
+typedef struct {
+  const guchar *data;
+  gsize length;
+  gsize position;
+  gboolean truncated;
+} Reader;
+
+static const guchar *
+read_bytes (Reader *reader,
+            gsize   length)
+{
+  const guchar *retval;
+
+  if (reader->truncated || reader->length - reader->position < length)
+    {
+      reader->truncated = TRUE;
+      return NULL;
+    }
+
+  retval = reader->data + reader->position;
+  reader->position += length;
+
+  return retval;
+}
+
+static guint8
+read_uint8 (Reader *reader)
+{
+  const guchar *data = read_bytes (reader, sizeof (guint8));
+
+  return data != NULL ? data[0] : 0;
+}
+
+static guint16
+read_uint16 (Reader *reader)
+{
+  const guchar *data = read_bytes (reader, sizeof (guint16));
+  guint16 value;
+
+  if (data == NULL)
+    return 0;
+
+  memcpy (&value, data, sizeof (value));
+
+  return GUINT16_FROM_LE (value);
+}
+
+static guint32
+read_uint32 (Reader *reader)
+{
+  const guchar *data = read_bytes (reader, sizeof (guint32));
+  guint32 value;
+
+  if (data == NULL)
+    return 0;
+
+  memcpy (&value, data, sizeof (value));
+
+  return GUINT32_FROM_LE (value);
+}
+
+static gfloat
+read_float (Reader *reader)
+{
+  union { gfloat f; guint32 i; } u;
+
+  u.i = read_uint32 (reader);
+
+  return u.f;
+}
+
+static gdouble
+read_double (Reader *reader)
+{
+  const guchar *data = read_bytes (reader, sizeof (guint64));
+  union { gdouble d; guint64 i; } u;
+
+  if (data == NULL)
+    return 0.0;
+
+  memcpy (&u.i, data, sizeof (u.i));
+  u.i = GUINT64_FROM_LE (u.i);
+
+  return u.d;
+}
+
+static void
+replay_events_free (GArray *events)
+{
+  guint i;
+
+  for (i = 0; i < events->len; i++)
+    g_free (g_array_index (events, ReplayEvent, i).axes);
+
+  g_array_free (events, TRUE);
+}
+
+static GArray *
+replay_load_events (const gchar  *filename,
+                    GError      **error)
+{
+  Reader reader = { NULL, };
+  GArray *events;
+  gchar *contents;
+  gsize length;
+  gint64 offset = 0;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  reader.data = (const guchar *) contents;
+  reader.length = length;
+
+  if (length < RECORD_MAGIC_LEN + sizeof (guint32) ||
+      memcmp (contents, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "The file '%s' is not an input recording",
+                   filename);
+      g_free (contents);
+      return NULL;
+    }
+
+  reader.position = RECORD_MAGIC_LEN;
+
+  if (read_uint32 (&reader) != RECORD_VERSION)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "The input recording '%s' has an unsupported version",
+                   filename);
+      g_free (contents);
+      return NULL;
+    }
+
+  events = g_array_new (FALSE, TRUE, sizeof (ReplayEvent));
+
+  while (reader.position < reader.length)
+    {
+      ReplayEvent event = { 0, };
+      guint i;
+
+      offset += read_uint32 (&reader);
+
+      event.offset = offset;
+      event.time = read_uint32 (&reader);
+      event.type = read_uint8 (&reader);
+      event.n_axes = read_uint8 (&reader);
+      event.flags = read_uint16 (&reader);
+      event.device_id = (gint32) read_uint32 (&reader);
+      event.source_device_id = (gint32) read_uint32 (&reader);
+      event.modifier_state = read_uint32 (&reader);
+      event.sequence = read_uint32 (&reader);
+      event.x = read_float (&reader);
+      event.y = read_float (&reader);
+      event.detail1 = read_uint32 (&reader);
+      event.detail2 = read_uint32 (&reader);
+      event.detail3 = read_uint16 (&reader);
+
+      if (event.type == CLUTTER_SCROLL &&
+          event.detail1 == CLUTTER_SCROLL_SMOOTH)
+        {
+          event.delta_x = read_double (&reader);
+          event.delta_y = read_double (&reader);
+        }
+
+      if (event.n_axes > 0)
+        {
+          event.axes = g_new (gdouble, event.n_axes);
+
+          for (i = 0; i < event.n_axes; i++)
+            event.axes[i] = read_double (&reader);
+        }
+
+      if (reader.truncated)
+        {
+          g_free (event.axes);
+          break;
+        }
+
+      g_array_append_val (events, event);
+    }
+
+  g_free (contents);
+
+  if (reader.truncated)
+    {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                   "The input recording '%s' is truncated",
+                   filename);
+      replay_events_free (events);
+      return NULL;
+    }
+
+  return events;
+}
+
+static ClutterInputDevice *
+replay_get_device (const ReplayEvent *record,
+                   gint               device_id)
+{
+  ClutterDeviceManager *manager = clutter_device_manager_get_default ();
+  ClutterInputDevice *device = NULL;
+
+  if (device_id >= 0)
+    device = clutter_device_manager_get_device (manager, device_id);
+
+  if (device == NULL)
+    {
+      if (record->type == CLUTTER_KEY_PRESS ||
+          record->type == CLUTTER_KEY_RELEASE)
+        device = clutter_device_manager_get_core_device (manager,
+                                                         CLUTTER_KEYBOARD_DEVICE);
+      else
+        device = clutter_device_manager_get_core_device (manager,
+                                                         CLUTTER_POINTER_DEVICE);
+    }
+
+  return device;
+}
+
+static void
+replay_inject_event (const ReplayEvent *record)
+{
+  ClutterInputDevice *device;
+  ClutterEvent *event;
+  gdouble *axes = NULL;
+
+  device = replay_get_device (record, record->device_id);
+
+  /* the axes are only meaningful for the device that recorded them */
+  if (record->n_axes > 0 &&
+      device != NULL &&
+      clutter_input_device_get_n_axes (device) == record->n_axes)
+    axes = g_memdup (record->axes, sizeof (gdouble) * record->n_axes);
+
+  event = clutter_event_new (record->type);
+  clutter_event_set_stage (event, replay->stage);
+  clutter_event_set_time (event, replay->time_base + record->time);
+  clutter_event_set_flags (event, record->flags);
+  clutter_event_set_state (event, record->modifier_state);
+  clutter_event_set_device (event, device);
+  clutter_event_set_source_device (event,
+                                   replay_get_device (record,
+                                                      record->source_device_id));
+  clutter_event_set_coords (event, record->x, record->y);
+
+  switch (record->type)
+    {
+    case CLUTTER_KEY_PRESS:
+    case CLUTTER_KEY_RELEASE:
+      clutter_event_set_key_symbol (event, record->detail1);
+      clutter_event_set_key_unicode (event, record->detail2);
+      clutter_event_set_key_code (event, record->detail3);
+      break;
+
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+      clutter_event_set_button (event, record->detail1);
+      event->button.click_count = record->detail2;
+      event->button.axes = axes;
+      break;
+
+    case CLUTTER_SCROLL:
+      if (record->detail1 == CLUTTER_SCROLL_SMOOTH)
+        clutter_event_set_scroll_delta (event,
+                                        record->delta_x,
+                                        record->delta_y);
+      else
+        clutter_event_set_scroll_direction (event, record->detail1);
+      event->scroll.axes = axes;
+      break;
+
+    case CLUTTER_MOTION:
+      event->motion.axes = axes;
+      break;
+
+    case CLUTTER_TOUCH_BEGIN:
+    case CLUTTER_TOUCH_UPDATE:
+    case CLUTTER_TOUCH_END:
+    case CLUTTER_TOUCH_CANCEL:
+      event->touch.sequence = GUINT_TO_POINTER (record->sequence);
+      event->touch.axes = axes;
+      break;
+
+    default:
+      g_free (axes);
+      break;
+    }
+
+  clutter_do_event (event);
+  clutter_event_free (event);
+}
+
+static void
+replay_finish (void)
+{
+  Replay *old_replay = replay;
+
+  /* the callbacks may start a new replay */
+  replay = NULL;
+
+  if (old_replay->source_id != 0)
+    g_source_remove (old_replay->source_id);
+
+  if (old_replay->repaint_id != 0)
+    clutter_threads_remove_repaint_func (old_replay->repaint_id);
+
+  CLUTTER_NOTE (EVENT, "Replayed %u of %u input events",
+                old_replay->next_event,
+                old_replay->events->len);
+
+  if (old_replay->func != NULL)
+    old_replay->func (old_replay->stage, old_replay->user_data);
+
+  if (old_replay->notify != NULL)
+    old_replay->notify (old_replay->user_data);
+
+  replay_events_free (old_replay->events);
+  g_object_unref (old_replay->stage);
+  g_slice_free (Replay, old_replay);
+}
+
+static gboolean replay_timeout (gpointer data);
+
+static void
+replay_schedule_timeout (void)
+{
+  const ReplayEvent *record;
+  gint64 delay;
+
+  record = &g_array_index (replay->events, ReplayEvent, replay->next_event);
+  delay = replay->start_time + record->offset - g_get_monotonic_time ();
+
+  replay->source_id =
+    clutter_threads_add_timeout_full (CLUTTER_PRIORITY_EVENTS,
+                                      delay > 0 ? (delay + 999) / 1000 : 0,
+                                      replay_timeout,
+                                      NULL, NULL);
+}
+
+/* injects the events whose time has come, when replaying in real time */
+static gboolean
+replay_timeout (gpointer data)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  replay->source_id = 0;
+
+  while (replay->next_event < replay->events->len)
+    {
+      const ReplayEvent *record;
+
+      record = &g_array_index (replay->events, ReplayEvent, replay->next_event);
+      if (replay->start_time + record->offset > now)
+        break;
+
+      replay_inject_event (record);
+      replay->next_event += 1;
+    }
+
+  if (replay->next_event < replay->events->len)
+    replay_schedule_timeout ();
+  else
+    replay_finish ();
+
+  return FALSE;
+}
+
+/* injects the events of the next frame of the recording, when not
+ * replaying in real time; returns %FALSE if there are no more events
+ */
+static gboolean
+replay_inject_frame (void)
+{
+  const ReplayEvent *record;
+  gint64 frame_end;
+
+  if (replay->next_event >= replay->events->len)
+    return FALSE;
+
+  /* the periods without events are skipped */
+  record = &g_array_index (replay->events, ReplayEvent, replay->next_event);
+  frame_end = record->offset + REPLAY_FRAME_INTERVAL;
+
+  while (replay->next_event < replay->events->len)
+    {
+      record = &g_array_index (replay->events, ReplayEvent, replay->next_event);
+      if (record->offset >= frame_end)
+        break;
+
+      replay_inject_event (record);
+      replay->next_event += 1;
+    }
+
+  return TRUE;
+}
+
+/* the events injected by the previous run of this function have been
+ * processed by the frame that just ended, so the events of the next
+ * frame can be injected
+ */
+static gboolean
+replay_repaint_func (gpointer data)
+{
+  if (replay_inject_frame ())
+    return TRUE;
+
+  /* the function is removed by returning FALSE */
+  replay->repaint_id = 0;
+  replay_finish ();
+
+  return FALSE;
+}
+
+/**
+ * clutter_input_replay_start:
+ * @stage: the #ClutterStage to replay the events on
+ * @filename: the name of a file written by clutter_input_record_start()
+ * @realtime: %TRUE to replay the events with the timing of the
+ *   recording, and %FALSE to replay them as fast as possible
+ * @func: (allow-none): the function to call when all the events
+ *   have been replayed, or %NULL
+ * @user_data: data to pass to @func
+ * @notify: (allow-none): the function to call to release @user_data
+ *   when the replay ends
+ * @error: return location for a #GError, or %NULL
+ *
+ * Starts replaying the input events recorded into @filename on @stage.
+ *
+ * If @realtime is %TRUE, each event is injected at the same time,
+ * relative to the start of the replay, it was received relative to
+ * the start of the recording. Otherwise, the events are injected one
+ * frame of the recording at a time, right after each frame drawn by
+ * Clutter, so that the replay takes as many frames as the recording
+ * but as little time as possible.
+ *
+ * Only one recording can be replayed at a time; starting a new replay
+ * stops the current one.
+ *
+ * Return value: %TRUE if the replay was started, and %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_input_replay_start (ClutterStage            *stage,
+                            const gchar             *filename,
+                            gboolean                 realtime,
+                            ClutterInputReplayFunc   func,
+                            gpointer                 user_data,
+                            GDestroyNotify           notify,
+                            GError                 **error)
+{
+  GArray *events;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  events = replay_load_events (filename, error);
+  if (events == NULL)
+    return FALSE;
+
+  clutter_input_replay_stop ();
+
+  replay = g_slice_new0 (Replay);
+  replay->stage = g_object_ref (stage);
+  replay->events = events;
+  replay->realtime = !!realtime;
+  replay->start_time = g_get_monotonic_time ();
+  replay->time_base = replay->start_time / 1000;
+  replay->func = func;
+  replay->user_data = user_data;
+  replay->notify = notify;
+
+  CLUTTER_NOTE (EVENT, "Replaying %u input events from '%s'%s",
+                events->len,
+                filename,
+                realtime ? "" : " as fast as possible");
+
+  if (events->len == 0)
+    {
+      replay_finish ();
+      return TRUE;
+    }
+
+  if (realtime)
+    replay_schedule_timeout ();
+  else
+    {
+      replay_inject_frame ();
+      replay->repaint_id =
+        clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                               replay_repaint_func,
+                                               NULL, NULL);
+    }
+
+  return TRUE;
+}
+
+/**
+ * clutter_input_replay_stop:
+ *
+ * Stops the replay started with clutter_input_replay_start(), if any.
+ *
+ * The function passed to clutter_input_replay_start() is called.
+ *
+ * Since: 1.16
+ */
+void
+clutter_input_replay_stop (void)
+{
+  if (replay == NULL)
+    return;
+
+  replay_finish ();
+}
@@ -0,0 +1,65 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(__CLUTTER_H_INSIDE__) && !defined(CLUTTER_COMPILATION)
+#error "Only <clutter/clutter.h> can be included directly."
+#endif
+
+#ifndef __CLUTTER_INPUT_REPLAY_H__
+#define __CLUTTER_INPUT_REPLAY_H__
+
+#include <clutter/clutter-types.h>
+
+G_BEGIN_DECLS
+
+/**
+ * ClutterInputReplayFunc:
+ * @stage: the #ClutterStage the events were replayed on
+ * @user_data: data passed to clutter_input_replay_start()
+ *
+ * The function called when all the events of a recording have
+ * been replayed, or when the replay was stopped.
+ *
+ * Since: 1.16
+ */
+typedef void (* ClutterInputReplayFunc) (ClutterStage *stage,
+                                         gpointer      user_data);
+
+CLUTTER_AVAILABLE_IN_1_16
+gboolean        clutter_input_record_start      (const gchar             *filename,
+                                                 GError                 **error);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_input_record_stop       (void);
+
+CLUTTER_AVAILABLE_IN_1_16
+gboolean        clutter_input_replay_start      (ClutterStage            *stage,
+                                                 const gchar             *filename,
+                                                 gboolean                 realtime,
+                                                 ClutterInputReplayFunc   func,
+                                                 gpointer                 user_data,
+                                                 GDestroyNotify           notify,
+                                                 GError                 **error);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_input_replay_stop       (void);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_INPUT_REPLAY_H__ */
@@ -104,6 +104,7 @@
 #include "clutter-device-manager-private.h"
 #include "clutter-event-private.h"
 #include "clutter-feature.h"
+#include "clutter-input-replay.h"
 #include "clutter-main.h"
 #include "clutter-master-clock.h"
 #include "clutter-private.h"
@@ -111,6 +112,7 @@
 #include "clutter-settings-private.h"
 #include "clutter-stage-manager.h"
 #include "clutter-stage-private.h"
+#include "clutter-trace.h"
 #include "clutter-version.h" 	/* For flavour define */
 
 #ifdef CLUTTER_WINDOWING_OSX
@@ -131,6 +133,9 @@
 #ifdef CLUTTER_WINDOWING_WAYLAND
 #include "wayland/clutter-backend-wayland.h"
 #endif
+#ifdef CLUTTER_WINDOWING_HEADLESS
+#include "headless/clutter-backend-headless.h"
+#endif
 
 #include <cogl/cogl.h>
 #include <cogl-pango/cogl-pango.h>
@@ -156,6 +161,8 @@ static gboolean clutter_enable_accessibility = TRUE;
 static gboolean clutter_sync_to_vblank       = TRUE;
 
 static guint clutter_default_fps             = 60;
+static guint clutter_max_pending_swaps       = 1;
+static guint clutter_frame_stats_interval    = 0;
 
 static ClutterTextDirection clutter_text_direction = CLUTTER_TEXT_DIRECTION_LTR;
 
@@ -208,6 +215,7 @@ static const GDebugKey clutter_paint_debug_keys[] = {
   { "disable-offscreen-redirect", CLUTTER_DEBUG_DISABLE_OFFSCREEN_REDIRECT },
   { "continuous-redraw", CLUTTER_DEBUG_CONTINUOUS_REDRAW },
   { "paint-deform-tiles", CLUTTER_DEBUG_PAINT_DEFORM_TILES },
+  { "cost-overlay", CLUTTER_DEBUG_COST_OVERLAY },
 };
 
 #ifdef CLUTTER_ENABLE_PROFILE
@@ -331,6 +339,26 @@ clutter_config_read_from_key_file (GKeyFile *keyfile)
   else
     clutter_default_fps = int_value;
 
+  int_value =
+    g_key_file_get_integer (keyfile, ENVIRONMENT_GROUP,
+                            "MaxPendingSwaps",
+                            &key_error);
+
+  if (key_error != NULL)
+    g_clear_error (&key_error);
+  else
+    clutter_max_pending_swaps = CLAMP (int_value, 1, 3);
+
+  int_value =
+    g_key_file_get_integer (keyfile, ENVIRONMENT_GROUP,
+                            "FrameStatsInterval",
+                            &key_error);
+
+  if (key_error != NULL)
+    g_clear_error (&key_error);
+  else
+    clutter_frame_stats_interval = MAX (int_value, 0);
+
   str_value =
     g_key_file_get_string (keyfile, ENVIRONMENT_GROUP,
                            "TextDirection",
@@ -1428,6 +1456,11 @@ clutter_create_backend (void)
   if (backend == NULL || backend == I_(CLUTTER_WINDOWING_GDK))
     retval = g_object_new (CLUTTER_TYPE_BACKEND_GDK, NULL);
   else
+#endif
+#ifdef CLUTTER_WINDOWING_HEADLESS
+  if (backend == NULL || backend == I_(CLUTTER_WINDOWING_HEADLESS))
+    retval = g_object_new (CLUTTER_TYPE_BACKEND_HEADLESS, NULL);
+  else
 #endif
   if (backend == NULL)
     g_error ("No default Clutter backend found.");
@@ -1624,6 +1657,12 @@ clutter_init_real (GError **error)
         CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS | CLUTTER_DEBUG_DISABLE_CULLING;
     }
 
+  /* ...and when tinting the actors by their cost, which changes
+   * every frame
+   */
+  if (clutter_paint_debug_flags & CLUTTER_DEBUG_COST_OVERLAY)
+    clutter_paint_debug_flags |= CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS;
+
   /* this will take care of initializing Cogl's state and
    * query the GL machinery for features
    */
@@ -1799,6 +1838,47 @@ pre_parse_hook (GOptionContext  *context,
   if (g_strcmp0 (env_string, "none") == 0)
     clutter_sync_to_vblank = FALSE;
 
+  env_string = g_getenv ("CLUTTER_MAX_PENDING_SWAPS");
+  if (env_string)
+    {
+      gint max_pending_swaps = g_ascii_strtoll (env_string, NULL, 10);
+
+      clutter_max_pending_swaps = CLAMP (max_pending_swaps, 1, 3);
+    }
+
+  env_string = g_getenv ("CLUTTER_TRACE");
+  if (env_string != NULL && *env_string != '\0')
+    {
+      GError *trace_error = NULL;
+
+      if (!clutter_trace_start (env_string, &trace_error))
+        {
+          g_warning ("Unable to start tracing: %s", trace_error->message);
+          g_error_free (trace_error);
+        }
+    }
+
+  env_string = g_getenv ("CLUTTER_INPUT_RECORD");
+  if (env_string != NULL && *env_string != '\0')
+    {
+      GError *record_error = NULL;
+
+      if (!clutter_input_record_start (env_string, &record_error))
+        {
+          g_warning ("Unable to record the input events: %s",
+                     record_error->message);
+          g_error_free (record_error);
+        }
+    }
+
+  env_string = g_getenv ("CLUTTER_FRAME_STATS_INTERVAL");
+  if (env_string)
+    {
+      gint frame_stats_interval = g_ascii_strtoll (env_string, NULL, 10);
+
+      clutter_frame_stats_interval = MAX (frame_stats_interval, 0);
+    }
+
   return _clutter_backend_pre_parse (backend, error);
 }
 
@@ -3402,6 +3482,9 @@ clutter_set_font_flags (ClutterFontFlags flags)
   /* update the default pango context, if any */
   if (context->pango_context != NULL)
     update_pango_context (backend, context->pango_context);
+
+  /* the shared text layouts were created using the old options */
+  _clutter_text_clear_shared_layouts ();
 }
 
 /**
@@ -3971,6 +4054,12 @@ clutter_check_windowing_backend (const char *backend_type)
       CLUTTER_IS_BACKEND_X11 (context->backend))
     return TRUE;
   else
+#endif
+#ifdef CLUTTER_WINDOWING_HEADLESS
+  if (backend_type == I_(CLUTTER_WINDOWING_HEADLESS) &&
+      CLUTTER_IS_BACKEND_HEADLESS (context->backend))
+    return TRUE;
+  else
 #endif
   return FALSE;
 }
@@ -3981,6 +4070,22 @@ _clutter_get_sync_to_vblank (void)
   return clutter_sync_to_vblank;
 }
 
+/* The number of swaps a stage may have in flight before it stops
+ * drawing; 1 means double buffering, 2 triple buffering */
+guint
+_clutter_get_max_pending_swaps (void)
+{
+  return clutter_max_pending_swaps;
+}
+
+/* The interval between the summaries of the frame statistics of the
+ * stages, in seconds; 0 means no summary is printed */
+guint
+_clutter_get_frame_stats_interval (void)
+{
+  return clutter_frame_stats_interval;
+}
+
 void
 _clutter_debug_messagev (const char *format,
                          va_list     var_args)
@@ -35,10 +35,14 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "clutter-master-clock.h"
+#include "clutter-actor-private.h"
 #include "clutter-debug.h"
 #include "clutter-private.h"
 #include "clutter-profile.h"
+#include "clutter-property-transition-private.h"
 #include "clutter-stage-manager-private.h"
 #include "clutter-stage-private.h"
 
@@ -61,6 +65,36 @@
 
 typedef struct _ClutterClockSource              ClutterClockSource;
 typedef struct _ClutterMasterClockClass         ClutterMasterClockClass;
+typedef struct _ClutterTransitionBatch          ClutterTransitionBatch;
+
+/* the state of the transitions advanced in bulk by the master clock;
+ * each field is an array of @size items, of which the first @n_items
+ * are in use. The arrays are kept around between frames, to avoid
+ * allocating memory at each clock iteration
+ */
+struct _ClutterTransitionBatch
+{
+  guint n_items;
+  guint size;
+
+  ClutterTimeline **timelines;
+
+  /* easing */
+  ClutterEasingFunc *funcs;
+  gdouble *cubic_beziers;
+  ClutterEasingTable **tables;
+  gdouble *elapsed;
+  gdouble *durations;
+  gdouble *progress;
+
+  /* interpolation */
+  ClutterActor **actors;
+  GParamSpec **pspecs;
+  gdouble *initial;
+  gdouble *final;
+  gdouble *values;
+  gboolean *is_integer;
+};
 
 struct _ClutterMasterClock
 {
@@ -75,6 +109,17 @@ struct _ClutterMasterClock
   /* the previous state of the clock, in usecs, used to compute the delta */
   gint64 prev_tick;
 
+  /* the time used to advance the timelines, in usecs; this is the
+   * predicted presentation time of the frame, when available
+   */
+  gint64 frame_time;
+
+  /* the transitions advanced in bulk, see master_clock_advance_timelines() */
+  ClutterTransitionBatch batch;
+
+  /* the time spent advancing the timelines in this frame, in usecs */
+  gint64 timeline_advance;
+
 #ifdef CLUTTER_ENABLE_DEBUG
   gint64 frame_budget;
   gint64 remaining_budget;
@@ -223,14 +268,14 @@ master_clock_list_ready_stages (ClutterMasterClock *master_clock)
     {
       gint64 update_time = _clutter_stage_get_update_time (l->data);
 
-      /* If a stage has a swap-buffers pending we don't want to draw to it
-       * in case the driver may block the CPU while it waits for the next
-       * backbuffer to become available.
+      /* If a stage has as many swap-buffers pending as its back buffers
+       * allow, it will report an update time of -1: we don't want to draw
+       * to it in case the driver may block the CPU while it waits for the
+       * next backbuffer to become available.
        *
-       * TODO: We should be able to identify if we are running triple or N
-       * buffered and in these cases we can still draw if there is 1 swap
-       * pending so we can hopefully always be ready to swap for the next
-       * vblank and really match the vsync frequency.
+       * When running triple or N buffered the stage can still be drawn
+       * with swaps pending, so we can hopefully always be ready to swap
+       * for the next vblank and really match the vsync frequency.
        */
       if (update_time != -1 && update_time <= master_clock->cur_tick)
         result = g_slist_prepend (result, g_object_ref (l->data));
@@ -239,6 +284,46 @@ master_clock_list_ready_stages (ClutterMasterClock *master_clock)
   return g_slist_reverse (result);
 }
 
+/*
+ * master_clock_get_frame_time:
+ * @master_clock: a #ClutterMasterClock
+ * @stages: the stages being updated
+ *
+ * Computes the time used to advance the timelines for the current
+ * frame: the earliest predicted presentation time of @stages, so that
+ * animations are sampled at the time the frame actually reaches the
+ * screen, or the current tick if no prediction is available.
+ *
+ * Return value: the frame time, in microseconds
+ */
+static gint64
+master_clock_get_frame_time (ClutterMasterClock *master_clock,
+                             GSList             *stages)
+{
+  gint64 frame_time = -1;
+  GSList *l;
+
+  for (l = stages; l != NULL; l = l->next)
+    {
+      gint64 presentation_time = _clutter_stage_get_presentation_time (l->data);
+
+      if (presentation_time != -1 &&
+          (frame_time == -1 || presentation_time < frame_time))
+        frame_time = presentation_time;
+    }
+
+  if (frame_time < master_clock->cur_tick)
+    frame_time = master_clock->cur_tick;
+
+  /* timelines drop a frame if the clock goes backwards, which could
+   * happen when we lose the prediction after having used it
+   */
+  if (frame_time < master_clock->frame_time)
+    frame_time = master_clock->frame_time;
+
+  return frame_time;
+}
+
 static void
 master_clock_reschedule_stage_updates (ClutterMasterClock *master_clock,
                                        GSList             *stages)
@@ -375,6 +460,190 @@ master_clock_process_events (ClutterMasterClock *master_clock,
 #endif
 }
 
+static void
+transition_batch_clear (ClutterTransitionBatch *batch)
+{
+  g_free (batch->timelines);
+  g_free (batch->funcs);
+  g_free (batch->cubic_beziers);
+  g_free (batch->tables);
+  g_free (batch->elapsed);
+  g_free (batch->durations);
+  g_free (batch->progress);
+  g_free (batch->actors);
+  g_free (batch->pspecs);
+  g_free (batch->initial);
+  g_free (batch->final);
+  g_free (batch->values);
+  g_free (batch->is_integer);
+
+  memset (batch, 0, sizeof (ClutterTransitionBatch));
+}
+
+static void
+transition_batch_ensure_size (ClutterTransitionBatch *batch,
+                              guint                   size)
+{
+  if (size <= batch->size)
+    return;
+
+  batch->size = MAX (size, MAX (batch->size * 2, 16));
+
+  batch->timelines = g_renew (ClutterTimeline *, batch->timelines, batch->size);
+  batch->funcs = g_renew (ClutterEasingFunc, batch->funcs, batch->size);
+  batch->cubic_beziers = g_renew (gdouble, batch->cubic_beziers, batch->size * 4);
+  batch->tables = g_renew (ClutterEasingTable *, batch->tables, batch->size);
+  batch->elapsed = g_renew (gdouble, batch->elapsed, batch->size);
+  batch->durations = g_renew (gdouble, batch->durations, batch->size);
+  batch->progress = g_renew (gdouble, batch->progress, batch->size);
+  batch->actors = g_renew (ClutterActor *, batch->actors, batch->size);
+  batch->pspecs = g_renew (GParamSpec *, batch->pspecs, batch->size);
+  batch->initial = g_renew (gdouble, batch->initial, batch->size);
+  batch->final = g_renew (gdouble, batch->final, batch->size);
+  batch->values = g_renew (gdouble, batch->values, batch->size);
+  batch->is_integer = g_renew (gboolean, batch->is_integer, batch->size);
+}
+
+/*
+ * transition_batch_add:
+ * @batch: a #ClutterTransitionBatch
+ * @timeline: a #ClutterTimeline
+ * @tick_time: the time used to advance @timeline, in msecs
+ *
+ * Advances @timeline without emitting the ::new-frame signal, if it is
+ * a transition that can be updated in bulk by
+ * transition_batch_apply().
+ *
+ * Return value: %TRUE if @timeline was added to the batch
+ */
+static gboolean
+transition_batch_add (ClutterTransitionBatch *batch,
+                      ClutterTimeline        *timeline,
+                      gint64                  tick_time)
+{
+  guint i = batch->n_items;
+
+  if (!_clutter_property_transition_is_batchable (timeline))
+    return FALSE;
+
+  transition_batch_ensure_size (batch, i + 1);
+
+  if (!_clutter_timeline_advance_batched (timeline, tick_time,
+                                          &batch->elapsed[i],
+                                          &batch->durations[i],
+                                          &batch->funcs[i],
+                                          &batch->cubic_beziers[i * 4],
+                                          &batch->tables[i]))
+    return FALSE;
+
+  batch->timelines[i] = timeline;
+  batch->n_items += 1;
+
+  return TRUE;
+}
+
+/*
+ * transition_batch_apply:
+ * @batch: a #ClutterTransitionBatch
+ *
+ * Computes the progress and the interpolated value of all the
+ * transitions in @batch, and sets them on the animated actors.
+ *
+ * The results are the same as going through the ::new-frame signal
+ * of each transition: the progress is computed using the same easing
+ * functions, and the values are interpolated using the same formula
+ * as #ClutterInterval.
+ */
+static void
+transition_batch_apply (ClutterTransitionBatch *batch)
+{
+  guint i, n_items = batch->n_items;
+
+  if (n_items == 0)
+    return;
+
+  /* the easing is evaluated first, since it only depends on the time;
+   * the sampled tables are referenced by the batch, as the ::new-frame
+   * handlers of the other timelines may have changed the progress mode
+   */
+  for (i = 0; i < n_items; i++)
+    {
+      const gdouble *cb = &batch->cubic_beziers[i * 4];
+
+      if (batch->tables[i] != NULL)
+        {
+          batch->progress[i] = clutter_easing_table_evaluate (batch->tables[i],
+                                                              batch->elapsed[i],
+                                                              batch->durations[i]);
+          clutter_easing_table_unref (batch->tables[i]);
+          batch->tables[i] = NULL;
+        }
+      else if (G_LIKELY (batch->funcs[i] != NULL))
+        batch->progress[i] = batch->funcs[i] (batch->elapsed[i],
+                                              batch->durations[i]);
+      else
+        batch->progress[i] = clutter_ease_cubic_bezier (batch->elapsed[i],
+                                                        batch->durations[i],
+                                                        cb[0], cb[1],
+                                                        cb[2], cb[3]);
+    }
+
+  /* the intervals are collected after all the other timelines have been
+   * advanced, since their ::new-frame handlers may have changed them
+   */
+  for (i = 0; i < n_items; i++)
+    {
+      ClutterTimeline *timeline = batch->timelines[i];
+
+      batch->actors[i] = NULL;
+
+      if (!clutter_timeline_is_playing (timeline))
+        continue;
+
+      if (!_clutter_property_transition_get_batch_interval (timeline,
+                                                            &batch->actors[i],
+                                                            &batch->pspecs[i],
+                                                            &batch->initial[i],
+                                                            &batch->final[i],
+                                                            &batch->is_integer[i]))
+        {
+          batch->actors[i] = NULL;
+          batch->initial[i] = batch->final[i] = 0.0;
+
+          _clutter_timeline_emit_new_frame (timeline);
+        }
+    }
+
+  for (i = 0; i < n_items; i++)
+    {
+      batch->values[i] = (batch->progress[i] * (batch->final[i] - batch->initial[i]))
+                       + batch->initial[i];
+    }
+
+  for (i = 0; i < n_items; i++)
+    {
+      gdouble value = batch->values[i];
+
+      if (batch->actors[i] == NULL)
+        continue;
+
+      /* a notification handler may have stopped the transition */
+      if (!clutter_timeline_is_playing (batch->timelines[i]))
+        continue;
+
+      if (batch->is_integer[i])
+        value = (guint) value;
+
+      _clutter_actor_set_fast_animatable_double (batch->actors[i],
+                                                 batch->pspecs[i],
+                                                 value);
+    }
+
+  CLUTTER_NOTE (SCHEDULER, "Advanced %u transitions in bulk", n_items);
+
+  batch->n_items = 0;
+}
+
 /*
  * master_clock_advance_timelines:
  * @master_clock: a #ClutterMasterClock
@@ -382,14 +651,18 @@ master_clock_process_events (ClutterMasterClock *master_clock,
  * Advances all the timelines held by the master clock. This function
  * should be called before calling _clutter_stage_do_update() to
  * make sure that all the timelines are advanced and the scene is updated.
+ *
+ * Simple property transitions, which do not have markers, custom
+ * progress functions or handlers connected to the ::new-frame signal,
+ * are advanced together and their values are computed in bulk; all
+ * the other timelines go through _clutter_timeline_do_tick().
  */
 static void
 master_clock_advance_timelines (ClutterMasterClock *master_clock)
 {
   GSList *timelines, *l;
-#ifdef CLUTTER_ENABLE_DEBUG
+  gint64 tick_time;
   gint64 start = g_get_monotonic_time ();
-#endif
 
   CLUTTER_STATIC_TIMER (master_timeline_advance,
                         "Master Clock",
@@ -416,20 +689,32 @@ master_clock_advance_timelines (ClutterMasterClock *master_clock)
    * a timeline might be removed as the direct result of do_tick()
    * and remove_timeline() would not find the timeline, failing
    * and leaving a dangling pointer behind.
+   *
+   * the references are also what keeps the batched transitions
+   * alive until transition_batch_apply() is done with them.
    */
   timelines = g_slist_copy (master_clock->timelines);
   g_slist_foreach (timelines, (GFunc) g_object_ref, NULL);
 
   CLUTTER_TIMER_START (_clutter_uprof_context, master_timeline_advance);
 
+  tick_time = master_clock->frame_time / 1000;
+
   for (l = timelines; l != NULL; l = l->next)
-    _clutter_timeline_do_tick (l->data, master_clock->cur_tick / 1000);
+    {
+      if (!transition_batch_add (&master_clock->batch, l->data, tick_time))
+        _clutter_timeline_do_tick (l->data, tick_time);
+    }
+
+  transition_batch_apply (&master_clock->batch);
 
   CLUTTER_TIMER_STOP (_clutter_uprof_context, master_timeline_advance);
 
   g_slist_foreach (timelines, (GFunc) g_object_unref, NULL);
   g_slist_free (timelines);
 
+  master_clock->timeline_advance = g_get_monotonic_time () - start;
+
 #ifdef CLUTTER_ENABLE_DEBUG
   if (_clutter_diagnostic_enabled ())
     clutter_warn_if_over_budget (master_clock, start, "Animations");
@@ -443,6 +728,7 @@ master_clock_update_stages (ClutterMasterClock *master_clock,
                             GSList             *stages)
 {
   gboolean stages_updated = FALSE;
+  gint64 swap_time = 0;
   GSList *l;
 #ifdef CLUTTER_ENABLE_DEBUG
   gint64 start = g_get_monotonic_time ();
@@ -454,7 +740,25 @@ master_clock_update_stages (ClutterMasterClock *master_clock,
    * is advanced.
    */
   for (l = stages; l != NULL; l = l->next)
-    stages_updated |= _clutter_stage_do_update (l->data);
+    {
+      if (_clutter_stage_do_update (l->data))
+        {
+          /* the stages are painted in sequence, so the render time of
+           * each stage includes all the work done since the frame began;
+           * the swaps are left out, since they may block until the
+           * vblank we are trying to predict
+           */
+          swap_time += _clutter_stage_get_swap_time (l->data);
+          _clutter_stage_record_render_time (l->data,
+                                             g_get_monotonic_time () -
+                                             master_clock->cur_tick -
+                                             swap_time);
+          _clutter_stage_finish_frame_stats (l->data,
+                                             master_clock->cur_tick,
+                                             master_clock->timeline_advance);
+          stages_updated = TRUE;
+        }
+    }
 
   _clutter_run_repaint_functions (CLUTTER_REPAINT_FLAGS_POST_PAINT);
 
@@ -572,6 +876,10 @@ clutter_clock_dispatch (GSource     *source,
    */
   stages = master_clock_list_ready_stages (master_clock);
 
+  /* Sample the animations at the time the frame will be presented */
+  master_clock->frame_time = master_clock_get_frame_time (master_clock,
+                                                          stages);
+
   master_clock->idle = FALSE;
 
   /* Each frame is split into three separate phases: */
@@ -600,6 +908,9 @@ clutter_clock_dispatch (GSource     *source,
 
   master_clock->prev_tick = master_clock->cur_tick;
 
+  if (G_UNLIKELY (_clutter_trace_enabled))
+    _clutter_trace_flush_counters ();
+
   _clutter_threads_release_lock ();
 
   CLUTTER_TIMER_STOP (_clutter_uprof_context, master_dispatch_timer);
@@ -614,6 +925,8 @@ clutter_master_clock_finalize (GObject *gobject)
 
   g_slist_free (master_clock->timelines);
 
+  transition_batch_clear (&master_clock->batch);
+
   G_OBJECT_CLASS (clutter_master_clock_parent_class)->finalize (gobject);
 }
 
@@ -25,6 +25,7 @@
 #define __CLUTTER_MASTER_CLOCK_H__
 
 #include <clutter/clutter-timeline.h>
+#include "clutter-easing.h"
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,14 @@ void                    _clutter_timeline_advance                       (Clutter
 gint64                  _clutter_timeline_get_delta                     (ClutterTimeline    *timeline);
 void                    _clutter_timeline_do_tick                       (ClutterTimeline    *timeline,
                                                                          gint64              tick_time);
+gboolean                _clutter_timeline_advance_batched               (ClutterTimeline    *timeline,
+                                                                         gint64              tick_time,
+                                                                         gdouble            *elapsed,
+                                                                         gdouble            *duration,
+                                                                         ClutterEasingFunc  *func,
+                                                                         gdouble            *cubic_bezier,
+                                                                         ClutterEasingTable **table);
+void                    _clutter_timeline_emit_new_frame                (ClutterTimeline    *timeline);
 
 G_END_DECLS
 
@@ -97,13 +97,15 @@ clutter_path_constraint_update_allocation (ClutterConstraint *constraint,
 {
   ClutterPathConstraint *self = CLUTTER_PATH_CONSTRAINT (constraint);
   gfloat width, height;
-  ClutterKnot position;
+  ClutterPoint position;
   guint knot_id;
 
   if (self->path == NULL)
     return;
 
-  knot_id = clutter_path_get_position (self->path, self->offset, &position);
+  knot_id = clutter_path_get_point (self->path, self->offset,
+                                    &position,
+                                    NULL, NULL);
   clutter_actor_box_get_size (allocation, &width, &height);
   allocation->x1 = position.x;
   allocation->y1 = position.y;
@@ -117,23 +117,35 @@ struct _ClutterPathNodeFull
 
   ClutterBezier *bezier;
 
-  guint length;
+  /* the absolute positions of the start and of the end of the node */
+  ClutterPoint start;
+  ClutterPoint end;
+
+  /* the length of the node, and the length of the path before it */
+  gfloat length;
+  gfloat offset;
 };
 
 struct _ClutterPathPrivate
 {
-  GSList *nodes, *nodes_tail;
+  /* the nodes, stored as ClutterPathNodeFull */
+  GArray *nodes;
   gboolean nodes_dirty;
 
-  guint total_length;
+  gfloat total_length;
+
+  /* the node found by the last position lookup; the progress along
+   * a path is usually monotonic, so the next lookup is likely to end
+   * up in the same node or in the following one
+   */
+  guint last_node;
 };
 
 /* Character tests that don't pay attention to the locale */
 #define clutter_path_isspace(ch) memchr (" \f\n\r\t\v", (ch), 6)
 #define clutter_path_isdigit(ch) ((ch) >= '0' && (ch) <= '9')
 
-static ClutterPathNodeFull *clutter_path_node_full_new (void);
-static void clutter_path_node_full_free (ClutterPathNodeFull *node);
+static void clutter_path_node_full_clear (gpointer data);
 
 static void clutter_path_finalize (GObject *object);
 
@@ -228,6 +240,9 @@ static void
 clutter_path_init (ClutterPath *self)
 {
   self->priv = CLUTTER_PATH_GET_PRIVATE (self);
+
+  self->priv->nodes = g_array_new (FALSE, TRUE, sizeof (ClutterPathNodeFull));
+  g_array_set_clear_func (self->priv->nodes, clutter_path_node_full_clear);
 }
 
 static void
@@ -255,6 +270,7 @@ clutter_path_finalize (GObject *object)
   ClutterPath *self = (ClutterPath *) object;
 
   clutter_path_clear (self);
+  g_array_unref (self->priv->nodes);
 
   G_OBJECT_CLASS (clutter_path_parent_class)->finalize (object);
 }
@@ -315,29 +331,21 @@ clutter_path_clear (ClutterPath *path)
 {
   ClutterPathPrivate *priv = path->priv;
 
-  g_slist_foreach (priv->nodes, (GFunc) clutter_path_node_full_free, NULL);
-  g_slist_free (priv->nodes);
+  g_array_set_size (priv->nodes, 0);
 
-  priv->nodes = priv->nodes_tail = NULL;
   priv->nodes_dirty = TRUE;
 }
 
-/* Takes ownership of the node */
 static void
-clutter_path_add_node_full (ClutterPath         *path,
-                            ClutterPathNodeFull *node)
+clutter_path_append_node (ClutterPath           *path,
+                          const ClutterPathNode *node)
 {
   ClutterPathPrivate *priv = path->priv;
-  GSList *new_node;
-
-  new_node = g_slist_prepend (NULL, node);
+  ClutterPathNodeFull node_full = { { 0, }, };
 
-  if (priv->nodes_tail == NULL)
-    priv->nodes = new_node;
-  else
-    priv->nodes_tail->next = new_node;
+  node_full.k = *node;
 
-  priv->nodes_tail = new_node;
+  g_array_append_val (priv->nodes, node_full);
 
   priv->nodes_dirty = TRUE;
 }
@@ -349,25 +357,23 @@ clutter_path_add_node_helper (ClutterPath         *path,
                               int                  num_coords,
                               ...)
 {
-  ClutterPathNodeFull *node;
+  ClutterPathNode node = { 0, };
   int i;
   va_list ap;
 
-  node = clutter_path_node_full_new ();
-
-  node->k.type = type;
+  node.type = type;
 
   va_start (ap, num_coords);
 
   for (i = 0; i < num_coords; i++)
     {
-      node->k.points[i].x = va_arg (ap, gint);
-      node->k.points[i].y = va_arg (ap, gint);
+      node.points[i].x = va_arg (ap, gint);
+      node.points[i].y = va_arg (ap, gint);
     }
 
   va_end (ap);
 
-  clutter_path_add_node_full (path, node);
+  clutter_path_append_node (path, &node);
 }
 
 /**
@@ -605,14 +611,16 @@ clutter_path_parse_number (const gchar **pin,
 
 static gboolean
 clutter_path_parse_description (const gchar  *p,
-                                GSList      **ret)
+                                GArray      **ret)
 {
-  ClutterPathNodeFull *node;
-  GSList *nodes = NULL;
+  ClutterPathNode *node;
+  GArray *nodes;
 
   if (p == NULL || *p == '\0')
     return FALSE;
 
+  nodes = g_array_new (FALSE, TRUE, sizeof (ClutterPathNode));
+
   while (TRUE)
     {
       /* Skip leading whitespace */
@@ -629,45 +637,45 @@ clutter_path_parse_description (const gchar  *p,
         case 'm':
         case 'L':
         case 'l':
-          node = clutter_path_node_full_new ();
-          nodes = g_slist_prepend (nodes, node);
+          g_array_set_size (nodes, nodes->len + 1);
+          node = &g_array_index (nodes, ClutterPathNode, nodes->len - 1);
 
-          node->k.type = (*p == 'M' ? CLUTTER_PATH_MOVE_TO :
+          node->type = (*p == 'M' ? CLUTTER_PATH_MOVE_TO :
                           *p == 'm' ? CLUTTER_PATH_REL_MOVE_TO :
                           *p == 'L' ? CLUTTER_PATH_LINE_TO :
                           CLUTTER_PATH_REL_LINE_TO);
           p++;
 
-          if (!clutter_path_parse_number (&p, FALSE, &node->k.points[0].x) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[0].y))
+          if (!clutter_path_parse_number (&p, FALSE, &node->points[0].x) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[0].y))
             goto fail;
           break;
 
         case 'C':
         case 'c':
-          node = clutter_path_node_full_new ();
-          nodes = g_slist_prepend (nodes, node);
+          g_array_set_size (nodes, nodes->len + 1);
+          node = &g_array_index (nodes, ClutterPathNode, nodes->len - 1);
 
-          node->k.type = (*p == 'C' ? CLUTTER_PATH_CURVE_TO :
+          node->type = (*p == 'C' ? CLUTTER_PATH_CURVE_TO :
                           CLUTTER_PATH_REL_CURVE_TO);
           p++;
 
-          if (!clutter_path_parse_number (&p, FALSE, &node->k.points[0].x) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[0].y) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[1].x) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[1].y) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[2].x) ||
-              !clutter_path_parse_number (&p, TRUE, &node->k.points[2].y))
+          if (!clutter_path_parse_number (&p, FALSE, &node->points[0].x) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[0].y) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[1].x) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[1].y) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[2].x) ||
+              !clutter_path_parse_number (&p, TRUE, &node->points[2].y))
             goto fail;
           break;
 
         case 'Z':
         case 'z':
-          node = clutter_path_node_full_new ();
-          nodes = g_slist_prepend (nodes, node);
+          g_array_set_size (nodes, nodes->len + 1);
+          node = &g_array_index (nodes, ClutterPathNode, nodes->len - 1);
           p++;
 
-          node->k.type = CLUTTER_PATH_CLOSE;
+          node->type = CLUTTER_PATH_CLOSE;
           break;
 
         default:
@@ -675,34 +683,25 @@ clutter_path_parse_description (const gchar  *p,
         }
     }
 
-  *ret = g_slist_reverse (nodes);
+  *ret = nodes;
   return TRUE;
 
  fail:
-  g_slist_foreach (nodes, (GFunc) clutter_path_node_full_free, NULL);
-  g_slist_free (nodes);
+  g_array_unref (nodes);
   return FALSE;
 }
 
-/* Takes ownership of the node list */
+/* Takes ownership of the node array */
 static void
 clutter_path_add_nodes (ClutterPath *path,
-                        GSList      *nodes)
+                        GArray      *nodes)
 {
-  ClutterPathPrivate *priv = path->priv;
+  guint i;
 
-  if (priv->nodes_tail == NULL)
-    priv->nodes = nodes;
-  else
-    priv->nodes_tail->next = nodes;
-
-  while (nodes)
-    {
-      priv->nodes_tail = nodes;
-      nodes = nodes->next;
-    }
+  for (i = 0; i < nodes->len; i++)
+    clutter_path_append_node (path, &g_array_index (nodes, ClutterPathNode, i));
 
-  priv->nodes_dirty = TRUE;
+  g_array_unref (nodes);
 }
 
 /**
@@ -759,7 +758,7 @@ gboolean
 clutter_path_add_string (ClutterPath *path,
                          const gchar *str)
 {
-  GSList *nodes;
+  GArray *nodes;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -787,16 +786,11 @@ void
 clutter_path_add_node (ClutterPath           *path,
                        const ClutterPathNode *node)
 {
-  ClutterPathNodeFull *node_full;
-
   g_return_if_fail (CLUTTER_IS_PATH (path));
   g_return_if_fail (node != NULL);
   g_return_if_fail (CLUTTER_PATH_NODE_TYPE_IS_VALID (node->type));
 
-  node_full = clutter_path_node_full_new ();
-  node_full->k = *node;
-
-  clutter_path_add_node_full (path, node_full);
+  clutter_path_append_node (path, node);
 }
 
 /**
@@ -933,7 +927,7 @@ clutter_path_get_n_nodes (ClutterPath *path)
 
   priv = path->priv;
 
-  return g_slist_length (priv->nodes);
+  return priv->nodes->len;
 }
 
 /**
@@ -951,18 +945,15 @@ clutter_path_get_node (ClutterPath     *path,
                        guint            index_,
                        ClutterPathNode *node)
 {
-  ClutterPathNodeFull *node_full;
   ClutterPathPrivate *priv;
 
   g_return_if_fail (CLUTTER_IS_PATH (path));
 
   priv = path->priv;
 
-  node_full = g_slist_nth_data (priv->nodes, index_);
+  g_return_if_fail (index_ < priv->nodes->len);
 
-  g_return_if_fail (node_full != NULL);
-
-  *node = node_full->k;
+  *node = g_array_index (priv->nodes, ClutterPathNodeFull, index_).k;
 }
 
 /**
@@ -984,12 +975,19 @@ GSList *
 clutter_path_get_nodes (ClutterPath *path)
 {
   ClutterPathPrivate *priv;
+  GSList *nodes = NULL;
+  guint i;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), NULL);
 
   priv = path->priv;
 
-  return g_slist_copy (priv->nodes);
+  for (i = priv->nodes->len; i > 0; i--)
+    nodes = g_slist_prepend (nodes, &g_array_index (priv->nodes,
+                                                    ClutterPathNodeFull,
+                                                    i - 1).k);
+
+  return nodes;
 }
 
 /**
@@ -1008,12 +1006,15 @@ clutter_path_foreach (ClutterPath         *path,
                       gpointer             user_data)
 {
   ClutterPathPrivate *priv;
+  guint i;
 
   g_return_if_fail (CLUTTER_IS_PATH (path));
 
   priv = path->priv;
 
-  g_slist_foreach (priv->nodes, (GFunc) callback, user_data);
+  for (i = 0; i < priv->nodes->len; i++)
+    callback (&g_array_index (priv->nodes, ClutterPathNodeFull, i).k,
+              user_data);
 }
 
 /**
@@ -1033,7 +1034,7 @@ clutter_path_insert_node (ClutterPath           *path,
                           const ClutterPathNode *node)
 {
   ClutterPathPrivate *priv;
-  ClutterPathNodeFull *node_full;
+  ClutterPathNodeFull node_full = { { 0, }, };
 
   g_return_if_fail (CLUTTER_IS_PATH (path));
   g_return_if_fail (node != NULL);
@@ -1041,15 +1042,12 @@ clutter_path_insert_node (ClutterPath           *path,
 
   priv = path->priv;
 
-  node_full = clutter_path_node_full_new ();
-  node_full->k = *node;
+  if (index_ < 0 || (guint) index_ > priv->nodes->len)
+    index_ = priv->nodes->len;
 
-  priv->nodes = g_slist_insert (priv->nodes, node_full, index_);
+  node_full.k = *node;
 
-  if (priv->nodes_tail == NULL)
-    priv->nodes_tail = priv->nodes;
-  else if (priv->nodes_tail->next)
-    priv->nodes_tail = priv->nodes_tail->next;
+  g_array_insert_val (priv->nodes, index_, node_full);
 
   priv->nodes_dirty = TRUE;
 }
@@ -1068,28 +1066,14 @@ clutter_path_remove_node (ClutterPath *path,
                           guint        index_)
 {
   ClutterPathPrivate *priv;
-  GSList *node, *prev = NULL;
 
   g_return_if_fail (CLUTTER_IS_PATH (path));
 
   priv = path->priv;
 
-  for (node = priv->nodes; node && index_--; node = node->next)
-    prev = node;
-
-  if (node)
+  if (index_ < priv->nodes->len)
     {
-      clutter_path_node_full_free (node->data);
-
-      if (prev)
-        prev->next = node->next;
-      else
-        priv->nodes = node->next;
-
-      if (node == priv->nodes_tail)
-        priv->nodes_tail = prev;
-
-      g_slist_free_1 (node);
+      g_array_remove_index (priv->nodes, index_);
 
       priv->nodes_dirty = TRUE;
     }
@@ -1119,8 +1103,9 @@ clutter_path_replace_node (ClutterPath           *path,
 
   priv = path->priv;
 
-  if ((node_full = g_slist_nth_data (priv->nodes, index_)))
+  if (index_ < priv->nodes->len)
     {
+      node_full = &g_array_index (priv->nodes, ClutterPathNodeFull, index_);
       node_full->k = *node;
 
       priv->nodes_dirty = TRUE;
@@ -1146,7 +1131,7 @@ gboolean
 clutter_path_set_description (ClutterPath *path,
                               const gchar *str)
 {
-  GSList *nodes;
+  GArray *nodes;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -1178,7 +1163,7 @@ clutter_path_get_description (ClutterPath *path)
 {
   ClutterPathPrivate *priv;
   GString *str;
-  GSList *l;
+  guint n;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), NULL);
 
@@ -1186,9 +1171,11 @@ clutter_path_get_description (ClutterPath *path)
 
   str = g_string_new ("");
 
-  for (l = priv->nodes; l; l = l->next)
+  for (n = 0; n < priv->nodes->len; n++)
     {
-      ClutterPathNodeFull *node = l->data;
+      ClutterPathNodeFull *node = &g_array_index (priv->nodes,
+                                                  ClutterPathNodeFull,
+                                                  n);
       gchar letter = '?';
       gint params = 0;
       gint i;
@@ -1244,134 +1231,256 @@ clutter_path_get_description (ClutterPath *path)
   return g_string_free (str, FALSE);
 }
 
-static guint
-clutter_path_node_distance (const ClutterKnot *start,
-                            const ClutterKnot *end)
-{
-  gint64 x_d, y_d;
-  float t;
-
-  g_return_val_if_fail (start != NULL, 0);
-  g_return_val_if_fail (end != NULL, 0);
-
-  if (clutter_knot_equal (start, end))
-    return 0;
-
-  x_d = end->x - start->x;
-  y_d = end->y - start->y;
-
-  t = floorf (sqrtf ((x_d * x_d) + (y_d * y_d)));
-
-  return (guint) t;
-}
-
 static void
 clutter_path_ensure_node_data (ClutterPath *path)
 {
   ClutterPathPrivate *priv = path->priv;
+  ClutterKnot last_position = { 0, 0 };
+  ClutterKnot loop_start = { 0, 0 };
+  ClutterKnot points[3];
+  guint i;
 
   /* Recalculate the nodes data if has changed */
-  if (priv->nodes_dirty)
+  if (!priv->nodes_dirty)
+    return;
+
+  priv->total_length = 0;
+  priv->last_node = 0;
+
+  for (i = 0; i < priv->nodes->len; i++)
     {
-      GSList *l;
-      ClutterKnot last_position = { 0, 0 };
-      ClutterKnot loop_start = { 0, 0 };
-      ClutterKnot points[3];
+      ClutterPathNodeFull *node = &g_array_index (priv->nodes,
+                                                  ClutterPathNodeFull,
+                                                  i);
+      gboolean relative = (node->k.type & CLUTTER_PATH_RELATIVE) != 0;
 
-      priv->total_length = 0;
+      clutter_point_init (&node->start, last_position.x, last_position.y);
+      node->offset = priv->total_length;
+      node->length = 0;
 
-      for (l = priv->nodes; l; l = l->next)
+      switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
         {
-          ClutterPathNodeFull *node = l->data;
-          gboolean relative = (node->k.type & CLUTTER_PATH_RELATIVE) != 0;
+        case CLUTTER_PATH_MOVE_TO:
+          if (relative)
+            {
+              last_position.x += node->k.points[0].x;
+              last_position.y += node->k.points[0].y;
+            }
+          else
+            last_position = node->k.points[0];
+
+          loop_start = last_position;
 
-          switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
+          /* the position of a move is the one it moves to */
+          clutter_point_init (&node->start, last_position.x, last_position.y);
+          break;
+
+        case CLUTTER_PATH_LINE_TO:
+          if (relative)
             {
-            case CLUTTER_PATH_MOVE_TO:
-              node->length = 0;
+              last_position.x += node->k.points[0].x;
+              last_position.y += node->k.points[0].y;
+            }
+          else
+            last_position = node->k.points[0];
+          break;
 
-              /* Store the actual position in point[1] */
-              if (relative)
+        case CLUTTER_PATH_CURVE_TO:
+          /* Convert to a bezier curve */
+          if (node->bezier == NULL)
+            node->bezier = _clutter_bezier_new ();
+
+          if (relative)
+            {
+              int j;
+
+              for (j = 0; j < 3; j++)
                 {
-                  node->k.points[1].x = last_position.x + node->k.points[0].x;
-                  node->k.points[1].y = last_position.y + node->k.points[0].y;
+                  points[j].x = last_position.x + node->k.points[j].x;
+                  points[j].y = last_position.y + node->k.points[j].y;
                 }
-              else
-                node->k.points[1] = node->k.points[0];
+            }
+          else
+            memcpy (points, node->k.points, sizeof (ClutterKnot) * 3);
 
-              last_position = node->k.points[1];
-              loop_start = node->k.points[1];
-              break;
+          _clutter_bezier_init (node->bezier,
+                                last_position.x, last_position.y,
+                                points[0].x, points[0].y,
+                                points[1].x, points[1].y,
+                                points[2].x, points[2].y);
 
-            case CLUTTER_PATH_LINE_TO:
-              /* Use point[1] as the start point and point[2] as the end
-                 point */
-              node->k.points[1] = last_position;
+          last_position = points[2];
 
-              if (relative)
-                {
-                  node->k.points[2].x = (node->k.points[1].x
-                                         + node->k.points[0].x);
-                  node->k.points[2].y = (node->k.points[1].y
-                                         + node->k.points[0].y);
-                }
-              else
-                node->k.points[2] = node->k.points[0];
+          node->length = _clutter_bezier_get_length (node->bezier);
+          break;
 
-              last_position = node->k.points[2];
+        case CLUTTER_PATH_CLOSE:
+          /* Convert to a line to from last_point to loop_start */
+          last_position = loop_start;
+          break;
+        }
 
-              node->length = clutter_path_node_distance (node->k.points + 1,
-                                                         node->k.points + 2);
-              break;
+      clutter_point_init (&node->end, last_position.x, last_position.y);
 
-            case CLUTTER_PATH_CURVE_TO:
-              /* Convert to a bezier curve */
-              if (node->bezier == NULL)
-                node->bezier = _clutter_bezier_new ();
+      if ((node->k.type & ~CLUTTER_PATH_RELATIVE) == CLUTTER_PATH_LINE_TO ||
+          node->k.type == CLUTTER_PATH_CLOSE)
+        node->length = clutter_point_distance (&node->start, &node->end,
+                                               NULL, NULL);
 
-              if (relative)
-                {
-                  int i;
+      priv->total_length += node->length;
+    }
 
-                  for (i = 0; i < 3; i++)
-                    {
-                      points[i].x = last_position.x + node->k.points[i].x;
-                      points[i].y = last_position.y + node->k.points[i].y;
-                    }
-                }
-              else
-                memcpy (points, node->k.points, sizeof (ClutterKnot) * 3);
+  priv->nodes_dirty = FALSE;
+}
+
+static inline gboolean
+clutter_path_node_covers (const ClutterPathNodeFull *nodes,
+                          guint                      n_nodes,
+                          guint                      index_,
+                          gfloat                     distance)
+{
+  /* a distance is covered by the first node ending after it, or by
+   * the last node if the distance is past the end of the path
+   */
+  if (index_ + 1 < n_nodes &&
+      nodes[index_].offset + nodes[index_].length <= distance)
+    return FALSE;
+
+  if (index_ > 0 &&
+      nodes[index_ - 1].offset + nodes[index_ - 1].length > distance)
+    return FALSE;
+
+  return TRUE;
+}
+
+/*
+ * clutter_path_find_node:
+ * @path: a #ClutterPath
+ * @distance: a distance along the path
+ *
+ * Finds the node covering @distance, using the node found by the
+ * previous lookup as a hint, or a binary search on the offsets of
+ * the nodes.
+ *
+ * Return value: the index of the node
+ */
+static guint
+clutter_path_find_node (ClutterPath *path,
+                        gfloat       distance)
+{
+  ClutterPathPrivate *priv = path->priv;
+  const ClutterPathNodeFull *nodes;
+  guint n_nodes, lo, hi;
 
-              _clutter_bezier_init (node->bezier,
-                                    last_position.x, last_position.y,
-                                    points[0].x, points[0].y,
-                                    points[1].x, points[1].y,
-                                    points[2].x, points[2].y);
+  nodes = (const ClutterPathNodeFull *) priv->nodes->data;
+  n_nodes = priv->nodes->len;
 
-              last_position = points[2];
+  for (lo = priv->last_node; lo < n_nodes && lo < priv->last_node + 2; lo++)
+    if (clutter_path_node_covers (nodes, n_nodes, lo, distance))
+      goto out;
 
-              node->length = _clutter_bezier_get_length (node->bezier);
+  lo = 0;
+  hi = n_nodes - 1;
 
-              break;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
 
-            case CLUTTER_PATH_CLOSE:
-              /* Convert to a line to from last_point to loop_start */
-              node->k.points[1] = last_position;
-              node->k.points[2] = loop_start;
-              last_position = node->k.points[2];
+      if (nodes[mid].offset + nodes[mid].length > distance)
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
 
-              node->length = clutter_path_node_distance (node->k.points + 1,
-                                                         node->k.points + 2);
-              break;
-            }
+out:
+  priv->last_node = lo;
+
+  return lo;
+}
+
+static void
+clutter_path_node_full_get_point (const ClutterPathNodeFull *node,
+                                  gfloat                     distance,
+                                  ClutterPoint              *position,
+                                  ClutterPoint              *tangent)
+{
+  if (tangent != NULL)
+    clutter_point_init (tangent, 1.f, 0.f);
+
+  switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
+    {
+    case CLUTTER_PATH_MOVE_TO:
+      *position = node->end;
+      break;
 
-          priv->total_length += node->length;
+    case CLUTTER_PATH_LINE_TO:
+    case CLUTTER_PATH_CLOSE:
+      if (node->length == 0)
+        *position = node->start;
+      else
+        {
+          gfloat dx = (node->end.x - node->start.x) / node->length;
+          gfloat dy = (node->end.y - node->start.y) / node->length;
+
+          position->x = node->start.x + dx * distance;
+          position->y = node->start.y + dy * distance;
+
+          if (tangent != NULL)
+            clutter_point_init (tangent, dx, dy);
         }
+      break;
 
-      priv->nodes_dirty = FALSE;
+    case CLUTTER_PATH_CURVE_TO:
+      if (node->length == 0)
+        *position = node->end;
+      else
+        _clutter_bezier_get_point (node->bezier,
+                                   distance / node->length,
+                                   position,
+                                   tangent);
+      break;
     }
 }
 
+static guint
+clutter_path_get_point_internal (ClutterPath  *path,
+                                 gdouble       progress,
+                                 ClutterPoint *position,
+                                 ClutterPoint *tangent)
+{
+  ClutterPathPrivate *priv = path->priv;
+  ClutterPathNodeFull *node;
+  gfloat distance;
+  guint node_num;
+
+  clutter_path_ensure_node_data (path);
+
+  /* Special case if the path is empty, just return 0,0 for want of
+     something better */
+  if (priv->nodes->len == 0)
+    {
+      clutter_point_init (position, 0.f, 0.f);
+
+      if (tangent != NULL)
+        clutter_point_init (tangent, 1.f, 0.f);
+
+      return 0;
+    }
+
+  /* Convert the progress to a length along the path */
+  distance = progress * priv->total_length;
+
+  node_num = clutter_path_find_node (path, distance);
+  node = &g_array_index (priv->nodes, ClutterPathNodeFull, node_num);
+
+  /* Convert the distance to a distance along the node */
+  distance = CLAMP (distance - node->offset, 0, node->length);
+
+  clutter_path_node_full_get_point (node, distance, position, tangent);
+
+  return node_num;
+}
+
 /**
  * clutter_path_get_position:
  * @path: a #ClutterPath
@@ -1382,6 +1491,8 @@ clutter_path_ensure_node_data (ClutterPath *path)
  * 0.0 is the beginning and 1.0 is the end of the path. An
  * interpolated position is then stored in @position.
  *
+ * See also clutter_path_get_point().
+ *
  * Return value: index of the node used to calculate the position.
  *
  * Since: 1.0
@@ -1391,79 +1502,71 @@ clutter_path_get_position (ClutterPath *path,
                            gdouble progress,
                            ClutterKnot *position)
 {
-  ClutterPathPrivate *priv;
-  GSList *l;
-  guint point_distance, length = 0, node_num = 0;
-  ClutterPathNodeFull *node;
+  ClutterPoint point;
+  guint node_num;
 
   g_return_val_if_fail (CLUTTER_IS_PATH (path), 0);
   g_return_val_if_fail (progress >= 0.0 && progress <= 1.0, 0);
 
-  priv = path->priv;
+  node_num = clutter_path_get_point_internal (path, progress, &point, NULL);
 
-  clutter_path_ensure_node_data (path);
+  position->x = point.x;
+  position->y = point.y;
 
-  /* Special case if the path is empty, just return 0,0 for want of
-     something better */
-  if (priv->nodes == NULL)
-    {
-      memset (position, 0, sizeof (ClutterKnot));
-      return 0;
-    }
-
-  /* Convert the progress to a length along the path */
-  point_distance = progress * priv->total_length;
+  return node_num;
+}
 
-  /* Find the node that covers this point */
-  for (l = priv->nodes;
-       l->next && point_distance >= (((ClutterPathNodeFull *) l->data)->length
-                                     + length);
-       l = l->next)
-    {
-      length += ((ClutterPathNodeFull *) l->data)->length;
-      node_num++;
-    }
+/**
+ * clutter_path_get_point:
+ * @path: a #ClutterPath
+ * @progress: a position along the path as a fraction of its length
+ * @position: (out caller-allocates) (allow-none): return location for
+ *   the position
+ * @tangent: (out caller-allocates) (allow-none): return location for
+ *   the direction of the path at @position
+ * @normal: (out caller-allocates) (allow-none): return location for
+ *   the normal of the path at @position
+ *
+ * Like clutter_path_get_position(), but the position is not rounded
+ * to integer coordinates, which avoids jittering when moving slowly
+ * along long paths.
+ *
+ * The @tangent is a unit vector pointing in the direction the path is
+ * travelled; the @normal is the @tangent rotated by 90 degrees, which
+ * points to the right of the direction of travel in the coordinate
+ * space of the stage. Actors following the path can use them to
+ * orient themselves. On nodes with no length, like the ones created
+ * by clutter_path_add_move_to(), the tangent points along the X axis.
+ *
+ * Return value: index of the node used to calculate the position
+ *
+ * Since: 1.16
+ */
+guint
+clutter_path_get_point (ClutterPath  *path,
+                        gdouble       progress,
+                        ClutterPoint *position,
+                        ClutterPoint *tangent,
+                        ClutterPoint *normal)
+{
+  ClutterPoint point, direction;
+  guint node_num;
 
-  node = l->data;
+  g_return_val_if_fail (CLUTTER_IS_PATH (path), 0);
+  g_return_val_if_fail (progress >= 0.0 && progress <= 1.0, 0);
 
-  /* Convert the point distance to a distance along the node */
-  point_distance -= length;
-  if (point_distance > node->length)
-    point_distance = node->length;
+  node_num = clutter_path_get_point_internal (path, progress,
+                                              &point,
+                                              &direction);
 
-  switch (node->k.type & ~CLUTTER_PATH_RELATIVE)
-    {
-    case CLUTTER_PATH_MOVE_TO:
-      *position = node->k.points[1];
-      break;
+  if (position != NULL)
+    *position = point;
 
-    case CLUTTER_PATH_LINE_TO:
-    case CLUTTER_PATH_CLOSE:
-      if (node->length == 0)
-        *position = node->k.points[1];
-      else
-        {
-          position->x = (node->k.points[1].x
-                         + ((node->k.points[2].x - node->k.points[1].x)
-                            * (gint) point_distance / (gint) node->length));
-          position->y = (node->k.points[1].y
-                         + ((node->k.points[2].y - node->k.points[1].y)
-                            * (gint) point_distance / (gint) node->length));
-        }
-      break;
+  if (tangent != NULL)
+    *tangent = direction;
 
-    case CLUTTER_PATH_CURVE_TO:
-      if (node->length == 0)
-        *position = node->k.points[2];
-      else
-        {
-          _clutter_bezier_advance (node->bezier,
-                                   point_distance * CLUTTER_BEZIER_MAX_LENGTH
-                                   / node->length,
-                                   position);
-        }
-      break;
-    }
+  if (normal != NULL)
+    clutter_point_init (normal, -direction.y, direction.x);
 
   return node_num;
 }
@@ -1488,19 +1591,13 @@ clutter_path_get_length (ClutterPath *path)
   return path->priv->total_length;
 }
 
-static ClutterPathNodeFull *
-clutter_path_node_full_new (void)
-{
-  return g_slice_new0 (ClutterPathNodeFull);
-}
-
 static void
-clutter_path_node_full_free (ClutterPathNodeFull *node)
+clutter_path_node_full_clear (gpointer data)
 {
+  ClutterPathNodeFull *node = data;
+
   if (node->bezier)
     _clutter_bezier_free (node->bezier);
-
-  g_slice_free (ClutterPathNodeFull, node);
 }
 
 /**
@@ -149,6 +149,12 @@ guint        clutter_path_get_position         (ClutterPath           *path,
                                                 gdouble                progress,
                                                 ClutterKnot           *position);
 guint        clutter_path_get_length           (ClutterPath           *path);
+CLUTTER_AVAILABLE_IN_1_16
+guint        clutter_path_get_point            (ClutterPath           *path,
+                                                gdouble                progress,
+                                                ClutterPoint          *position,
+                                                ClutterPoint          *tangent,
+                                                ClutterPoint          *normal);
 
 G_END_DECLS
 
@@ -228,6 +228,10 @@ ClutterActor *  _clutter_get_actor_by_id        (ClutterStage *stage,
                                                  guint32       actor_id);
 
 gboolean        _clutter_get_sync_to_vblank     (void);
+guint           _clutter_get_max_pending_swaps  (void);
+guint           _clutter_get_frame_stats_interval (void);
+
+void            _clutter_input_record_event     (const ClutterEvent *event);
 
 /* use this function as the accumulator if you have a signal with
  * a G_TYPE_BOOLEAN return value; this will stop the emission as
@@ -265,6 +269,9 @@ void  _clutter_util_fully_transform_vertices (const CoglMatrix    *modelview,
 void _clutter_util_rectangle_union (const cairo_rectangle_int_t *src1,
                                     const cairo_rectangle_int_t *src2,
                                     cairo_rectangle_int_t       *dest);
+gboolean _clutter_util_rectangle_intersection (const cairo_rectangle_int_t *src1,
+                                               const cairo_rectangle_int_t *src2,
+                                               cairo_rectangle_int_t       *dest);
 
 
 struct _ClutterVertex4
@@ -324,6 +331,11 @@ gboolean        _clutter_run_progress_function  (GType gtype,
                                                  const GValue *final,
                                                  gdouble progress,
                                                  GValue *retval);
+ClutterProgressFunc _clutter_get_progress_function (GType gtype);
+
+gboolean        _clutter_color_has_default_progress (void);
+
+void            _clutter_text_clear_shared_layouts (void);
 
 G_END_DECLS
 
@@ -24,6 +24,8 @@
 
 #include <glib.h>
 
+#include "clutter-trace-private.h"
+
 G_BEGIN_DECLS
 
 typedef enum {
@@ -38,12 +40,21 @@ typedef enum {
 extern UProfContext *   _clutter_uprof_context;
 extern guint            clutter_profile_flags;
 
-#define CLUTTER_STATIC_TIMER    UPROF_STATIC_TIMER
-#define CLUTTER_STATIC_COUNTER  UPROF_STATIC_COUNTER
-#define CLUTTER_COUNTER_INC     UPROF_COUNTER_INC
-#define CLUTTER_COUNTER_DEC     UPROF_COUNTER_DEC
-#define CLUTTER_TIMER_START     UPROF_TIMER_START
-#define CLUTTER_TIMER_STOP      UPROF_TIMER_STOP
+/* the timers and counters are also recorded by the tracer, see
+ * clutter_trace_start()
+ */
+#define CLUTTER_STATIC_TIMER(A,B,C,D,E) \
+  UPROF_STATIC_TIMER (A,B,C,D,E); _CLUTTER_TRACE_STATIC_TIMER (A,C)
+#define CLUTTER_STATIC_COUNTER(A,B,C,D) \
+  UPROF_STATIC_COUNTER (A,B,C,D); _CLUTTER_TRACE_STATIC_COUNTER (A,B)
+#define CLUTTER_COUNTER_INC(A,B)        G_STMT_START { \
+  UPROF_COUNTER_INC (A,B); _CLUTTER_TRACE_COUNTER_ADD (B,1); } G_STMT_END
+#define CLUTTER_COUNTER_DEC(A,B)        G_STMT_START { \
+  UPROF_COUNTER_DEC (A,B); _CLUTTER_TRACE_COUNTER_ADD (B,-1); } G_STMT_END
+#define CLUTTER_TIMER_START(A,B)        G_STMT_START { \
+  UPROF_TIMER_START (A,B); _CLUTTER_TRACE_TIMER_START (B); } G_STMT_END
+#define CLUTTER_TIMER_STOP(A,B)         G_STMT_START { \
+  _CLUTTER_TRACE_TIMER_STOP (B); UPROF_TIMER_STOP (A,B); } G_STMT_END
 
 void    _clutter_uprof_init             (void);
 void    _clutter_profile_suspend        (void);
@@ -51,17 +62,15 @@ void    _clutter_profile_resume         (void);
 
 #else /* CLUTTER_ENABLE_PROFILE */
 
-#ifdef __COUNTER__
-#define CLUTTER_STATIC_TIMER(A,B,C,D,E) extern void G_PASTE (_clutter_dummy_decl, __COUNTER__) (void)
-#define CLUTTER_STATIC_COUNTER(A,B,C,D) extern void G_PASTE (_clutter_dummy_decl, __COUNTER__) (void)
-#else
-#define CLUTTER_STATIC_TIMER(A,B,C,D,E) extern void G_PASTE (_clutter_dummy_decl, __LINE__) (void)
-#define CLUTTER_STATIC_COUNTER(A,B,C,D) extern void G_PASTE (_clutter_dummy_decl, __LINE__) (void)
-#endif
-#define CLUTTER_COUNTER_INC(A,B)        G_STMT_START { } G_STMT_END
-#define CLUTTER_COUNTER_DEC(A,B)        G_STMT_START { } G_STMT_END
-#define CLUTTER_TIMER_START(A,B)        G_STMT_START { } G_STMT_END
-#define CLUTTER_TIMER_STOP(A,B)         G_STMT_START { } G_STMT_END
+/* without UProf, the timers and counters are only recorded by the
+ * tracer, see clutter_trace_start()
+ */
+#define CLUTTER_STATIC_TIMER(A,B,C,D,E) _CLUTTER_TRACE_STATIC_TIMER (A,C)
+#define CLUTTER_STATIC_COUNTER(A,B,C,D) _CLUTTER_TRACE_STATIC_COUNTER (A,B)
+#define CLUTTER_COUNTER_INC(A,B)        _CLUTTER_TRACE_COUNTER_ADD (B,1)
+#define CLUTTER_COUNTER_DEC(A,B)        _CLUTTER_TRACE_COUNTER_ADD (B,-1)
+#define CLUTTER_TIMER_START(A,B)        _CLUTTER_TRACE_TIMER_START (B)
+#define CLUTTER_TIMER_STOP(A,B)         _CLUTTER_TRACE_TIMER_STOP (B)
 
 #define _clutter_uprof_init             G_STMT_START { } G_STMT_END
 #define _clutter_profile_suspend        G_STMT_START { } G_STMT_END
@@ -36,10 +36,13 @@
 
 #include "clutter-property-transition.h"
 
+#include "clutter-actor-private.h"
 #include "clutter-animatable.h"
+#include "clutter-color.h"
 #include "clutter-debug.h"
 #include "clutter-interval.h"
 #include "clutter-private.h"
+#include "clutter-property-transition-private.h"
 #include "clutter-transition.h"
 
 struct _ClutterPropertyTransitionPrivate
@@ -47,6 +50,11 @@ struct _ClutterPropertyTransitionPrivate
   char *property_name;
 
   GParamSpec *pspec;
+
+  /* whether the property can be set directly on a ClutterActor,
+   * see _clutter_actor_has_fast_animatable_property()
+   */
+  guint fast_path : 1;
 };
 
 enum
@@ -94,6 +102,18 @@ clutter_property_transition_ensure_interval (ClutterPropertyTransition *transiti
     }
 }
 
+static inline void
+clutter_property_transition_update_fast_path (ClutterPropertyTransition *transition,
+                                              ClutterAnimatable         *animatable)
+{
+  ClutterPropertyTransitionPrivate *priv = transition->priv;
+
+  priv->fast_path = priv->pspec != NULL &&
+                    CLUTTER_IS_ACTOR (animatable) &&
+                    _clutter_actor_has_fast_animatable_property (CLUTTER_ACTOR (animatable),
+                                                                 priv->pspec);
+}
+
 static void
 clutter_property_transition_attached (ClutterTransition *transition,
                                       ClutterAnimatable *animatable)
@@ -108,6 +128,8 @@ clutter_property_transition_attached (ClutterTransition *transition,
   priv->pspec =
     clutter_animatable_find_property (animatable, priv->property_name);
 
+  clutter_property_transition_update_fast_path (self, animatable);
+
   if (priv->pspec == NULL)
     return;
 
@@ -125,7 +147,102 @@ clutter_property_transition_detached (ClutterTransition *transition,
   ClutterPropertyTransition *self = CLUTTER_PROPERTY_TRANSITION (transition);
   ClutterPropertyTransitionPrivate *priv = self->priv;
 
-  priv->pspec = NULL; 
+  priv->pspec = NULL;
+  priv->fast_path = FALSE;
+}
+
+/*
+ * clutter_property_transition_compute_fast_value:
+ *
+ * Interpolates and sets the value of the property directly on the
+ * actor, without going through #GValue and #ClutterAnimatable. The
+ * results must be the same as the default implementation of the
+ * #ClutterInterval class, so we bail out if the interval is a subclass
+ * or if a progress function has been registered for the value type.
+ *
+ * Return value: %TRUE if the value was set
+ */
+static gboolean
+clutter_property_transition_compute_fast_value (ClutterPropertyTransition *transition,
+                                                ClutterAnimatable         *animatable,
+                                                ClutterInterval           *interval,
+                                                gdouble                    progress)
+{
+  ClutterPropertyTransitionPrivate *priv = transition->priv;
+  ClutterActor *actor = CLUTTER_ACTOR (animatable);
+  const GValue *initial, *final;
+  GType value_type;
+
+  if (G_OBJECT_TYPE (interval) != CLUTTER_TYPE_INTERVAL)
+    return FALSE;
+
+  value_type = clutter_interval_get_value_type (interval);
+  if (value_type != G_PARAM_SPEC_VALUE_TYPE (priv->pspec))
+    return FALSE;
+
+  initial = clutter_interval_peek_initial_value (interval);
+  final = clutter_interval_peek_final_value (interval);
+
+  if (value_type == CLUTTER_TYPE_COLOR)
+    {
+      ClutterColor res = { 0, };
+
+      if (!_clutter_color_has_default_progress ())
+        return FALSE;
+
+      clutter_color_interpolate (clutter_value_get_color (initial),
+                                 clutter_value_get_color (final),
+                                 progress,
+                                 &res);
+
+      _clutter_actor_set_fast_animatable_color (actor, priv->pspec, &res);
+
+      return TRUE;
+    }
+
+  if (_clutter_has_progress_function (value_type))
+    return FALSE;
+
+  switch (value_type)
+    {
+    case G_TYPE_UINT:
+      {
+        guint ia, ib, res;
+
+        ia = g_value_get_uint (initial);
+        ib = g_value_get_uint (final);
+
+        res = (progress * (ib - (gdouble) ia)) + ia;
+
+        _clutter_actor_set_fast_animatable_double (actor, priv->pspec, res);
+      }
+      return TRUE;
+
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      {
+        gdouble ia, ib, res;
+
+        if (value_type == G_TYPE_DOUBLE)
+          {
+            ia = g_value_get_double (initial);
+            ib = g_value_get_double (final);
+          }
+        else
+          {
+            ia = g_value_get_float (initial);
+            ib = g_value_get_float (final);
+          }
+
+        res = (progress * (ib - ia)) + ia;
+
+        _clutter_actor_set_fast_animatable_double (actor, priv->pspec, res);
+      }
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
 }
 
 static void
@@ -146,6 +263,12 @@ clutter_property_transition_compute_value (ClutterTransition *transition,
 
   clutter_property_transition_ensure_interval (self, animatable, interval);
 
+  if (priv->fast_path &&
+      clutter_property_transition_compute_fast_value (self, animatable,
+                                                      interval,
+                                                      progress))
+    return;
+
   p_type = G_PARAM_SPEC_VALUE_TYPE (priv->pspec);
   i_type = clutter_interval_get_value_type (interval);
 
@@ -329,6 +452,7 @@ clutter_property_transition_set_property_name (ClutterPropertyTransition *transi
   g_free (priv->property_name);
   priv->property_name = g_strdup (property_name);
   priv->pspec = NULL;
+  priv->fast_path = FALSE;
 
   animatable =
     clutter_transition_get_animatable (CLUTTER_TRANSITION (transition));
@@ -336,6 +460,7 @@ clutter_property_transition_set_property_name (ClutterPropertyTransition *transi
     {
       priv->pspec = clutter_animatable_find_property (animatable,
                                                       priv->property_name);
+      clutter_property_transition_update_fast_path (transition, animatable);
     }
 
   g_object_notify_by_pspec (G_OBJECT (transition),
@@ -362,3 +487,123 @@ clutter_property_transition_get_property_name (ClutterPropertyTransition *transi
 
   return transition->priv->property_name;
 }
+
+/*< private >
+ * _clutter_property_transition_is_batchable:
+ * @timeline: a #ClutterTimeline
+ *
+ * Checks whether @timeline is a #ClutterPropertyTransition whose
+ * frames can be computed by the master clock in bulk, instead of
+ * going through the #ClutterTimeline::new-frame signal; see
+ * _clutter_property_transition_get_batch_interval().
+ *
+ * The values of the interval are only checked by
+ * _clutter_property_transition_get_batch_interval(), since the
+ * ::new-frame handlers of the other timelines may change them.
+ *
+ * Return value: %TRUE if the transition can be batched
+ */
+gboolean
+_clutter_property_transition_is_batchable (ClutterTimeline *timeline)
+{
+  ClutterPropertyTransitionPrivate *priv;
+  ClutterInterval *interval;
+
+  /* subclasses may override ClutterTransition.compute_value() */
+  if (G_OBJECT_TYPE (timeline) != CLUTTER_TYPE_PROPERTY_TRANSITION)
+    return FALSE;
+
+  priv = CLUTTER_PROPERTY_TRANSITION (timeline)->priv;
+  if (!priv->fast_path)
+    return FALSE;
+
+  interval = clutter_transition_get_interval (CLUTTER_TRANSITION (timeline));
+
+  return interval != NULL && G_OBJECT_TYPE (interval) == CLUTTER_TYPE_INTERVAL;
+}
+
+/*< private >
+ * _clutter_property_transition_get_batch_interval:
+ * @timeline: a #ClutterTimeline
+ * @actor: (out): return location for the animated actor
+ * @pspec: (out): return location for the animated property
+ * @initial: (out): return location for the initial value
+ * @final: (out): return location for the final value
+ * @is_integer: (out): return location for whether the interpolated
+ *   value should be truncated to an integer
+ *
+ * Retrieves the state of a batchable transition. Only scalar
+ * properties are handled here; the interpolated value must be set
+ * using _clutter_actor_set_fast_animatable_double(), and it must be
+ * computed using the same formula as #ClutterInterval, that is:
+ *
+ * |[
+ *   value = (progress * (final - initial)) + initial;
+ * ]|
+ *
+ * Return value: %TRUE if the transition can be batched
+ */
+gboolean
+_clutter_property_transition_get_batch_interval (ClutterTimeline  *timeline,
+                                                 ClutterActor    **actor,
+                                                 GParamSpec      **pspec,
+                                                 gdouble          *initial,
+                                                 gdouble          *final,
+                                                 gboolean         *is_integer)
+{
+  ClutterPropertyTransitionPrivate *priv;
+  ClutterInterval *interval;
+  const GValue *initial_p, *final_p;
+  GType value_type;
+
+  if (!_clutter_property_transition_is_batchable (timeline))
+    return FALSE;
+
+  priv = CLUTTER_PROPERTY_TRANSITION (timeline)->priv;
+  interval = clutter_transition_get_interval (CLUTTER_TRANSITION (timeline));
+
+  /* an invalid interval goes through ::new-frame, like the
+   * transitions that are not batched
+   */
+  if (!clutter_interval_is_valid (interval))
+    return FALSE;
+
+  value_type = clutter_interval_get_value_type (interval);
+  if (value_type != G_PARAM_SPEC_VALUE_TYPE (priv->pspec))
+    return FALSE;
+
+  if (_clutter_has_progress_function (value_type))
+    return FALSE;
+
+  initial_p = clutter_interval_peek_initial_value (interval);
+  final_p = clutter_interval_peek_final_value (interval);
+
+  switch (value_type)
+    {
+    case G_TYPE_UINT:
+      *initial = g_value_get_uint (initial_p);
+      *final = g_value_get_uint (final_p);
+      *is_integer = TRUE;
+      break;
+
+    case G_TYPE_FLOAT:
+      *initial = g_value_get_float (initial_p);
+      *final = g_value_get_float (final_p);
+      *is_integer = FALSE;
+      break;
+
+    case G_TYPE_DOUBLE:
+      *initial = g_value_get_double (initial_p);
+      *final = g_value_get_double (final_p);
+      *is_integer = FALSE;
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  *actor = CLUTTER_ACTOR (clutter_transition_get_animatable (CLUTTER_TRANSITION (timeline)));
+  *pspec = priv->pspec;
+
+  return TRUE;
+}
@@ -0,0 +1,1024 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The ClutterScript cache stores the object definitions parsed from a
+ * UI definition file, so that loading the same file again does not
+ * require parsing the JSON data, nor resolving the type names through
+ * the symbols of the process.
+ *
+ * The definitions are recorded by the parser while loading the file,
+ * before they are used to construct the objects, and saved at the end
+ * of a successful load. Each definition is stored with its members;
+ * the values of the properties are kept as a tree of typed values,
+ * since they can only be parsed once the object class is known.
+ *
+ * The cache file is only valid for the same version of Clutter and
+ * for the same architecture. It is validated against the modification
+ * time and size of the UI definition file and, if the modification
+ * time changed, against the checksum of its contents.
+ *
+ * All the values are stored in host byte order:
+ *
+ *   header:
+ *     magic             8 bytes, "CLTSCRPT"
+ *     format version    uint32
+ *     Clutter version   uint32
+ *     byte order mark   uint32
+ *     source mtime      int64
+ *     source size       uint64
+ *     source checksum   string
+ *     fake ids          uint32
+ *     objects           uint32
+ *     type functions    string, for each object
+ *   object:
+ *     id, type, type_func                string
+ *     is_stage, is_stage_default         uint8
+ *     children                           uint32, string for each child
+ *     signals                            uint32, signal for each signal
+ *     properties                         uint32, (string, node) for each
+ *   signal:
+ *     name, handler, object, state, target  string
+ *     flags                                 uint32
+ *     is_handler, warp_to                   uint8
+ *   node:
+ *     type              uint8
+ *     value             depending on the type
+ *   string:
+ *     length            uint32, or one of the markers below
+ *     contents          length + 1 bytes, including the trailing NUL
+ *
+ * Fake ids are generated for the object definitions without an "id"
+ * member, and depend on the state of the ClutterScript loading the
+ * file; they are stored as indices, and generated again when loading
+ * the cache.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "clutter-actor.h"
+#include "clutter-debug.h"
+#include "clutter-script-private.h"
+#include "clutter-stage.h"
+#include "clutter-version.h"
+
+#define CACHE_MAGIC             "CLTSCRPT"
+#define CACHE_MAGIC_LEN         8
+#define CACHE_VERSION           2
+#define CACHE_BYTE_ORDER        0x01020304
+
+#define CACHE_STRING_NULL       G_MAXUINT32
+#define CACHE_STRING_FAKE_ID    (G_MAXUINT32 - 1)
+
+/* corrupted files should not be able to exhaust the stack */
+#define CACHE_MAX_DEPTH         256
+
+enum
+{
+  CACHE_NODE_NULL,
+  CACHE_NODE_OBJECT,
+  CACHE_NODE_ARRAY,
+  CACHE_NODE_INT,
+  CACHE_NODE_DOUBLE,
+  CACHE_NODE_BOOLEAN,
+  CACHE_NODE_STRING
+};
+
+struct _ClutterScriptCache
+{
+  /* the object definitions */
+  GByteArray *data;
+
+  /* the ids of the recorded definitions, in order */
+  GPtrArray *ids;
+
+  /* fake id -> index + 1 */
+  GHashTable *fake_ids;
+
+  /* the state of the file when the load started */
+  gint64 mtime;
+  guint64 size;
+
+  guint is_valid : 1;
+};
+
+typedef struct {
+  const guint8 *cursor;
+  const guint8 *end;
+
+  gchar **fake_ids;
+  guint n_fake_ids;
+
+  gboolean error;
+} CacheReader;
+
+static void
+cache_write (GByteArray   *data,
+             gconstpointer value,
+             gsize         size)
+{
+  g_byte_array_append (data, value, size);
+}
+
+static void
+cache_write_uint8 (GByteArray *data,
+                   guint8      value)
+{
+  cache_write (data, &value, sizeof (value));
+}
+
+static void
+cache_write_uint32 (GByteArray *data,
+                    guint32     value)
+{
+  cache_write (data, &value, sizeof (value));
+}
+
+static void
+cache_write_int64 (GByteArray *data,
+                   gint64      value)
+{
+  cache_write (data, &value, sizeof (value));
+}
+
+static void
+cache_write_string (GByteArray  *data,
+                    const gchar *str)
+{
+  gsize len;
+
+  if (str == NULL)
+    {
+      cache_write_uint32 (data, CACHE_STRING_NULL);
+      return;
+    }
+
+  len = strlen (str);
+
+  cache_write_uint32 (data, len);
+  cache_write (data, str, len + 1);
+}
+
+/* strings that may be fake ids: the ids themselves, and the string
+ * values of the nodes, which include the "id" members of the nested
+ * definitions
+ */
+static void
+cache_write_id (ClutterScriptCache *cache,
+                const gchar        *str)
+{
+  guint index_ = 0;
+
+  if (str != NULL)
+    index_ = GPOINTER_TO_UINT (g_hash_table_lookup (cache->fake_ids, str));
+
+  if (index_ == 0)
+    {
+      cache_write_string (cache->data, str);
+      return;
+    }
+
+  cache_write_uint32 (cache->data, CACHE_STRING_FAKE_ID);
+  cache_write_uint32 (cache->data, index_ - 1);
+}
+
+static void
+cache_write_node (ClutterScriptCache *cache,
+                  JsonNode           *node)
+{
+  GList *members, *l;
+  JsonObject *object;
+  JsonArray *array;
+  guint i, len;
+
+  switch (JSON_NODE_TYPE (node))
+    {
+    case JSON_NODE_NULL:
+      cache_write_uint8 (cache->data, CACHE_NODE_NULL);
+      break;
+
+    case JSON_NODE_OBJECT:
+      object = json_node_get_object (node);
+      members = json_object_get_members (object);
+
+      cache_write_uint8 (cache->data, CACHE_NODE_OBJECT);
+      cache_write_uint32 (cache->data, g_list_length (members));
+
+      for (l = members; l != NULL; l = l->next)
+        {
+          cache_write_string (cache->data, l->data);
+          cache_write_node (cache, json_object_get_member (object, l->data));
+        }
+
+      g_list_free (members);
+      break;
+
+    case JSON_NODE_ARRAY:
+      array = json_node_get_array (node);
+      len = json_array_get_length (array);
+
+      cache_write_uint8 (cache->data, CACHE_NODE_ARRAY);
+      cache_write_uint32 (cache->data, len);
+
+      for (i = 0; i < len; i++)
+        cache_write_node (cache, json_array_get_element (array, i));
+      break;
+
+    case JSON_NODE_VALUE:
+      switch (json_node_get_value_type (node))
+        {
+        case G_TYPE_INT64:
+          cache_write_uint8 (cache->data, CACHE_NODE_INT);
+          cache_write_int64 (cache->data, json_node_get_int (node));
+          break;
+
+        case G_TYPE_DOUBLE:
+          {
+            gdouble value = json_node_get_double (node);
+
+            cache_write_uint8 (cache->data, CACHE_NODE_DOUBLE);
+            cache_write (cache->data, &value, sizeof (value));
+          }
+          break;
+
+        case G_TYPE_BOOLEAN:
+          cache_write_uint8 (cache->data, CACHE_NODE_BOOLEAN);
+          cache_write_uint8 (cache->data, json_node_get_boolean (node));
+          break;
+
+        case G_TYPE_STRING:
+          cache_write_uint8 (cache->data, CACHE_NODE_STRING);
+          cache_write_id (cache, json_node_get_string (node));
+          break;
+
+        default:
+          CLUTTER_NOTE (SCRIPT, "Unsupported value of type '%s'",
+                        g_type_name (json_node_get_value_type (node)));
+          cache->is_valid = FALSE;
+          break;
+        }
+      break;
+    }
+}
+
+static gboolean
+cache_read (CacheReader *reader,
+            gpointer     value,
+            gsize        size)
+{
+  if (reader->error || (gsize) (reader->end - reader->cursor) < size)
+    {
+      reader->error = TRUE;
+      memset (value, 0, size);
+      return FALSE;
+    }
+
+  memcpy (value, reader->cursor, size);
+  reader->cursor += size;
+
+  return TRUE;
+}
+
+static guint8
+cache_read_uint8 (CacheReader *reader)
+{
+  guint8 value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+static guint32
+cache_read_uint32 (CacheReader *reader)
+{
+  guint32 value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+static gint64
+cache_read_int64 (CacheReader *reader)
+{
+  gint64 value;
+
+  cache_read (reader, &value, sizeof (value));
+
+  return value;
+}
+
+/* returns a newly allocated string, or %NULL */
+static gchar *
+cache_read_string (CacheReader *reader)
+{
+  const gchar *str;
+  guint32 len;
+
+  len = cache_read_uint32 (reader);
+  if (reader->error || len == CACHE_STRING_NULL)
+    return NULL;
+
+  if (len == CACHE_STRING_FAKE_ID)
+    {
+      guint32 index_ = cache_read_uint32 (reader);
+
+      if (reader->error || index_ >= reader->n_fake_ids)
+        {
+          reader->error = TRUE;
+          return NULL;
+        }
+
+      return g_strdup (reader->fake_ids[index_]);
+    }
+
+  if ((gsize) (reader->end - reader->cursor) <= len ||
+      reader->cursor[len] != '\0')
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  str = (const gchar *) reader->cursor;
+  reader->cursor += len + 1;
+
+  return g_strdup (str);
+}
+
+/* reads a count of items which take at least min_size bytes each */
+static guint32
+cache_read_count (CacheReader *reader,
+                  gsize        min_size)
+{
+  guint32 count = cache_read_uint32 (reader);
+
+  if (count > (gsize) (reader->end - reader->cursor) / min_size)
+    {
+      reader->error = TRUE;
+      return 0;
+    }
+
+  return count;
+}
+
+static JsonNode *
+cache_read_node (CacheReader *reader,
+                 guint        depth)
+{
+  JsonNode *node = NULL;
+  JsonObject *object;
+  JsonArray *array;
+  guint32 i, len;
+  gchar *str;
+
+  if (depth > CACHE_MAX_DEPTH)
+    {
+      reader->error = TRUE;
+      return NULL;
+    }
+
+  switch (cache_read_uint8 (reader))
+    {
+    case CACHE_NODE_NULL:
+      node = json_node_new (JSON_NODE_NULL);
+      break;
+
+    case CACHE_NODE_OBJECT:
+      len = cache_read_count (reader, sizeof (guint32) + 1);
+      object = json_object_new ();
+
+      for (i = 0; i < len && !reader->error; i++)
+        {
+          gchar *name = cache_read_string (reader);
+          JsonNode *member = cache_read_node (reader, depth + 1);
+
+          if (name != NULL && member != NULL)
+            json_object_set_member (object, name, member);
+          else if (member != NULL)
+            json_node_free (member);
+
+          g_free (name);
+        }
+
+      node = json_node_new (JSON_NODE_OBJECT);
+      json_node_take_object (node, object);
+      break;
+
+    case CACHE_NODE_ARRAY:
+      len = cache_read_count (reader, 1);
+      array = json_array_sized_new (len);
+
+      for (i = 0; i < len && !reader->error; i++)
+        {
+          JsonNode *element = cache_read_node (reader, depth + 1);
+
+          if (element != NULL)
+            json_array_add_element (array, element);
+        }
+
+      node = json_node_new (JSON_NODE_ARRAY);
+      json_node_take_array (node, array);
+      break;
+
+    case CACHE_NODE_INT:
+      node = json_node_new (JSON_NODE_VALUE);
+      json_node_set_int (node, cache_read_int64 (reader));
+      break;
+
+    case CACHE_NODE_DOUBLE:
+      {
+        gdouble value;
+
+        cache_read (reader, &value, sizeof (value));
+
+        node = json_node_new (JSON_NODE_VALUE);
+        json_node_set_double (node, value);
+      }
+      break;
+
+    case CACHE_NODE_BOOLEAN:
+      node = json_node_new (JSON_NODE_VALUE);
+      json_node_set_boolean (node, cache_read_uint8 (reader));
+      break;
+
+    case CACHE_NODE_STRING:
+      str = cache_read_string (reader);
+
+      node = json_node_new (JSON_NODE_VALUE);
+      json_node_set_string (node, str);
+
+      g_free (str);
+      break;
+
+    default:
+      reader->error = TRUE;
+      break;
+    }
+
+  if (reader->error && node != NULL)
+    {
+      json_node_free (node);
+      node = NULL;
+    }
+
+  return node;
+}
+
+static ObjectInfo *
+cache_read_object (CacheReader   *reader,
+                   ClutterScript *script,
+                   const gchar   *type_symbol)
+{
+  ObjectInfo *oinfo;
+  guint32 i, len;
+
+  oinfo = g_slice_new0 (ObjectInfo);
+  oinfo->merge_id = _clutter_script_get_last_merge_id (script);
+  oinfo->id = cache_read_string (reader);
+  oinfo->class_name = cache_read_string (reader);
+  oinfo->type_func = cache_read_string (reader);
+  oinfo->is_stage = cache_read_uint8 (reader);
+  oinfo->is_stage_default = cache_read_uint8 (reader);
+  oinfo->is_actor = oinfo->is_stage;
+  oinfo->has_unresolved = TRUE;
+
+  len = cache_read_count (reader, sizeof (guint32));
+  for (i = 0; i < len && !reader->error; i++)
+    oinfo->children = g_list_prepend (oinfo->children,
+                                      cache_read_string (reader));
+
+  oinfo->children = g_list_reverse (oinfo->children);
+
+  len = cache_read_count (reader, 5 * sizeof (guint32) + 6);
+  for (i = 0; i < len && !reader->error; i++)
+    {
+      SignalInfo *sinfo = g_slice_new0 (SignalInfo);
+
+      sinfo->name = cache_read_string (reader);
+      sinfo->handler = cache_read_string (reader);
+      sinfo->object = cache_read_string (reader);
+      sinfo->state = cache_read_string (reader);
+      sinfo->target = cache_read_string (reader);
+      sinfo->flags = cache_read_uint32 (reader);
+      sinfo->is_handler = cache_read_uint8 (reader);
+      sinfo->warp_to = cache_read_uint8 (reader);
+
+      oinfo->signals = g_list_prepend (oinfo->signals, sinfo);
+    }
+
+  oinfo->signals = g_list_reverse (oinfo->signals);
+
+  len = cache_read_count (reader, sizeof (guint32) + 1);
+  for (i = 0; i < len && !reader->error; i++)
+    {
+      PropertyInfo *pinfo = g_slice_new0 (PropertyInfo);
+
+      pinfo->name = cache_read_string (reader);
+      pinfo->node = cache_read_node (reader, 0);
+
+      if (pinfo->name != NULL)
+        {
+          pinfo->is_child = g_str_has_prefix (pinfo->name, "child::");
+          pinfo->is_layout = g_str_has_prefix (pinfo->name, "layout::");
+        }
+
+      oinfo->properties = g_list_prepend (oinfo->properties, pinfo);
+    }
+
+  oinfo->properties = g_list_reverse (oinfo->properties);
+
+  if (reader->error || oinfo->id == NULL || oinfo->class_name == NULL)
+    {
+      reader->error = TRUE;
+      object_info_free (oinfo);
+      return NULL;
+    }
+
+  /* skip the type name resolution if the type is already registered,
+   * or use the type function found when the cache was saved
+   */
+  if (oinfo->type_func == NULL)
+    {
+      oinfo->gtype = g_type_from_name (oinfo->class_name);
+
+      if (oinfo->gtype == G_TYPE_INVALID && type_symbol != NULL)
+        oinfo->type_func = g_strdup (type_symbol);
+    }
+
+  if (oinfo->gtype != G_TYPE_INVALID)
+    {
+      oinfo->is_actor = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_ACTOR);
+      if (oinfo->is_actor)
+        oinfo->is_stage = g_type_is_a (oinfo->gtype, CLUTTER_TYPE_STAGE);
+    }
+
+  return oinfo;
+}
+
+/* the modification time is in nanoseconds, though its resolution
+ * depends on the platform and on the file system
+ */
+static gboolean
+cache_get_file_info (const gchar *filename,
+                     gint64      *mtime,
+                     guint64     *size)
+{
+  GStatBuf buf;
+
+  if (g_stat (filename, &buf) < 0)
+    return FALSE;
+
+  *mtime = (gint64) buf.st_mtime * G_GINT64_CONSTANT (1000000000);
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+  *mtime += buf.st_mtim.tv_nsec;
+#endif
+  *size = buf.st_size;
+
+  return TRUE;
+}
+
+static gchar *
+cache_get_checksum (const gchar *filename,
+                    guint64      size)
+{
+  gchar *contents, *retval;
+  gsize length;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL))
+    return NULL;
+
+  if (length != size)
+    retval = NULL;
+  else
+    retval = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                          (const guchar *) contents,
+                                          length);
+
+  g_free (contents);
+
+  return retval;
+}
+
+/*< private >
+ * _clutter_script_cache_new:
+ * @filename: the UI definition file about to be loaded
+ *
+ * Creates a new #ClutterScriptCache, to record the definitions parsed
+ * from @filename.
+ *
+ * Return value: the newly created #ClutterScriptCache
+ */
+ClutterScriptCache *
+_clutter_script_cache_new (const gchar *filename)
+{
+  ClutterScriptCache *cache = g_slice_new0 (ClutterScriptCache);
+
+  cache->data = g_byte_array_new ();
+  cache->ids = g_ptr_array_new_with_free_func (g_free);
+  cache->fake_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free,
+                                           NULL);
+  cache->is_valid = cache_get_file_info (filename, &cache->mtime, &cache->size);
+
+  return cache;
+}
+
+void
+_clutter_script_cache_free (ClutterScriptCache *cache)
+{
+  g_byte_array_unref (cache->data);
+  g_ptr_array_unref (cache->ids);
+  g_hash_table_destroy (cache->fake_ids);
+
+  g_slice_free (ClutterScriptCache, cache);
+}
+
+void
+_clutter_script_cache_add_fake_id (ClutterScriptCache *cache,
+                                   const gchar        *fake_id)
+{
+  guint index_ = g_hash_table_size (cache->fake_ids) + 1;
+
+  g_hash_table_insert (cache->fake_ids,
+                       g_strdup (fake_id),
+                       GUINT_TO_POINTER (index_));
+}
+
+void
+_clutter_script_cache_add_object (ClutterScriptCache *cache,
+                                  ObjectInfo         *oinfo)
+{
+  GList *l;
+
+  if (!cache->is_valid)
+    return;
+
+  g_ptr_array_add (cache->ids, g_strdup (oinfo->id));
+
+  cache_write_id (cache, oinfo->id);
+  cache_write_string (cache->data, oinfo->class_name);
+  cache_write_string (cache->data, oinfo->type_func);
+  cache_write_uint8 (cache->data, oinfo->is_stage);
+  cache_write_uint8 (cache->data, oinfo->is_stage_default);
+
+  cache_write_uint32 (cache->data, g_list_length (oinfo->children));
+  for (l = oinfo->children; l != NULL; l = l->next)
+    cache_write_id (cache, l->data);
+
+  cache_write_uint32 (cache->data, g_list_length (oinfo->signals));
+  for (l = oinfo->signals; l != NULL; l = l->next)
+    {
+      SignalInfo *sinfo = l->data;
+
+      cache_write_string (cache->data, sinfo->name);
+      cache_write_string (cache->data, sinfo->handler);
+      cache_write_id (cache, sinfo->object);
+      cache_write_string (cache->data, sinfo->state);
+      cache_write_string (cache->data, sinfo->target);
+      cache_write_uint32 (cache->data, sinfo->flags);
+      cache_write_uint8 (cache->data, sinfo->is_handler);
+      cache_write_uint8 (cache->data, sinfo->warp_to);
+    }
+
+  cache_write_uint32 (cache->data, g_list_length (oinfo->properties));
+  for (l = oinfo->properties; l != NULL; l = l->next)
+    {
+      PropertyInfo *pinfo = l->data;
+
+      cache_write_string (cache->data, pinfo->name);
+      cache_write_node (cache, pinfo->node);
+    }
+}
+
+void
+_clutter_script_cache_invalidate (ClutterScriptCache *cache)
+{
+  cache->is_valid = FALSE;
+}
+
+/*< private >
+ * _clutter_script_cache_get_file:
+ * @cache_directory: the directory containing the cache files
+ * @filename: the path of a UI definition file
+ *
+ * Retrieves the path of the cache file for @filename.
+ *
+ * Return value: a newly allocated string
+ */
+gchar *
+_clutter_script_cache_get_file (const gchar *cache_directory,
+                                const gchar *filename)
+{
+  gchar *path, *checksum, *basename, *retval;
+
+  if (g_path_is_absolute (filename))
+    path = g_strdup (filename);
+  else
+    {
+      gchar *cwd = g_get_current_dir ();
+
+      path = g_build_filename (cwd, filename, NULL);
+      g_free (cwd);
+    }
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, path, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  retval = g_build_filename (cache_directory, basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+  g_free (path);
+
+  return retval;
+}
+
+/*< private >
+ * _clutter_script_cache_save:
+ * @cache: a #ClutterScriptCache
+ * @script: the #ClutterScript that loaded @filename
+ * @filename: the UI definition file
+ * @cache_file: the path of the cache file
+ *
+ * Saves the definitions recorded while loading @filename. Failures
+ * are not fatal, since the file can still be loaded without a cache.
+ */
+void
+_clutter_script_cache_save (ClutterScriptCache *cache,
+                            ClutterScript      *script,
+                            const gchar        *filename,
+                            const gchar        *cache_file)
+{
+  GByteArray *header;
+  GError *error;
+  gchar *checksum, *dirname;
+  gint64 mtime;
+  guint64 size;
+  guint i, n_fake_ids;
+
+  if (!cache->is_valid)
+    {
+      CLUTTER_NOTE (SCRIPT, "The definitions of '%s' cannot be cached",
+                    filename);
+      return;
+    }
+
+  /* the file must not have changed while we were parsing it */
+  if (!cache_get_file_info (filename, &mtime, &size) ||
+      mtime != cache->mtime ||
+      size != cache->size)
+    return;
+
+  checksum = cache_get_checksum (filename, size);
+  if (checksum == NULL)
+    return;
+
+  header = g_byte_array_sized_new (256 + cache->data->len);
+
+  cache_write (header, CACHE_MAGIC, CACHE_MAGIC_LEN);
+  cache_write_uint32 (header, CACHE_VERSION);
+  cache_write_uint32 (header, CLUTTER_VERSION_HEX);
+  cache_write_uint32 (header, CACHE_BYTE_ORDER);
+  cache_write_int64 (header, mtime);
+  cache_write_int64 (header, size);
+  cache_write_string (header, checksum);
+
+  n_fake_ids = g_hash_table_size (cache->fake_ids);
+  cache_write_uint32 (header, n_fake_ids);
+  cache_write_uint32 (header, cache->ids->len);
+
+  /* store the type functions resolved from the class names */
+  for (i = 0; i < cache->ids->len; i++)
+    {
+      const gchar *id_ = g_ptr_array_index (cache->ids, i);
+      ObjectInfo *oinfo = _clutter_script_get_object_info (script, id_);
+      gchar *symbol = NULL;
+
+      if (oinfo != NULL &&
+          oinfo->type_func == NULL &&
+          oinfo->gtype != G_TYPE_INVALID)
+        {
+          symbol = _clutter_script_get_symbol_for_class (oinfo->class_name);
+
+          if (_clutter_script_get_type_from_symbol (symbol) != oinfo->gtype)
+            {
+              g_free (symbol);
+              symbol = NULL;
+            }
+        }
+
+      cache_write_string (header, symbol);
+      g_free (symbol);
+    }
+
+  g_byte_array_append (header, cache->data->data, cache->data->len);
+
+  dirname = g_path_get_dirname (cache_file);
+  if (g_mkdir_with_parents (dirname, 0700) < 0)
+    {
+      CLUTTER_NOTE (SCRIPT, "Unable to create the cache directory '%s': %s",
+                    dirname,
+                    g_strerror (errno));
+      goto out;
+    }
+
+  error = NULL;
+  if (!g_file_set_contents (cache_file,
+                            (const gchar *) header->data,
+                            header->len,
+                            &error))
+    {
+      CLUTTER_NOTE (SCRIPT, "Unable to save the cache file '%s': %s",
+                    cache_file,
+                    error->message);
+      g_error_free (error);
+      goto out;
+    }
+
+  CLUTTER_NOTE (SCRIPT, "Saved %u definitions of '%s' in '%s' (%u bytes)",
+                cache->ids->len,
+                filename,
+                cache_file,
+                header->len);
+
+out:
+  g_free (dirname);
+  g_free (checksum);
+  g_byte_array_unref (header);
+}
+
+/*< private >
+ * _clutter_script_cache_load:
+ * @script: a #ClutterScript
+ * @filename: the UI definition file
+ * @cache_file: the path of the cache file
+ *
+ * Loads the definitions of @filename from @cache_file, if it exists
+ * and it is still valid, and constructs the objects.
+ *
+ * Return value: %TRUE if the definitions were loaded, and %FALSE if
+ *   @filename should be parsed instead
+ */
+gboolean
+_clutter_script_cache_load (ClutterScript *script,
+                            const gchar   *filename,
+                            const gchar   *cache_file)
+{
+  GMappedFile *mapped_file;
+  CacheReader reader = { NULL, };
+  gchar **type_symbols = NULL;
+  gchar magic[CACHE_MAGIC_LEN];
+  GList *objects = NULL, *l;
+  gchar *checksum = NULL;
+  gint64 mtime, file_mtime, cache_mtime;
+  guint64 size, file_size, cache_size;
+  guint32 i, n_objects = 0;
+  gboolean retval = FALSE;
+
+  mapped_file = g_mapped_file_new (cache_file, FALSE, NULL);
+  if (mapped_file == NULL)
+    return FALSE;
+
+  reader.cursor = (const guint8 *) g_mapped_file_get_contents (mapped_file);
+  reader.end = reader.cursor + g_mapped_file_get_length (mapped_file);
+
+  cache_read (&reader, magic, CACHE_MAGIC_LEN);
+  if (reader.error ||
+      memcmp (magic, CACHE_MAGIC, CACHE_MAGIC_LEN) != 0 ||
+      cache_read_uint32 (&reader) != CACHE_VERSION ||
+      cache_read_uint32 (&reader) != CLUTTER_VERSION_HEX ||
+      cache_read_uint32 (&reader) != CACHE_BYTE_ORDER)
+    {
+      CLUTTER_NOTE (SCRIPT, "Ignoring incompatible cache file '%s'",
+                    cache_file);
+      goto out;
+    }
+
+  mtime = cache_read_int64 (&reader);
+  size = cache_read_int64 (&reader);
+  checksum = cache_read_string (&reader);
+
+  if (reader.error ||
+      !cache_get_file_info (filename, &file_mtime, &file_size) ||
+      size != file_size)
+    goto out;
+
+  /* the modification time is only trusted if the file was last
+   * modified before the cache was written; otherwise it might have
+   * changed again within the resolution of the timestamps, so the
+   * checksums are compared, as they are when the file was touched
+   */
+  if (mtime != file_mtime ||
+      !cache_get_file_info (cache_file, &cache_mtime, &cache_size) ||
+      file_mtime >= cache_mtime)
+    {
+      gchar *file_checksum = cache_get_checksum (filename, file_size);
+      gboolean is_same;
+
+      is_same = g_strcmp0 (checksum, file_checksum) == 0;
+      g_free (file_checksum);
+
+      if (!is_same)
+        {
+          CLUTTER_NOTE (SCRIPT, "The cache file '%s' is out of date",
+                        cache_file);
+          goto out;
+        }
+    }
+
+  reader.n_fake_ids = cache_read_count (&reader, 1);
+  n_objects = cache_read_count (&reader, sizeof (guint32));
+  if (reader.error)
+    goto out;
+
+  type_symbols = g_new0 (gchar *, n_objects + 1);
+  for (i = 0; i < n_objects; i++)
+    type_symbols[i] = cache_read_string (&reader);
+
+  reader.fake_ids = g_new0 (gchar *, reader.n_fake_ids + 1);
+  for (i = 0; i < reader.n_fake_ids; i++)
+    reader.fake_ids[i] = _clutter_script_generate_fake_id (script);
+
+  for (i = 0; i < n_objects && !reader.error; i++)
+    {
+      ObjectInfo *oinfo = cache_read_object (&reader, script, type_symbols[i]);
+
+      if (oinfo == NULL)
+        break;
+
+      objects = g_list_prepend (objects, oinfo);
+
+      /* merging into the objects already defined is left to the parser */
+      if (_clutter_script_get_object_info (script, oinfo->id) != NULL)
+        reader.error = TRUE;
+    }
+
+  if (reader.error || reader.cursor != reader.end)
+    {
+      CLUTTER_NOTE (SCRIPT, "Ignoring invalid cache file '%s'", cache_file);
+      g_list_free_full (objects, object_info_free);
+      goto out;
+    }
+
+  objects = g_list_reverse (objects);
+
+  for (l = objects; l != NULL; l = l->next)
+    {
+      ObjectInfo *oinfo = l->data;
+
+      _clutter_script_add_object_info (script, oinfo);
+
+      if (!clutter_script_get_lazy_construction (script))
+        _clutter_script_construct_object (script, oinfo);
+    }
+
+  g_list_free (objects);
+
+  _clutter_script_resolve_objects (script);
+
+  CLUTTER_NOTE (SCRIPT, "Loaded %u definitions of '%s' from '%s'",
+                n_objects,
+                filename,
+                cache_file);
+
+  retval = TRUE;
+
+out:
+  g_strfreev (reader.fake_ids);
+
+  /* some of the symbols are NULL */
+  for (i = 0; type_symbols != NULL && i < n_objects; i++)
+    g_free (type_symbols[i]);
+
+  g_free (type_symbols);
+  g_free (checksum);
+  g_mapped_file_unref (mapped_file);
+
+  return retval;
+}
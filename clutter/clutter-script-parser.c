@@ -88,19 +88,12 @@ _clutter_script_get_type_from_symbol (const gchar *symbol)
   return gtype;
 }
 
-GType
-_clutter_script_get_type_from_class (const gchar *name)
+gchar *
+_clutter_script_get_symbol_for_class (const gchar *name)
 {
-  static GModule *module = NULL;
   GString *symbol_name = g_string_sized_new (64);
-  GType gtype = G_TYPE_INVALID;
-  GTypeGetFunc func;
-  gchar *symbol;
   gint i;
 
-  if (G_UNLIKELY (!module))
-    module = g_module_open (NULL, 0);
-  
   for (i = 0; name[i] != '\0'; i++)
     {
       gchar c = name[i];
@@ -138,8 +131,22 @@ _clutter_script_get_type_from_class (const gchar *name)
     }
 
   g_string_append (symbol_name, "_get_type");
-  
-  symbol = g_string_free (symbol_name, FALSE);
+
+  return g_string_free (symbol_name, FALSE);
+}
+
+GType
+_clutter_script_get_type_from_class (const gchar *name)
+{
+  static GModule *module = NULL;
+  GType gtype = G_TYPE_INVALID;
+  GTypeGetFunc func;
+  gchar *symbol;
+
+  if (G_UNLIKELY (!module))
+    module = g_module_open (NULL, 0);
+
+  symbol = _clutter_script_get_symbol_for_class (name);
 
   if (g_module_symbol (module, symbol, (gpointer)&func))
     {
@@ -1076,7 +1083,15 @@ clutter_script_parser_object_end (JsonParser *json_parser,
   CLUTTER_NOTE (SCRIPT, "Getting object info for object '%s'", id_);
 
   oinfo = _clutter_script_get_object_info (script, id_);
-  if (oinfo == NULL)
+  if (oinfo != NULL)
+    {
+      /* the definition is merged into one loaded before, which the
+       * cache would not be able to reproduce
+       */
+      if (parser->cache != NULL)
+        _clutter_script_cache_invalidate (parser->cache);
+    }
+  else
     {
       const gchar *class_name;
 
@@ -1187,14 +1202,19 @@ clutter_script_parser_object_end (JsonParser *json_parser,
                 g_list_length (oinfo->properties),
                 g_list_length (oinfo->signals));
 
+  if (parser->cache != NULL)
+    _clutter_script_cache_add_object (parser->cache, oinfo);
+
   _clutter_script_add_object_info (script, oinfo);
-  _clutter_script_construct_object (script, oinfo);
+
+  if (!clutter_script_get_lazy_construction (script))
+    _clutter_script_construct_object (script, oinfo);
 }
 
 static void
 clutter_script_parser_parse_end (JsonParser *parser)
 {
-  clutter_script_ensure_objects (CLUTTER_SCRIPT_PARSER (parser)->script);
+  _clutter_script_resolve_objects (CLUTTER_SCRIPT_PARSER (parser)->script);
 }
 
 gboolean
@@ -2020,6 +2040,13 @@ add_children (ClutterScript *script,
                     g_type_name (G_OBJECT_TYPE (container)));
 
       clutter_container_add_actor (container, CLUTTER_ACTOR (object));
+
+      /* children constructed on demand need their child properties
+       * applied now that they have a parent
+       */
+      if (child_info->has_unresolved &&
+          clutter_script_get_lazy_construction (script))
+        _clutter_script_apply_properties (script, child_info);
     }
 
   g_list_foreach (oinfo->children, (GFunc) g_free, NULL);
@@ -2252,4 +2279,13 @@ _clutter_script_construct_object (ClutterScript *script,
                             g_free);
 
   _clutter_script_check_unresolved (script, oinfo);
+
+  /* objects constructed on demand are not resolved at the end of
+   * the parsing, so we need to complete them here
+   */
+  if (clutter_script_get_lazy_construction (script))
+    {
+      _clutter_script_apply_properties (script, oinfo);
+      _clutter_script_connect_object (script, oinfo);
+    }
 }
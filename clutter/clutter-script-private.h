@@ -41,6 +41,7 @@ G_BEGIN_DECLS
 
 typedef struct _ClutterScriptParser     ClutterScriptParser;
 typedef struct _JsonParserClass         ClutterScriptParserClass;
+typedef struct _ClutterScriptCache      ClutterScriptCache;
 
 struct _ClutterScriptParser
 {
@@ -48,6 +49,9 @@ struct _ClutterScriptParser
 
   /* back reference */
   ClutterScript *script;
+
+  /* records the parsed definitions, if set */
+  ClutterScriptCache *cache;
 };
 
 typedef GType (* GTypeGetFunc) (void);
@@ -109,6 +113,7 @@ gboolean _clutter_script_parse_node        (ClutterScript *script,
 
 GType    _clutter_script_get_type_from_symbol (const gchar *symbol);
 GType    _clutter_script_get_type_from_class  (const gchar *name);
+gchar *  _clutter_script_get_symbol_for_class (const gchar *name);
 
 gulong   _clutter_script_resolve_animation_mode (JsonNode *node);
 
@@ -145,6 +150,9 @@ void _clutter_script_construct_object (ClutterScript *script,
                                        ObjectInfo    *oinfo);
 void _clutter_script_apply_properties (ClutterScript *script,
                                        ObjectInfo    *oinfo);
+void _clutter_script_resolve_objects  (ClutterScript *script);
+void _clutter_script_connect_object   (ClutterScript *script,
+                                       ObjectInfo    *oinfo);
 
 gchar *_clutter_script_generate_fake_id (ClutterScript *script);
 
@@ -167,6 +175,23 @@ void _clutter_script_add_object_info (ClutterScript *script,
 
 const gchar *_clutter_script_get_id_from_node (JsonNode *node);
 
+ClutterScriptCache *_clutter_script_cache_new (const gchar *filename);
+void _clutter_script_cache_free (ClutterScriptCache *cache);
+void _clutter_script_cache_add_fake_id (ClutterScriptCache *cache,
+                                        const gchar        *fake_id);
+void _clutter_script_cache_add_object (ClutterScriptCache *cache,
+                                       ObjectInfo         *oinfo);
+void _clutter_script_cache_invalidate (ClutterScriptCache *cache);
+void _clutter_script_cache_save (ClutterScriptCache *cache,
+                                 ClutterScript      *script,
+                                 const gchar        *filename,
+                                 const gchar        *cache_file);
+gboolean _clutter_script_cache_load (ClutterScript *script,
+                                     const gchar   *filename,
+                                     const gchar   *cache_file);
+gchar *_clutter_script_cache_get_file (const gchar *cache_directory,
+                                       const gchar *filename);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_SCRIPT_PRIVATE_H__ */
@@ -245,6 +245,7 @@
 #include "clutter-scriptable.h"
 
 #include "clutter-enum-types.h"
+#include "clutter-main.h"
 #include "clutter-private.h"
 #include "clutter-debug.h"
 
@@ -260,6 +261,8 @@ enum
   PROP_FILENAME_SET,
   PROP_FILENAME,
   PROP_TRANSLATION_DOMAIN,
+  PROP_CACHE_DIRECTORY,
+  PROP_LAZY_CONSTRUCTION,
 
   PROP_LAST
 };
@@ -283,12 +286,27 @@ struct _ClutterScriptPrivate
 
   gchar *translation_domain;
 
+  gchar *cache_directory;
+
+  /* the connection function used for the objects constructed
+   * after clutter_script_connect_signals_full() in lazy mode
+   */
+  ClutterScriptConnectFunc connect_func;
+  gpointer connect_data;
+  gpointer default_connect;
+
+  GQueue prewarm_ids;
+  guint prewarm_id;
+
   gchar *filename;
   guint is_filename : 1;
+  guint is_lazy : 1;
 };
 
 G_DEFINE_TYPE (ClutterScript, clutter_script, G_TYPE_OBJECT);
 
+static void clutter_script_clear_default_connect (ClutterScript *script);
+
 static GType
 clutter_script_real_get_type_from_name (ClutterScript *script,
                                         const gchar   *type_name)
@@ -385,12 +403,21 @@ clutter_script_finalize (GObject *gobject)
 {
   ClutterScriptPrivate *priv = CLUTTER_SCRIPT_GET_PRIVATE (gobject);
 
+  if (priv->prewarm_id != 0)
+    g_source_remove (priv->prewarm_id);
+
+  g_queue_foreach (&priv->prewarm_ids, (GFunc) g_free, NULL);
+  g_queue_clear (&priv->prewarm_ids);
+
+  clutter_script_clear_default_connect (CLUTTER_SCRIPT (gobject));
+
   g_object_unref (priv->parser);
   g_hash_table_destroy (priv->objects);
   g_strfreev (priv->search_paths);
   g_free (priv->filename);
   g_hash_table_destroy (priv->states);
   g_free (priv->translation_domain);
+  g_free (priv->cache_directory);
 
   G_OBJECT_CLASS (clutter_script_parent_class)->finalize (gobject);
 }
@@ -409,6 +436,14 @@ clutter_script_set_property (GObject      *gobject,
       clutter_script_set_translation_domain (script, g_value_get_string (value));
       break;
 
+    case PROP_CACHE_DIRECTORY:
+      clutter_script_set_cache_directory (script, g_value_get_string (value));
+      break;
+
+    case PROP_LAZY_CONSTRUCTION:
+      clutter_script_set_lazy_construction (script, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -437,6 +472,14 @@ clutter_script_get_property (GObject    *gobject,
       g_value_set_string (value, script->priv->translation_domain);
       break;
 
+    case PROP_CACHE_DIRECTORY:
+      g_value_set_string (value, script->priv->cache_directory);
+      break;
+
+    case PROP_LAZY_CONSTRUCTION:
+      g_value_set_boolean (value, script->priv->is_lazy);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -501,6 +544,39 @@ clutter_script_class_init (ClutterScriptClass *klass)
                          NULL,
                          CLUTTER_PARAM_READWRITE);
 
+  /**
+   * ClutterScript:cache-directory:
+   *
+   * The directory used to cache the definitions loaded using
+   * clutter_script_load_from_file(), or %NULL to disable the cache.
+   *
+   * Since: 1.16
+   */
+  obj_props[PROP_CACHE_DIRECTORY] =
+    g_param_spec_string ("cache-directory",
+                         P_("Cache Directory"),
+                         P_("The directory used to cache the parsed definitions"),
+                         NULL,
+                         CLUTTER_PARAM_READWRITE);
+
+  /**
+   * ClutterScript:lazy-construction:
+   *
+   * Whether the objects defined inside a UI definition should be
+   * constructed only when they are first requested, instead of when
+   * the definition is loaded.
+   *
+   * See clutter_script_set_lazy_construction().
+   *
+   * Since: 1.16
+   */
+  obj_props[PROP_LAZY_CONSTRUCTION] =
+    g_param_spec_boolean ("lazy-construction",
+                          P_("Lazy Construction"),
+                          P_("Whether objects are constructed on demand"),
+                          FALSE,
+                          CLUTTER_PARAM_READWRITE);
+
   gobject_class->set_property = clutter_script_set_property;
   gobject_class->get_property = clutter_script_get_property;
   gobject_class->finalize = clutter_script_finalize;
@@ -521,8 +597,11 @@ clutter_script_init (ClutterScript *script)
   priv->parser->script = script;
 
   priv->is_filename = FALSE;
+  priv->is_lazy = FALSE;
   priv->last_merge_id = 0;
 
+  g_queue_init (&priv->prewarm_ids);
+
   priv->objects = g_hash_table_new_full (g_str_hash, g_str_equal,
                                          NULL,
                                          object_info_free);
@@ -560,6 +639,11 @@ clutter_script_new (void)
  * Loads the definitions from @filename into @script and merges with
  * the currently loaded ones, if any.
  *
+ * If a #ClutterScript:cache-directory is set, the definitions are
+ * loaded from the cache, if the file did not change since it was
+ * last loaded; otherwise, they are saved into the cache after
+ * parsing @filename.
+ *
  * Return value: on error, zero is returned and @error is set
  *   accordingly. On success, the merge id for the UI definitions is
  *   returned. You can use the merge id with clutter_script_unmerge_objects().
@@ -573,6 +657,7 @@ clutter_script_load_from_file (ClutterScript  *script,
 {
   ClutterScriptPrivate *priv;
   GError *internal_error;
+  gchar *cache_file = NULL;
 
   g_return_val_if_fail (CLUTTER_IS_SCRIPT (script), 0);
   g_return_val_if_fail (filename != NULL, 0);
@@ -584,10 +669,39 @@ clutter_script_load_from_file (ClutterScript  *script,
   priv->is_filename = TRUE;
   priv->last_merge_id += 1;
 
+  if (priv->cache_directory != NULL)
+    {
+      cache_file = _clutter_script_cache_get_file (priv->cache_directory,
+                                                   filename);
+
+      if (_clutter_script_cache_load (script, filename, cache_file))
+        {
+          g_free (cache_file);
+          return priv->last_merge_id;
+        }
+
+      priv->parser->cache = _clutter_script_cache_new (filename);
+    }
+
   internal_error = NULL;
   json_parser_load_from_file (JSON_PARSER (priv->parser),
                               filename,
                               &internal_error);
+
+  if (priv->parser->cache != NULL)
+    {
+      if (internal_error == NULL)
+        _clutter_script_cache_save (priv->parser->cache,
+                                    script,
+                                    filename,
+                                    cache_file);
+
+      _clutter_script_cache_free (priv->parser->cache);
+      priv->parser->cache = NULL;
+    }
+
+  g_free (cache_file);
+
   if (internal_error)
     {
       g_propagate_error (error, internal_error);
@@ -854,7 +968,7 @@ clutter_script_unmerge_objects (ClutterScript *script,
   g_slist_foreach (data.ids, (GFunc) g_free, NULL);
   g_slist_free (data.ids);
 
-  clutter_script_ensure_objects (script);
+  _clutter_script_resolve_objects (script);
 }
 
 static void
@@ -901,6 +1015,40 @@ clutter_script_ensure_objects (ClutterScript *script)
   g_hash_table_foreach (priv->objects, construct_each_objects, script);
 }
 
+static void
+resolve_each_object (gpointer key,
+                     gpointer value,
+                     gpointer user_data)
+{
+  ClutterScript *script = user_data;
+  ObjectInfo *oinfo = value;
+
+  if (oinfo->object != NULL && oinfo->has_unresolved)
+    _clutter_script_apply_properties (script, oinfo);
+}
+
+/*< private >
+ * _clutter_script_resolve_objects:
+ * @script: a #ClutterScript
+ *
+ * Resolves the pending properties and children of the objects defined
+ * inside @script after a UI definition has been merged or unmerged.
+ *
+ * If #ClutterScript:lazy-construction is set, only the objects that
+ * have already been constructed are resolved.
+ */
+void
+_clutter_script_resolve_objects (ClutterScript *script)
+{
+  if (!script->priv->is_lazy)
+    {
+      clutter_script_ensure_objects (script);
+      return;
+    }
+
+  g_hash_table_foreach (script->priv->objects, resolve_each_object, script);
+}
+
 /**
  * clutter_script_get_type_from_name:
  * @script: a #ClutterScript
@@ -1018,6 +1166,10 @@ clutter_script_default_connect (ClutterScript *script,
  * Note that this function will not work if #GModule is not supported by
  * the platform Clutter is running on.
  *
+ * If #ClutterScript:lazy-construction is set, the current module is
+ * kept open to connect the signals of the objects constructed later
+ * on, so @user_data must remain valid as well.
+ *
  * Since: 0.6
  */
 void
@@ -1043,11 +1195,40 @@ clutter_script_connect_signals (ClutterScript *script,
                                        clutter_script_default_connect,
                                        cd);
 
+  /* objects constructed later on will need the module as well */
+  if (script->priv->is_lazy)
+    {
+      clutter_script_clear_default_connect (script);
+      script->priv->default_connect = cd;
+      return;
+    }
+
   g_module_close (cd->module);
 
   g_free (cd);
 }
 
+static void
+clutter_script_clear_default_connect (ClutterScript *script)
+{
+  ClutterScriptPrivate *priv = script->priv;
+  ConnectData *cd = priv->default_connect;
+
+  if (cd == NULL)
+    return;
+
+  if (priv->connect_data == cd)
+    {
+      priv->connect_func = NULL;
+      priv->connect_data = NULL;
+    }
+
+  g_module_close (cd->module);
+  g_free (cd);
+
+  priv->default_connect = NULL;
+}
+
 typedef struct {
   ClutterState *state;
   GObject *emitter;
@@ -1108,18 +1289,13 @@ clutter_script_remove_state_change_hook (gpointer  user_data,
 }
 
 static void
-connect_each_object (gpointer key,
-                     gpointer value,
-                     gpointer data)
+connect_object_signals (SignalConnectData *connect_data,
+                        ObjectInfo        *oinfo)
 {
-  SignalConnectData *connect_data = data;
   ClutterScript *script = connect_data->script;
-  ObjectInfo *oinfo = value;
   GObject *object = oinfo->object;
   GList *unresolved, *l;
 
-  _clutter_script_construct_object (script, oinfo);
-
   unresolved = NULL;
   for (l = oinfo->signals; l != NULL; l = l->next)
     {
@@ -1217,6 +1393,55 @@ connect_each_object (gpointer key,
   oinfo->signals = unresolved;
 }
 
+static void
+connect_each_object (gpointer key,
+                     gpointer value,
+                     gpointer data)
+{
+  SignalConnectData *connect_data = data;
+  ObjectInfo *oinfo = value;
+
+  /* in lazy mode, the signals are connected when the object
+   * is constructed; see _clutter_script_connect_object()
+   */
+  if (connect_data->script->priv->is_lazy && oinfo->object == NULL)
+    return;
+
+  _clutter_script_construct_object (connect_data->script, oinfo);
+
+  if (oinfo->object == NULL)
+    return;
+
+  connect_object_signals (connect_data, oinfo);
+}
+
+/*< private >
+ * _clutter_script_connect_object:
+ * @script: a #ClutterScript
+ * @oinfo: the #ObjectInfo of an object constructed on demand
+ *
+ * Connects the signals of an object constructed after a call to
+ * clutter_script_connect_signals_full() in lazy mode.
+ */
+void
+_clutter_script_connect_object (ClutterScript *script,
+                                ObjectInfo    *oinfo)
+{
+  ClutterScriptPrivate *priv = script->priv;
+  SignalConnectData data;
+
+  if (priv->connect_func == NULL ||
+      oinfo->object == NULL ||
+      oinfo->signals == NULL)
+    return;
+
+  data.script = script;
+  data.func = priv->connect_func;
+  data.user_data = priv->connect_data;
+
+  connect_object_signals (&data, oinfo);
+}
+
 /**
  * clutter_script_connect_signals_full:
  * @script: a #ClutterScript
@@ -1234,6 +1459,12 @@ connect_each_object (gpointer key,
  *
  * Applications should use clutter_script_connect_signals().
  *
+ * If #ClutterScript:lazy-construction is set, only the signals of
+ * the objects that have already been constructed are connected by
+ * this function; the signals of the other objects are connected
+ * using @func and @user_data when the objects are constructed, so
+ * both must remain valid for as long as @script can construct them.
+ *
  * Since: 0.6
  */
 void
@@ -1246,6 +1477,12 @@ clutter_script_connect_signals_full (ClutterScript            *script,
   g_return_if_fail (CLUTTER_IS_SCRIPT (script));
   g_return_if_fail (func != NULL);
 
+  if (script->priv->is_lazy)
+    {
+      script->priv->connect_func = func;
+      script->priv->connect_data = user_data;
+    }
+
   data.script = script;
   data.func = func;
   data.user_data = user_data;
@@ -1538,6 +1775,185 @@ clutter_script_get_translation_domain (ClutterScript *script)
   return script->priv->translation_domain;
 }
 
+/**
+ * clutter_script_set_cache_directory:
+ * @script: a #ClutterScript
+ * @path: (type filename) (allow-none): the path of a directory, or %NULL
+ *
+ * Sets the directory used by @script to cache the definitions loaded
+ * using clutter_script_load_from_file().
+ *
+ * The cache stores the parsed definitions in a binary format, which
+ * can be loaded without parsing the JSON data again; a cache file is
+ * used only as long as its UI definition file does not change.
+ *
+ * The directory is created if needed. Applications should use a
+ * directory inside g_get_user_cache_dir().
+ *
+ * Since: 1.16
+ */
+void
+clutter_script_set_cache_directory (ClutterScript *script,
+                                    const gchar   *path)
+{
+  g_return_if_fail (CLUTTER_IS_SCRIPT (script));
+
+  if (g_strcmp0 (path, script->priv->cache_directory) == 0)
+    return;
+
+  g_free (script->priv->cache_directory);
+  script->priv->cache_directory = g_strdup (path);
+
+  g_object_notify_by_pspec (G_OBJECT (script), obj_props[PROP_CACHE_DIRECTORY]);
+}
+
+/**
+ * clutter_script_get_cache_directory:
+ * @script: a #ClutterScript
+ *
+ * Retrieves the directory set using clutter_script_set_cache_directory().
+ *
+ * Return value: (transfer none) (type filename): the cache directory,
+ *   or %NULL
+ *
+ * Since: 1.16
+ */
+const gchar *
+clutter_script_get_cache_directory (ClutterScript *script)
+{
+  g_return_val_if_fail (CLUTTER_IS_SCRIPT (script), NULL);
+
+  return script->priv->cache_directory;
+}
+
+/**
+ * clutter_script_set_lazy_construction:
+ * @script: a #ClutterScript
+ * @lazy: whether objects should be constructed on demand
+ *
+ * Sets whether @script should construct the objects defined inside
+ * the UI definitions it loads only when they are needed.
+ *
+ * By default, every object is constructed as soon as its definition
+ * has been loaded. If @lazy is %TRUE, an object is constructed only
+ * when it is retrieved using clutter_script_get_object(), or when it
+ * is referenced by an object that is being constructed; its signals
+ * are connected at that point, if clutter_script_connect_signals()
+ * has already been called.
+ *
+ * Objects that are not immediately needed, like dialogs or pages
+ * that are hidden at startup, can be constructed ahead of time
+ * using clutter_script_prewarm_objects().
+ *
+ * This function should be called before loading a UI definition.
+ *
+ * Since: 1.16
+ */
+void
+clutter_script_set_lazy_construction (ClutterScript *script,
+                                      gboolean       lazy)
+{
+  g_return_if_fail (CLUTTER_IS_SCRIPT (script));
+
+  lazy = !!lazy;
+
+  if (script->priv->is_lazy == lazy)
+    return;
+
+  script->priv->is_lazy = lazy;
+
+  g_object_notify_by_pspec (G_OBJECT (script), obj_props[PROP_LAZY_CONSTRUCTION]);
+}
+
+/**
+ * clutter_script_get_lazy_construction:
+ * @script: a #ClutterScript
+ *
+ * Retrieves the value set using clutter_script_set_lazy_construction().
+ *
+ * Return value: %TRUE if the objects are constructed on demand
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_script_get_lazy_construction (ClutterScript *script)
+{
+  g_return_val_if_fail (CLUTTER_IS_SCRIPT (script), FALSE);
+
+  return script->priv->is_lazy;
+}
+
+static gboolean
+clutter_script_prewarm_idle (gpointer data)
+{
+  ClutterScript *script = data;
+  ClutterScriptPrivate *priv = script->priv;
+  gchar *id_;
+
+  /* construct a single object for each iteration of the main loop,
+   * so that we do not block the frames that follow
+   */
+  id_ = g_queue_pop_head (&priv->prewarm_ids);
+  if (id_ != NULL)
+    {
+      CLUTTER_NOTE (SCRIPT, "Pre-warming object '%s'", id_);
+
+      clutter_script_get_object (script, id_);
+      g_free (id_);
+    }
+
+  if (g_queue_is_empty (&priv->prewarm_ids))
+    {
+      priv->prewarm_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/**
+ * clutter_script_prewarm_objects:
+ * @script: a #ClutterScript
+ * @ids: (array length=n_ids): the ids of the objects to construct
+ * @n_ids: the length of the passed array
+ *
+ * Queues the objects identified by @ids for construction.
+ *
+ * The objects are constructed one at a time from an idle callback
+ * with a priority lower than the one used to redraw the stages, so
+ * this function can be called once the first frame of an application
+ * is on screen to construct the objects that will be needed later
+ * without delaying the frames in between.
+ *
+ * This function is only useful if #ClutterScript:lazy-construction
+ * is set. Ids that do not exist when the idle callback runs are
+ * ignored.
+ *
+ * Since: 1.16
+ */
+void
+clutter_script_prewarm_objects (ClutterScript       *script,
+                                const gchar * const  ids[],
+                                gsize                n_ids)
+{
+  ClutterScriptPrivate *priv;
+  gsize i;
+
+  g_return_if_fail (CLUTTER_IS_SCRIPT (script));
+  g_return_if_fail (ids != NULL || n_ids == 0);
+
+  priv = script->priv;
+
+  for (i = 0; i < n_ids; i++)
+    g_queue_push_tail (&priv->prewarm_ids, g_strdup (ids[i]));
+
+  if (priv->prewarm_id == 0 && !g_queue_is_empty (&priv->prewarm_ids))
+    priv->prewarm_id = clutter_threads_add_idle_full (G_PRIORITY_LOW,
+                                                      clutter_script_prewarm_idle,
+                                                      script,
+                                                      NULL);
+}
+
 /*
  * _clutter_script_generate_fake_id:
  * @script: a #ClutterScript
@@ -1554,10 +1970,16 @@ gchar *
 _clutter_script_generate_fake_id (ClutterScript *script)
 {
   ClutterScriptPrivate *priv = script->priv;
+  gchar *retval;
 
-  return g_strdup_printf ("script-%d-%d",
-                          priv->last_merge_id,
-                          priv->last_unknown++);
+  retval = g_strdup_printf ("script-%d-%d",
+                            priv->last_merge_id,
+                            priv->last_unknown++);
+
+  if (priv->parser->cache != NULL)
+    _clutter_script_cache_add_fake_id (priv->parser->cache, retval);
+
+  return retval;
 }
 
 /*
@@ -197,6 +197,22 @@ void            clutter_script_set_translation_domain   (ClutterScript
 CLUTTER_AVAILABLE_IN_1_10
 const gchar *   clutter_script_get_translation_domain   (ClutterScript             *script);
 
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_script_set_cache_directory      (ClutterScript             *script,
+                                                         const gchar               *path);
+CLUTTER_AVAILABLE_IN_1_16
+const gchar *   clutter_script_get_cache_directory      (ClutterScript             *script);
+
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_script_set_lazy_construction    (ClutterScript             *script,
+                                                         gboolean                   lazy);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean        clutter_script_get_lazy_construction    (ClutterScript             *script);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_script_prewarm_objects          (ClutterScript             *script,
+                                                         const gchar * const        ids[],
+                                                         gsize                      n_ids);
+
 const gchar *   clutter_get_script_id                   (GObject                   *gobject);
 
 G_END_DECLS
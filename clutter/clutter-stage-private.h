@@ -69,6 +69,30 @@ void     _clutter_stage_update_input_devices              (ClutterStage *stage);
 void     _clutter_stage_schedule_update                   (ClutterStage *stage);
 gint64    _clutter_stage_get_update_time                  (ClutterStage *stage);
 void     _clutter_stage_clear_update_time                 (ClutterStage *stage);
+gint64   _clutter_stage_get_presentation_time             (ClutterStage *stage);
+void     _clutter_stage_record_render_time                (ClutterStage *stage,
+                                                           gint64        render_time);
+gint64   _clutter_stage_get_swap_time                     (ClutterStage *stage);
+void     _clutter_stage_finish_frame_stats                (ClutterStage *stage,
+                                                           gint64        frame_time,
+                                                           gint64        timeline_advance);
+void     _clutter_stage_count_painted_actor               (gboolean      culled);
+
+typedef enum {
+  CLUTTER_ACTOR_COST_PAINT,
+  CLUTTER_ACTOR_COST_ALLOCATE,
+  CLUTTER_ACTOR_COST_PREFERRED_SIZE
+} ClutterActorCostType;
+
+gint64   _clutter_stage_actor_cost_begin                  (void);
+void     _clutter_stage_actor_cost_end                    (ClutterActor         *actor,
+                                                           ClutterActorCostType  type,
+                                                           gint64                start);
+gfloat   _clutter_stage_get_actor_cost_fraction           (ClutterStage         *stage,
+                                                           ClutterActor         *actor);
+void     _clutter_stage_capture_frame                     (ClutterStage                *stage,
+                                                           CoglFramebuffer             *framebuffer,
+                                                           const cairo_rectangle_int_t *damage);
 gboolean _clutter_stage_has_full_redraw_queued            (ClutterStage *stage);
 
 ClutterActor *_clutter_stage_do_pick (ClutterStage    *stage,
@@ -174,6 +174,69 @@ _clutter_stage_window_clear_update_time (ClutterStageWindow *window)
   iface->clear_update_time (window);
 }
 
+/* Returns the time at which the frame currently being prepared is
+ * predicted to reach the screen, or -1 if the backend can't tell */
+gint64
+_clutter_stage_window_get_presentation_time (ClutterStageWindow *window)
+{
+  ClutterStageWindowIface *iface;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE_WINDOW (window), -1);
+
+  iface = CLUTTER_STAGE_WINDOW_GET_IFACE (window);
+  if (iface->get_presentation_time != NULL)
+    return iface->get_presentation_time (window);
+
+  return -1;
+}
+
+/* Tells the backend how long, in microseconds, the last update of
+ * the stage took, from the start of the frame to the swap request */
+void
+_clutter_stage_window_record_render_time (ClutterStageWindow *window,
+                                          gint64              render_time)
+{
+  ClutterStageWindowIface *iface;
+
+  g_return_if_fail (CLUTTER_IS_STAGE_WINDOW (window));
+
+  iface = CLUTTER_STAGE_WINDOW_GET_IFACE (window);
+  if (iface->record_render_time != NULL)
+    iface->record_render_time (window, render_time);
+}
+
+/* Returns the number of frames that were presented later than the
+ * vblank they were scheduled for */
+guint
+_clutter_stage_window_get_missed_frames (ClutterStageWindow *window)
+{
+  ClutterStageWindowIface *iface;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE_WINDOW (window), 0);
+
+  iface = CLUTTER_STAGE_WINDOW_GET_IFACE (window);
+  if (iface->get_missed_frames != NULL)
+    return iface->get_missed_frames (window);
+
+  return 0;
+}
+
+/* Returns the refresh rate of the output the stage is presented on,
+ * or 0 if it is not known */
+gfloat
+_clutter_stage_window_get_refresh_rate (ClutterStageWindow *window)
+{
+  ClutterStageWindowIface *iface;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE_WINDOW (window), 0.0);
+
+  iface = CLUTTER_STAGE_WINDOW_GET_IFACE (window);
+  if (iface->get_refresh_rate != NULL)
+    return iface->get_refresh_rate (window);
+
+  return 0.0;
+}
+
 void
 _clutter_stage_window_add_redraw_clip (ClutterStageWindow    *window,
                                        cairo_rectangle_int_t *stage_clip)
@@ -22,6 +22,15 @@ G_BEGIN_DECLS
 typedef struct _ClutterStageWindow      ClutterStageWindow; /* dummy */
 typedef struct _ClutterStageWindowIface ClutterStageWindowIface;
 
+/*
+ * CLUTTER_STAGE_WINDOW_SYNC_DELAY_NONE:
+ *
+ * Sync delay passed to _clutter_stage_window_schedule_update() to
+ * request an update as soon as possible, bypassing any prediction
+ * of the next presentation time.
+ */
+#define CLUTTER_STAGE_WINDOW_SYNC_DELAY_NONE    (-2)
+
 /*
  * ClutterStageWindowIface: (skip)
  *
@@ -62,6 +71,11 @@ struct _ClutterStageWindowIface
                                                  int                 sync_delay);
   gint64            (* get_update_time)         (ClutterStageWindow *stage_window);
   void              (* clear_update_time)       (ClutterStageWindow *stage_window);
+  gint64            (* get_presentation_time)   (ClutterStageWindow *stage_window);
+  void              (* record_render_time)      (ClutterStageWindow *stage_window,
+                                                 gint64              render_time);
+  guint             (* get_missed_frames)       (ClutterStageWindow *stage_window);
+  gfloat            (* get_refresh_rate)        (ClutterStageWindow *stage_window);
 
   void              (* add_redraw_clip)         (ClutterStageWindow    *stage_window,
                                                  cairo_rectangle_int_t *stage_rectangle);
@@ -115,6 +129,11 @@ void              _clutter_stage_window_schedule_update         (ClutterStageWin
                                                                  int                 sync_delay);
 gint64            _clutter_stage_window_get_update_time         (ClutterStageWindow *window);
 void              _clutter_stage_window_clear_update_time       (ClutterStageWindow *window);
+gint64            _clutter_stage_window_get_presentation_time   (ClutterStageWindow *window);
+void              _clutter_stage_window_record_render_time      (ClutterStageWindow *window,
+                                                                 gint64              render_time);
+guint             _clutter_stage_window_get_missed_frames       (ClutterStageWindow *window);
+gfloat            _clutter_stage_window_get_refresh_rate        (ClutterStageWindow *window);
 
 void              _clutter_stage_window_add_redraw_clip         (ClutterStageWindow    *window,
                                                                  cairo_rectangle_int_t *stage_clip);
@@ -47,6 +47,7 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 #include <cairo.h>
 
 #define CLUTTER_DISABLE_DEPRECATION_WARNINGS
@@ -107,6 +108,69 @@ typedef enum { /*< prefix=CLUTTER_STAGE >*/
 
 #define STAGE_NO_CLEAR_ON_PAINT(s)      ((((ClutterStage *) (s))->priv->stage_hints & CLUTTER_STAGE_NO_CLEAR_ON_PAINT) != 0)
 
+/* number of frames used to compute the automatic sync delay, the
+ * percentile of their update durations that must fit in a frame,
+ * and the safety margin left before the deadline, in microseconds
+ */
+#define N_UPDATE_DURATIONS              64
+#define UPDATE_DURATION_PERCENTILE      95
+#define AUTO_SYNC_DELAY_MARGIN          2000
+
+/* number of frames kept by clutter_stage_get_frame_stats() */
+#define N_FRAME_STATS                   128
+
+/* number of pixel buffers the captured frames are read into, how many
+ * frames a capture is delivered behind the painting, and how long the
+ * last captures are held back when no new frame is painted, in
+ * milliseconds
+ */
+#define N_CAPTURE_BUFFERS               3
+#define CAPTURE_LAG                     2
+#define CAPTURE_FLUSH_TIMEOUT           100
+
+typedef struct _StageCaptureBuffer
+{
+  CoglPixelBuffer *buffer;
+  gsize size;
+
+  /* the serial of the frame read into the buffer, or 0 */
+  guint serial;
+
+  ClutterFrameCapture frame;
+} StageCaptureBuffer;
+
+typedef struct _StageCapture
+{
+  /* the stage, the repaint function and every delivery in progress
+   * hold a reference, as the callback can stop the capture while
+   * one of its buffers is mapped
+   */
+  guint ref_count;
+
+  ClutterStage *stage;
+
+  ClutterStageCaptureFunc func;
+  gpointer data;
+  GDestroyNotify notify;
+
+  gboolean damage_only;
+
+  /* set once the capture has been removed from the stage */
+  gboolean stopped;
+
+  StageCaptureBuffer buffers[N_CAPTURE_BUFFERS];
+  guint next_serial;
+
+  /* the damage of the frames dropped since the last capture, which
+   * the next one has to include
+   */
+  gboolean has_missed_damage;
+  cairo_rectangle_int_t missed_damage;
+
+  guint repaint_id;
+  guint flush_id;
+} StageCapture;
+
 struct _ClutterStageQueueRedrawEntry
 {
   ClutterActor *actor;
@@ -147,9 +211,35 @@ struct _ClutterStagePrivate
   CoglFramebuffer *active_framebuffer;
 
   gint sync_delay;
+  gint auto_sync_delay_value;
+
+  gint64 update_durations[N_UPDATE_DURATIONS];
+  guint update_duration_index;
+  guint n_update_durations;
 
   GTimer *fps_timer;
   gint32 timer_n_frames;
+  guint timer_missed_frames;
+
+  /* the statistics of the last frames, as a ring buffer, and of the
+   * frame being prepared; see clutter_stage_get_frame_stats()
+   */
+  ClutterFrameStats frame_stats[N_FRAME_STATS];
+  guint frame_stats_index;
+  guint n_frame_stats;
+  ClutterFrameStats cur_frame_stats;
+
+  /* the frames since the last summary of the statistics was printed */
+  gint64 frame_stats_log_time;
+  guint frame_stats_log_frames;
+
+  /* the costs of the actors during the frame being prepared and during
+   * the last frame, as ClutterActorCost indexed by actor, or NULL if
+   * the costs are not accounted; see clutter_stage_get_actor_costs()
+   */
+  GHashTable *actor_costs;
+  GHashTable *last_actor_costs;
+  gint64 last_actor_costs_max;
 
   ClutterIDPool *pick_id_pool;
 
@@ -163,6 +253,8 @@ struct _ClutterStagePrivate
   gpointer paint_data;
   GDestroyNotify paint_notify;
 
+  StageCapture *capture;
+
   guint relayout_pending       : 1;
   guint redraw_pending         : 1;
   guint is_fullscreen          : 1;
@@ -178,6 +270,7 @@ struct _ClutterStagePrivate
   guint accept_focus           : 1;
   guint motion_events_enabled  : 1;
   guint has_custom_perspective : 1;
+  guint auto_sync_delay        : 1;
 };
 
 enum
@@ -214,6 +307,18 @@ static guint stage_signals[LAST_SIGNAL] = { 0, };
 
 static const ClutterColor default_stage_color = { 255, 255, 255, 255 };
 
+/* the statistics of the frame being painted, if any; only one stage
+ * is painted at any given time
+ */
+static ClutterFrameStats *painting_frame_stats = NULL;
+
+/* the stage whose actors are being accounted, if any, and the time
+ * spent in the nested accounted calls of each accounted call being
+ * run; see _clutter_stage_actor_cost_begin()
+ */
+static ClutterStage *accounting_stage = NULL;
+static GArray *accounting_stack = NULL;
+
 static void clutter_stage_maybe_finish_queue_redraws (ClutterStage *stage);
 static void free_queue_redraw_entry (ClutterStageQueueRedrawEntry *entry);
 static void clutter_stage_invoke_paint_callback (ClutterStage *stage);
@@ -630,8 +735,19 @@ _clutter_stage_do_paint (ClutterStage                *stage,
                          const cairo_rectangle_int_t *clip)
 {
   ClutterStagePrivate *priv = stage->priv;
+  ClutterFrameStats *old_frame_stats = painting_frame_stats;
   float clip_poly[8];
   cairo_rectangle_int_t geom;
+  gint64 start = 0;
+
+  /* picking is accounted separately, by _clutter_stage_do_pick() */
+  if (_clutter_context_get_pick_mode () == CLUTTER_PICK_NONE)
+    {
+      painting_frame_stats = &priv->cur_frame_stats;
+      start = g_get_monotonic_time ();
+    }
+  else
+    painting_frame_stats = NULL;
 
   _clutter_stage_window_get_geometry (priv->impl, &geom);
 
@@ -676,6 +792,30 @@ _clutter_stage_do_paint (ClutterStage                *stage,
   clutter_actor_paint (CLUTTER_ACTOR (stage));
 
   clutter_stage_invoke_paint_callback (stage);
+
+  if (painting_frame_stats != NULL)
+    painting_frame_stats->paint += g_get_monotonic_time () - start;
+
+  painting_frame_stats = old_frame_stats;
+}
+
+/*
+ * _clutter_stage_count_painted_actor:
+ * @culled: whether the actor was culled instead of being painted
+ *
+ * Updates the statistics of the frame being painted; this is called
+ * by clutter_actor_paint() for every actor outside of picking.
+ */
+void
+_clutter_stage_count_painted_actor (gboolean culled)
+{
+  if (painting_frame_stats == NULL)
+    return;
+
+  if (culled)
+    painting_frame_stats->n_actors_culled += 1;
+  else
+    painting_frame_stats->n_actors_painted += 1;
 }
 
 static void
@@ -931,6 +1071,8 @@ _clutter_stage_queue_event (ClutterStage *stage,
 
   priv = stage->priv;
 
+  _clutter_input_record_event (event);
+
   first_event = priv->event_queue->length == 0;
 
   g_queue_push_tail (priv->event_queue, clutter_event_copy (event));
@@ -979,6 +1121,7 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
 {
   ClutterStagePrivate *priv;
   GList *events, *l;
+  gint64 start;
 
   g_return_if_fail (CLUTTER_IS_STAGE (stage));
 
@@ -987,6 +1130,8 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
   if (priv->event_queue->length == 0)
     return;
 
+  start = g_get_monotonic_time ();
+
   /* In case the stage gets destroyed during event processing */
   g_object_ref (stage);
 
@@ -1041,6 +1186,8 @@ _clutter_stage_process_queued_events (ClutterStage *stage)
 
   g_list_free (events);
 
+  priv->cur_frame_stats.event_processing += g_get_monotonic_time () - start;
+
   g_object_unref (stage);
 }
 
@@ -1140,6 +1287,7 @@ clutter_stage_do_redraw (ClutterStage *stage)
   ClutterBackend *backend = clutter_get_default_backend ();
   ClutterActor *actor = CLUTTER_ACTOR (stage);
   ClutterStagePrivate *priv = stage->priv;
+  gint64 paint_time, start;
 
   CLUTTER_STATIC_COUNTER (redraw_counter,
                           "clutter_stage_do_redraw counter",
@@ -1177,8 +1325,15 @@ clutter_stage_do_redraw (ClutterStage *stage)
   CLUTTER_COUNTER_INC (_clutter_uprof_context, redraw_counter);
   CLUTTER_TIMER_START (_clutter_uprof_context, redraw_timer);
 
+  paint_time = priv->cur_frame_stats.paint;
+  start = g_get_monotonic_time ();
+
   _clutter_stage_window_redraw (priv->impl);
 
+  /* the time not spent painting was spent presenting the frame */
+  paint_time = priv->cur_frame_stats.paint - paint_time;
+  priv->cur_frame_stats.swap += g_get_monotonic_time () - start - paint_time;
+
   CLUTTER_TIMER_STOP (_clutter_uprof_context, redraw_timer);
 
   if (_clutter_context_get_show_fps ())
@@ -1187,9 +1342,14 @@ clutter_stage_do_redraw (ClutterStage *stage)
 
       if (g_timer_elapsed (priv->fps_timer, NULL) >= 1.0)
         {
-          g_print ("*** FPS for %s: %i ***\n",
+          guint missed_frames = _clutter_stage_window_get_missed_frames (priv->impl);
+
+          g_print ("*** FPS for %s: %i (missed vblanks: %u) ***\n",
                    _clutter_actor_get_debug_name (actor),
-                   priv->timer_n_frames);
+                   priv->timer_n_frames,
+                   missed_frames - priv->timer_missed_frames);
+
+          priv->timer_missed_frames = missed_frames;
 
           priv->timer_n_frames = 0;
           g_timer_start (priv->fps_timer);
@@ -1201,6 +1361,90 @@ clutter_stage_do_redraw (ClutterStage *stage)
                 stage);
 }
 
+static gint
+compare_update_durations (gconstpointer a,
+                          gconstpointer b,
+                          gpointer      dummy)
+{
+  gint64 duration_a = *(const gint64 *) a;
+  gint64 duration_b = *(const gint64 *) b;
+
+  if (duration_a < duration_b)
+    return -1;
+
+  if (duration_a > duration_b)
+    return 1;
+
+  return 0;
+}
+
+/*
+ * clutter_stage_add_update_duration:
+ * @stage: a #ClutterStage
+ * @duration: the time spent in the layout and paint of the last
+ *   frame, in microseconds
+ *
+ * Records the duration of the last update and, if the sync delay is
+ * computed automatically, picks the largest delay that still leaves
+ * enough time to the slowest updates to meet the next vblank.
+ *
+ * The duration does not include the swap, which may block until the
+ * vblank when the backend does not support swap events, and would
+ * then always take a whole refresh interval.
+ */
+static void
+clutter_stage_add_update_duration (ClutterStage *stage,
+                                   gint64        duration)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  gint64 durations[N_UPDATE_DURATIONS];
+  gint64 refresh_interval, percentile, available;
+  gfloat refresh_rate;
+
+  priv->update_durations[priv->update_duration_index] = duration;
+  priv->update_duration_index =
+    (priv->update_duration_index + 1) % N_UPDATE_DURATIONS;
+
+  if (priv->n_update_durations < N_UPDATE_DURATIONS)
+    priv->n_update_durations += 1;
+
+  if (!priv->auto_sync_delay)
+    return;
+
+  refresh_rate = _clutter_stage_window_get_refresh_rate (priv->impl);
+  if (refresh_rate <= 0.0)
+    refresh_rate = 60.0;
+
+  refresh_interval = (gint64) (0.5 + G_USEC_PER_SEC / refresh_rate);
+
+  memcpy (durations, priv->update_durations,
+          priv->n_update_durations * sizeof (gint64));
+  g_qsort_with_data (durations, priv->n_update_durations, sizeof (gint64),
+                     compare_update_durations,
+                     NULL);
+
+  percentile = durations[(priv->n_update_durations - 1)
+                         * UPDATE_DURATION_PERCENTILE
+                         / 100];
+
+  available = refresh_interval - percentile - AUTO_SYNC_DELAY_MARGIN;
+
+  /* if we cannot make it in a single frame, then we should start
+   * drawing as soon as possible
+   */
+  if (available < 0)
+    priv->auto_sync_delay_value = -1;
+  else
+    priv->auto_sync_delay_value = available / 1000;
+
+  CLUTTER_NOTE (SCHEDULER, "Update duration %" G_GINT64_FORMAT " usecs "
+                "(%d%%: %" G_GINT64_FORMAT " usecs), sync delay: %d msecs",
+                duration,
+                UPDATE_DURATION_PERCENTILE,
+                percentile,
+                priv->auto_sync_delay_value);
+}
+
 /**
  * _clutter_stage_do_update:
  * @stage: A #ClutterStage
@@ -1213,6 +1457,7 @@ gboolean
 _clutter_stage_do_update (ClutterStage *stage)
 {
   ClutterStagePrivate *priv = stage->priv;
+  gint64 start, swap_time;
 
   /* if the stage is being destroyed, or if the destruction already
    * happened and we don't have an StageWindow any more, then we
@@ -1224,19 +1469,38 @@ _clutter_stage_do_update (ClutterStage *stage)
   if (!CLUTTER_ACTOR_IS_REALIZED (stage))
     return FALSE;
 
+  start = g_get_monotonic_time ();
+
+  if (priv->actor_costs != NULL)
+    accounting_stage = stage;
+
   /* NB: We need to ensure we have an up to date layout *before* we
    * check or clear the pending redraws flag since a relayout may
    * queue a redraw.
    */
   _clutter_stage_maybe_relayout (CLUTTER_ACTOR (stage));
 
+  priv->cur_frame_stats.relayout += g_get_monotonic_time () - start;
+
   if (!priv->redraw_pending)
-    return FALSE;
+    {
+      accounting_stage = NULL;
+      return FALSE;
+    }
 
   clutter_stage_maybe_finish_queue_redraws (stage);
 
+  swap_time = priv->cur_frame_stats.swap;
+
   clutter_stage_do_redraw (stage);
 
+  accounting_stage = NULL;
+
+  /* leave out the time spent presenting the frame */
+  swap_time = priv->cur_frame_stats.swap - swap_time;
+  clutter_stage_add_update_duration (stage,
+                                     g_get_monotonic_time () - start - swap_time);
+
   /* reset the guard, so that new redraws are possible */
   priv->redraw_pending = FALSE;
 
@@ -1292,6 +1556,8 @@ clutter_stage_real_queue_redraw (ClutterActor *actor,
   if (stage_window == NULL)
     return;
 
+  stage->priv->cur_frame_stats.n_redraw_clips += 1;
+
   if (_clutter_stage_window_ignoring_redraw_clips (stage_window))
     {
       _clutter_stage_window_add_redraw_clip (stage_window, NULL);
@@ -1433,6 +1699,7 @@ _clutter_stage_do_pick (ClutterStage   *stage,
   gboolean is_clipped;
   gint read_x;
   gint read_y;
+  gint64 start;
 
   CLUTTER_STATIC_COUNTER (do_pick_counter,
                           "_clutter_stage_do_pick counter",
@@ -1466,6 +1733,8 @@ _clutter_stage_do_pick (ClutterStage   *stage,
   if (G_UNLIKELY (clutter_pick_debug_flags & CLUTTER_DEBUG_NOP_PICKING))
     return CLUTTER_ACTOR (stage);
 
+  start = g_get_monotonic_time ();
+
 #ifdef CLUTTER_ENABLE_PROFILE
   if (clutter_profile_flags & CLUTTER_PROFILE_PICKING_ONLY)
     _clutter_profile_resume ();
@@ -1616,6 +1885,9 @@ check_pixel:
       actor = _clutter_get_actor_by_id (stage, id_);
     }
 
+  priv->cur_frame_stats.pick += g_get_monotonic_time () - start;
+  priv->cur_frame_stats.n_picks += 1;
+
   CLUTTER_TIMER_STOP (_clutter_uprof_context, pick_timer);
 
 #ifdef CLUTTER_ENABLE_PROFILE
@@ -1857,6 +2129,12 @@ clutter_stage_dispose (GObject *object)
 
   clutter_actor_remove_all_children (CLUTTER_ACTOR (object));
 
+  /* the costs hold references on the actors */
+  clutter_stage_set_actor_costs_enabled (stage, FALSE);
+
+  /* delivers the frames still in flight */
+  clutter_stage_set_capture_callback (stage, FALSE, NULL, NULL, NULL);
+
   g_list_free_full (priv->pending_queue_redraws,
                     (GDestroyNotify) free_queue_redraw_entry);
   priv->pending_queue_redraws = NULL;
@@ -2291,6 +2569,7 @@ clutter_stage_init (ClutterStage *self)
   priv->throttle_motion_events = TRUE;
   priv->min_size_changed = FALSE;
   priv->sync_delay = -1;
+  priv->auto_sync_delay_value = -1;
 
   /* XXX - we need to keep the invariant that calling
    * clutter_set_motion_event_enabled() before the stage creation
@@ -2350,6 +2629,9 @@ clutter_stage_init (ClutterStage *self)
     g_array_new (FALSE, FALSE, sizeof (ClutterPaintVolume));
 
   priv->pick_id_pool = _clutter_id_pool_new (256);
+
+  if (G_UNLIKELY (clutter_paint_debug_flags & CLUTTER_DEBUG_COST_OVERLAY))
+    clutter_stage_set_actor_costs_enabled (self, TRUE);
 }
 
 /**
@@ -3900,6 +4182,10 @@ _clutter_stage_schedule_update (ClutterStage *stage)
   if (stage_window == NULL)
     return;
 
+  if (stage->priv->auto_sync_delay)
+    return _clutter_stage_window_schedule_update (stage_window,
+                                                  stage->priv->auto_sync_delay_value);
+
   return _clutter_stage_window_schedule_update (stage_window,
                                                 stage->priv->sync_delay);
 }
@@ -3930,6 +4216,480 @@ _clutter_stage_clear_update_time (ClutterStage *stage)
     _clutter_stage_window_clear_update_time (stage_window);
 }
 
+/* Returns the predicted presentation time of the frame being prepared,
+ * or -1 if it is not known */
+gint64
+_clutter_stage_get_presentation_time (ClutterStage *stage)
+{
+  ClutterStageWindow *stage_window;
+
+  if (CLUTTER_ACTOR_IN_DESTRUCTION (stage))
+    return -1;
+
+  stage_window = _clutter_stage_get_window (stage);
+  if (stage_window == NULL)
+    return -1;
+
+  return _clutter_stage_window_get_presentation_time (stage_window);
+}
+
+void
+_clutter_stage_record_render_time (ClutterStage *stage,
+                                   gint64        render_time)
+{
+  ClutterStageWindow *stage_window;
+
+  stage_window = _clutter_stage_get_window (stage);
+  if (stage_window)
+    _clutter_stage_window_record_render_time (stage_window, render_time);
+}
+
+/* Returns the time spent presenting the frame being prepared, in
+ * microseconds */
+gint64
+_clutter_stage_get_swap_time (ClutterStage *stage)
+{
+  return stage->priv->cur_frame_stats.swap;
+}
+
+static void
+actor_cost_free (gpointer data)
+{
+  ClutterActorCost *cost = data;
+
+  g_object_unref (cost->actor);
+  g_slice_free (ClutterActorCost, cost);
+}
+
+static inline gint64
+actor_cost_get_exclusive (const ClutterActorCost *cost)
+{
+  return cost->paint_exclusive
+       + cost->allocate_exclusive
+       + cost->preferred_size_exclusive;
+}
+
+static GHashTable *
+actor_costs_new (void)
+{
+  return g_hash_table_new_full (NULL, NULL, NULL, actor_cost_free);
+}
+
+/* makes the costs accounted since the last frame the costs of the
+ * last frame
+ */
+static void
+clutter_stage_finish_actor_costs (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_destroy (priv->last_actor_costs);
+  priv->last_actor_costs = priv->actor_costs;
+  priv->actor_costs = actor_costs_new ();
+
+  priv->last_actor_costs_max = 0;
+
+  g_hash_table_iter_init (&iter, priv->last_actor_costs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    priv->last_actor_costs_max = MAX (priv->last_actor_costs_max,
+                                      actor_cost_get_exclusive (value));
+}
+
+static void
+clutter_stage_print_frame_stats (ClutterStage *stage,
+                                 guint         n_frames)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  ClutterFrameStats total = { 0, };
+  guint i;
+
+  for (i = 0; i < n_frames; i++)
+    {
+      const ClutterFrameStats *stats;
+
+      stats = &priv->frame_stats[(priv->frame_stats_index + N_FRAME_STATS - 1 - i)
+                                 % N_FRAME_STATS];
+
+      total.event_processing += stats->event_processing;
+      total.timeline_advance += stats->timeline_advance;
+      total.relayout += stats->relayout;
+      total.paint += stats->paint;
+      total.pick += stats->pick;
+      total.swap += stats->swap;
+      total.n_actors_painted += stats->n_actors_painted;
+      total.n_actors_culled += stats->n_actors_culled;
+      total.n_redraw_clips += stats->n_redraw_clips;
+      total.n_picks += stats->n_picks;
+    }
+
+  g_print ("*** Frame stats for %s over %u frames (average usecs): "
+           "events %" G_GINT64_FORMAT ", "
+           "timelines %" G_GINT64_FORMAT ", "
+           "relayout %" G_GINT64_FORMAT ", "
+           "paint %" G_GINT64_FORMAT ", "
+           "pick %" G_GINT64_FORMAT ", "
+           "swap %" G_GINT64_FORMAT "; "
+           "(average counts): painted %u, culled %u, clips %u, picks %u ***\n",
+           _clutter_actor_get_debug_name (CLUTTER_ACTOR (stage)),
+           n_frames,
+           total.event_processing / n_frames,
+           total.timeline_advance / n_frames,
+           total.relayout / n_frames,
+           total.paint / n_frames,
+           total.pick / n_frames,
+           total.swap / n_frames,
+           total.n_actors_painted / n_frames,
+           total.n_actors_culled / n_frames,
+           total.n_redraw_clips / n_frames,
+           total.n_picks / n_frames);
+}
+
+/*
+ * _clutter_stage_finish_frame_stats:
+ * @stage: a #ClutterStage
+ * @frame_time: the time the frame began, in microseconds
+ * @timeline_advance: the time spent advancing the timelines
+ *
+ * Stores the statistics gathered since the last frame, once @stage
+ * has been redrawn.
+ */
+void
+_clutter_stage_finish_frame_stats (ClutterStage *stage,
+                                   gint64        frame_time,
+                                   gint64        timeline_advance)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  guint interval;
+
+  priv->cur_frame_stats.frame_time = frame_time;
+  priv->cur_frame_stats.timeline_advance = timeline_advance;
+
+  priv->frame_stats[priv->frame_stats_index] = priv->cur_frame_stats;
+  priv->frame_stats_index = (priv->frame_stats_index + 1) % N_FRAME_STATS;
+  priv->n_frame_stats = MIN (priv->n_frame_stats + 1, N_FRAME_STATS);
+
+  memset (&priv->cur_frame_stats, 0, sizeof (ClutterFrameStats));
+
+  if (priv->actor_costs != NULL)
+    clutter_stage_finish_actor_costs (stage);
+
+  interval = _clutter_get_frame_stats_interval ();
+  if (G_LIKELY (interval == 0))
+    return;
+
+  priv->frame_stats_log_frames += 1;
+
+  if (priv->frame_stats_log_time == 0)
+    priv->frame_stats_log_time = frame_time;
+  else if (frame_time - priv->frame_stats_log_time >= interval * G_USEC_PER_SEC)
+    {
+      clutter_stage_print_frame_stats (stage,
+                                       MIN (priv->frame_stats_log_frames,
+                                            N_FRAME_STATS));
+
+      priv->frame_stats_log_time = frame_time;
+      priv->frame_stats_log_frames = 0;
+    }
+}
+
+/**
+ * clutter_stage_get_frame_stats:
+ * @stage: a #ClutterStage
+ * @stats: (out caller-allocates) (array length=n_stats): return location
+ *   for the statistics of the frames
+ * @n_stats: the number of elements in @stats
+ *
+ * Retrieves the statistics of the last frames drawn by @stage, from
+ * the oldest to the most recent.
+ *
+ * The statistics are always gathered, and @stage keeps those of the
+ * last 128 frames; their cost is a few reads of the monotonic clock
+ * for each frame.
+ *
+ * The statistics are also printed periodically if the
+ * <envar>CLUTTER_FRAME_STATS_INTERVAL</envar> environment variable
+ * is set to the interval between two summaries, in seconds.
+ *
+ * Return value: the number of elements of @stats that have been
+ *   filled; this can be less than @n_stats if @stage has not drawn
+ *   enough frames yet
+ *
+ * Since: 1.16
+ */
+guint
+clutter_stage_get_frame_stats (ClutterStage      *stage,
+                               ClutterFrameStats *stats,
+                               guint              n_stats)
+{
+  ClutterStagePrivate *priv;
+  guint first, i;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), 0);
+  g_return_val_if_fail (stats != NULL || n_stats == 0, 0);
+
+  priv = stage->priv;
+
+  n_stats = MIN (n_stats, priv->n_frame_stats);
+  first = priv->frame_stats_index + N_FRAME_STATS - n_stats;
+
+  for (i = 0; i < n_stats; i++)
+    stats[i] = priv->frame_stats[(first + i) % N_FRAME_STATS];
+
+  return n_stats;
+}
+
+/*< private >
+ * _clutter_stage_actor_cost_begin:
+ *
+ * Starts accounting the time spent in a call of an actor; the
+ * returned value must be passed to _clutter_stage_actor_cost_end()
+ * at the end of the call.
+ *
+ * Return value: the start time of the call, or 0 if the actors are
+ *   not being accounted
+ */
+gint64
+_clutter_stage_actor_cost_begin (void)
+{
+  gint64 nested = 0;
+
+  if (G_LIKELY (accounting_stage == NULL))
+    return 0;
+
+  if (G_UNLIKELY (accounting_stack == NULL))
+    accounting_stack = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  g_array_append_val (accounting_stack, nested);
+
+  return g_get_monotonic_time ();
+}
+
+/*< private >
+ * _clutter_stage_actor_cost_end:
+ * @actor: the #ClutterActor being accounted
+ * @type: the kind of call being accounted
+ * @start: the value returned by _clutter_stage_actor_cost_begin()
+ *
+ * Adds the time spent in the call started with
+ * _clutter_stage_actor_cost_begin() to the costs of @actor; the
+ * exclusive time excludes the time spent in the nested accounted
+ * calls, like the paint of the children of @actor.
+ */
+void
+_clutter_stage_actor_cost_end (ClutterActor         *actor,
+                               ClutterActorCostType  type,
+                               gint64                start)
+{
+  ClutterActorCost *cost;
+  gint64 inclusive, exclusive;
+
+  if (G_LIKELY (start == 0))
+    return;
+
+  inclusive = g_get_monotonic_time () - start;
+  exclusive = inclusive - g_array_index (accounting_stack, gint64,
+                                         accounting_stack->len - 1);
+
+  g_array_set_size (accounting_stack, accounting_stack->len - 1);
+
+  if (accounting_stack->len > 0)
+    g_array_index (accounting_stack, gint64,
+                   accounting_stack->len - 1) += inclusive;
+
+  if (accounting_stage == NULL)
+    return;
+
+  cost = g_hash_table_lookup (accounting_stage->priv->actor_costs, actor);
+  if (cost == NULL)
+    {
+      cost = g_slice_new0 (ClutterActorCost);
+      cost->actor = g_object_ref (actor);
+      g_hash_table_insert (accounting_stage->priv->actor_costs, actor, cost);
+    }
+
+  switch (type)
+    {
+    case CLUTTER_ACTOR_COST_PAINT:
+      cost->paint_inclusive += inclusive;
+      cost->paint_exclusive += exclusive;
+      break;
+
+    case CLUTTER_ACTOR_COST_ALLOCATE:
+      cost->allocate_inclusive += inclusive;
+      cost->allocate_exclusive += exclusive;
+      break;
+
+    case CLUTTER_ACTOR_COST_PREFERRED_SIZE:
+      cost->preferred_size_inclusive += inclusive;
+      cost->preferred_size_exclusive += exclusive;
+      break;
+    }
+}
+
+/*< private >
+ * _clutter_stage_get_actor_cost_fraction:
+ * @stage: a #ClutterStage
+ * @actor: a #ClutterActor of @stage
+ *
+ * Retrieves the exclusive cost of @actor during the last frame,
+ * relative to the cost of the most expensive actor of @stage.
+ *
+ * Return value: a value between 0 and 1
+ */
+gfloat
+_clutter_stage_get_actor_cost_fraction (ClutterStage *stage,
+                                        ClutterActor *actor)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  ClutterActorCost *cost;
+
+  if (priv->last_actor_costs == NULL || priv->last_actor_costs_max <= 0)
+    return 0.f;
+
+  cost = g_hash_table_lookup (priv->last_actor_costs, actor);
+  if (cost == NULL)
+    return 0.f;
+
+  return (gfloat) actor_cost_get_exclusive (cost) / priv->last_actor_costs_max;
+}
+
+/**
+ * clutter_stage_set_actor_costs_enabled:
+ * @stage: a #ClutterStage
+ * @enabled: whether the costs of the actors should be accounted
+ *
+ * Sets whether @stage should account the time spent painting, allocating
+ * and measuring each of its actors; the costs of the last frame can be
+ * retrieved using clutter_stage_get_actor_costs().
+ *
+ * Accounting the costs reads the monotonic clock twice for every actor
+ * painted, allocated or measured, so it is disabled by default. It is
+ * enabled on every stage by the <literal>cost-overlay</literal> mode
+ * of the <envar>CLUTTER_PAINT</envar> environment variable, which also
+ * tints each actor from green to red depending on its exclusive cost.
+ *
+ * Since: 1.16
+ */
+void
+clutter_stage_set_actor_costs_enabled (ClutterStage *stage,
+                                       gboolean      enabled)
+{
+  ClutterStagePrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  priv = stage->priv;
+
+  if (enabled == (priv->actor_costs != NULL))
+    return;
+
+  if (enabled)
+    {
+      priv->actor_costs = actor_costs_new ();
+      priv->last_actor_costs = actor_costs_new ();
+    }
+  else
+    {
+      g_hash_table_destroy (priv->actor_costs);
+      priv->actor_costs = NULL;
+
+      g_hash_table_destroy (priv->last_actor_costs);
+      priv->last_actor_costs = NULL;
+
+      priv->last_actor_costs_max = 0;
+
+      if (accounting_stage == stage)
+        accounting_stage = NULL;
+    }
+}
+
+/**
+ * clutter_stage_get_actor_costs_enabled:
+ * @stage: a #ClutterStage
+ *
+ * Retrieves the value set with clutter_stage_set_actor_costs_enabled().
+ *
+ * Return value: %TRUE if the costs of the actors are accounted
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_stage_get_actor_costs_enabled (ClutterStage *stage)
+{
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), FALSE);
+
+  return stage->priv->actor_costs != NULL;
+}
+
+static gint
+compare_actor_costs (gconstpointer a,
+                     gconstpointer b)
+{
+  gint64 cost_a = actor_cost_get_exclusive (*(ClutterActorCost * const *) a);
+  gint64 cost_b = actor_cost_get_exclusive (*(ClutterActorCost * const *) b);
+
+  return cost_a > cost_b ? -1 : cost_a < cost_b ? 1 : 0;
+}
+
+/**
+ * clutter_stage_get_actor_costs:
+ * @stage: a #ClutterStage
+ * @costs: (out caller-allocates) (array length=n_costs): return location
+ *   for the costs of the actors
+ * @n_costs: the number of elements in @costs
+ *
+ * Retrieves the costs of the most expensive actors of @stage during
+ * the last frame, sorted by decreasing exclusive cost, that is the sum
+ * of the exclusive times spent painting, allocating and measuring each
+ * actor. The work done between two frames is accounted to the following
+ * frame; picking is not accounted.
+ *
+ * The costs are only accounted if clutter_stage_set_actor_costs_enabled()
+ * has been called. The actors in @costs are not referenced, and they
+ * are only guaranteed to be valid until the next frame.
+ *
+ * Return value: the number of elements of @costs that have been filled
+ *
+ * Since: 1.16
+ */
+guint
+clutter_stage_get_actor_costs (ClutterStage     *stage,
+                               ClutterActorCost *costs,
+                               guint             n_costs)
+{
+  ClutterStagePrivate *priv;
+  GPtrArray *sorted;
+  GHashTableIter iter;
+  gpointer value;
+  guint i;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), 0);
+  g_return_val_if_fail (costs != NULL || n_costs == 0, 0);
+
+  priv = stage->priv;
+
+  if (priv->last_actor_costs == NULL)
+    return 0;
+
+  sorted = g_ptr_array_sized_new (g_hash_table_size (priv->last_actor_costs));
+
+  g_hash_table_iter_init (&iter, priv->last_actor_costs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (sorted, value);
+
+  g_ptr_array_sort (sorted, compare_actor_costs);
+
+  n_costs = MIN (n_costs, sorted->len);
+  for (i = 0; i < n_costs; i++)
+    costs[i] = *(ClutterActorCost *) g_ptr_array_index (sorted, i);
+
+  g_ptr_array_free (sorted, TRUE);
+
+  return n_costs;
+}
+
 /**
  * clutter_stage_set_no_clear_hint:
  * @stage: a #ClutterStage
@@ -4557,8 +5317,9 @@ _clutter_stage_update_state (ClutterStage      *stage,
  * @stage: a #ClutterStage
  * @sync_delay: number of milliseconds after frame presentation to wait
  *   before painting the next frame. If less than zero, restores the
- *   default behavior where redraw is throttled to the refresh rate but
- *   not synchronized to it.
+ *   default behavior where Clutter predicts the next presentation time
+ *   from the recent frames and starts drawing just early enough to
+ *   hit it.
  *
  * This function enables an alternate behavior where Clutter draws at
  * a fixed point in time after the frame presentation time (also known
@@ -4583,7 +5344,7 @@ clutter_stage_set_sync_delay (ClutterStage *stage,
 {
   g_return_if_fail (CLUTTER_IS_STAGE (stage));
 
-  stage->priv->sync_delay = sync_delay;
+  stage->priv->sync_delay = MAX (sync_delay, -1);
 }
 
 /**
@@ -4604,7 +5365,67 @@ clutter_stage_skip_sync_delay (ClutterStage *stage)
 
   stage_window = _clutter_stage_get_window (stage);
   if (stage_window)
-    _clutter_stage_window_schedule_update (stage_window, -1);
+    _clutter_stage_window_schedule_update (stage_window,
+                                           CLUTTER_STAGE_WINDOW_SYNC_DELAY_NONE);
+}
+
+/**
+ * clutter_stage_set_auto_sync_delay:
+ * @stage: a #ClutterStage
+ * @auto_sync_delay: whether the sync delay should be computed automatically
+ *
+ * Sets whether the sync delay of @stage, see clutter_stage_set_sync_delay(),
+ * should be computed automatically.
+ *
+ * When enabled, the stage keeps track of the time spent laying out
+ * and painting the recent frames, and uses the largest delay
+ * that still lets 95% of them meet the next vblank, with a safety margin.
+ * Events arriving in the meantime are then shown in the very next frame.
+ *
+ * The automatic sync delay takes precedence over the value set using
+ * clutter_stage_set_sync_delay().
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+void
+clutter_stage_set_auto_sync_delay (ClutterStage *stage,
+                                   gboolean      auto_sync_delay)
+{
+  ClutterStagePrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  priv = stage->priv;
+
+  auto_sync_delay = !!auto_sync_delay;
+
+  if (priv->auto_sync_delay == auto_sync_delay)
+    return;
+
+  priv->auto_sync_delay = auto_sync_delay;
+
+  /* start from the default scheduling until we have a new estimate */
+  priv->auto_sync_delay_value = -1;
+}
+
+/**
+ * clutter_stage_get_auto_sync_delay:
+ * @stage: a #ClutterStage
+ *
+ * Retrieves the value set using clutter_stage_set_auto_sync_delay().
+ *
+ * Return value: %TRUE if the sync delay is computed automatically
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+gboolean
+clutter_stage_get_auto_sync_delay (ClutterStage *stage)
+{
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), FALSE);
+
+  return stage->priv->auto_sync_delay;
 }
 
 /**
@@ -4645,3 +5466,385 @@ clutter_stage_invoke_paint_callback (ClutterStage *stage)
   if (stage->priv->paint_callback != NULL)
     stage->priv->paint_callback (stage, stage->priv->paint_data);
 }
+
+static StageCapture *
+stage_capture_ref (StageCapture *capture)
+{
+  capture->ref_count += 1;
+
+  return capture;
+}
+
+static void
+stage_capture_unref (StageCapture *capture)
+{
+  guint i;
+
+  capture->ref_count -= 1;
+  if (capture->ref_count > 0)
+    return;
+
+  for (i = 0; i < N_CAPTURE_BUFFERS; i++)
+    {
+      if (capture->buffers[i].buffer != NULL)
+        cogl_object_unref (capture->buffers[i].buffer);
+    }
+
+  g_slice_free (StageCapture, capture);
+}
+
+static void
+clutter_stage_deliver_capture (StageCapture       *capture,
+                               StageCaptureBuffer *capture_buffer)
+{
+  CoglBuffer *buffer = COGL_BUFFER (capture_buffer->buffer);
+  guint8 *data;
+
+  capture_buffer->serial = 0;
+
+  data = cogl_buffer_map (buffer,
+                          COGL_BUFFER_ACCESS_READ,
+                          0);
+  if (data == NULL)
+    {
+      CLUTTER_NOTE (MISC, "Unable to map the pixel buffer of the capture");
+      return;
+    }
+
+  capture_buffer->frame.data = data;
+  capture->func (capture->stage, &capture_buffer->frame, capture->data);
+  capture_buffer->frame.data = NULL;
+
+  cogl_buffer_unmap (buffer);
+}
+
+/* delivers the captured frames in the order they were painted; if
+ * @max_serial is not 0, only the frames up to it are delivered
+ */
+static void
+clutter_stage_deliver_captures (StageCapture *capture,
+                                guint         max_serial)
+{
+  stage_capture_ref (capture);
+
+  while (TRUE)
+    {
+      StageCaptureBuffer *oldest = NULL;
+      guint i;
+
+      for (i = 0; i < N_CAPTURE_BUFFERS; i++)
+        {
+          StageCaptureBuffer *capture_buffer = &capture->buffers[i];
+
+          if (capture_buffer->serial == 0)
+            continue;
+
+          if (max_serial != 0 && capture_buffer->serial > max_serial)
+            continue;
+
+          if (oldest == NULL || capture_buffer->serial < oldest->serial)
+            oldest = capture_buffer;
+        }
+
+      if (oldest == NULL)
+        break;
+
+      clutter_stage_deliver_capture (capture, oldest);
+    }
+
+  stage_capture_unref (capture);
+}
+
+static gboolean
+clutter_stage_capture_repaint (gpointer data)
+{
+  StageCapture *capture = data;
+
+  /* the capture may have been stopped by another repaint function
+   * while the repaint functions were running, in which case it could
+   * not remove this one
+   */
+  if (capture->stopped)
+    return FALSE;
+
+  /* the frames read back CAPTURE_LAG frames ago should be available
+   * by now, so mapping their buffers will not stall the GPU
+   */
+  if (capture->next_serial > CAPTURE_LAG)
+    clutter_stage_deliver_captures (capture,
+                                    capture->next_serial - CAPTURE_LAG);
+
+  return !capture->stopped;
+}
+
+static gboolean
+clutter_stage_capture_flush (gpointer data)
+{
+  StageCapture *capture = data;
+
+  /* no frame has been painted in a while, or every buffer is in use,
+   * so the last frames would otherwise be held back until the next one
+   */
+  capture->flush_id = 0;
+  clutter_stage_deliver_captures (capture, 0);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * _clutter_stage_capture_frame:
+ * @stage: a #ClutterStage
+ * @framebuffer: the framebuffer @stage has just been painted on
+ * @damage: (allow-none): the area of @stage that was repainted, or
+ *   %NULL if the whole stage was repainted
+ *
+ * Reads back the contents of @framebuffer into a pixel buffer, if
+ * a capture callback has been set on @stage; the stage windows call
+ * this function once the stage has been painted, before swapping the
+ * buffers.
+ *
+ * The read back is asynchronous, and the frame is delivered to the
+ * callback a couple of frames later.
+ */
+void
+_clutter_stage_capture_frame (ClutterStage                *stage,
+                              CoglFramebuffer             *framebuffer,
+                              const cairo_rectangle_int_t *damage)
+{
+  StageCapture *capture = stage->priv->capture;
+  StageCaptureBuffer *capture_buffer;
+  cairo_rectangle_int_t area;
+  ClutterBackend *backend;
+  CoglBitmap *bitmap;
+  gint width, height;
+  gsize size;
+  gint stride;
+
+  if (capture == NULL)
+    return;
+
+  width = cogl_framebuffer_get_width (framebuffer);
+  height = cogl_framebuffer_get_height (framebuffer);
+
+  area.x = 0;
+  area.y = 0;
+  area.width = width;
+  area.height = height;
+
+  capture_buffer = &capture->buffers[capture->next_serial % N_CAPTURE_BUFFERS];
+
+  /* the ring is full, which happens when the frames are painted
+   * without going through the master clock; we are in the middle of
+   * a redraw, so instead of calling back from here we drop the frame,
+   * keep its damage for the next one, and deliver the pending frames
+   * as soon as possible
+   */
+  if (capture_buffer->serial != 0)
+    {
+      cairo_rectangle_int_t frame_damage = area;
+
+      CLUTTER_NOTE (MISC, "Dropping a frame, as the capture of frame %u "
+                    "is still pending",
+                    capture_buffer->serial);
+
+      if (damage != NULL)
+        _clutter_util_rectangle_intersection (damage, &area, &frame_damage);
+
+      if (frame_damage.width > 0 && frame_damage.height > 0)
+        {
+          if (capture->has_missed_damage)
+            _clutter_util_rectangle_union (&capture->missed_damage,
+                                           &frame_damage,
+                                           &capture->missed_damage);
+          else
+            capture->missed_damage = frame_damage;
+
+          capture->has_missed_damage = TRUE;
+        }
+
+      if (capture->flush_id != 0)
+        g_source_remove (capture->flush_id);
+
+      capture->flush_id =
+        clutter_threads_add_idle (clutter_stage_capture_flush, capture);
+
+      return;
+    }
+
+  capture_buffer->frame.frame_time = g_get_monotonic_time ();
+  capture_buffer->frame.damage = area;
+
+  if (damage != NULL)
+    _clutter_util_rectangle_intersection (damage, &area,
+                                          &capture_buffer->frame.damage);
+
+  if (capture->has_missed_damage)
+    {
+      cairo_rectangle_int_t *frame_damage = &capture_buffer->frame.damage;
+
+      if (frame_damage->width <= 0 || frame_damage->height <= 0)
+        *frame_damage = capture->missed_damage;
+      else
+        _clutter_util_rectangle_union (frame_damage, &capture->missed_damage,
+                                       frame_damage);
+
+      /* the stage may have been resized since */
+      _clutter_util_rectangle_intersection (frame_damage, &area, frame_damage);
+    }
+
+  if (capture->damage_only)
+    area = capture_buffer->frame.damage;
+
+  if (area.width <= 0 || area.height <= 0)
+    return;
+
+  stride = area.width * 4;
+  size = (gsize) stride * area.height;
+
+  if (capture_buffer->buffer == NULL || capture_buffer->size < size)
+    {
+      backend = clutter_get_default_backend ();
+
+      if (capture_buffer->buffer != NULL)
+        cogl_object_unref (capture_buffer->buffer);
+
+      capture_buffer->buffer =
+        cogl_pixel_buffer_new (clutter_backend_get_cogl_context (backend),
+                               size,
+                               NULL);
+      capture_buffer->size = size;
+
+      cogl_buffer_set_update_hint (COGL_BUFFER (capture_buffer->buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+    }
+
+  bitmap = cogl_bitmap_new_from_buffer (COGL_BUFFER (capture_buffer->buffer),
+                                        CLUTTER_CAIRO_FORMAT_ARGB32,
+                                        area.width,
+                                        area.height,
+                                        stride,
+                                        0);
+
+  /* reading into a pixel buffer only queues the transfer */
+  if (cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                area.x, area.y,
+                                                COGL_READ_PIXELS_COLOR_BUFFER,
+                                                bitmap))
+    {
+      capture->next_serial += 1;
+      capture->has_missed_damage = FALSE;
+
+      capture_buffer->serial = capture->next_serial;
+      capture_buffer->frame.area = area;
+      capture_buffer->frame.stride = stride;
+
+      if (capture->flush_id != 0)
+        g_source_remove (capture->flush_id);
+
+      capture->flush_id =
+        clutter_threads_add_timeout (CAPTURE_FLUSH_TIMEOUT,
+                                     clutter_stage_capture_flush,
+                                     capture);
+    }
+  else
+    CLUTTER_NOTE (MISC, "Unable to read back the frame for the capture");
+
+  cogl_object_unref (bitmap);
+}
+
+/**
+ * clutter_stage_set_capture_callback:
+ * @stage: a #ClutterStage
+ * @damage_only: whether to capture only the damaged area of each frame
+ * @callback: (allow-none): the function to call for each captured frame,
+ *   or %NULL to stop capturing
+ * @data: (allow-none): data to be passed to @callback
+ * @notify: (allow-none): function to be called when the callback is removed
+ *
+ * Captures every frame painted by @stage, and passes its contents to
+ * @callback.
+ *
+ * Unlike clutter_stage_read_pixels(), capturing a frame does not force
+ * a paint, and does not wait for the GPU: each frame is read back into
+ * a pixel buffer and delivered to @callback a couple of frames later,
+ * once the transfer has completed. The frames are delivered in the
+ * order they were painted, outside of the paint, and the last frames
+ * are flushed when @stage stops painting. If @stage paints faster than
+ * the frames can be delivered, some of them are dropped; the damage of
+ * a dropped frame is then reported with the next captured one.
+ *
+ * If @damage_only is %TRUE, only the area of the stage that changed
+ * since the previous frame is captured; this is usually a lot cheaper
+ * than capturing the whole stage, for instance when streaming it.
+ *
+ * Setting a %NULL @callback delivers the frames still pending, and
+ * stops capturing.
+ *
+ * Capturing frames is not supported by every backend; on those that
+ * do not support it, @callback is never called.
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+void
+clutter_stage_set_capture_callback (ClutterStage            *stage,
+                                    gboolean                 damage_only,
+                                    ClutterStageCaptureFunc  callback,
+                                    gpointer                 data,
+                                    GDestroyNotify           notify)
+{
+  ClutterStagePrivate *priv;
+  StageCapture *capture;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  priv = stage->priv;
+
+  if (priv->capture != NULL)
+    {
+      capture = priv->capture;
+
+      /* the callback can set a new capture while the pending frames
+       * are delivered, so we detach the current one first
+       */
+      priv->capture = NULL;
+      capture->stopped = TRUE;
+
+      clutter_threads_remove_repaint_func (capture->repaint_id);
+      capture->repaint_id = 0;
+
+      if (capture->flush_id != 0)
+        {
+          g_source_remove (capture->flush_id);
+          capture->flush_id = 0;
+        }
+
+      clutter_stage_deliver_captures (capture, 0);
+
+      if (capture->notify != NULL)
+        capture->notify (capture->data);
+
+      /* if the capture was stopped by its own callback, the buffers
+       * are released once the delivery in progress returns
+       */
+      stage_capture_unref (capture);
+    }
+
+  if (callback == NULL)
+    return;
+
+  capture = g_slice_new0 (StageCapture);
+  capture->ref_count = 1;
+  capture->stage = stage;
+  capture->func = callback;
+  capture->data = data;
+  capture->notify = notify;
+  capture->damage_only = !!damage_only;
+  capture->repaint_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                           clutter_stage_capture_repaint,
+                                           stage_capture_ref (capture),
+                                           (GDestroyNotify) stage_capture_unref);
+
+  priv->capture = capture;
+}
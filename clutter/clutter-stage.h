@@ -135,6 +135,85 @@ struct _ClutterFog
   gfloat z_far;
 };
 
+/**
+ * ClutterFrameStats:
+ * @frame_time: the monotonic time at which the frame began, in
+ *   microseconds
+ * @event_processing: the time spent processing the events of the stage
+ * @timeline_advance: the time spent advancing the timelines
+ * @relayout: the time spent allocating the actors of the stage
+ * @paint: the time spent painting the actors of the stage
+ * @pick: the time spent picking the actors of the stage
+ * @swap: the time spent presenting the frame, once painted
+ * @n_actors_painted: the number of actors that have been painted
+ * @n_actors_culled: the number of actors that have been skipped
+ *   because they were outside of the redraw clip
+ * @n_redraw_clips: the number of redraws queued on the stage
+ * @n_picks: the number of picks done on the stage
+ *
+ * The statistics of a frame drawn by a #ClutterStage, as returned by
+ * clutter_stage_get_frame_stats().
+ *
+ * All the durations are in microseconds. The work done between two
+ * frames, like the events processed and the picks done when the stage
+ * does not need to be redrawn, is accounted to the following frame.
+ *
+ * Since: 1.16
+ */
+struct _ClutterFrameStats
+{
+  gint64 frame_time;
+
+  gint64 event_processing;
+  gint64 timeline_advance;
+  gint64 relayout;
+  gint64 paint;
+  gint64 pick;
+  gint64 swap;
+
+  guint n_actors_painted;
+  guint n_actors_culled;
+  guint n_redraw_clips;
+  guint n_picks;
+};
+
+/**
+ * ClutterActorCost:
+ * @actor: the #ClutterActor
+ * @paint_inclusive: the time spent painting the actor, including
+ *   its children
+ * @paint_exclusive: the time spent painting the actor, excluding
+ *   its children
+ * @allocate_inclusive: the time spent allocating the actor, including
+ *   its children
+ * @allocate_exclusive: the time spent allocating the actor, excluding
+ *   its children
+ * @preferred_size_inclusive: the time spent computing the preferred
+ *   size of the actor, including its children
+ * @preferred_size_exclusive: the time spent computing the preferred
+ *   size of the actor, excluding its children
+ *
+ * The time spent on an actor during a frame, as returned by
+ * clutter_stage_get_actor_costs().
+ *
+ * All the durations are in microseconds. The exclusive durations
+ * exclude the time spent in any nested call that is accounted, like
+ * the size requests of the children done while allocating the actor.
+ *
+ * Since: 1.16
+ */
+struct _ClutterActorCost
+{
+  ClutterActor *actor;
+
+  gint64 paint_inclusive;
+  gint64 paint_exclusive;
+  gint64 allocate_inclusive;
+  gint64 allocate_exclusive;
+  gint64 preferred_size_inclusive;
+  gint64 preferred_size_exclusive;
+};
+
 GType clutter_perspective_get_type (void) G_GNUC_CONST;
 GType clutter_fog_get_type (void) G_GNUC_CONST;
 GType clutter_stage_get_type (void) G_GNUC_CONST;
@@ -202,12 +281,32 @@ void            clutter_stage_ensure_current                    (ClutterStage
 void            clutter_stage_ensure_viewport                   (ClutterStage          *stage);
 void            clutter_stage_ensure_redraw                     (ClutterStage          *stage);
 
+CLUTTER_AVAILABLE_IN_1_16
+guint           clutter_stage_get_frame_stats                   (ClutterStage          *stage,
+                                                                 ClutterFrameStats     *stats,
+                                                                 guint                  n_stats);
+
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_stage_set_actor_costs_enabled           (ClutterStage          *stage,
+                                                                 gboolean               enabled);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean        clutter_stage_get_actor_costs_enabled           (ClutterStage          *stage);
+CLUTTER_AVAILABLE_IN_1_16
+guint           clutter_stage_get_actor_costs                   (ClutterStage          *stage,
+                                                                 ClutterActorCost      *costs,
+                                                                 guint                  n_costs);
+
 #ifdef CLUTTER_ENABLE_EXPERIMENTAL_API
 CLUTTER_AVAILABLE_IN_1_14
 void            clutter_stage_set_sync_delay                    (ClutterStage          *stage,
                                                                  gint                   sync_delay);
 CLUTTER_AVAILABLE_IN_1_14
 void            clutter_stage_skip_sync_delay                   (ClutterStage          *stage);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_stage_set_auto_sync_delay               (ClutterStage          *stage,
+                                                                 gboolean               auto_sync_delay);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean        clutter_stage_get_auto_sync_delay               (ClutterStage          *stage);
 
 typedef void (* ClutterStagePaintFunc) (ClutterStage *stage,
                                         gpointer      data);
@@ -217,6 +316,58 @@ void            clutter_stage_set_paint_callback                (ClutterStage
                                                                  ClutterStagePaintFunc  callback,
                                                                  gpointer               data,
                                                                  GDestroyNotify         notify);
+
+/**
+ * ClutterFrameCapture:
+ * @frame_time: the time the captured frame was painted, in microseconds,
+ *   using the same clock as g_get_monotonic_time()
+ * @area: the area of the stage that was captured, in pixels
+ * @damage: the area of the stage that changed since the previous captured
+ *   frame, in pixels
+ * @stride: the number of bytes between two rows of @data
+ * @data: the pixels of @area, in the %CLUTTER_CAIRO_FORMAT_ARGB32 format
+ *
+ * A frame captured by clutter_stage_set_capture_callback().
+ *
+ * The contents of this structure are only valid for the duration of
+ * the #ClutterStageCaptureFunc it is passed to.
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+struct _ClutterFrameCapture
+{
+  gint64 frame_time;
+
+  cairo_rectangle_int_t area;
+  cairo_rectangle_int_t damage;
+
+  gint stride;
+  const guint8 *data;
+};
+
+/**
+ * ClutterStageCaptureFunc:
+ * @stage: the #ClutterStage that was captured
+ * @frame: the captured frame
+ * @data: data passed to clutter_stage_set_capture_callback()
+ *
+ * The function called for each frame captured by
+ * clutter_stage_set_capture_callback().
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+typedef void (* ClutterStageCaptureFunc) (ClutterStage              *stage,
+                                          const ClutterFrameCapture *frame,
+                                          gpointer                   data);
+
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_stage_set_capture_callback              (ClutterStage            *stage,
+                                                                 gboolean                 damage_only,
+                                                                 ClutterStageCaptureFunc  callback,
+                                                                 gpointer                 data,
+                                                                 GDestroyNotify           notify);
 #endif
 
 G_END_DECLS
@@ -24,6 +24,7 @@
 #endif
 
 #include "clutter-text-buffer.h"
+#include "clutter-text-buffer-private.h"
 #include "clutter-marshal.h"
 #include "clutter-private.h"
 
@@ -52,6 +53,11 @@
 /* Initial size of buffer, in bytes */
 #define MIN_SIZE 16
 
+/* Minimum distance, in characters, between two entries of the
+ * character offset index
+ */
+#define INDEX_STRIDE 256
+
 enum {
   PROP_0,
   PROP_TEXT,
@@ -70,15 +76,37 @@ enum {
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+typedef struct {
+  guint chars;
+  gsize bytes;
+} IndexEntry;
+
 struct _ClutterTextBufferPrivate
 {
   gint  max_length;
 
-  /* Only valid if this class is not derived */
+  /* Only valid if this class is not derived.
+   *
+   * The text is stored in a gap buffer: the normal_text_size bytes
+   * of normal_text hold the text before the gap, the gap between
+   * gap_start and gap_end, and the text after the gap. The gap is
+   * moved to the position of each edit, so that editing the same
+   * area repeatedly does not move the whole tail of the text, and
+   * it is moved to the end of the text when the contents are
+   * retrieved. The bytes in the gap are always zeroed.
+   */
   gchar *normal_text;
   gsize  normal_text_size;
   gsize  normal_text_bytes;
   guint  normal_text_chars;
+  gsize  gap_start;
+  gsize  gap_end;
+
+  /* A sparse, sorted index of character offsets to byte offsets,
+   * used to avoid scanning the text from the start each time a
+   * position has to be converted; entries are added lazily
+   */
+  GArray *index;
 };
 
 G_DEFINE_TYPE (ClutterTextBuffer, clutter_text_buffer, G_TYPE_OBJECT);
@@ -101,15 +129,217 @@ trash_area (gchar *area,
     *varea++ = 0;
 }
 
+/* Moves the gap to the byte offset @pos in the text */
+static void
+gap_buffer_move_gap (ClutterTextBufferPrivate *pv,
+                     gsize                     pos)
+{
+  gsize gap_len = pv->gap_end - pv->gap_start;
+  gsize len;
+
+  if (pos == pv->gap_start)
+    return;
+
+  /* Could be a password: the bytes left behind by the move become part
+   * of the gap, and must not keep a copy of the text.
+   */
+  if (pos < pv->gap_start)
+    {
+      len = pv->gap_start - pos;
+      g_memmove (pv->normal_text + pv->gap_end - len, pv->normal_text + pos, len);
+      trash_area (pv->normal_text + pos, MIN (len, gap_len));
+    }
+  else
+    {
+      len = pos - pv->gap_start;
+      g_memmove (pv->normal_text + pv->gap_start, pv->normal_text + pv->gap_end, len);
+      trash_area (pv->normal_text + pv->gap_end + len - MIN (len, gap_len),
+                  MIN (len, gap_len));
+    }
+
+  pv->gap_start = pos;
+  pv->gap_end = pos + gap_len;
+}
+
+/* Returns the byte offset of the character @n_chars characters after
+ * the one at the byte offset @bytes, skipping over the gap
+ */
+static gsize
+gap_buffer_skip_chars (ClutterTextBufferPrivate *pv,
+                       gsize                     bytes,
+                       guint                     n_chars)
+{
+  const guchar *text = (const guchar *) pv->normal_text;
+  gsize gap_len = pv->gap_end - pv->gap_start;
+
+  while (n_chars-- > 0)
+    {
+      if (bytes < pv->gap_start)
+        bytes += g_utf8_skip[text[bytes]];
+      else
+        bytes += g_utf8_skip[text[bytes + gap_len]];
+    }
+
+  return bytes;
+}
+
+/* Returns the position of the last index entry at or before the
+ * character @position, or -1
+ */
+static gint
+gap_buffer_index_lookup (ClutterTextBufferPrivate *pv,
+                         guint                     position)
+{
+  const IndexEntry *entries = (const IndexEntry *) pv->index->data;
+  gint lo = 0, hi = (gint) pv->index->len - 1;
+  gint res = -1;
+
+  while (lo <= hi)
+    {
+      gint mid = (lo + hi) / 2;
+
+      if (entries[mid].chars <= position)
+        {
+          res = mid;
+          lo = mid + 1;
+        }
+      else
+        hi = mid - 1;
+    }
+
+  return res;
+}
+
+static gsize
+gap_buffer_offset_to_bytes (ClutterTextBufferPrivate *pv,
+                            guint                     position)
+{
+  IndexEntry entry = { 0, 0 };
+  gint i;
+
+  if (position >= pv->normal_text_chars)
+    return pv->normal_text_bytes;
+
+  i = gap_buffer_index_lookup (pv, position);
+  if (i >= 0)
+    entry = g_array_index (pv->index, IndexEntry, i);
+
+  if (position - entry.chars < INDEX_STRIDE)
+    return gap_buffer_skip_chars (pv, entry.bytes, position - entry.chars);
+
+  /* remember the position, to skip the scan the next time */
+  entry.bytes = gap_buffer_skip_chars (pv, entry.bytes, position - entry.chars);
+  entry.chars = position;
+  g_array_insert_val (pv->index, i + 1, entry);
+
+  return entry.bytes;
+}
+
+/* Returns the character offset of the byte offset @bytes, using the
+ * closest index entry before it
+ */
+static guint
+gap_buffer_bytes_to_offset (ClutterTextBufferPrivate *pv,
+                            gsize                     bytes)
+{
+  const IndexEntry *entries = (const IndexEntry *) pv->index->data;
+  const guchar *text = (const guchar *) pv->normal_text;
+  gsize gap_len = pv->gap_end - pv->gap_start;
+  IndexEntry entry = { 0, 0 };
+  gint lo = 0, hi = (gint) pv->index->len - 1;
+  gsize cur;
+  guint chars;
+
+  if (bytes >= pv->normal_text_bytes)
+    return pv->normal_text_chars;
+
+  /* the entries are sorted by bytes as well as by characters */
+  while (lo <= hi)
+    {
+      gint mid = (lo + hi) / 2;
+
+      if (entries[mid].bytes <= bytes)
+        {
+          entry = entries[mid];
+          lo = mid + 1;
+        }
+      else
+        hi = mid - 1;
+    }
+
+  for (cur = entry.bytes, chars = entry.chars; cur < bytes; chars++)
+    {
+      if (cur < pv->gap_start)
+        cur += g_utf8_skip[text[cur]];
+      else
+        cur += g_utf8_skip[text[cur + gap_len]];
+    }
+
+  return chars;
+}
+
+/* Updates the index after inserting @n_chars characters, for @n_bytes
+ * bytes, at @position
+ */
+static void
+gap_buffer_index_insert (ClutterTextBufferPrivate *pv,
+                         guint                     position,
+                         guint                     n_chars,
+                         gsize                     n_bytes)
+{
+  guint i;
+
+  for (i = gap_buffer_index_lookup (pv, position) + 1; i < pv->index->len; i++)
+    {
+      IndexEntry *entry = &g_array_index (pv->index, IndexEntry, i);
+
+      entry->chars += n_chars;
+      entry->bytes += n_bytes;
+    }
+}
+
+/* Updates the index after removing @n_chars characters, for @n_bytes
+ * bytes, at @position
+ */
+static void
+gap_buffer_index_delete (ClutterTextBufferPrivate *pv,
+                         guint                     position,
+                         guint                     n_chars,
+                         gsize                     n_bytes)
+{
+  guint first, last, i;
+
+  first = gap_buffer_index_lookup (pv, position) + 1;
+  last = gap_buffer_index_lookup (pv, position + n_chars) + 1;
+
+  if (last > first)
+    g_array_remove_range (pv->index, first, last - first);
+
+  for (i = first; i < pv->index->len; i++)
+    {
+      IndexEntry *entry = &g_array_index (pv->index, IndexEntry, i);
+
+      entry->chars -= n_chars;
+      entry->bytes -= n_bytes;
+    }
+}
+
 static const gchar*
 clutter_text_buffer_normal_get_text (ClutterTextBuffer *buffer,
                                   gsize          *n_bytes)
 {
+  ClutterTextBufferPrivate *pv = buffer->priv;
+
   if (n_bytes)
-    *n_bytes = buffer->priv->normal_text_bytes;
-  if (!buffer->priv->normal_text)
+    *n_bytes = pv->normal_text_bytes;
+  if (!pv->normal_text)
       return "";
-  return buffer->priv->normal_text;
+
+  /* the gap always has room for the terminating zero */
+  gap_buffer_move_gap (pv, pv->normal_text_bytes);
+  pv->normal_text[pv->normal_text_bytes] = '\0';
+
+  return pv->normal_text;
 }
 
 static guint
@@ -135,6 +365,7 @@ clutter_text_buffer_normal_insert_text (ClutterTextBuffer *buffer,
   if (n_bytes + pv->normal_text_bytes + 1 > pv->normal_text_size)
     {
       gchar *et_new;
+      gsize tail;
 
       prev_size = pv->normal_text_size;
 
@@ -161,23 +392,36 @@ clutter_text_buffer_normal_insert_text (ClutterTextBuffer *buffer,
             }
         }
 
-      /* Could be a password, so can't leave stuff in memory. */
-      et_new = g_malloc (pv->normal_text_size);
-      memcpy (et_new, pv->normal_text, MIN (prev_size, pv->normal_text_size));
-      trash_area (pv->normal_text, prev_size);
-      g_free (pv->normal_text);
+      /* Could be a password, so can't leave stuff in memory. The text
+       * after the gap is moved to the end of the new buffer, which
+       * leaves the gap zeroed.
+       */
+      tail = prev_size - pv->gap_end;
+
+      et_new = g_malloc0 (pv->normal_text_size);
+      if (pv->normal_text != NULL)
+        {
+          memcpy (et_new, pv->normal_text, pv->gap_start);
+          memcpy (et_new + pv->normal_text_size - tail, pv->normal_text + pv->gap_end, tail);
+          trash_area (pv->normal_text, prev_size);
+          g_free (pv->normal_text);
+        }
+
       pv->normal_text = et_new;
+      pv->gap_end = pv->normal_text_size - tail;
     }
 
   /* Actual text insertion */
-  at = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
-  g_memmove (pv->normal_text + at + n_bytes, pv->normal_text + at, pv->normal_text_bytes - at);
-  memcpy (pv->normal_text + at, chars, n_bytes);
+  at = gap_buffer_offset_to_bytes (pv, position);
+  gap_buffer_move_gap (pv, at);
+  memcpy (pv->normal_text + pv->gap_start, chars, n_bytes);
+  pv->gap_start += n_bytes;
+
+  gap_buffer_index_insert (pv, position, n_chars, n_bytes);
 
   /* Book keeping */
   pv->normal_text_bytes += n_bytes;
   pv->normal_text_chars += n_chars;
-  pv->normal_text[pv->normal_text_bytes] = '\0';
 
   clutter_text_buffer_emit_inserted_text (buffer, position, chars, n_chars);
   return n_chars;
@@ -198,19 +442,23 @@ clutter_text_buffer_normal_delete_text (ClutterTextBuffer *buffer,
 
   if (n_chars > 0)
     {
-      start = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
-      end = g_utf8_offset_to_pointer (pv->normal_text, position + n_chars) - pv->normal_text;
+      start = gap_buffer_offset_to_bytes (pv, position);
+      end = gap_buffer_skip_chars (pv, start, n_chars);
 
-      g_memmove (pv->normal_text + start, pv->normal_text + end, pv->normal_text_bytes + 1 - end);
-      pv->normal_text_chars -= n_chars;
-      pv->normal_text_bytes -= (end - start);
+      /* The deleted text becomes part of the gap */
+      gap_buffer_move_gap (pv, start);
 
       /*
-       * Could be a password, make sure we don't leave anything sensitive after
-       * the terminating zero.  Note, that the terminating zero already trashed
-       * one byte.
+       * Could be a password, make sure we don't leave anything sensitive
+       * inside the gap.
        */
-      trash_area (pv->normal_text + pv->normal_text_bytes + 1, end - start - 1);
+      trash_area (pv->normal_text + pv->gap_end, end - start);
+      pv->gap_end += (end - start);
+
+      gap_buffer_index_delete (pv, position, n_chars, end - start);
+
+      pv->normal_text_chars -= n_chars;
+      pv->normal_text_bytes -= (end - start);
 
       clutter_text_buffer_emit_deleted_text (buffer, position, n_chars);
     }
@@ -218,6 +466,169 @@ clutter_text_buffer_normal_delete_text (ClutterTextBuffer *buffer,
   return n_chars;
 }
 
+/* whether the contents of @buffer are stored in the gap buffer */
+static inline gboolean
+clutter_text_buffer_is_normal (ClutterTextBuffer *buffer)
+{
+  ClutterTextBufferClass *klass = CLUTTER_TEXT_BUFFER_GET_CLASS (buffer);
+
+  return klass->get_text == clutter_text_buffer_normal_get_text &&
+         klass->insert_text == clutter_text_buffer_normal_insert_text &&
+         klass->delete_text == clutter_text_buffer_normal_delete_text;
+}
+
+/*< private >
+ * _clutter_text_buffer_offset_to_bytes:
+ * @buffer: a #ClutterTextBuffer
+ * @position: a position in the buffer, in characters
+ *
+ * Converts a character offset in the contents of @buffer into a byte
+ * offset; positions past the end of the text are clamped to its
+ * length, like the contents of the buffer were scanned up to the
+ * terminating zero.
+ *
+ * The default implementation keeps an index of character offsets, so
+ * this is cheaper than scanning the result of
+ * clutter_text_buffer_get_text() from the start.
+ *
+ * Return value: the offset in bytes
+ */
+gsize
+_clutter_text_buffer_offset_to_bytes (ClutterTextBuffer *buffer,
+                                      guint              position)
+{
+  const gchar *text, *ptr;
+
+  if (clutter_text_buffer_is_normal (buffer))
+    return gap_buffer_offset_to_bytes (buffer->priv, position);
+
+  text = clutter_text_buffer_get_text (buffer);
+
+  for (ptr = text; *ptr && position-- > 0; ptr = g_utf8_next_char (ptr))
+    ;
+
+  return ptr - text;
+}
+
+/*< private >
+ * _clutter_text_buffer_bytes_to_offset:
+ * @buffer: a #ClutterTextBuffer
+ * @index_: an offset in the contents of the buffer, in bytes
+ *
+ * Converts a byte offset in the contents of @buffer into a character
+ * offset; offsets past the end of the text are clamped to its length.
+ *
+ * Unlike scanning the result of clutter_text_buffer_get_text(), this
+ * does not move the gap of the default implementation.
+ *
+ * Return value: the offset in characters
+ */
+guint
+_clutter_text_buffer_bytes_to_offset (ClutterTextBuffer *buffer,
+                                      gsize              index_)
+{
+  const gchar *text;
+
+  if (clutter_text_buffer_is_normal (buffer))
+    return gap_buffer_bytes_to_offset (buffer->priv, index_);
+
+  text = clutter_text_buffer_get_text (buffer);
+  index_ = MIN (index_, clutter_text_buffer_get_bytes (buffer));
+
+  return g_utf8_pointer_to_offset (text, text + index_);
+}
+
+/*< private >
+ * _clutter_text_buffer_get_segments:
+ * @buffer: a #ClutterTextBuffer
+ * @before: (out): return location for the text before the gap
+ * @n_before: (out): return location for the length of @before, in bytes
+ * @after: (out): return location for the text after the gap
+ * @n_after: (out): return location for the length of @after, in bytes
+ *
+ * Retrieves the contents of @buffer as two segments, without moving
+ * the gap of the default implementation to the end of the text like
+ * clutter_text_buffer_get_text() does; this keeps the following edits
+ * close to the gap cheap.
+ *
+ * Neither segment is NUL-terminated. Buffers using their own storage
+ * return all of their contents in @before, and an empty @after.
+ *
+ * The segments are only valid until the next change in @buffer.
+ */
+void
+_clutter_text_buffer_get_segments (ClutterTextBuffer  *buffer,
+                                   const gchar       **before,
+                                   gsize              *n_before,
+                                   const gchar       **after,
+                                   gsize              *n_after)
+{
+  ClutterTextBufferPrivate *pv = buffer->priv;
+
+  if (!clutter_text_buffer_is_normal (buffer))
+    {
+      *before = clutter_text_buffer_get_text (buffer);
+      *n_before = clutter_text_buffer_get_bytes (buffer);
+      *after = "";
+      *n_after = 0;
+      return;
+    }
+
+  if (pv->normal_text == NULL)
+    {
+      *before = *after = "";
+      *n_before = *n_after = 0;
+      return;
+    }
+
+  *before = pv->normal_text;
+  *n_before = pv->gap_start;
+  *after = pv->normal_text + pv->gap_end;
+  *n_after = pv->normal_text_bytes - pv->gap_start;
+}
+
+/*< private >
+ * _clutter_text_buffer_dup_bytes:
+ * @buffer: a #ClutterTextBuffer
+ * @start: the offset of the first byte to copy
+ * @n_bytes: the number of bytes to copy
+ *
+ * Copies a range of the contents of @buffer, in bytes, without moving
+ * the gap of the default implementation.
+ *
+ * Return value: (transfer full): a newly allocated, NUL-terminated
+ *   string; use g_free() to free it
+ */
+gchar *
+_clutter_text_buffer_dup_bytes (ClutterTextBuffer *buffer,
+                                gsize              start,
+                                gsize              n_bytes)
+{
+  const gchar *before, *after;
+  gsize n_before, n_after;
+  gchar *retval;
+
+  _clutter_text_buffer_get_segments (buffer, &before, &n_before, &after, &n_after);
+
+  g_return_val_if_fail (start + n_bytes <= n_before + n_after, NULL);
+
+  retval = g_malloc (n_bytes + 1);
+
+  if (start + n_bytes <= n_before)
+    memcpy (retval, before + start, n_bytes);
+  else if (start >= n_before)
+    memcpy (retval, after + (start - n_before), n_bytes);
+  else
+    {
+      memcpy (retval, before + start, n_before - start);
+      memcpy (retval + (n_before - start), after, n_bytes - (n_before - start));
+    }
+
+  retval[n_bytes] = '\0';
+
+  return retval;
+}
+
 /* --------------------------------------------------------------------------------
  *
  */
@@ -256,6 +667,10 @@ clutter_text_buffer_init (ClutterTextBuffer *buffer)
   pv->normal_text_chars = 0;
   pv->normal_text_bytes = 0;
   pv->normal_text_size = 0;
+  pv->gap_start = 0;
+  pv->gap_end = 0;
+
+  pv->index = g_array_new (FALSE, FALSE, sizeof (IndexEntry));
 }
 
 static void
@@ -271,8 +686,11 @@ clutter_text_buffer_finalize (GObject *obj)
       pv->normal_text = NULL;
       pv->normal_text_bytes = pv->normal_text_size = 0;
       pv->normal_text_chars = 0;
+      pv->gap_start = pv->gap_end = 0;
     }
 
+  g_array_unref (pv->index);
+
   G_OBJECT_CLASS (clutter_text_buffer_parent_class)->finalize (obj);
 }
 
@@ -512,6 +930,10 @@ clutter_text_buffer_get_bytes (ClutterTextBuffer *buffer)
 
   g_return_val_if_fail (CLUTTER_IS_TEXT_BUFFER (buffer), 0);
 
+  /* retrieving the text would move the gap to the end */
+  if (clutter_text_buffer_is_normal (buffer))
+    return buffer->priv->normal_text_bytes;
+
   klass = CLUTTER_TEXT_BUFFER_GET_CLASS (buffer);
   g_return_val_if_fail (klass->get_text != NULL, 0);
 
@@ -0,0 +1,51 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_TEXT_SHAPER_PRIVATE_H__
+#define __CLUTTER_TEXT_SHAPER_PRIVATE_H__
+
+#include <pango/pango.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ClutterTextShapeJob     ClutterTextShapeJob;
+
+/*< private >
+ * ClutterTextShapeFunc:
+ * @layout: (allow-none): the shaped layout, or %NULL if the worker
+ *   thread could not shape it
+ * @user_data: the data passed to _clutter_text_shape_layout_async()
+ *
+ * The function called, in the main thread, when an asynchronous
+ * shaping job completes. The function must acquire a reference on
+ * @layout in order to keep it.
+ */
+typedef void (* ClutterTextShapeFunc) (PangoLayout *layout,
+                                       gpointer     user_data);
+
+ClutterTextShapeJob *   _clutter_text_shape_layout_async        (PangoLayout          *layout,
+                                                                 ClutterTextShapeFunc  func,
+                                                                 gpointer              user_data);
+void                    _clutter_text_shape_job_cancel          (ClutterTextShapeJob  *job);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_TEXT_SHAPER_PRIVATE_H__ */
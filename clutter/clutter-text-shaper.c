@@ -0,0 +1,556 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The text shaper lays out PangoLayouts inside a worker thread, on
+ * behalf of the ClutterText actors using the :async-layout property.
+ *
+ * Pango font maps, and the fonts they create, are not thread safe, so
+ * the worker cannot use the font map of the main context; instead, it
+ * uses a font map of its own, which is handed over to the main thread
+ * together with the layouts shaped with it. From that point on the
+ * worker thread switches to a spare font map, and the font map it
+ * handed over is only used by the main thread, to paint the layouts,
+ * until all of them have been released.
+ *
+ * The font maps are created by the main thread, as creating a
+ * CoglPangoFontMap requires a Cogl context, and their number is
+ * bounded; if no font map is available the layouts are simply shaped
+ * synchronously by the caller.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pango/pangocairo.h>
+
+#include "clutter-text-shaper-private.h"
+
+#include "clutter-backend.h"
+#include "clutter-debug.h"
+#include "clutter-main.h"
+#include "clutter-master-clock.h"
+#include "clutter-private.h"
+
+#define MAX_FONT_MAPS   4
+
+typedef struct _ShaperFontMap   ShaperFontMap;
+
+struct _ShaperFontMap
+{
+  CoglPangoFontMap *font_map;
+
+  /* the number of PangoContexts created from the font map that
+   * are still alive
+   */
+  guint n_contexts;
+};
+
+struct _ClutterTextShapeJob
+{
+  /* the parameters of the layout */
+  gchar *text;
+  PangoAttrList *attrs;
+  PangoFontDescription *font_desc;
+  PangoTabArray *tabs;
+  gint width;
+  gint height;
+  gint indent;
+  gint spacing;
+  PangoAlignment alignment;
+  PangoWrapMode wrap;
+  PangoEllipsizeMode ellipsize;
+
+  /* the parameters of the context */
+  PangoFontDescription *context_font_desc;
+  PangoDirection base_dir;
+  PangoLanguage *language;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+
+  /* the font map used to shape the layout, and the result */
+  ShaperFontMap *font_map;
+  PangoLayout *layout;
+
+  ClutterTextShapeFunc func;
+  gpointer user_data;
+
+  guint justify : 1;
+  guint single_paragraph : 1;
+  guint auto_dir : 1;
+  guint cancelled : 1;
+};
+
+static struct {
+  GMutex lock;
+
+  GThreadPool *pool;
+
+  /* the font map used by the worker thread; none of the layouts
+   * shaped with it have been handed to the main thread yet
+   */
+  ShaperFontMap *worker_font_map;
+
+  /* font maps without live contexts */
+  GSList *spare_font_maps;
+  guint n_font_maps;
+
+  /* the completed jobs, in order of completion */
+  GQueue done;
+
+  guint repaint_func;
+
+  /* the idle source delivering the completed jobs, added by the
+   * worker thread so that the main loop wakes up even if no frame
+   * is being painted
+   */
+  guint deliver_id;
+
+  guint running : 1;
+  guint retire_requested : 1;
+} shaper;
+
+static gboolean clutter_text_shaper_deliver_idle (gpointer data);
+
+static void
+clutter_text_shape_job_free (ClutterTextShapeJob *job)
+{
+  /* this function is only called by the main thread, after the job
+   * has been completed
+   */
+  g_free (job->text);
+
+  if (job->attrs != NULL)
+    pango_attr_list_unref (job->attrs);
+
+  if (job->font_desc != NULL)
+    pango_font_description_free (job->font_desc);
+
+  if (job->tabs != NULL)
+    pango_tab_array_free (job->tabs);
+
+  if (job->context_font_desc != NULL)
+    pango_font_description_free (job->context_font_desc);
+
+  if (job->font_options != NULL)
+    cairo_font_options_destroy (job->font_options);
+
+  if (job->layout != NULL)
+    g_object_unref (job->layout);
+
+  g_slice_free (ClutterTextShapeJob, job);
+}
+
+/* called with the lock held */
+static void
+clutter_text_shaper_retire_worker_font_map (void)
+{
+  ShaperFontMap *font_map = shaper.worker_font_map;
+
+  if (font_map == NULL)
+    return;
+
+  shaper.worker_font_map = NULL;
+
+  /* the layouts shaped with it might all be gone already */
+  if (font_map->n_contexts == 0)
+    shaper.spare_font_maps = g_slist_prepend (shaper.spare_font_maps,
+                                              font_map);
+}
+
+static void
+clutter_text_shaper_context_finalized (gpointer  data,
+                                       GObject  *context)
+{
+  ShaperFontMap *font_map = data;
+
+  g_mutex_lock (&shaper.lock);
+
+  font_map->n_contexts -= 1;
+
+  if (font_map->n_contexts == 0 && font_map != shaper.worker_font_map)
+    {
+      CLUTTER_NOTE (PANGO, "Font map %p of the text shaper is spare again",
+                    font_map->font_map);
+
+      shaper.spare_font_maps = g_slist_prepend (shaper.spare_font_maps,
+                                                font_map);
+    }
+
+  g_mutex_unlock (&shaper.lock);
+}
+
+/*
+ * clutter_text_shaper_ensure_spare_font_map:
+ *
+ * Makes sure that the worker thread has a font map to switch to
+ * once it hands over its current one, if the maximum number of font
+ * maps has not been reached.
+ *
+ * This function must be called from the main thread.
+ */
+static void
+clutter_text_shaper_ensure_spare_font_map (void)
+{
+  ShaperFontMap *font_map;
+  CoglPangoFontMap *default_map;
+  ClutterBackend *backend;
+  gboolean needs_font_map;
+
+  g_mutex_lock (&shaper.lock);
+
+  needs_font_map = shaper.spare_font_maps == NULL &&
+                   shaper.n_font_maps < MAX_FONT_MAPS;
+
+  if (needs_font_map)
+    shaper.n_font_maps += 1;
+
+  g_mutex_unlock (&shaper.lock);
+
+  if (!needs_font_map)
+    return;
+
+  backend = clutter_get_default_backend ();
+  default_map = COGL_PANGO_FONT_MAP (clutter_get_font_map ());
+
+  font_map = g_slice_new0 (ShaperFontMap);
+  font_map->font_map = COGL_PANGO_FONT_MAP (cogl_pango_font_map_new ());
+
+  cogl_pango_font_map_set_resolution (font_map->font_map,
+                                      clutter_backend_get_resolution (backend));
+  cogl_pango_font_map_set_use_mipmapping (font_map->font_map,
+                                          cogl_pango_font_map_get_use_mipmapping (default_map));
+
+  CLUTTER_NOTE (PANGO, "Created font map %p for the text shaper",
+                font_map->font_map);
+
+  g_mutex_lock (&shaper.lock);
+  shaper.spare_font_maps = g_slist_prepend (shaper.spare_font_maps, font_map);
+  g_mutex_unlock (&shaper.lock);
+}
+
+static PangoLayout *
+clutter_text_shape_job_run (ClutterTextShapeJob *job,
+                            ShaperFontMap       *font_map)
+{
+  PangoContext *context;
+  PangoLayout *layout;
+
+  context = cogl_pango_font_map_create_context (font_map->font_map);
+  g_object_weak_ref (G_OBJECT (context),
+                     clutter_text_shaper_context_finalized,
+                     font_map);
+
+  pango_context_set_base_dir (context, job->base_dir);
+  pango_context_set_language (context, job->language);
+  pango_context_set_font_description (context, job->context_font_desc);
+  pango_cairo_context_set_font_options (context, job->font_options);
+  pango_cairo_context_set_resolution (context, job->resolution);
+
+  layout = pango_layout_new (context);
+  g_object_unref (context);
+
+  pango_layout_set_auto_dir (layout, job->auto_dir);
+  pango_layout_set_text (layout, job->text, -1);
+  pango_layout_set_attributes (layout, job->attrs);
+  pango_layout_set_font_description (layout, job->font_desc);
+  pango_layout_set_tabs (layout, job->tabs);
+  pango_layout_set_alignment (layout, job->alignment);
+  pango_layout_set_single_paragraph_mode (layout, job->single_paragraph);
+  pango_layout_set_justify (layout, job->justify);
+  pango_layout_set_wrap (layout, job->wrap);
+  pango_layout_set_ellipsize (layout, job->ellipsize);
+  pango_layout_set_indent (layout, job->indent);
+  pango_layout_set_spacing (layout, job->spacing);
+  pango_layout_set_width (layout, job->width);
+  pango_layout_set_height (layout, job->height);
+
+  /* this lays out all the lines of the layout */
+  pango_layout_get_extents (layout, NULL, NULL);
+
+  return layout;
+}
+
+static void
+clutter_text_shaper_thread_func (gpointer data,
+                                 gpointer pool_data)
+{
+  ClutterTextShapeJob *job = data;
+  ShaperFontMap *font_map = NULL;
+
+  g_mutex_lock (&shaper.lock);
+
+  if (!job->cancelled)
+    {
+      if (shaper.retire_requested)
+        {
+          clutter_text_shaper_retire_worker_font_map ();
+          shaper.retire_requested = FALSE;
+        }
+
+      if (shaper.worker_font_map == NULL && shaper.spare_font_maps != NULL)
+        {
+          shaper.worker_font_map = shaper.spare_font_maps->data;
+          shaper.spare_font_maps =
+            g_slist_delete_link (shaper.spare_font_maps,
+                                 shaper.spare_font_maps);
+        }
+
+      font_map = shaper.worker_font_map;
+      if (font_map != NULL)
+        {
+          font_map->n_contexts += 1;
+          shaper.running = TRUE;
+        }
+    }
+
+  g_mutex_unlock (&shaper.lock);
+
+  /* if all the font maps are in use by the main thread the job
+   * fails, and the layout will be shaped by the main thread
+   */
+  if (font_map != NULL)
+    job->layout = clutter_text_shape_job_run (job, font_map);
+
+  g_mutex_lock (&shaper.lock);
+
+  job->font_map = font_map;
+  shaper.running = FALSE;
+  g_queue_push_tail (&shaper.done, job);
+
+  if (shaper.deliver_id == 0)
+    shaper.deliver_id =
+      clutter_threads_add_idle_full (G_PRIORITY_DEFAULT,
+                                     clutter_text_shaper_deliver_idle,
+                                     NULL,
+                                     NULL);
+
+  g_mutex_unlock (&shaper.lock);
+}
+
+/* hands the completed jobs over to their ClutterText actors; this
+ * function must be called from the main thread
+ */
+static void
+clutter_text_shaper_deliver (void)
+{
+  GQueue completed = G_QUEUE_INIT;
+  ClutterTextShapeJob *job;
+  GList *l, *next;
+  gboolean pending;
+
+  g_mutex_lock (&shaper.lock);
+
+  if (shaper.done.length == 0)
+    {
+      g_mutex_unlock (&shaper.lock);
+      return;
+    }
+
+  /* the layouts shaped with the font map of the worker thread can
+   * only be handed over once the worker stops using it; if the
+   * worker is busy, we ask it to switch font map before its next job
+   */
+  if (!shaper.running)
+    clutter_text_shaper_retire_worker_font_map ();
+
+  for (l = shaper.done.head; l != NULL; l = next)
+    {
+      job = l->data;
+      next = l->next;
+
+      if (job->font_map != NULL && job->font_map == shaper.worker_font_map)
+        continue;
+
+      g_queue_unlink (&shaper.done, l);
+      g_queue_push_tail_link (&completed, l);
+    }
+
+  pending = shaper.done.length != 0;
+  if (pending)
+    shaper.retire_requested = TRUE;
+
+  g_mutex_unlock (&shaper.lock);
+
+  CLUTTER_NOTE (PANGO, "Text shaper: %u jobs completed, %s",
+                completed.length,
+                pending ? "some pending" : "none pending");
+
+  while ((job = g_queue_pop_head (&completed)) != NULL)
+    {
+      if (!job->cancelled)
+        job->func (job->layout, job->user_data);
+
+      clutter_text_shape_job_free (job);
+    }
+
+  clutter_text_shaper_ensure_spare_font_map ();
+
+  if (pending)
+    _clutter_master_clock_ensure_next_iteration (_clutter_master_clock_get_default ());
+}
+
+static gboolean
+clutter_text_shaper_deliver_idle (gpointer data)
+{
+  g_mutex_lock (&shaper.lock);
+  shaper.deliver_id = 0;
+  g_mutex_unlock (&shaper.lock);
+
+  clutter_text_shaper_deliver ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+clutter_text_shaper_repaint_func (gpointer data)
+{
+  /* the completed jobs are also delivered before each frame, so
+   * that the jobs completed while the stage is being updated do not
+   * wait for the idle source
+   */
+  clutter_text_shaper_deliver ();
+
+  return TRUE;
+}
+
+/*< private >
+ * _clutter_text_shape_layout_async:
+ * @layout: a #PangoLayout, used as a template
+ * @func: the function to call when the layout has been shaped
+ * @user_data: data to pass to @func
+ *
+ * Shapes a copy of @layout inside a worker thread. The contents and
+ * the parameters of @layout and of its #PangoContext are copied, so
+ * @layout can be modified or released after this function returns.
+ *
+ * The copy is passed to @func, from within the main thread, as soon
+ * as the main loop is idle or before the next frame is painted,
+ * whichever comes first; the copy can be painted and queried like
+ * any other layout, but it must not be modified.
+ *
+ * Return value: (transfer none): a handle for the job, which can be
+ *   used to cancel it until @func is called, or %NULL if the layout
+ *   cannot be shaped asynchronously
+ */
+ClutterTextShapeJob *
+_clutter_text_shape_layout_async (PangoLayout          *layout,
+                                  ClutterTextShapeFunc  func,
+                                  gpointer              user_data)
+{
+  const cairo_font_options_t *font_options;
+  const PangoFontDescription *font_desc;
+  ClutterTextShapeJob *job;
+  PangoContext *context;
+  PangoAttrList *attrs;
+  gboolean available;
+
+  g_return_val_if_fail (PANGO_IS_LAYOUT (layout), NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  clutter_text_shaper_ensure_spare_font_map ();
+
+  g_mutex_lock (&shaper.lock);
+  available = shaper.worker_font_map != NULL ||
+              shaper.spare_font_maps != NULL;
+  g_mutex_unlock (&shaper.lock);
+
+  if (!available)
+    {
+      CLUTTER_NOTE (PANGO, "No font map available for the text shaper");
+      return NULL;
+    }
+
+  if (G_UNLIKELY (shaper.pool == NULL))
+    {
+      /* This apparently can't fail if exclusive == FALSE */
+      shaper.pool = g_thread_pool_new (clutter_text_shaper_thread_func,
+                                       NULL,
+                                       1,
+                                       FALSE,
+                                       NULL);
+
+      shaper.repaint_func =
+        clutter_threads_add_repaint_func (clutter_text_shaper_repaint_func,
+                                          NULL,
+                                          NULL);
+    }
+
+  context = pango_layout_get_context (layout);
+
+  job = g_slice_new0 (ClutterTextShapeJob);
+  job->func = func;
+  job->user_data = user_data;
+
+  job->text = g_strdup (pango_layout_get_text (layout));
+
+  attrs = pango_layout_get_attributes (layout);
+  if (attrs != NULL)
+    job->attrs = pango_attr_list_copy (attrs);
+
+  font_desc = pango_layout_get_font_description (layout);
+  if (font_desc != NULL)
+    job->font_desc = pango_font_description_copy (font_desc);
+
+  job->tabs = pango_layout_get_tabs (layout);
+  job->width = pango_layout_get_width (layout);
+  job->height = pango_layout_get_height (layout);
+  job->indent = pango_layout_get_indent (layout);
+  job->spacing = pango_layout_get_spacing (layout);
+  job->alignment = pango_layout_get_alignment (layout);
+  job->wrap = pango_layout_get_wrap (layout);
+  job->ellipsize = pango_layout_get_ellipsize (layout);
+  job->justify = pango_layout_get_justify (layout);
+  job->single_paragraph = pango_layout_get_single_paragraph_mode (layout);
+  job->auto_dir = pango_layout_get_auto_dir (layout);
+
+  job->context_font_desc =
+    pango_font_description_copy (pango_context_get_font_description (context));
+  job->base_dir = pango_context_get_base_dir (context);
+  job->language = pango_context_get_language (context);
+  job->resolution = pango_cairo_context_get_resolution (context);
+
+  font_options = pango_cairo_context_get_font_options (context);
+  if (font_options != NULL)
+    job->font_options = cairo_font_options_copy (font_options);
+
+  g_thread_pool_push (shaper.pool, job, NULL);
+
+  return job;
+}
+
+/*< private >
+ * _clutter_text_shape_job_cancel:
+ * @job: a #ClutterTextShapeJob
+ *
+ * Cancels @job; the function passed to _clutter_text_shape_layout_async()
+ * will not be called.
+ *
+ * This function must be called from the main thread, before the
+ * job completes.
+ */
+void
+_clutter_text_shape_job_cancel (ClutterTextShapeJob *job)
+{
+  g_mutex_lock (&shaper.lock);
+  job->cancelled = TRUE;
+  g_mutex_unlock (&shaper.lock);
+}
@@ -59,7 +59,8 @@
 #include "clutter-private.h"    /* includes <cogl-pango/cogl-pango.h> */
 #include "clutter-profile.h"
 #include "clutter-property-transition.h"
-#include "clutter-text-buffer.h"
+#include "clutter-text-buffer-private.h"
+#include "clutter-text-shaper-private.h"
 #include "clutter-units.h"
 #include "clutter-paint-volume-private.h"
 #include "clutter-scriptable.h"
@@ -82,9 +83,39 @@
  */
 #define N_CACHED_LAYOUTS        6
 
+/* Layouts of non-editable text actors are also stored in a process-wide
+ * cache, so that actors showing the same text with the same font and
+ * layout parameters can share the same PangoLayout; lists and grids
+ * tend to repeat the same strings over and over.
+ *
+ * The shared cache is bounded by an estimate of the memory used by the
+ * layouts, and it evicts the least recently used ones first.
+ */
+#define SHARED_LAYOUTS_MAX_SIZE         (4 * 1024 * 1024)
+#define SHARED_LAYOUT_BYTES_PER_CHAR    32
+#define SHARED_LAYOUT_BYTES_OVERHEAD    512
+
+/* Wrapping, editable texts with many paragraphs are laid out one
+ * paragraph at a time, so that an edit only needs to re-shape the
+ * paragraphs it touches instead of the whole contents; we keep the
+ * layouts for two widths, the unconstrained one used for the width
+ * request and the allocated one.
+ *
+ * Texts using the :lazy-layout property are always laid out one
+ * paragraph at a time, and a paragraph is only shaped once it
+ * becomes visible; until then its size is estimated from the
+ * metrics of the font.
+ */
+#define PARAGRAPHS_MIN_LINES    32
+#define N_PARAGRAPH_SLOTS       2
+
 #define CLUTTER_TEXT_GET_PRIVATE(obj)   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_TEXT, ClutterTextPrivate))
 
 typedef struct _LayoutCache     LayoutCache;
+typedef struct _SharedLayout    SharedLayout;
+typedef struct _TextParagraph   TextParagraph;
+typedef struct _ParagraphSlot   ParagraphSlot;
+typedef struct _ShapeRequest    ShapeRequest;
 
 static const ClutterColor default_cursor_color    = {   0,   0,   0, 255 };
 static const ClutterColor default_selection_color = {   0,   0,   0, 255 };
@@ -117,8 +148,112 @@ struct _LayoutCache
    * new layout is needed the last used cache is replaced)
    */
   guint age;
+
+  /* Whether the layout comes from the shared cache, and may be in
+   * use by other actors
+   */
+  guint shared : 1;
+};
+
+struct _SharedLayout
+{
+  /* the key */
+  PangoFontDescription *font_desc;
+  PangoAttrList *attrs;
+  gchar *text;
+  gsize text_len;
+  gint width;
+  gint height;
+  guint alignment : 2;
+  guint wrap_mode : 3;
+  guint ellipsize : 3;
+  guint justify : 1;
+  guint single_line_mode : 1;
+  guint hash;
+
+  /* the value; actors sharing it must not modify it */
+  PangoLayout *layout;
+
+  /* estimated memory used by the layout */
+  gsize size;
+
+  /* link inside the LRU queue */
+  GList link;
+};
+
+struct _TextParagraph
+{
+  /* the length of the paragraph, without the newline */
+  guint n_chars;
+
+  /* the position of the paragraph inside the buffer; these are
+   * only valid after clutter_text_ensure_paragraph_offsets()
+   */
+  guint char_offset;
+  gsize byte_offset;
+  gsize n_bytes;
+
+  /* one layout for each ParagraphSlot, with its extents */
+  PangoLayout *layouts[N_PARAGRAPH_SLOTS];
+  PangoRectangle ink_rects[N_PARAGRAPH_SLOTS];
+  PangoRectangle logical_rects[N_PARAGRAPH_SLOTS];
+};
+
+struct _ParagraphSlot
+{
+  /* the width of the layouts, in Pango units */
+  gint width;
+
+  guint age;
+
+  /* the vertical position of each paragraph, in Pango units, plus
+   * the total height as the last element
+   */
+  GArray *y_offsets;
+
+  /* the extents of all the paragraphs, as if they were laid out
+   * using a single PangoLayout
+   */
+  PangoRectangle ink_rect;
+  PangoRectangle logical_rect;
+
+  /* the metrics used to estimate the size of the paragraphs that
+   * have not been shaped yet, in lazy mode
+   */
+  gint line_height;
+  gint char_width;
+
+  guint in_use : 1;
+  guint extents_valid : 1;
+};
+
+struct _ShapeRequest
+{
+  ClutterText *text;
+
+  ClutterTextShapeJob *job;
+
+  /* the value of the layout generation when the job was queued */
+  guint generation;
+
+  /* the parameters of the layout */
+  gint width;
+  gint height;
+  PangoEllipsizeMode ellipsize;
 };
 
+static struct {
+  GHashTable *layouts;
+
+  /* most recently used layouts at the head */
+  GQueue lru;
+
+  gsize size;
+
+  guint hits;
+  guint misses;
+} shared_layouts = { NULL, G_QUEUE_INIT, 0, 0, 0 };
+
 struct _ClutterTextPrivate
 {
   PangoFontDescription *font_desc;
@@ -135,6 +270,32 @@ struct _ClutterTextPrivate
   LayoutCache cached_layouts[N_CACHED_LAYOUTS];
   guint cache_age;
 
+  /* Incremented each time the cached layouts are deleted */
+  guint layout_generation;
+
+  /* The pending ShapeRequests, when using :async-layout */
+  GSList *shape_requests;
+  /* The layout shown while the current contents are being shaped,
+     and the generation it belongs to; NULL if none is available */
+  PangoLayout *stale_layout;
+  guint stale_generation;
+  /* An empty layout, shown when there is no stale layout */
+  PangoLayout *placeholder_layout;
+
+  /* The per-paragraph layouts; NULL unless the contents can be
+     laid out one paragraph at a time */
+  GArray *paragraphs;
+  ParagraphSlot paragraph_slots[N_PARAGRAPH_SLOTS];
+  guint paragraph_age;
+  /* the paragraphs preceding this one have valid offsets */
+  guint n_paragraph_offsets;
+  /* the number of paragraph layouts created so far */
+  guint n_paragraph_shapes;
+
+  /* Idle source queueing a relayout when the size of the lazily
+     shaped paragraphs differs from the estimated one */
+  guint lazy_relayout_id;
+
   /* These are the attributes set by the attributes property */
   PangoAttrList *attrs;
   /* These are the attributes derived from the text when the
@@ -221,6 +382,9 @@ struct _ClutterTextPrivate
   guint paint_volume_valid      : 1;
   guint show_password_hint      : 1;
   guint password_hint_visible   : 1;
+  guint paragraphs_disabled     : 1;
+  guint lazy_layout             : 1;
+  guint async_layout            : 1;
 };
 
 enum
@@ -256,6 +420,8 @@ enum
   PROP_SINGLE_LINE_MODE,
   PROP_SELECTED_TEXT_COLOR,
   PROP_SELECTED_TEXT_COLOR_SET,
+  PROP_LAZY_LAYOUT,
+  PROP_ASYNC_LAYOUT,
 
   PROP_LAST
 };
@@ -280,6 +446,7 @@ static void clutter_text_settings_changed_cb (ClutterText *text);
 static void buffer_connect_signals (ClutterText *self);
 static void buffer_disconnect_signals (ClutterText *self);
 static ClutterTextBuffer *get_buffer (ClutterText *self);
+static PangoLayout *clutter_text_get_layout_internal (ClutterText *self);
 
 static inline void
 clutter_text_dirty_paint_volume (ClutterText *text)
@@ -332,6 +499,29 @@ offset_to_bytes (const gchar *text,
 
 #define bytes_to_offset(t,p)    (g_utf8_pointer_to_offset ((t), (t) + (p)))
 
+/* Like offset_to_bytes(), but for the contents of the buffer, which
+ * can use its own index instead of scanning the text from the start
+ */
+static inline gint
+buffer_offset_to_bytes (ClutterText *self,
+                        gint         pos)
+{
+  ClutterTextBuffer *buffer = get_buffer (self);
+
+  if (pos < 0)
+    return clutter_text_buffer_get_bytes (buffer);
+
+  return _clutter_text_buffer_offset_to_bytes (buffer, pos);
+}
+
+/* The reverse of buffer_offset_to_bytes() */
+static inline gint
+buffer_bytes_to_offset (ClutterText *self,
+                        gint         index_)
+{
+  return _clutter_text_buffer_bytes_to_offset (get_buffer (self), index_);
+}
+
 static inline void
 clutter_text_clear_selection (ClutterText *self)
 {
@@ -353,6 +543,14 @@ clutter_text_get_display_text (ClutterText *self)
   const gchar *text;
 
   buffer = get_buffer (self);
+
+  /* copying the contents does not move the gap of the default
+   * buffer, unlike clutter_text_buffer_get_text()
+   */
+  if (G_LIKELY (priv->password_char == 0))
+    return _clutter_text_buffer_dup_bytes (buffer, 0,
+                                           clutter_text_buffer_get_bytes (buffer));
+
   text = clutter_text_buffer_get_text (buffer);
 
   /* simple short-circuit to avoid going through GString
@@ -360,9 +558,6 @@ clutter_text_get_display_text (ClutterText *self)
    */
   if (text[0] == '\0')
     return g_strdup ("");
-
-  if (G_LIKELY (priv->password_char == 0))
-    return g_strdup (text);
   else
     {
       GString *str;
@@ -535,12 +730,387 @@ clutter_text_create_layout_no_cache (ClutterText       *text,
   return layout;
 }
 
+static gboolean
+attr_lists_equal (PangoAttrList *a,
+                  PangoAttrList *b)
+{
+  PangoAttrIterator *iter_a, *iter_b;
+  gboolean retval = TRUE;
+
+  if (a == b)
+    return TRUE;
+
+  if (a == NULL || b == NULL)
+    return FALSE;
+
+  iter_a = pango_attr_list_get_iterator (a);
+  iter_b = pango_attr_list_get_iterator (b);
+
+  while (retval)
+    {
+      GSList *attrs_a, *attrs_b, *l_a, *l_b;
+      gint start_a, end_a, start_b, end_b;
+      gboolean has_next_a, has_next_b;
+
+      pango_attr_iterator_range (iter_a, &start_a, &end_a);
+      pango_attr_iterator_range (iter_b, &start_b, &end_b);
+
+      if (start_a != start_b || end_a != end_b)
+        {
+          retval = FALSE;
+          break;
+        }
+
+      attrs_a = pango_attr_iterator_get_attrs (iter_a);
+      attrs_b = pango_attr_iterator_get_attrs (iter_b);
+
+      for (l_a = attrs_a, l_b = attrs_b;
+           l_a != NULL && l_b != NULL;
+           l_a = l_a->next, l_b = l_b->next)
+        {
+          if (!pango_attribute_equal (l_a->data, l_b->data))
+            break;
+        }
+
+      if (l_a != NULL || l_b != NULL)
+        retval = FALSE;
+
+      g_slist_free_full (attrs_a, (GDestroyNotify) pango_attribute_destroy);
+      g_slist_free_full (attrs_b, (GDestroyNotify) pango_attribute_destroy);
+
+      has_next_a = pango_attr_iterator_next (iter_a);
+      has_next_b = pango_attr_iterator_next (iter_b);
+
+      if (has_next_a != has_next_b)
+        retval = FALSE;
+
+      if (!has_next_a)
+        break;
+    }
+
+  pango_attr_iterator_destroy (iter_a);
+  pango_attr_iterator_destroy (iter_b);
+
+  return retval;
+}
+
+static guint
+shared_layout_hash (gconstpointer data)
+{
+  const SharedLayout *key = data;
+
+  return key->hash;
+}
+
+static gboolean
+shared_layout_equal (gconstpointer data_a,
+                     gconstpointer data_b)
+{
+  const SharedLayout *a = data_a;
+  const SharedLayout *b = data_b;
+
+  return a->hash == b->hash &&
+         a->width == b->width &&
+         a->height == b->height &&
+         a->alignment == b->alignment &&
+         a->wrap_mode == b->wrap_mode &&
+         a->ellipsize == b->ellipsize &&
+         a->justify == b->justify &&
+         a->single_line_mode == b->single_line_mode &&
+         a->text_len == b->text_len &&
+         memcmp (a->text, b->text, a->text_len) == 0 &&
+         pango_font_description_equal (a->font_desc, b->font_desc) &&
+         attr_lists_equal (a->attrs, b->attrs);
+}
+
 static void
-clutter_text_dirty_cache (ClutterText *text)
+shared_layout_free (gpointer data)
+{
+  SharedLayout *shared = data;
+
+  g_queue_unlink (&shared_layouts.lru, &shared->link);
+  shared_layouts.size -= shared->size;
+
+  pango_font_description_free (shared->font_desc);
+  if (shared->attrs != NULL)
+    pango_attr_list_unref (shared->attrs);
+  g_free (shared->text);
+  g_object_unref (shared->layout);
+
+  g_slice_free (SharedLayout, shared);
+}
+
+/*< private >
+ * _clutter_text_clear_shared_layouts:
+ *
+ * Drops all the layouts in the process-wide layout cache; the layouts
+ * still in use by #ClutterText actors are released once they are
+ * recreated.
+ *
+ * This function is called when the font options or the resolution
+ * change.
+ */
+void
+_clutter_text_clear_shared_layouts (void)
+{
+  if (shared_layouts.layouts == NULL)
+    return;
+
+  CLUTTER_NOTE (ACTOR, "Clearing the shared text layouts "
+                "(layouts: %u, size: %" G_GSIZE_FORMAT " bytes, "
+                "hits: %u, misses: %u)",
+                g_hash_table_size (shared_layouts.layouts),
+                shared_layouts.size,
+                shared_layouts.hits,
+                shared_layouts.misses);
+
+  g_hash_table_remove_all (shared_layouts.layouts);
+}
+
+static void
+clutter_text_shared_layouts_changed (ClutterBackend *backend)
+{
+  _clutter_text_clear_shared_layouts ();
+}
+
+static void
+clutter_text_ensure_shared_layouts (void)
+{
+  ClutterBackend *backend;
+
+  if (G_LIKELY (shared_layouts.layouts != NULL))
+    return;
+
+  shared_layouts.layouts = g_hash_table_new_full (shared_layout_hash,
+                                                  shared_layout_equal,
+                                                  NULL,
+                                                  shared_layout_free);
+
+  backend = clutter_get_default_backend ();
+  g_signal_connect (backend, "font-changed",
+                    G_CALLBACK (clutter_text_shared_layouts_changed),
+                    NULL);
+  g_signal_connect (backend, "resolution-changed",
+                    G_CALLBACK (clutter_text_shared_layouts_changed),
+                    NULL);
+  g_signal_connect (backend, "settings-changed",
+                    G_CALLBACK (clutter_text_shared_layouts_changed),
+                    NULL);
+}
+
+/*
+ * clutter_text_get_shared_layout:
+ * @text: a #ClutterText
+ * @width: the width of the layout, in Pango units, or -1
+ * @height: the height of the layout, in Pango units, or -1
+ * @ellipsize: the ellipsization mode of the layout
+ * @create: whether the layout should be created if it is not
+ *   in the cache
+ *
+ * Retrieves a layout for @text from the shared cache, or creates it
+ * and stores it in the cache if no other actor is using a layout with
+ * the same contents and parameters.
+ *
+ * Return value: (transfer full): a #PangoLayout, or %NULL if the
+ *   layout cannot be shared, or if it is not in the cache and
+ *   @create is %FALSE
+ */
+static PangoLayout *
+clutter_text_get_shared_layout (ClutterText        *text,
+                                gint                width,
+                                gint                height,
+                                PangoEllipsizeMode  ellipsize,
+                                gboolean            create)
+{
+  ClutterTextPrivate *priv = text->priv;
+  SharedLayout key, *shared;
+  gchar *contents;
+
+  CLUTTER_STATIC_COUNTER (shared_layout_hit_counter,
+                          "Shared text layout cache hit counter",
+                          "Increments for each shared layout cache hit",
+                          0);
+  CLUTTER_STATIC_COUNTER (shared_layout_miss_counter,
+                          "Shared text layout cache miss counter",
+                          "Increments for each shared layout cache miss",
+                          0);
+
+  /* editable actors change their contents all the time, and they may
+   * have a pre-edit string; there is little point in sharing them
+   */
+  if (priv->editable)
+    return NULL;
+
+  contents = clutter_text_get_display_text (text);
+
+  memset (&key, 0, sizeof (SharedLayout));
+  key.text = contents;
+  key.text_len = strlen (contents);
+
+  /* large layouts would just push everything else out of the cache */
+  if (key.text_len * SHARED_LAYOUT_BYTES_PER_CHAR > SHARED_LAYOUTS_MAX_SIZE / 4)
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  clutter_text_ensure_effective_attributes (text);
+
+  key.font_desc = priv->font_desc;
+  key.attrs = priv->effective_attrs;
+  key.width = width;
+  key.height = height;
+  key.alignment = priv->alignment;
+  key.wrap_mode = priv->wrap_mode;
+  key.ellipsize = ellipsize;
+  key.justify = priv->justify;
+  key.single_line_mode = priv->single_line_mode;
+  key.hash = g_str_hash (contents)
+           ^ pango_font_description_hash (priv->font_desc)
+           ^ ((guint) width * 31)
+           ^ ((guint) height * 17)
+           ^ ((guint) ellipsize << 24)
+           ^ (priv->effective_attrs != NULL ? 1u << 31 : 0);
+
+  clutter_text_ensure_shared_layouts ();
+
+  shared = g_hash_table_lookup (shared_layouts.layouts, &key);
+  if (shared != NULL)
+    {
+      CLUTTER_COUNTER_INC (_clutter_uprof_context, shared_layout_hit_counter);
+      shared_layouts.hits += 1;
+
+      g_queue_unlink (&shared_layouts.lru, &shared->link);
+      g_queue_push_head_link (&shared_layouts.lru, &shared->link);
+
+      g_free (contents);
+
+      return g_object_ref (shared->layout);
+    }
+
+  if (!create)
+    {
+      g_free (contents);
+      return NULL;
+    }
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, shared_layout_miss_counter);
+  shared_layouts.misses += 1;
+
+  shared = g_slice_new (SharedLayout);
+  *shared = key;
+  shared->text = contents;
+  shared->font_desc = pango_font_description_copy (priv->font_desc);
+
+  /* copy the attributes, as the list is mutable */
+  shared->attrs = priv->effective_attrs != NULL
+                ? pango_attr_list_copy (priv->effective_attrs)
+                : NULL;
+
+  shared->layout =
+    clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+
+  cogl_pango_ensure_glyph_cache_for_layout (shared->layout);
+
+  shared->size = sizeof (SharedLayout)
+               + SHARED_LAYOUT_BYTES_OVERHEAD
+               + shared->text_len * SHARED_LAYOUT_BYTES_PER_CHAR;
+
+  shared->link.data = shared;
+  shared->link.prev = shared->link.next = NULL;
+  g_queue_push_head_link (&shared_layouts.lru, &shared->link);
+  shared_layouts.size += shared->size;
+
+  g_hash_table_add (shared_layouts.layouts, shared);
+
+  /* evict the least recently used layouts; actors using them will
+   * keep their reference until they recreate their layouts
+   */
+  while (shared_layouts.size > SHARED_LAYOUTS_MAX_SIZE &&
+         shared_layouts.lru.tail != &shared->link)
+    g_hash_table_remove (shared_layouts.layouts, shared_layouts.lru.tail->data);
+
+  return g_object_ref (shared->layout);
+}
+
+static void
+text_paragraph_clear_layouts (TextParagraph *paragraph)
+{
+  int i;
+
+  for (i = 0; i < N_PARAGRAPH_SLOTS; i++)
+    if (paragraph->layouts[i] != NULL)
+      {
+        g_object_unref (paragraph->layouts[i]);
+        paragraph->layouts[i] = NULL;
+      }
+}
+
+static void
+clutter_text_clear_paragraphs (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  guint i;
+
+  priv->paragraphs_disabled = FALSE;
+
+  if (priv->paragraphs == NULL)
+    return;
+
+  for (i = 0; i < priv->paragraphs->len; i++)
+    text_paragraph_clear_layouts (&g_array_index (priv->paragraphs,
+                                                  TextParagraph,
+                                                  i));
+
+  g_array_free (priv->paragraphs, TRUE);
+  priv->paragraphs = NULL;
+  priv->n_paragraph_offsets = 0;
+
+  for (i = 0; i < N_PARAGRAPH_SLOTS; i++)
+    {
+      ParagraphSlot *slot = &priv->paragraph_slots[i];
+
+      if (slot->y_offsets != NULL)
+        g_array_free (slot->y_offsets, TRUE);
+
+      memset (slot, 0, sizeof (ParagraphSlot));
+    }
+}
+
+/* Deletes the cached layouts of the whole contents, but keeps
+ * the per-paragraph ones
+ */
+static void
+clutter_text_dirty_layouts (ClutterText *text)
 {
   ClutterTextPrivate *priv = text->priv;
+  LayoutCache *newest_cache = NULL;
   int i;
 
+  /* Keep showing the most recently used layout until the new
+     contents have been shaped */
+  if (priv->async_layout)
+    {
+      for (i = 0; i < N_CACHED_LAYOUTS; i++)
+        if (priv->cached_layouts[i].layout != NULL &&
+            (newest_cache == NULL ||
+             priv->cached_layouts[i].age > newest_cache->age))
+          newest_cache = priv->cached_layouts + i;
+
+      if (newest_cache != NULL)
+        {
+          if (priv->stale_layout != NULL)
+            g_object_unref (priv->stale_layout);
+
+          priv->stale_layout = g_object_ref (newest_cache->layout);
+          priv->stale_generation = priv->layout_generation;
+        }
+
+      g_clear_object (&priv->placeholder_layout);
+    }
+
+  priv->layout_generation += 1;
+
   /* Delete the cached layouts so they will be recreated the next time
      they are needed */
   for (i = 0; i < N_CACHED_LAYOUTS; i++)
@@ -553,6 +1123,13 @@ clutter_text_dirty_cache (ClutterText *text)
   clutter_text_dirty_paint_volume (text);
 }
 
+static void
+clutter_text_dirty_cache (ClutterText *text)
+{
+  clutter_text_clear_paragraphs (text);
+  clutter_text_dirty_layouts (text);
+}
+
 /*
  * clutter_text_set_font_description_internal:
  * @self: a #ClutterText
@@ -638,47 +1215,282 @@ clutter_text_direction_changed_cb (GObject    *gobject,
   /* no need to queue a relayout: set_text_direction() will do that for us */
 }
 
-/*
- * clutter_text_create_layout:
- * @text: a #ClutterText
- * @allocation_width: the allocation width
- * @allocation_height: the allocation height
- *
- * Like clutter_text_create_layout_no_cache(), but will also ensure
- * the glyphs cache. If a previously cached layout generated using the
- * same width is available then that will be used instead of
- * generating a new one.
- */
-static PangoLayout *
-clutter_text_create_layout (ClutterText *text,
-                            gfloat       allocation_width,
-                            gfloat       allocation_height)
+static void
+clutter_text_clear_shape_requests (ClutterText *text)
 {
   ClutterTextPrivate *priv = text->priv;
-  LayoutCache *oldest_cache = priv->cached_layouts;
-  gboolean found_free_cache = FALSE;
-  gint width = -1;
-  gint height = -1;
-  PangoEllipsizeMode ellipsize = PANGO_ELLIPSIZE_NONE;
+  GSList *l;
+
+  for (l = priv->shape_requests; l != NULL; l = l->next)
+    {
+      ShapeRequest *request = l->data;
+
+      _clutter_text_shape_job_cancel (request->job);
+      g_slice_free (ShapeRequest, request);
+    }
+
+  g_slist_free (priv->shape_requests);
+  priv->shape_requests = NULL;
+
+  g_clear_object (&priv->stale_layout);
+  g_clear_object (&priv->placeholder_layout);
+}
+
+static void
+clutter_text_layout_shaped (PangoLayout *layout,
+                            gpointer     user_data)
+{
+  ShapeRequest *request = user_data;
+  ClutterText *text = request->text;
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *oldest_cache = NULL;
   int i;
 
-  CLUTTER_STATIC_COUNTER (text_cache_hit_counter,
-                          "Text layout cache hit counter",
-                          "Increments for each layout cache hit",
-                          0);
-  CLUTTER_STATIC_COUNTER (text_cache_miss_counter,
-                          "Text layout cache miss counter",
-                          "Increments for each layout cache miss",
-                          0);
+  priv->shape_requests = g_slist_remove (priv->shape_requests, request);
 
-  /* First determine the width, height, and ellipsize mode that
-   * we need for the layout. The ellipsize mode depends on
-   * allocation_width/allocation_size as follows:
-   *
-   * Cases, assuming ellipsize != NONE on actor:
-   *
-   * Width request: ellipsization can be set or not on layout,
-   * doesn't matter.
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: shaped layout for size %dx%d%s",
+                text,
+                request->width,
+                request->height,
+                request->generation != priv->layout_generation
+                  ? " (outdated)"
+                  : "");
+
+  /* if the worker thread could not shape the layout, it will be
+   * shaped synchronously during the next relayout
+   */
+  if (layout == NULL)
+    goto out;
+
+  if (request->generation == priv->layout_generation)
+    {
+      for (i = 0; i < N_CACHED_LAYOUTS; i++)
+        {
+          PangoLayout *cached = priv->cached_layouts[i].layout;
+
+          /* always prefer free cache spaces */
+          if (cached == NULL)
+            {
+              oldest_cache = priv->cached_layouts + i;
+              continue;
+            }
+
+          /* the layout might have been created synchronously in the
+           * meantime
+           */
+          if (pango_layout_get_width (cached) == request->width &&
+              pango_layout_get_height (cached) == request->height &&
+              pango_layout_get_ellipsize (cached) == request->ellipsize)
+            goto out;
+
+          if (oldest_cache == NULL ||
+              (oldest_cache->layout != NULL &&
+               priv->cached_layouts[i].age < oldest_cache->age))
+            oldest_cache = priv->cached_layouts + i;
+        }
+
+      cogl_pango_ensure_glyph_cache_for_layout (layout);
+
+      if (oldest_cache->layout != NULL)
+        g_object_unref (oldest_cache->layout);
+
+      oldest_cache->layout = g_object_ref (layout);
+      oldest_cache->age = priv->cache_age++;
+      oldest_cache->shared = FALSE;
+
+      g_clear_object (&priv->stale_layout);
+    }
+  else if (priv->stale_layout == NULL ||
+           request->generation >= priv->stale_generation)
+    {
+      /* the contents changed while the layout was being shaped, but
+       * it is still more recent than what we are showing
+       */
+      cogl_pango_ensure_glyph_cache_for_layout (layout);
+
+      if (priv->stale_layout != NULL)
+        g_object_unref (priv->stale_layout);
+
+      priv->stale_layout = g_object_ref (layout);
+      priv->stale_generation = request->generation;
+    }
+
+out:
+  g_slice_free (ShapeRequest, request);
+
+  clutter_text_dirty_paint_volume (text);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (text));
+}
+
+/*
+ * clutter_text_create_layout_async:
+ * @text: a #ClutterText
+ * @width: the width of the layout, in Pango units, or -1
+ * @height: the height of the layout, in Pango units, or -1
+ * @ellipsize: the ellipsization mode of the layout
+ *
+ * Queues the shaping of a layout for @text inside the worker thread
+ * of the text shaper, unless one with the same size is already being
+ * shaped, and returns the layout to use in the meantime: the most
+ * recently used layout for the current contents, if any, or the one
+ * for the previous contents, or an empty layout.
+ *
+ * Return value: (transfer none): the layout to use until the new one
+ *   has been shaped, or %NULL if the layout cannot be shaped
+ *   asynchronously
+ */
+static PangoLayout *
+clutter_text_create_layout_async (ClutterText        *text,
+                                  gint                width,
+                                  gint                height,
+                                  PangoEllipsizeMode  ellipsize)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *newest_cache = NULL;
+  ShapeRequest *request = NULL;
+  GSList *l;
+  int i;
+
+  for (l = priv->shape_requests; l != NULL; l = l->next)
+    {
+      ShapeRequest *pending = l->data;
+
+      if (pending->width == width &&
+          pending->height == height &&
+          pending->ellipsize == ellipsize)
+        {
+          request = pending;
+          break;
+        }
+    }
+
+  /* if a layout for the previous contents is still being shaped we
+   * wait for it, instead of piling up jobs when the contents change
+   * faster than the worker thread can shape them
+   */
+  if (request == NULL)
+    {
+      PangoLayout *layout;
+
+      layout = clutter_text_create_layout_no_cache (text, width, height,
+                                                    ellipsize);
+
+      request = g_slice_new0 (ShapeRequest);
+      request->text = text;
+      request->generation = priv->layout_generation;
+      request->width = width;
+      request->height = height;
+      request->ellipsize = ellipsize;
+      request->job = _clutter_text_shape_layout_async (layout,
+                                                       clutter_text_layout_shaped,
+                                                       request);
+
+      g_object_unref (layout);
+
+      if (request->job == NULL)
+        {
+          g_slice_free (ShapeRequest, request);
+          return NULL;
+        }
+
+      priv->shape_requests = g_slist_prepend (priv->shape_requests, request);
+    }
+
+  for (i = 0; i < N_CACHED_LAYOUTS; i++)
+    if (priv->cached_layouts[i].layout != NULL &&
+        (newest_cache == NULL ||
+         priv->cached_layouts[i].age > newest_cache->age))
+      newest_cache = priv->cached_layouts + i;
+
+  if (newest_cache != NULL)
+    return newest_cache->layout;
+
+  if (priv->stale_layout != NULL)
+    return priv->stale_layout;
+
+  if (priv->placeholder_layout == NULL)
+    {
+      priv->placeholder_layout =
+        clutter_actor_create_pango_layout (CLUTTER_ACTOR (text), NULL);
+      pango_layout_set_font_description (priv->placeholder_layout,
+                                         priv->font_desc);
+    }
+
+  return priv->placeholder_layout;
+}
+
+/*
+ * clutter_text_should_shape_async:
+ * @text: a #ClutterText
+ *
+ * Checks whether a layout for @text should be shaped asynchronously.
+ *
+ * Only the layouts needed while the stage lays out and paints a frame
+ * are shaped asynchronously; everybody else, including the size
+ * negotiation done outside of a relayout, gets a layout for the
+ * current contents.
+ */
+static gboolean
+clutter_text_should_shape_async (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ClutterActor *stage;
+
+  if (!priv->async_layout || priv->editable)
+    return FALSE;
+
+  if (CLUTTER_ACTOR_IN_PAINT (text))
+    return TRUE;
+
+  stage = _clutter_actor_get_stage_internal (CLUTTER_ACTOR (text));
+
+  return stage != NULL && CLUTTER_ACTOR_IN_RELAYOUT (stage);
+}
+
+/*
+ * clutter_text_create_layout:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width
+ * @allocation_height: the allocation height
+ *
+ * Like clutter_text_create_layout_no_cache(), but will also ensure
+ * the glyphs cache. If a previously cached layout generated using the
+ * same width is available then that will be used instead of
+ * generating a new one.
+ */
+static PangoLayout *
+clutter_text_create_layout (ClutterText *text,
+                            gfloat       allocation_width,
+                            gfloat       allocation_height)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *oldest_cache = priv->cached_layouts;
+  gboolean found_free_cache = FALSE;
+  gboolean shape_async;
+  gboolean shared;
+  PangoLayout *layout;
+  gint width = -1;
+  gint height = -1;
+  PangoEllipsizeMode ellipsize = PANGO_ELLIPSIZE_NONE;
+  int i;
+
+  CLUTTER_STATIC_COUNTER (text_cache_hit_counter,
+                          "Text layout cache hit counter",
+                          "Increments for each layout cache hit",
+                          0);
+  CLUTTER_STATIC_COUNTER (text_cache_miss_counter,
+                          "Text layout cache miss counter",
+                          "Increments for each layout cache miss",
+                          0);
+
+  /* First determine the width, height, and ellipsize mode that
+   * we need for the layout. The ellipsize mode depends on
+   * allocation_width/allocation_size as follows:
+   *
+   * Cases, assuming ellipsize != NONE on actor:
+   *
+   * Width request: ellipsization can be set or not on layout,
+   * doesn't matter.
    *
    * Height request: ellipsization must never be set on layout
    * if wrap=true, because we need to measure the wrapped
@@ -771,69 +1583,1230 @@ clutter_text_create_layout (ClutterText *text,
               return priv->cached_layouts[i].layout;
 	    }
 
-	  /* When getting the preferred height for a specific width,
-	   * we might be able to reuse the layout from getting the
-	   * preferred width. If the width that the layout gives
-	   * unconstrained is less than the width that we are using
-	   * than the height will be unaffected by that width.
-	   */
-	  if (allocation_height < 0 &&
-              cached_width == -1 &&
-              cached_ellipsize == ellipsize)
-	    {
-	      PangoRectangle logical_rect;
+	  /* When getting the preferred height for a specific width,
+	   * we might be able to reuse the layout from getting the
+	   * preferred width. If the width that the layout gives
+	   * unconstrained is less than the width that we are using
+	   * than the height will be unaffected by that width.
+	   */
+	  if (allocation_height < 0 &&
+              cached_width == -1 &&
+              cached_ellipsize == ellipsize)
+	    {
+	      PangoRectangle logical_rect;
+
+	      pango_layout_get_extents (priv->cached_layouts[i].layout,
+                                        NULL,
+                                        &logical_rect);
+
+	      if (logical_rect.width <= width)
+		{
+		  /* We've been asked for our height for the width we gave as a result
+		   * of a _get_preferred_width call
+		   */
+		  CLUTTER_NOTE (ACTOR,
+                                "ClutterText: %p: cache hit for size %.2fx%.2f "
+				"(unwrapped width narrower than given width)",
+				text,
+				allocation_width,
+				allocation_height);
+
+                  CLUTTER_COUNTER_INC (_clutter_uprof_context,
+                                       text_cache_hit_counter);
+
+		  return priv->cached_layouts[i].layout;
+		}
+	    }
+
+	  if (!found_free_cache &&
+	      (priv->cached_layouts[i].age < oldest_cache->age))
+	    {
+	      oldest_cache = priv->cached_layouts + i;
+	    }
+        }
+    }
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: cache miss for size %.2fx%.2f",
+		text,
+                allocation_width,
+                allocation_height);
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, text_cache_miss_counter);
+
+  /* If we make it here then we didn't have a cached version so we
+     need to recreate the layout */
+  shape_async = clutter_text_should_shape_async (text);
+
+  layout = clutter_text_get_shared_layout (text, width, height, ellipsize,
+                                           !shape_async);
+
+  if (layout == NULL && shape_async)
+    {
+      PangoLayout *fallback;
+
+      fallback = clutter_text_create_layout_async (text, width, height,
+                                                   ellipsize);
+      if (fallback != NULL)
+        return fallback;
+
+      layout = clutter_text_get_shared_layout (text, width, height, ellipsize,
+                                               TRUE);
+    }
+
+  shared = layout != NULL;
+
+  if (layout == NULL)
+    {
+      layout =
+        clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+
+      cogl_pango_ensure_glyph_cache_for_layout (layout);
+    }
+
+  if (oldest_cache->layout)
+    g_object_unref (oldest_cache->layout);
+
+  oldest_cache->layout = layout;
+  oldest_cache->shared = shared;
+
+  /* Mark the 'time' this cache was created and advance the time */
+  oldest_cache->age = priv->cache_age++;
+  return oldest_cache->layout;
+}
+
+/*
+ * clutter_text_can_use_paragraphs:
+ * @text: a #ClutterText
+ *
+ * Checks whether the contents of @text can be laid out one paragraph
+ * at a time. Each paragraph must be laid out exactly like it would be
+ * inside a layout holding the whole contents, so this is only possible
+ * for wrapping editable texts without attributes or a preedit string.
+ *
+ * Texts using the :lazy-layout property accept that the paragraphs
+ * are aligned independently, and can also be laid out without
+ * wrapping.
+ */
+static gboolean
+clutter_text_can_use_paragraphs (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+
+  if (priv->single_line_mode ||
+      priv->preedit_set ||
+      priv->password_char != 0 ||
+      priv->ellipsize != PANGO_ELLIPSIZE_NONE)
+    return FALSE;
+
+  if (priv->lazy_layout)
+    {
+      clutter_text_ensure_effective_attributes (text);
+
+      return priv->effective_attrs == NULL;
+    }
+
+  return priv->editable &&
+         priv->wrap &&
+         priv->attrs == NULL;
+}
+
+/* finds the first newline at or after the byte offset @from in the
+ * contents of a buffer, split in two segments around its gap
+ *
+ * Return value: the byte offset of the newline, or -1
+ */
+static gssize
+text_segments_find_newline (const gchar *before,
+                            gsize        n_before,
+                            const gchar *after,
+                            gsize        n_after,
+                            gsize        from)
+{
+  const gchar *p;
+
+  if (from < n_before)
+    {
+      p = memchr (before + from, '\n', n_before - from);
+      if (p != NULL)
+        return p - before;
+
+      from = n_before;
+    }
+
+  if (from < n_before + n_after)
+    {
+      p = memchr (after + (from - n_before), '\n', n_before + n_after - from);
+      if (p != NULL)
+        return n_before + (p - after);
+    }
+
+  return -1;
+}
+
+/* counts the characters between the byte offsets @start and @end in
+ * the contents of a buffer, split in two segments around its gap; the
+ * gap always falls between two characters
+ */
+static guint
+text_segments_strlen (const gchar *before,
+                      gsize        n_before,
+                      const gchar *after,
+                      gsize        n_after,
+                      gsize        start,
+                      gsize        end)
+{
+  guint n_chars = 0;
+
+  if (start < n_before)
+    {
+      n_chars += g_utf8_strlen (before + start, MIN (end, n_before) - start);
+      start = n_before;
+    }
+
+  if (end > start)
+    n_chars += g_utf8_strlen (after + (start - n_before), end - start);
+
+  return n_chars;
+}
+
+static gboolean
+clutter_text_build_paragraphs (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  const gchar *before, *after;
+  gsize n_before, n_after, start;
+  gssize eol;
+  guint i, n_lines;
+
+  /* scanning the segments does not move the gap of the buffer, unlike
+   * clutter_text_buffer_get_text()
+   */
+  _clutter_text_buffer_get_segments (get_buffer (text),
+                                     &before, &n_before,
+                                     &after, &n_after);
+
+  /* Pango also splits paragraphs on carriage returns and on the
+   * paragraph separator; we leave those to the single layout
+   */
+  if (memchr (before, '\r', n_before) != NULL ||
+      memchr (after, '\r', n_after) != NULL ||
+      g_strstr_len (before, n_before, "\xe2\x80\xa9") != NULL ||
+      g_strstr_len (after, n_after, "\xe2\x80\xa9") != NULL)
+    return FALSE;
+
+  n_lines = 1;
+  for (eol = text_segments_find_newline (before, n_before, after, n_after, 0);
+       eol >= 0;
+       eol = text_segments_find_newline (before, n_before, after, n_after, eol + 1))
+    n_lines += 1;
+
+  if (n_lines < PARAGRAPHS_MIN_LINES && !priv->lazy_layout)
+    return FALSE;
+
+  priv->paragraphs = g_array_sized_new (FALSE, TRUE,
+                                        sizeof (TextParagraph),
+                                        n_lines);
+  g_array_set_size (priv->paragraphs, n_lines);
+
+  for (i = 0, start = 0; i < n_lines; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+      eol = text_segments_find_newline (before, n_before, after, n_after, start);
+      if (eol < 0)
+        eol = n_before + n_after;
+
+      paragraph->n_chars = text_segments_strlen (before, n_before,
+                                                 after, n_after,
+                                                 start, eol);
+
+      start = eol + 1;
+    }
+
+  priv->n_paragraph_offsets = 0;
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: laying out %u paragraphs",
+                text,
+                n_lines);
+
+  return TRUE;
+}
+
+/*
+ * clutter_text_ensure_paragraph_offsets:
+ * @text: a #ClutterText
+ *
+ * Updates the position of each paragraph inside the buffer after
+ * an edit.
+ *
+ * Return value: %FALSE if the paragraphs do not match the contents
+ *   of the buffer anymore
+ */
+static gboolean
+clutter_text_ensure_paragraph_offsets (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ClutterTextBuffer *buffer = get_buffer (text);
+  const gchar *before, *after;
+  gsize n_before, n_after, n_bytes, p;
+  guint i, char_offset;
+
+  if (priv->n_paragraph_offsets == priv->paragraphs->len)
+    return TRUE;
+
+  /* scan the contents without moving the gap of the buffer, so that
+   * editing in the middle of a long text stays cheap
+   */
+  _clutter_text_buffer_get_segments (buffer,
+                                     &before, &n_before,
+                                     &after, &n_after);
+  n_bytes = n_before + n_after;
+
+  /* start from the first paragraph following the valid ones, so that
+   * appending to a long text does not need to scan all of it
+   */
+  i = priv->n_paragraph_offsets;
+  if (i > 0)
+    {
+      const TextParagraph *prev;
+
+      prev = &g_array_index (priv->paragraphs, TextParagraph, i - 1);
+      p = prev->byte_offset + prev->n_bytes + 1;
+      char_offset = prev->char_offset + prev->n_chars + 1;
+    }
+  else
+    {
+      p = 0;
+      char_offset = 0;
+    }
+
+  for (; i < priv->paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+      gsize eol;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+      if (i + 1 < priv->paragraphs->len)
+        {
+          gssize res;
+
+          res = text_segments_find_newline (before, n_before,
+                                            after, n_after,
+                                            p);
+          if (res < 0)
+            return FALSE;
+
+          eol = res;
+        }
+      else
+        eol = n_bytes;
+
+      paragraph->char_offset = char_offset;
+      paragraph->byte_offset = p;
+      paragraph->n_bytes = eol - p;
+
+      char_offset += paragraph->n_chars + 1;
+      p = eol + 1;
+    }
+
+  if (char_offset - 1 != clutter_text_buffer_get_length (buffer))
+    return FALSE;
+
+  priv->n_paragraph_offsets = priv->paragraphs->len;
+
+  return TRUE;
+}
+
+static PangoLayout *
+clutter_text_create_paragraph_layout (ClutterText         *text,
+                                      const TextParagraph *paragraph,
+                                      gint                 width)
+{
+  ClutterTextPrivate *priv = text->priv;
+  PangoLayout *layout;
+  gchar *contents;
+
+  /* the paragraph can span the gap of the buffer */
+  contents = _clutter_text_buffer_dup_bytes (get_buffer (text),
+                                             paragraph->byte_offset,
+                                             paragraph->n_bytes);
+
+  /* this must match clutter_text_create_layout_no_cache() */
+  layout = clutter_actor_create_pango_layout (CLUTTER_ACTOR (text), NULL);
+  pango_layout_set_font_description (layout, priv->font_desc);
+  pango_layout_set_text (layout, contents, paragraph->n_bytes);
+  g_free (contents);
+
+  pango_layout_set_alignment (layout, priv->alignment);
+  pango_layout_set_justify (layout, priv->justify);
+  pango_layout_set_wrap (layout, priv->wrap_mode);
+  pango_layout_set_width (layout, width);
+
+  cogl_pango_ensure_glyph_cache_for_layout (layout);
+
+  return layout;
+}
+
+/*
+ * clutter_text_shape_paragraphs:
+ * @text: a #ClutterText
+ * @slot_index: the index of a #ParagraphSlot
+ * @first: the first paragraph to shape
+ * @last: the last paragraph to shape
+ *
+ * Creates the missing layouts of the paragraphs between @first
+ * and @last, inclusive.
+ *
+ * Return value: the number of paragraphs that have been shaped
+ */
+static guint
+clutter_text_shape_paragraphs (ClutterText *text,
+                               gint         slot_index,
+                               guint        first,
+                               guint        last)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ParagraphSlot *slot = &priv->paragraph_slots[slot_index];
+  guint i, n_shaped;
+
+  last = MIN (last, priv->paragraphs->len - 1);
+
+  for (i = first, n_shaped = 0; i <= last; i++)
+    {
+      TextParagraph *paragraph;
+      PangoLayout *layout;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+      if (paragraph->layouts[slot_index] != NULL)
+        continue;
+
+      layout = clutter_text_create_paragraph_layout (text, paragraph,
+                                                     slot->width);
+      pango_layout_get_extents (layout,
+                                &paragraph->ink_rects[slot_index],
+                                &paragraph->logical_rects[slot_index]);
+
+      paragraph->layouts[slot_index] = layout;
+
+      n_shaped += 1;
+    }
+
+  priv->n_paragraph_shapes += n_shaped;
+
+  if (n_shaped > 0)
+    {
+      CLUTTER_NOTE (ACTOR, "ClutterText: %p: laid out %u of %u paragraphs "
+                           "for width %d",
+                    text,
+                    n_shaped,
+                    priv->paragraphs->len,
+                    slot->width);
+
+      slot->extents_valid = FALSE;
+    }
+
+  return n_shaped;
+}
+
+/* estimates the size of a paragraph that has not been shaped yet */
+static void
+clutter_text_estimate_paragraph_extents (ClutterText         *text,
+                                         const ParagraphSlot *slot,
+                                         const TextParagraph *paragraph,
+                                         PangoRectangle      *rect)
+{
+  ClutterTextPrivate *priv = text->priv;
+  gint64 width = (gint64) paragraph->n_chars * slot->char_width;
+  gint n_lines = 1;
+
+  if (priv->wrap && slot->width > 0 && width > slot->width)
+    {
+      n_lines = (width + slot->width - 1) / slot->width;
+      width = slot->width;
+    }
+
+  rect->x = 0;
+  rect->y = 0;
+  rect->width = width;
+  rect->height = n_lines * slot->line_height;
+}
+
+static void
+clutter_text_update_paragraph_extents (ClutterText *text,
+                                       gint         slot_index)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ParagraphSlot *slot = &priv->paragraph_slots[slot_index];
+  gint min_x, max_x, ink_x1, ink_y1, ink_x2, ink_y2;
+  gint y;
+  guint i;
+
+  if (slot->y_offsets == NULL)
+    slot->y_offsets = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  g_array_set_size (slot->y_offsets, priv->paragraphs->len + 1);
+
+  min_x = ink_x1 = ink_y1 = G_MAXINT;
+  max_x = ink_x2 = ink_y2 = G_MININT;
+
+  for (i = 0, y = 0; i < priv->paragraphs->len; i++)
+    {
+      TextParagraph *paragraph;
+      PangoRectangle ink_rect, logical_rect;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+      if (paragraph->layouts[slot_index] != NULL)
+        {
+          ink_rect = paragraph->ink_rects[slot_index];
+          logical_rect = paragraph->logical_rects[slot_index];
+        }
+      else
+        {
+          clutter_text_estimate_paragraph_extents (text, slot, paragraph,
+                                                   &logical_rect);
+          ink_rect = logical_rect;
+        }
+
+      g_array_index (slot->y_offsets, gint, i) = y;
+
+      min_x = MIN (min_x, logical_rect.x);
+      max_x = MAX (max_x, logical_rect.x + logical_rect.width);
+
+      if (ink_rect.width > 0 && ink_rect.height > 0)
+        {
+          ink_x1 = MIN (ink_x1, ink_rect.x);
+          ink_y1 = MIN (ink_y1, y + ink_rect.y);
+          ink_x2 = MAX (ink_x2, ink_rect.x + ink_rect.width);
+          ink_y2 = MAX (ink_y2, y + ink_rect.y + ink_rect.height);
+        }
+
+      y += logical_rect.y + logical_rect.height;
+    }
+
+  g_array_index (slot->y_offsets, gint, i) = y;
+
+  slot->logical_rect.x = min_x;
+  slot->logical_rect.y = 0;
+  slot->logical_rect.width = max_x - min_x;
+  slot->logical_rect.height = y;
+
+  if (ink_x1 < ink_x2)
+    {
+      slot->ink_rect.x = ink_x1;
+      slot->ink_rect.y = ink_y1;
+      slot->ink_rect.width = ink_x2 - ink_x1;
+      slot->ink_rect.height = ink_y2 - ink_y1;
+    }
+  else
+    memset (&slot->ink_rect, 0, sizeof (PangoRectangle));
+
+  slot->extents_valid = TRUE;
+}
+
+static void
+clutter_text_init_paragraph_slot (ClutterText   *text,
+                                  ParagraphSlot *slot,
+                                  gint           width)
+{
+  ClutterTextPrivate *priv = text->priv;
+
+  slot->width = width;
+  slot->in_use = TRUE;
+  slot->extents_valid = FALSE;
+
+  if (priv->lazy_layout)
+    {
+      PangoContext *context;
+      PangoFontMetrics *metrics;
+
+      context = clutter_actor_get_pango_context (CLUTTER_ACTOR (text));
+      metrics = pango_context_get_metrics (context, priv->font_desc, NULL);
+
+      slot->line_height = pango_font_metrics_get_ascent (metrics)
+                        + pango_font_metrics_get_descent (metrics);
+      slot->char_width =
+        pango_font_metrics_get_approximate_char_width (metrics);
+
+      pango_font_metrics_unref (metrics);
+    }
+}
+
+/*
+ * clutter_text_ensure_paragraphs:
+ * @text: a #ClutterText
+ * @allocation_width: the allocation width, or -1
+ *
+ * Ensures that every paragraph of @text has a layout for the
+ * given width, creating only the ones that are missing. In lazy
+ * mode, the paragraphs are shaped only when they are needed, see
+ * clutter_text_shape_paragraphs().
+ *
+ * Return value: the index of the #ParagraphSlot holding the layouts,
+ *   or -1 if @text must be laid out using a single layout
+ */
+static gint
+clutter_text_ensure_paragraphs (ClutterText *text,
+                                gfloat       allocation_width)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ParagraphSlot *slot = NULL;
+  gint width, slot_index;
+  guint i;
+
+  if (!clutter_text_can_use_paragraphs (text))
+    {
+      clutter_text_clear_paragraphs (text);
+      return -1;
+    }
+
+  if (priv->paragraphs == NULL)
+    {
+      if (priv->paragraphs_disabled)
+        return -1;
+
+      if (!clutter_text_build_paragraphs (text))
+        {
+          priv->paragraphs_disabled = TRUE;
+          return -1;
+        }
+    }
+
+  if (!clutter_text_ensure_paragraph_offsets (text))
+    {
+      /* the buffer changed behind our back */
+      clutter_text_clear_paragraphs (text);
+
+      if (!clutter_text_build_paragraphs (text) ||
+          !clutter_text_ensure_paragraph_offsets (text))
+        {
+          clutter_text_clear_paragraphs (text);
+          priv->paragraphs_disabled = TRUE;
+          return -1;
+        }
+    }
+
+  /* same as clutter_text_create_layout(): the width only matters
+   * to wrapping texts
+   */
+  if (allocation_width >= 0 && priv->wrap)
+    width = allocation_width * 1024 + 0.5f;
+  else
+    width = -1;
+
+  /* look for the slot with the same width, falling back to the
+   * free or least recently used one
+   */
+  for (slot_index = -1, i = 0; i < N_PARAGRAPH_SLOTS; i++)
+    {
+      ParagraphSlot *cur = &priv->paragraph_slots[i];
+
+      if (cur->in_use && cur->width == width)
+        {
+          slot_index = i;
+          break;
+        }
+
+      if (slot_index == -1 ||
+          (priv->paragraph_slots[slot_index].in_use &&
+           (!cur->in_use || cur->age < priv->paragraph_slots[slot_index].age)))
+        slot_index = i;
+    }
+
+  slot = &priv->paragraph_slots[slot_index];
+
+  if (!slot->in_use || slot->width != width)
+    {
+      for (i = 0; i < priv->paragraphs->len; i++)
+        {
+          TextParagraph *paragraph;
+
+          paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+          if (paragraph->layouts[slot_index] != NULL)
+            {
+              g_object_unref (paragraph->layouts[slot_index]);
+              paragraph->layouts[slot_index] = NULL;
+            }
+        }
+
+      clutter_text_init_paragraph_slot (text, slot, width);
+    }
+
+  slot->age = priv->paragraph_age++;
+
+  if (!priv->lazy_layout)
+    clutter_text_shape_paragraphs (text, slot_index,
+                                   0, priv->paragraphs->len - 1);
+
+  if (!slot->extents_valid)
+    clutter_text_update_paragraph_extents (text, slot_index);
+
+  return slot_index;
+}
+
+/* the same as clutter_text_get_layout(), for the paragraph layouts */
+static gint
+clutter_text_get_paragraph_slot (ClutterText *text)
+{
+  gfloat width;
+
+  if (!clutter_text_can_use_paragraphs (text))
+    return -1;
+
+  clutter_actor_get_size (CLUTTER_ACTOR (text), &width, NULL);
+
+  return clutter_text_ensure_paragraphs (text, width);
+}
+
+/* returns the index of the paragraph at the given vertical position */
+static guint
+clutter_text_get_paragraph_at_y (ClutterText *text,
+                                 gint         slot_index,
+                                 gint         y)
+{
+  ClutterTextPrivate *priv = text->priv;
+  GArray *y_offsets = priv->paragraph_slots[slot_index].y_offsets;
+  guint lo, hi;
+
+  lo = 0;
+  hi = priv->paragraphs->len - 1;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi + 1) / 2;
+
+      if (g_array_index (y_offsets, gint, mid) <= y)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/* returns the index of the paragraph containing the given position */
+static guint
+clutter_text_get_paragraph_at_position (ClutterText *text,
+                                        gint         position)
+{
+  ClutterTextPrivate *priv = text->priv;
+  guint lo, hi;
+
+  lo = 0;
+  hi = priv->paragraphs->len - 1;
+
+  if (position < 0)
+    return hi;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi + 1) / 2;
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, mid);
+      if (paragraph->char_offset <= (guint) position)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+
+  return lo;
+}
+
+/* returns the layout of the paragraph @i, shaping it if needed */
+static PangoLayout *
+clutter_text_get_paragraph_layout (ClutterText *text,
+                                   gint         slot_index,
+                                   guint        i)
+{
+  ClutterTextPrivate *priv = text->priv;
+
+  /* shaping the paragraph in lazy mode moves the following ones */
+  if (clutter_text_shape_paragraphs (text, slot_index, i, i) > 0)
+    clutter_text_update_paragraph_extents (text, slot_index);
+
+  return g_array_index (priv->paragraphs, TextParagraph, i).layouts[slot_index];
+}
+
+/* retrieves the paragraph containing @position, and the byte index
+ * of @position inside the layout of the paragraph, which is shaped
+ */
+static guint
+clutter_text_get_paragraph_index (ClutterText *text,
+                                  gint         slot_index,
+                                  gint         position,
+                                  gint        *index_)
+{
+  ClutterTextPrivate *priv = text->priv;
+  TextParagraph *paragraph;
+  PangoLayout *layout;
+  guint i;
+
+  i = clutter_text_get_paragraph_at_position (text, position);
+  layout = clutter_text_get_paragraph_layout (text, slot_index, i);
+  paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+  if (position == -1)
+    *index_ = paragraph->n_bytes;
+  else
+    *index_ = offset_to_bytes (pango_layout_get_text (layout),
+                               position - paragraph->char_offset);
+
+  return i;
+}
+
+/* the reverse of clutter_text_get_paragraph_index() */
+static gint
+clutter_text_get_paragraph_position (ClutterText *text,
+                                     gint         slot_index,
+                                     guint        i,
+                                     gint         index_)
+{
+  ClutterTextPrivate *priv = text->priv;
+  TextParagraph *paragraph;
+
+  paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+  return paragraph->char_offset +
+         bytes_to_offset (pango_layout_get_text (paragraph->layouts[slot_index]),
+                          index_);
+}
+
+/* the same as pango_layout_get_cursor_pos(), for the paragraph layouts */
+static void
+clutter_text_get_paragraph_cursor_pos (ClutterText    *text,
+                                       gint            slot_index,
+                                       gint            position,
+                                       PangoRectangle *rect)
+{
+  ClutterTextPrivate *priv = text->priv;
+  GArray *y_offsets = priv->paragraph_slots[slot_index].y_offsets;
+  TextParagraph *paragraph;
+  gint index_;
+  guint i;
+
+  i = clutter_text_get_paragraph_index (text, slot_index, position, &index_);
+  paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+  pango_layout_get_cursor_pos (paragraph->layouts[slot_index],
+                               index_,
+                               rect, NULL);
+
+  rect->y += g_array_index (y_offsets, gint, i);
+}
+
+/* the same as scanning the result of pango_layout_get_log_attrs()
+ * for the next word boundary, for the paragraph layouts
+ */
+static gint
+clutter_text_paragraphs_move_word (ClutterText *text,
+                                   gint         slot_index,
+                                   gint         start,
+                                   gboolean     forward)
+{
+  ClutterTextPrivate *priv = text->priv;
+  PangoLogAttr *log_attrs = NULL;
+  gint n_chars, retval, current;
+
+  n_chars = clutter_text_buffer_get_length (get_buffer (text));
+  if (start < 0)
+    start = n_chars;
+
+  retval = forward ? start + 1 : start - 1;
+  current = -1;
+
+  /* the newline ending a paragraph is at the same position as the
+   * end of its layout
+   */
+  while (forward ? retval < n_chars : retval > 0)
+    {
+      TextParagraph *paragraph;
+      const PangoLogAttr *attr;
+      guint i;
+
+      i = clutter_text_get_paragraph_at_position (text, retval);
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+      if ((gint) i != current)
+        {
+          PangoLayout *layout;
+          gint n_attrs;
+
+          g_free (log_attrs);
+
+          layout = clutter_text_get_paragraph_layout (text, slot_index, i);
+          pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
+          current = i;
+        }
+
+      attr = &log_attrs[retval - paragraph->char_offset];
+      if (forward ? attr->is_word_end : attr->is_word_start)
+        break;
+
+      retval += forward ? 1 : -1;
+    }
+
+  g_free (log_attrs);
+
+  return CLAMP (retval, 0, n_chars);
+}
+
+/* invalidates the offsets and the extents following an edit */
+static void
+clutter_text_paragraphs_changed (ClutterText *text,
+                                 guint        first)
+{
+  ClutterTextPrivate *priv = text->priv;
+  int i;
+
+  priv->n_paragraph_offsets = MIN (priv->n_paragraph_offsets, first);
+
+  for (i = 0; i < N_PARAGRAPH_SLOTS; i++)
+    priv->paragraph_slots[i].extents_valid = FALSE;
+}
+
+/* tracks an insertion in the buffer, so that only the affected
+ * paragraphs will be laid out again
+ */
+static void
+clutter_text_paragraphs_insert (ClutterText *text,
+                                guint        position,
+                                const gchar *chars,
+                                guint        n_chars,
+                                gsize        n_bytes)
+{
+  ClutterTextPrivate *priv = text->priv;
+  TextParagraph *paragraph;
+  const gchar *p, *eol, *end;
+  guint i, start, head, tail, n_lines;
+
+  end = chars + n_bytes;
+
+  if (memchr (chars, '\r', n_bytes) != NULL ||
+      g_strstr_len (chars, n_bytes, "\xe2\x80\xa9") != NULL)
+    {
+      clutter_text_clear_paragraphs (text);
+      return;
+    }
+
+  i = priv->paragraphs->len - 1;
+  paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+  if (position + n_chars == clutter_text_buffer_get_length (get_buffer (text)))
+    {
+      /* appending to the last paragraph; this is the common case
+       * when streaming contents, so we avoid walking the paragraphs
+       */
+      start = position - MIN (position, paragraph->n_chars);
+    }
+  else
+    {
+      for (i = 0, start = 0; i < priv->paragraphs->len - 1; i++)
+        {
+          paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+          if (position <= start + paragraph->n_chars)
+            break;
+
+          start += paragraph->n_chars + 1;
+        }
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+    }
+
+  if (position < start || position > start + paragraph->n_chars)
+    {
+      clutter_text_clear_paragraphs (text);
+      return;
+    }
+
+  head = position - start;
+  tail = paragraph->n_chars - head;
+  text_paragraph_clear_layouts (paragraph);
+  clutter_text_paragraphs_changed (text, i);
+
+  n_lines = 0;
+  for (p = memchr (chars, '\n', n_bytes);
+       p != NULL;
+       p = memchr (p + 1, '\n', end - p - 1))
+    n_lines += 1;
+
+  /* every newline splits the paragraph in two */
+  if (n_lines > 0)
+    {
+      g_array_set_size (priv->paragraphs, priv->paragraphs->len + n_lines);
+      memmove (&g_array_index (priv->paragraphs, TextParagraph, i + 1 + n_lines),
+               &g_array_index (priv->paragraphs, TextParagraph, i + 1),
+               (priv->paragraphs->len - i - 1 - n_lines) * sizeof (TextParagraph));
+      memset (&g_array_index (priv->paragraphs, TextParagraph, i + 1), 0,
+              n_lines * sizeof (TextParagraph));
+    }
+
+  for (p = chars; ; i++)
+    {
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+      eol = memchr (p, '\n', end - p);
+      if (eol == NULL)
+        {
+          paragraph->n_chars = head + g_utf8_strlen (p, end - p) + tail;
+          break;
+        }
+
+      paragraph->n_chars = head + g_utf8_strlen (p, eol - p);
+      head = 0;
+      p = eol + 1;
+    }
+}
+
+/* tracks a deletion from the buffer, merging the paragraphs that
+ * lost their newlines
+ */
+static void
+clutter_text_paragraphs_delete (ClutterText *text,
+                                guint        position,
+                                guint        n_chars)
+{
+  ClutterTextPrivate *priv = text->priv;
+  TextParagraph *first, *last;
+  guint i, j, first_start, last_start, end, n_paragraphs;
+
+  n_paragraphs = priv->paragraphs->len;
+  end = position + n_chars;
+
+  for (i = 0, first_start = 0; i < n_paragraphs; i++)
+    {
+      first = &g_array_index (priv->paragraphs, TextParagraph, i);
+      if (position <= first_start + first->n_chars)
+        break;
+
+      first_start += first->n_chars + 1;
+    }
+
+  for (j = i, last_start = first_start; j < n_paragraphs; j++)
+    {
+      last = &g_array_index (priv->paragraphs, TextParagraph, j);
+      if (end <= last_start + last->n_chars)
+        break;
+
+      last_start += last->n_chars + 1;
+    }
+
+  if (j == n_paragraphs)
+    {
+      clutter_text_clear_paragraphs (text);
+      return;
+    }
+
+  first = &g_array_index (priv->paragraphs, TextParagraph, i);
+  last = &g_array_index (priv->paragraphs, TextParagraph, j);
+
+  /* the first paragraph keeps what precedes the deleted range, and
+   * gains what follows it inside the last one
+   */
+  first->n_chars = (position - first_start)
+                 + (last_start + last->n_chars - end);
+  text_paragraph_clear_layouts (first);
+
+  if (j > i)
+    {
+      guint k;
+
+      for (k = i + 1; k <= j; k++)
+        text_paragraph_clear_layouts (&g_array_index (priv->paragraphs,
+                                                      TextParagraph,
+                                                      k));
+
+      g_array_remove_range (priv->paragraphs, i + 1, j - i);
+    }
+
+  clutter_text_paragraphs_changed (text, i);
+}
+
+/*
+ * clutter_text_get_visible_rect:
+ * @text: a #ClutterText
+ * @rect: (out): return location for the visible rectangle
+ *
+ * Computes the bounding rectangle, in actor coordinates, of the part
+ * of @text that is not clipped away by the stage or by its ancestors.
+ *
+ * Return value: %FALSE if the visible area could not be computed
+ */
+static gboolean
+clutter_text_get_visible_rect (ClutterText *text,
+                               ClutterRect *rect)
+{
+  ClutterActor *self = CLUTTER_ACTOR (text);
+  ClutterActor *actor;
+  gfloat width, height;
+
+  clutter_actor_get_size (self, &width, &height);
+  clutter_rect_init (rect, 0, 0, width, height);
+
+  for (actor = clutter_actor_get_parent (self);
+       actor != NULL;
+       actor = clutter_actor_get_parent (actor))
+    {
+      ClutterVertex corners[4];
+      gfloat clip_x, clip_y, clip_w, clip_h;
+      gfloat x1, y1, x2, y2;
+      ClutterRect clip;
+      int i;
+
+      if (clutter_actor_has_clip (actor))
+        clutter_actor_get_clip (actor, &clip_x, &clip_y, &clip_w, &clip_h);
+      else if (clutter_actor_get_clip_to_allocation (actor) ||
+               CLUTTER_ACTOR_IS_TOPLEVEL (actor))
+        {
+          clip_x = clip_y = 0;
+          clutter_actor_get_size (actor, &clip_w, &clip_h);
+        }
+      else
+        continue;
+
+      x1 = y1 = G_MAXFLOAT;
+      x2 = y2 = -G_MAXFLOAT;
+
+      for (i = 0; i < 4; i++)
+        {
+          ClutterVertex point;
+
+          point.x = clip_x + ((i & 1) ? clip_w : 0);
+          point.y = clip_y + ((i & 2) ? clip_h : 0);
+          point.z = 0;
+
+          /* from the coordinates of the ancestor to the ones of the
+           * stage, and back to the ones of the text actor
+           */
+          clutter_actor_apply_transform_to_point (actor, &point, &corners[i]);
+
+          if (!clutter_actor_transform_stage_point (self,
+                                                    corners[i].x,
+                                                    corners[i].y,
+                                                    &corners[i].x,
+                                                    &corners[i].y))
+            return FALSE;
+
+          x1 = MIN (x1, corners[i].x);
+          y1 = MIN (y1, corners[i].y);
+          x2 = MAX (x2, corners[i].x);
+          y2 = MAX (y2, corners[i].y);
+        }
+
+      clutter_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+
+      if (!clutter_rect_intersection (rect, &clip, rect))
+        break;
+    }
+
+  return TRUE;
+}
+
+/* retrieves the range of paragraphs intersecting @visible */
+static void
+clutter_text_get_visible_paragraphs (ClutterText       *text,
+                                     gint               slot_index,
+                                     const ClutterRect *visible,
+                                     guint             *first,
+                                     guint             *last)
+{
+  ClutterTextPrivate *priv = text->priv;
+  gint top, bottom;
+
+  if (visible == NULL)
+    {
+      *first = 0;
+      *last = priv->paragraphs->len - 1;
+      return;
+    }
+
+  top = (visible->origin.y - priv->text_y) * PANGO_SCALE;
+  bottom = top + visible->size.height * PANGO_SCALE;
+
+  *first = clutter_text_get_paragraph_at_y (text, slot_index, top);
+  *last = clutter_text_get_paragraph_at_y (text, slot_index, bottom);
+
+  /* the ink of a paragraph can overflow its logical rectangle, so
+   * we also include the paragraphs surrounding the visible ones
+   */
+  if (*first > 0)
+    *first -= 1;
+
+  if (*last + 1 < priv->paragraphs->len)
+    *last += 1;
+}
 
-	      pango_layout_get_extents (priv->cached_layouts[i].layout,
-                                        NULL,
-                                        &logical_rect);
+static gboolean
+clutter_text_lazy_relayout (gpointer data)
+{
+  ClutterText *self = data;
 
-	      if (logical_rect.width <= width)
-		{
-		  /* We've been asked for our height for the width we gave as a result
-		   * of a _get_preferred_width call
-		   */
-		  CLUTTER_NOTE (ACTOR,
-                                "ClutterText: %p: cache hit for size %.2fx%.2f "
-				"(unwrapped width narrower than given width)",
-				text,
-				allocation_width,
-				allocation_height);
+  self->priv->lazy_relayout_id = 0;
 
-                  CLUTTER_COUNTER_INC (_clutter_uprof_context,
-                                       text_cache_hit_counter);
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
 
-		  return priv->cached_layouts[i].layout;
-		}
-	    }
+  return FALSE;
+}
 
-	  if (!found_free_cache &&
-	      (priv->cached_layouts[i].age < oldest_cache->age))
-	    {
-	      oldest_cache = priv->cached_layouts + i;
-	    }
-        }
-    }
+/* Paints the paragraphs intersecting the visible area of the actor */
+static void
+clutter_text_paint_paragraphs (ClutterText     *text,
+                               gint             slot_index,
+                               const CoglColor *color)
+{
+  ClutterTextPrivate *priv = text->priv;
+  ParagraphSlot *slot = &priv->paragraph_slots[slot_index];
+  PangoRectangle old_logical_rect = slot->logical_rect;
+  ClutterRect visible;
+  gboolean has_visible;
+  guint i, first, last;
 
-  CLUTTER_NOTE (ACTOR, "ClutterText: %p: cache miss for size %.2fx%.2f",
-		text,
-                allocation_width,
-                allocation_height);
+  has_visible = clutter_text_get_visible_rect (text, &visible);
 
-  CLUTTER_COUNTER_INC (_clutter_uprof_context, text_cache_miss_counter);
+  /* in lazy mode, shaping the visible paragraphs moves the ones
+   * following them, so we repeat until all the paragraphs in the
+   * visible area have been shaped
+   */
+  do
+    {
+      if (!slot->extents_valid)
+        clutter_text_update_paragraph_extents (text, slot_index);
 
-  /* If we make it here then we didn't have a cached version so we
-     need to recreate the layout */
-  if (oldest_cache->layout)
-    g_object_unref (oldest_cache->layout);
+      clutter_text_get_visible_paragraphs (text, slot_index,
+                                           has_visible ? &visible : NULL,
+                                           &first, &last);
+    }
+  while (clutter_text_shape_paragraphs (text, slot_index, first, last) > 0);
 
-  oldest_cache->layout =
-    clutter_text_create_layout_no_cache (text, width, height, ellipsize);
+  for (i = first; i <= last; i++)
+    {
+      TextParagraph *paragraph;
+
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+      cogl_pango_render_layout_subpixel (paragraph->layouts[slot_index],
+                                         priv->text_x * PANGO_SCALE,
+                                         priv->text_y * PANGO_SCALE +
+                                         g_array_index (slot->y_offsets, gint, i),
+                                         color,
+                                         0);
+    }
 
-  cogl_pango_ensure_glyph_cache_for_layout (oldest_cache->layout);
+  CLUTTER_NOTE (PAINT, "ClutterText: %p: painted %u of %u paragraphs",
+                text,
+                last - first + 1,
+                priv->paragraphs->len);
 
-  /* Mark the 'time' this cache was created and advance the time */
-  oldest_cache->age = priv->cache_age++;
-  return oldest_cache->layout;
+  /* the estimated size was used to allocate the actor */
+  if ((old_logical_rect.width != slot->logical_rect.width ||
+       old_logical_rect.height != slot->logical_rect.height) &&
+      priv->lazy_relayout_id == 0)
+    {
+      priv->lazy_relayout_id =
+        clutter_threads_add_idle (clutter_text_lazy_relayout, text);
+    }
 }
 
 /**
@@ -856,6 +2829,7 @@ clutter_text_coords_to_position (ClutterText *self,
   gint index_;
   gint px, py;
   gint trailing;
+  gint slot_index;
 
   g_return_val_if_fail (CLUTTER_IS_TEXT (self), 0);
 
@@ -865,7 +2839,35 @@ clutter_text_coords_to_position (ClutterText *self,
   px = (x - self->priv->text_x) * PANGO_SCALE;
   py = (y - self->priv->text_y) * PANGO_SCALE;
 
-  pango_layout_xy_to_index (clutter_text_get_layout (self),
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      ParagraphSlot *slot = &self->priv->paragraph_slots[slot_index];
+      GArray *y_offsets;
+      TextParagraph *paragraph;
+      guint i;
+
+      /* in lazy mode, the paragraph might move once it is shaped */
+      do
+        {
+          if (!slot->extents_valid)
+            clutter_text_update_paragraph_extents (self, slot_index);
+
+          i = clutter_text_get_paragraph_at_y (self, slot_index, py);
+        }
+      while (clutter_text_shape_paragraphs (self, slot_index, i, i) > 0);
+
+      y_offsets = slot->y_offsets;
+      paragraph = &g_array_index (self->priv->paragraphs, TextParagraph, i);
+
+      pango_layout_xy_to_index (paragraph->layouts[slot_index],
+                                px, py - g_array_index (y_offsets, gint, i),
+                                &index_, &trailing);
+
+      return paragraph->byte_offset + index_ + trailing;
+    }
+
+  pango_layout_xy_to_index (clutter_text_get_layout_internal (self),
                             px, py,
                             &index_, &trailing);
 
@@ -899,6 +2901,7 @@ clutter_text_position_to_coords (ClutterText *self,
   gint password_char_bytes = 1;
   gint index_;
   gsize n_bytes;
+  gint slot_index;
 
   g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
 
@@ -911,49 +2914,55 @@ clutter_text_position_to_coords (ClutterText *self,
   if (position < -1 || position > n_chars)
     return FALSE;
 
-  if (priv->password_char != 0)
-    password_char_bytes = g_unichar_to_utf8 (priv->password_char, NULL);
-
-  if (position == -1)
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    clutter_text_get_paragraph_cursor_pos (self, slot_index, position, &rect);
+  else
     {
-      if (priv->password_char == 0)
+      if (priv->password_char != 0)
+        password_char_bytes = g_unichar_to_utf8 (priv->password_char, NULL);
+
+      if (position == -1)
         {
-          n_bytes = clutter_text_buffer_get_bytes (get_buffer (self));
-          if (priv->editable && priv->preedit_set)
-            index_ = n_bytes + strlen (priv->preedit_str);
+          if (priv->password_char == 0)
+            {
+              n_bytes = clutter_text_buffer_get_bytes (get_buffer (self));
+              if (priv->editable && priv->preedit_set)
+                index_ = n_bytes + strlen (priv->preedit_str);
+              else
+                index_ = n_bytes;
+            }
           else
-            index_ = n_bytes;
+            index_ = n_chars * password_char_bytes;
+        }
+      else if (position == 0)
+        {
+          index_ = 0;
         }
       else
-        index_ = n_chars * password_char_bytes;
-    }
-  else if (position == 0)
-    {
-      index_ = 0;
-    }
-  else
-    {
-      gchar *text = clutter_text_get_display_text (self);
-      GString *tmp = g_string_new (text);
-      gint cursor_index;
+        {
+          gchar *text = clutter_text_get_display_text (self);
+          GString *tmp = g_string_new (text);
+          gint cursor_index;
 
-      cursor_index = offset_to_bytes (text, priv->position);
+          cursor_index = offset_to_bytes (text, priv->position);
 
-      if (priv->preedit_str != NULL)
-        g_string_insert (tmp, cursor_index, priv->preedit_str);
+          if (priv->preedit_str != NULL)
+            g_string_insert (tmp, cursor_index, priv->preedit_str);
 
-      if (priv->password_char == 0)
-        index_ = offset_to_bytes (tmp->str, position);
-      else
-        index_ = position * password_char_bytes;
+          if (priv->password_char == 0)
+            index_ = offset_to_bytes (tmp->str, position);
+          else
+            index_ = position * password_char_bytes;
 
-      g_free (text);
-      g_string_free (tmp, TRUE);
-    }
+          g_free (text);
+          g_string_free (tmp, TRUE);
+        }
 
-  pango_layout_get_cursor_pos (clutter_text_get_layout (self),
-                               index_,
-                               &rect, NULL);
+      pango_layout_get_cursor_pos (clutter_text_get_layout_internal (self),
+                                   index_,
+                                   &rect, NULL);
+    }
 
   if (x)
     {
@@ -1277,6 +3286,14 @@ clutter_text_set_property (GObject      *gobject,
       clutter_text_set_selected_text_color (self, clutter_value_get_color (value));
       break;
 
+    case PROP_LAZY_LAYOUT:
+      clutter_text_set_lazy_layout (self, g_value_get_boolean (value));
+      break;
+
+    case PROP_ASYNC_LAYOUT:
+      clutter_text_set_async_layout (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -1374,6 +3391,14 @@ clutter_text_get_property (GObject    *gobject,
       g_value_set_boolean (value, priv->single_line_mode);
       break;
 
+    case PROP_LAZY_LAYOUT:
+      g_value_set_boolean (value, priv->lazy_layout);
+      break;
+
+    case PROP_ASYNC_LAYOUT:
+      g_value_set_boolean (value, priv->async_layout);
+      break;
+
     case PROP_ELLIPSIZE:
       g_value_set_enum (value, priv->ellipsize);
       break;
@@ -1419,6 +3444,7 @@ clutter_text_dispose (GObject *gobject)
 
   /* get rid of the entire cache */
   clutter_text_dirty_cache (self);
+  clutter_text_clear_shape_requests (self);
 
   if (priv->direction_changed_id)
     {
@@ -1439,6 +3465,12 @@ clutter_text_dispose (GObject *gobject)
       priv->password_hint_id = 0;
     }
 
+  if (priv->lazy_relayout_id)
+    {
+      g_source_remove (priv->lazy_relayout_id);
+      priv->lazy_relayout_id = 0;
+    }
+
   clutter_text_set_buffer (self, NULL);
 
   G_OBJECT_CLASS (clutter_text_parent_class)->dispose (gobject);
@@ -1474,36 +3506,23 @@ typedef void (* ClutterTextSelectionFunc) (ClutterText           *text,
                                            const ClutterActorBox *box,
                                            gpointer               user_data);
 
+/* calls @func for the selected ranges of the lines of @layout, which
+ * starts at the character @offset of the contents
+ */
 static void
-clutter_text_foreach_selection_rectangle (ClutterText              *self,
-                                          ClutterTextSelectionFunc  func,
-                                          gpointer                  user_data)
+clutter_text_foreach_layout_selection_rectangle (ClutterText              *self,
+                                                 PangoLayout              *layout,
+                                                 gint                      offset,
+                                                 gint                      start_index,
+                                                 gint                      end_index,
+                                                 ClutterTextSelectionFunc  func,
+                                                 gpointer                  user_data)
 {
   ClutterTextPrivate *priv = self->priv;
-  PangoLayout *layout = clutter_text_get_layout (self);
-  gchar *utf8 = clutter_text_get_display_text (self);
+  const gchar *contents = pango_layout_get_text (layout);
   gint lines;
-  gint start_index;
-  gint end_index;
   gint line_no;
 
-  if (priv->position == 0)
-    start_index = 0;
-  else
-    start_index = offset_to_bytes (utf8, priv->position);
-
-  if (priv->selection_bound == 0)
-    end_index = 0;
-  else
-    end_index = offset_to_bytes (utf8, priv->selection_bound);
-
-  if (start_index > end_index)
-    {
-      gint temp = start_index;
-      start_index = end_index;
-      end_index = temp;
-    }
-
   lines = pango_layout_get_line_count (layout);
 
   for (line_no = 0; line_no < lines; line_no++)
@@ -1528,7 +3547,7 @@ clutter_text_foreach_selection_rectangle (ClutterText              *self,
       pango_layout_line_x_to_index (line, 0, &index_, NULL);
 
       clutter_text_position_to_coords (self,
-                                       bytes_to_offset (utf8, index_),
+                                       offset + bytes_to_offset (contents, index_),
                                        NULL, &y, &height);
 
       box.y1 = y;
@@ -1557,6 +3576,125 @@ clutter_text_foreach_selection_rectangle (ClutterText              *self,
 
       g_free (ranges);
     }
+}
+
+/* the same as clutter_text_foreach_layout_selection_rectangle(), for
+ * the selected paragraphs; only the visible ones are shaped
+ */
+static void
+clutter_text_foreach_paragraph_selection_rectangle (ClutterText              *self,
+                                                    gint                      slot_index,
+                                                    ClutterTextSelectionFunc  func,
+                                                    gpointer                  user_data)
+{
+  ClutterTextPrivate *priv = self->priv;
+  ParagraphSlot *slot = &priv->paragraph_slots[slot_index];
+  ClutterRect visible;
+  gint n_chars, start, end;
+  guint i, first, last;
+
+  n_chars = clutter_text_buffer_get_length (get_buffer (self));
+  start = priv->position < 0 ? n_chars : priv->position;
+  end = priv->selection_bound < 0 ? n_chars : priv->selection_bound;
+
+  if (start > end)
+    {
+      gint temp = start;
+      start = end;
+      end = temp;
+    }
+
+  first = clutter_text_get_paragraph_at_position (self, start);
+  last = clutter_text_get_paragraph_at_position (self, end);
+
+  if (clutter_text_get_visible_rect (self, &visible))
+    {
+      guint visible_first, visible_last;
+
+      if (!slot->extents_valid)
+        clutter_text_update_paragraph_extents (self, slot_index);
+
+      clutter_text_get_visible_paragraphs (self, slot_index, &visible,
+                                           &visible_first, &visible_last);
+
+      first = MAX (first, visible_first);
+      last = MIN (last, visible_last);
+    }
+
+  for (i = first; i <= last; i++)
+    {
+      TextParagraph *paragraph;
+      PangoLayout *layout;
+      const gchar *contents;
+      gint start_index, end_index;
+
+      layout = clutter_text_get_paragraph_layout (self, slot_index, i);
+      paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+      contents = pango_layout_get_text (layout);
+
+      if (start > (gint) paragraph->char_offset)
+        start_index = offset_to_bytes (contents, start - paragraph->char_offset);
+      else
+        start_index = 0;
+
+      /* past the end of the line when the newline is selected, like
+       * in a layout holding the whole contents
+       */
+      if (end <= (gint) (paragraph->char_offset + paragraph->n_chars))
+        end_index = offset_to_bytes (contents, end - paragraph->char_offset);
+      else
+        end_index = paragraph->n_bytes + 1;
+
+      clutter_text_foreach_layout_selection_rectangle (self, layout,
+                                                       paragraph->char_offset,
+                                                       start_index, end_index,
+                                                       func, user_data);
+    }
+}
+
+static void
+clutter_text_foreach_selection_rectangle (ClutterText              *self,
+                                          ClutterTextSelectionFunc  func,
+                                          gpointer                  user_data)
+{
+  ClutterTextPrivate *priv = self->priv;
+  PangoLayout *layout;
+  gchar *utf8;
+  gint start_index;
+  gint end_index;
+  gint slot_index;
+
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      clutter_text_foreach_paragraph_selection_rectangle (self, slot_index,
+                                                          func, user_data);
+      return;
+    }
+
+  layout = clutter_text_get_layout_internal (self);
+  utf8 = clutter_text_get_display_text (self);
+
+  if (priv->position == 0)
+    start_index = 0;
+  else
+    start_index = offset_to_bytes (utf8, priv->position);
+
+  if (priv->selection_bound == 0)
+    end_index = 0;
+  else
+    end_index = offset_to_bytes (utf8, priv->selection_bound);
+
+  if (start_index > end_index)
+    {
+      gint temp = start_index;
+      start_index = end_index;
+      end_index = temp;
+    }
+
+  clutter_text_foreach_layout_selection_rectangle (self, layout, 0,
+                                                   start_index, end_index,
+                                                   func, user_data);
 
   g_free (utf8);
 }
@@ -1607,10 +3745,9 @@ selection_paint (ClutterText *self)
         }
       else
         {
-          /* Paint selection background first */
-          PangoLayout *layout = clutter_text_get_layout (self);
           CoglPath *selection_path = cogl_path_new ();
           CoglColor cogl_color = { 0, };
+          gint slot_index;
 
           /* Paint selection background */
           if (priv->selection_color_set)
@@ -1647,7 +3784,14 @@ selection_paint (ClutterText *self)
                                     color->blue,
                                     paint_opacity * color->alpha / 255);
 
-          cogl_pango_render_layout (layout, priv->text_x, 0, &cogl_color, 0);
+          /* large editable texts only paint the visible paragraphs */
+          slot_index = clutter_text_get_paragraph_slot (self);
+          if (slot_index >= 0)
+            clutter_text_paint_paragraphs (self, slot_index, &cogl_color);
+          else
+            cogl_pango_render_layout (clutter_text_get_layout_internal (self),
+                                      priv->text_x, 0,
+                                      &cogl_color, 0);
 
           cogl_clip_pop ();
         }
@@ -1662,10 +3806,16 @@ clutter_text_move_word_backward (ClutterText *self,
 
   if (clutter_text_buffer_get_length (get_buffer (self)) > 0 && start > 0)
     {
-      PangoLayout *layout = clutter_text_get_layout (self);
+      PangoLayout *layout;
       PangoLogAttr *log_attrs = NULL;
       gint n_attrs = 0;
+      gint slot_index;
 
+      slot_index = clutter_text_get_paragraph_slot (self);
+      if (slot_index >= 0)
+        return clutter_text_paragraphs_move_word (self, slot_index, start, FALSE);
+
+      layout = clutter_text_get_layout_internal (self);
       pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
 
       retval = start - 1;
@@ -1688,10 +3838,16 @@ clutter_text_move_word_forward (ClutterText *self,
   n_chars = clutter_text_buffer_get_length (get_buffer (self));
   if (n_chars > 0 && start < n_chars)
     {
-      PangoLayout *layout = clutter_text_get_layout (self);
+      PangoLayout *layout;
       PangoLogAttr *log_attrs = NULL;
       gint n_attrs = 0;
+      gint slot_index;
 
+      slot_index = clutter_text_get_paragraph_slot (self);
+      if (slot_index >= 0)
+        return clutter_text_paragraphs_move_word (self, slot_index, start, TRUE);
+
+      layout = clutter_text_get_layout_internal (self);
       pango_layout_get_log_attrs (layout, &log_attrs, &n_attrs);
 
       retval = start + 1;
@@ -1713,15 +3869,29 @@ clutter_text_move_line_start (ClutterText *self,
   gint line_no;
   gint index_;
   gint position;
-  const gchar *text;
-
-  layout = clutter_text_get_layout (self);
-  text = clutter_text_buffer_get_text (get_buffer (self));
+  gint slot_index;
+  guint paragraph = 0;
 
-  if (start == 0)
-    index_ = 0;
+  /* large editable texts only shape the paragraph holding @start */
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      paragraph = clutter_text_get_paragraph_index (self, slot_index,
+                                                    start,
+                                                    &index_);
+      layout = g_array_index (self->priv->paragraphs,
+                              TextParagraph,
+                              paragraph).layouts[slot_index];
+    }
   else
-    index_ = offset_to_bytes (text, start);
+    {
+      layout = clutter_text_get_layout_internal (self);
+
+      if (start == 0)
+        index_ = 0;
+      else
+        index_ = buffer_offset_to_bytes (self, start);
+    }
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -1733,7 +3903,12 @@ clutter_text_move_line_start (ClutterText *self,
 
   pango_layout_line_x_to_index (layout_line, 0, &index_, NULL);
 
-  position = bytes_to_offset (text, index_);
+  if (slot_index >= 0)
+    position = clutter_text_get_paragraph_position (self, slot_index,
+                                                    paragraph,
+                                                    index_);
+  else
+    position = buffer_bytes_to_offset (self, index_);
 
   return position;
 }
@@ -1749,15 +3924,29 @@ clutter_text_move_line_end (ClutterText *self,
   gint index_;
   gint trailing;
   gint position;
-  const gchar *text;
+  gint slot_index;
+  guint paragraph = 0;
 
-  layout = clutter_text_get_layout (self);
-  text = clutter_text_buffer_get_text (get_buffer (self));
-
-  if (start == 0)
-    index_ = 0;
+  /* large editable texts only shape the paragraph holding the cursor */
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      paragraph = clutter_text_get_paragraph_index (self, slot_index,
+                                                    start == 0 ? 0 : priv->position,
+                                                    &index_);
+      layout = g_array_index (priv->paragraphs,
+                              TextParagraph,
+                              paragraph).layouts[slot_index];
+    }
   else
-    index_ = offset_to_bytes (text, priv->position);
+    {
+      layout = clutter_text_get_layout_internal (self);
+
+      if (start == 0)
+        index_ = 0;
+      else
+        index_ = buffer_offset_to_bytes (self, priv->position);
+    }
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -1770,7 +3959,12 @@ clutter_text_move_line_end (ClutterText *self,
   pango_layout_line_x_to_index (layout_line, G_MAXINT, &index_, &trailing);
   index_ += trailing;
 
-  position = bytes_to_offset (text, index_);
+  if (slot_index >= 0)
+    position = clutter_text_get_paragraph_position (self, slot_index,
+                                                    paragraph,
+                                                    index_);
+  else
+    position = buffer_bytes_to_offset (self, index_);
 
   return position;
 }
@@ -1843,12 +4037,10 @@ clutter_text_press (ClutterActor *actor,
   res = clutter_actor_transform_stage_point (actor, x, y, &x, &y);
   if (res)
     {
-      const char *text;
       int offset;
 
       index_ = clutter_text_coords_to_position (self, x, y);
-      text = clutter_text_buffer_get_text (get_buffer (self));
-      offset = bytes_to_offset (text, index_);
+      offset = buffer_bytes_to_offset (self, index_);
 
       /* what we select depends on the number of button clicks we
        * receive, and whether we are selectable:
@@ -1910,7 +4102,6 @@ clutter_text_move (ClutterActor *actor,
   gfloat x, y;
   gint index_, offset;
   gboolean res;
-  const gchar *text;
 
   if (!priv->in_select_drag)
     return CLUTTER_EVENT_PROPAGATE;
@@ -1922,8 +4113,7 @@ clutter_text_move (ClutterActor *actor,
     return CLUTTER_EVENT_PROPAGATE;
 
   index_ = clutter_text_coords_to_position (self, x, y);
-  text = clutter_text_buffer_get_text (get_buffer (self));
-  offset = bytes_to_offset (text, index_);
+  offset = buffer_bytes_to_offset (self, index_);
 
   if (priv->selectable)
     clutter_text_set_cursor_position (self, offset);
@@ -2110,19 +4300,17 @@ clutter_text_key_press (ClutterActor    *actor,
 
 static void
 clutter_text_compute_layout_offsets (ClutterText           *self,
-                                     PangoLayout           *layout,
+                                     const PangoRectangle  *logical_rect,
                                      const ClutterActorBox *alloc,
                                      int                   *text_x,
                                      int                   *text_y)
 {
   ClutterActor *actor = CLUTTER_ACTOR (self);
   ClutterActorAlign x_align, y_align;
-  PangoRectangle logical_rect;
   float alloc_width, alloc_height;
   float x, y;
 
   clutter_actor_box_get_size (alloc, &alloc_width, &alloc_height);
-  pango_layout_get_pixel_extents (layout, NULL, &logical_rect);
 
   if (clutter_actor_needs_expand (actor, CLUTTER_ORIENTATION_HORIZONTAL))
     x_align = _clutter_actor_get_effective_x_align (actor);
@@ -2142,13 +4330,13 @@ clutter_text_compute_layout_offsets (ClutterText           *self,
       break;
 
     case CLUTTER_ACTOR_ALIGN_END:
-      if (alloc_width > logical_rect.width)
-        x = alloc_width - logical_rect.width;
+      if (alloc_width > logical_rect->width)
+        x = alloc_width - logical_rect->width;
       break;
 
     case CLUTTER_ACTOR_ALIGN_CENTER:
-      if (alloc_width > logical_rect.width)
-        x = (alloc_width - logical_rect.width) / 2.f;
+      if (alloc_width > logical_rect->width)
+        x = (alloc_width - logical_rect->width) / 2.f;
       break;
     }
 
@@ -2160,13 +4348,13 @@ clutter_text_compute_layout_offsets (ClutterText           *self,
       break;
 
     case CLUTTER_ACTOR_ALIGN_END:
-      if (alloc_height > logical_rect.height)
-        y = alloc_height - logical_rect.height;
+      if (alloc_height > logical_rect->height)
+        y = alloc_height - logical_rect->height;
       break;
 
     case CLUTTER_ACTOR_ALIGN_CENTER:
-      if (alloc_height > logical_rect.height)
-        y = (alloc_height - logical_rect.height) / 2.f;
+      if (alloc_height > logical_rect->height)
+        y = (alloc_height - logical_rect->height) / 2.f;
       break;
     }
 
@@ -2184,10 +4372,11 @@ clutter_text_paint (ClutterActor *self)
 {
   ClutterText *text = CLUTTER_TEXT (self);
   ClutterTextPrivate *priv = text->priv;
-  PangoLayout *layout;
+  PangoLayout *layout = NULL;
   ClutterActorBox alloc = { 0, };
   CoglColor color = { 0, };
   guint8 real_opacity;
+  gint slot_index = -1;
   gint text_x = priv->text_x;
   gint text_y = priv->text_y;
   gboolean clip_set = FALSE;
@@ -2227,6 +4416,13 @@ clutter_text_paint (ClutterActor *self)
 
   if (priv->editable && priv->single_line_mode)
     layout = clutter_text_create_layout (text, -1, -1);
+  else if ((slot_index = clutter_text_ensure_paragraphs (text,
+                                                          alloc.x2 - alloc.x1)) >= 0)
+    {
+      /* large editable texts, and the ones using :lazy-layout, are
+       * painted one paragraph at a time, see clutter_text_paint_paragraphs()
+       */
+    }
   else
     {
       /* the only time when we create the PangoLayout using the full
@@ -2312,7 +4508,13 @@ clutter_text_paint (ClutterActor *self)
     {
       PangoRectangle logical_rect = { 0, };
 
-      pango_layout_get_pixel_extents (layout, NULL, &logical_rect);
+      if (layout != NULL)
+        pango_layout_get_pixel_extents (layout, NULL, &logical_rect);
+      else
+        {
+          logical_rect = priv->paragraph_slots[slot_index].logical_rect;
+          pango_extents_to_pixels (&logical_rect, NULL);
+        }
 
       /* don't clip if the layout managed to fit inside our allocation */
       if (logical_rect.width > (alloc.x2 - alloc.x1) ||
@@ -2324,10 +4526,22 @@ clutter_text_paint (ClutterActor *self)
           clip_set = TRUE;
         }
 
-      clutter_text_compute_layout_offsets (text, layout, &alloc, &text_x, &text_y);
+      clutter_text_compute_layout_offsets (text, &logical_rect, &alloc, &text_x, &text_y);
     }
   else
-    clutter_text_compute_layout_offsets (text, layout, &alloc, &text_x, &text_y);
+    {
+      PangoRectangle logical_rect = { 0, };
+
+      if (layout != NULL)
+        pango_layout_get_pixel_extents (layout, NULL, &logical_rect);
+      else
+        {
+          logical_rect = priv->paragraph_slots[slot_index].logical_rect;
+          pango_extents_to_pixels (&logical_rect, NULL);
+        }
+
+      clutter_text_compute_layout_offsets (text, &logical_rect, &alloc, &text_x, &text_y);
+    }
 
   if (priv->text_x != text_x ||
       priv->text_y != text_y)
@@ -2350,7 +4564,10 @@ clutter_text_paint (ClutterActor *self)
                             priv->text_color.green,
                             priv->text_color.blue,
                             real_opacity);
-  cogl_pango_render_layout (layout, priv->text_x, priv->text_y, &color, 0);
+  if (layout != NULL)
+    cogl_pango_render_layout (layout, priv->text_x, priv->text_y, &color, 0);
+  else
+    clutter_text_paint_paragraphs (text, slot_index, &color);
 
   selection_paint (text);
 
@@ -2424,7 +4641,9 @@ clutter_text_get_paint_volume (ClutterActor       *self,
     {
       PangoLayout *layout;
       PangoRectangle ink_rect;
+      ClutterRect ink_box, visible;
       ClutterVertex origin;
+      gint slot_index;
 
       /* If the text is single line editable then it gets clipped to
          the allocation anyway so we can just use that */
@@ -2441,17 +4660,41 @@ clutter_text_get_paint_volume (ClutterActor       *self,
 
       _clutter_paint_volume_init_static (&priv->paint_volume, self);
 
-      layout = clutter_text_get_layout (text);
-      pango_layout_get_extents (layout, &ink_rect, NULL);
+      slot_index = clutter_text_get_paragraph_slot (text);
+      if (slot_index >= 0)
+        ink_rect = priv->paragraph_slots[slot_index].ink_rect;
+      else
+        {
+          layout = clutter_text_get_layout_internal (text);
+          pango_layout_get_extents (layout, &ink_rect, NULL);
+        }
+
+      clutter_rect_init (&ink_box,
+                         ink_rect.x / (float) PANGO_SCALE,
+                         ink_rect.y / (float) PANGO_SCALE,
+                         ink_rect.width / (float) PANGO_SCALE,
+                         ink_rect.height / (float) PANGO_SCALE);
 
-      origin.x = ink_rect.x / (float) PANGO_SCALE;
-      origin.y = ink_rect.y / (float) PANGO_SCALE;
+      /* when painting one paragraph at a time we only paint the
+       * visible ones, so we can limit the volume to the visible
+       * area; this depends on the ancestors of the actor, so the
+       * volume cannot be cached
+       */
+      if (slot_index >= 0 &&
+          clutter_text_get_visible_rect (text, &visible))
+        {
+          clutter_rect_offset (&visible, -priv->text_x, -priv->text_y);
+          clutter_rect_intersection (&ink_box, &visible, &ink_box);
+        }
+
+      origin.x = ink_box.origin.x;
+      origin.y = ink_box.origin.y;
       origin.z = 0;
       clutter_paint_volume_set_origin (&priv->paint_volume, &origin);
       clutter_paint_volume_set_width (&priv->paint_volume,
-                                      ink_rect.width / (float) PANGO_SCALE);
+                                      ink_box.size.width);
       clutter_paint_volume_set_height (&priv->paint_volume,
-                                       ink_rect.height / (float) PANGO_SCALE);
+                                       ink_box.size.height);
 
       /* If the cursor is visible then that will likely be drawn
          outside of the ink rectangle so we should merge that in */
@@ -2470,7 +4713,11 @@ clutter_text_get_paint_volume (ClutterActor       *self,
           clutter_paint_volume_free (&cursor_paint_volume);
         }
 
-      priv->paint_volume_valid = TRUE;
+      _clutter_paint_volume_copy_static (&priv->paint_volume, volume);
+
+      priv->paint_volume_valid = slot_index < 0;
+
+      return TRUE;
     }
 
   _clutter_paint_volume_copy_static (&priv->paint_volume, volume);
@@ -2490,10 +4737,16 @@ clutter_text_get_preferred_width (ClutterActor *self,
   PangoLayout *layout;
   gint logical_width;
   gfloat layout_width;
+  gint slot_index;
 
-  layout = clutter_text_create_layout (text, -1, -1);
-
-  pango_layout_get_extents (layout, NULL, &logical_rect);
+  slot_index = clutter_text_ensure_paragraphs (text, -1);
+  if (slot_index >= 0)
+    logical_rect = priv->paragraph_slots[slot_index].logical_rect;
+  else
+    {
+      layout = clutter_text_create_layout (text, -1, -1);
+      pango_layout_get_extents (layout, NULL, &logical_rect);
+    }
 
   /* the X coordinate of the logical rectangle might be non-zero
    * according to the Pango documentation; hence, we need to offset
@@ -2544,14 +4797,27 @@ clutter_text_get_preferred_height (ClutterActor *self,
       PangoRectangle logical_rect = { 0, };
       gint logical_height;
       gfloat layout_height;
+      gint slot_index;
 
       if (priv->single_line_mode)
         for_width = -1;
 
-      layout = clutter_text_create_layout (CLUTTER_TEXT (self),
-                                           for_width, -1);
-
-      pango_layout_get_extents (layout, NULL, &logical_rect);
+      /* the paragraphs are only used for wrapping texts which do not
+       * ellipsize, so we never need the first line below
+       */
+      slot_index = clutter_text_ensure_paragraphs (CLUTTER_TEXT (self),
+                                                   for_width);
+      if (slot_index >= 0)
+        {
+          logical_rect = priv->paragraph_slots[slot_index].logical_rect;
+          layout = NULL;
+        }
+      else
+        {
+          layout = clutter_text_create_layout (CLUTTER_TEXT (self),
+                                               for_width, -1);
+          pango_layout_get_extents (layout, NULL, &logical_rect);
+        }
 
       /* the Y coordinate of the logical rectangle might be non-zero
        * according to the Pango documentation; hence, we need to offset
@@ -2604,7 +4870,7 @@ clutter_text_allocate (ClutterActor           *self,
    */
   if (text->priv->editable && text->priv->single_line_mode)
     clutter_text_create_layout (text, -1, -1);
-  else
+  else if (clutter_text_ensure_paragraphs (text, box->x2 - box->x1) < 0)
     clutter_text_create_layout (text,
                                 box->x2 - box->x1,
                                 box->y2 - box->y1);
@@ -2736,15 +5002,31 @@ clutter_text_real_move_up (ClutterText         *self,
   gint index_, trailing;
   gint pos;
   gint x;
-  const gchar *text;
-
-  layout = clutter_text_get_layout (self);
-  text = clutter_text_buffer_get_text (get_buffer (self));
+  gint slot_index;
+  guint paragraph = 0;
 
-  if (priv->position == 0)
-    index_ = 0;
+  /* large editable texts only shape the paragraph holding the cursor,
+   * and the one preceding it
+   */
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      paragraph = clutter_text_get_paragraph_index (self, slot_index,
+                                                    priv->position,
+                                                    &index_);
+      layout = g_array_index (priv->paragraphs,
+                              TextParagraph,
+                              paragraph).layouts[slot_index];
+    }
   else
-    index_ = offset_to_bytes (text, priv->position);
+    {
+      layout = clutter_text_get_layout_internal (self);
+
+      if (priv->position == 0)
+        index_ = 0;
+      else
+        index_ = buffer_offset_to_bytes (self, priv->position);
+    }
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -2752,7 +5034,15 @@ clutter_text_real_move_up (ClutterText         *self,
 
   line_no -= 1;
   if (line_no < 0)
-    return FALSE;
+    {
+      if (slot_index < 0 || paragraph == 0)
+        return FALSE;
+
+      /* the last line of the previous paragraph */
+      paragraph -= 1;
+      layout = clutter_text_get_paragraph_layout (self, slot_index, paragraph);
+      line_no = pango_layout_get_line_count (layout) - 1;
+    }
 
   if (priv->x_pos != -1)
     x = priv->x_pos;
@@ -2765,7 +5055,12 @@ clutter_text_real_move_up (ClutterText         *self,
 
   g_object_freeze_notify (G_OBJECT (self));
 
-  pos = bytes_to_offset (text, index_);
+  if (slot_index >= 0)
+    pos = clutter_text_get_paragraph_position (self, slot_index,
+                                               paragraph,
+                                               index_);
+  else
+    pos = buffer_bytes_to_offset (self, index_);
   clutter_text_set_cursor_position (self, pos + trailing);
 
   /* Store the target x position to avoid drifting left and right when
@@ -2793,24 +5088,52 @@ clutter_text_real_move_down (ClutterText         *self,
   gint index_, trailing;
   gint x;
   gint pos;
-  const gchar *text;
+  gint slot_index;
+  guint paragraph = 0;
 
-  layout = clutter_text_get_layout (self);
-  text = clutter_text_buffer_get_text (get_buffer (self));
-
-  if (priv->position == 0)
-    index_ = 0;
+  /* large editable texts only shape the paragraph holding the cursor,
+   * and the one following it
+   */
+  slot_index = clutter_text_get_paragraph_slot (self);
+  if (slot_index >= 0)
+    {
+      paragraph = clutter_text_get_paragraph_index (self, slot_index,
+                                                    priv->position,
+                                                    &index_);
+      layout = g_array_index (priv->paragraphs,
+                              TextParagraph,
+                              paragraph).layouts[slot_index];
+    }
   else
-    index_ = offset_to_bytes (text, priv->position);
+    {
+      layout = clutter_text_get_layout_internal (self);
+
+      if (priv->position == 0)
+        index_ = 0;
+      else
+        index_ = buffer_offset_to_bytes (self, priv->position);
+    }
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
                                 &line_no, &x);
 
+  line_no += 1;
+  if (slot_index >= 0 && line_no >= pango_layout_get_line_count (layout))
+    {
+      if (paragraph + 1 >= priv->paragraphs->len)
+        return FALSE;
+
+      /* the first line of the next paragraph */
+      paragraph += 1;
+      layout = clutter_text_get_paragraph_layout (self, slot_index, paragraph);
+      line_no = 0;
+    }
+
   if (priv->x_pos != -1)
     x = priv->x_pos;
 
-  layout_line = pango_layout_get_line_readonly (layout, line_no + 1);
+  layout_line = pango_layout_get_line_readonly (layout, line_no);
   if (!layout_line)
     return FALSE;
 
@@ -2818,7 +5141,12 @@ clutter_text_real_move_down (ClutterText         *self,
 
   g_object_freeze_notify (G_OBJECT (self));
 
-  pos = bytes_to_offset (text, index_);
+  if (slot_index >= 0)
+    pos = clutter_text_get_paragraph_position (self, slot_index,
+                                               paragraph,
+                                               index_);
+  else
+    pos = buffer_bytes_to_offset (self, index_);
   clutter_text_set_cursor_position (self, pos + trailing);
 
   /* Store the target x position to avoid drifting left and right when
@@ -3830,6 +6158,63 @@ clutter_text_class_init (ClutterTextClass *klass)
   obj_props[PROP_SELECTED_TEXT_COLOR_SET] = pspec;
   g_object_class_install_property (gobject_class, PROP_SELECTED_TEXT_COLOR_SET, pspec);
 
+  /**
+   * ClutterText:lazy-layout:
+   *
+   * Whether the #ClutterText actor should lay out its contents one
+   * paragraph at a time, shaping each paragraph only once it becomes
+   * visible, and painting only the visible paragraphs.
+   *
+   * Until they are shaped, the size of the paragraphs is estimated
+   * from the metrics of the font, so the preferred size of the actor
+   * may change while the contents are scrolled into view.
+   *
+   * Each paragraph is aligned independently of the others, and the
+   * property is ignored by single line actors, by actors with
+   * attributes, markup, a password character or an ellipsization
+   * mode, and while a preedit string is set.
+   *
+   * This is useful for actors showing large contents, like logs,
+   * inside a #ClutterScrollActor; see also clutter_text_append_text().
+   *
+   * Since: 1.16
+   */
+  pspec = g_param_spec_boolean ("lazy-layout",
+                                P_("Lazy Layout"),
+                                P_("Whether the paragraphs should be laid out only when visible"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  obj_props[PROP_LAZY_LAYOUT] = pspec;
+  g_object_class_install_property (gobject_class, PROP_LAZY_LAYOUT, pspec);
+
+  /**
+   * ClutterText:async-layout:
+   *
+   * Whether the #ClutterText actor should shape its contents inside
+   * a worker thread while the stage lays out and paints a frame.
+   *
+   * Until the new contents have been shaped, the actor keeps showing
+   * its previous contents, or nothing if it has none; once they have
+   * been shaped, a relayout is queued. The size of the actor is only
+   * affected while the stage is laid out: querying the preferred size
+   * or the layout of the actor outside of the paint cycle always
+   * shapes the current contents synchronously.
+   *
+   * This is useful for actors showing long strings, or strings in
+   * scripts that are expensive to shape, which are changed while
+   * animations are running. The property is ignored by editable
+   * actors.
+   *
+   * Since: 1.16
+   */
+  pspec = g_param_spec_boolean ("async-layout",
+                                P_("Asynchronous Layout"),
+                                P_("Whether the contents should be shaped inside a worker thread"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  obj_props[PROP_ASYNC_LAYOUT] = pspec;
+  g_object_class_install_property (gobject_class, PROP_ASYNC_LAYOUT, pspec);
+
   /**
    * ClutterText::text-changed:
    * @self: the #ClutterText that emitted the signal
@@ -4230,6 +6615,11 @@ buffer_inserted_text (ClutterTextBuffer *buffer,
   gsize n_bytes;
 
   priv = self->priv;
+  n_bytes = g_utf8_offset_to_pointer (chars, n_chars) - chars;
+
+  if (priv->paragraphs != NULL)
+    clutter_text_paragraphs_insert (self, position, chars, n_chars, n_bytes);
+
   if (priv->position >= 0 || priv->selection_bound >= 0)
     {
       new_position = priv->position;
@@ -4244,7 +6634,6 @@ buffer_inserted_text (ClutterTextBuffer *buffer,
         clutter_text_set_positions (self, new_position, new_selection_bound);
     }
 
-  n_bytes = g_utf8_offset_to_pointer (chars, n_chars) - chars;
   g_signal_emit (self, text_signals[INSERT_TEXT], 0, chars,
                  n_bytes, &position);
 
@@ -4262,6 +6651,10 @@ buffer_deleted_text (ClutterTextBuffer *buffer,
   gint new_selection_bound;
 
   priv = self->priv;
+
+  if (priv->paragraphs != NULL)
+    clutter_text_paragraphs_delete (self, position, n_chars);
+
   if (priv->position >= 0 || priv->selection_bound >= 0)
     {
       new_position = priv->position;
@@ -4286,7 +6679,12 @@ buffer_notify_text (ClutterTextBuffer *buffer,
 {
   g_object_freeze_notify (G_OBJECT (self));
 
-  clutter_text_dirty_cache (self);
+  /* the paragraph layouts are updated by the ::inserted-text and
+   * ::deleted-text handlers, so that we only lay out again the
+   * paragraphs that were edited
+   */
+  clutter_text_dirty_layouts (self);
+  self->priv->paragraphs_disabled = FALSE;
 
   clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
 
@@ -4395,6 +6793,8 @@ clutter_text_set_buffer (ClutterText       *self,
 
   priv->buffer = buffer;
 
+  clutter_text_clear_paragraphs (self);
+
   if (priv->buffer)
      buffer_connect_signals (self);
 
@@ -4769,8 +7169,8 @@ clutter_text_get_selection (ClutterText *self)
     }
 
   text = clutter_text_buffer_get_text (get_buffer (self));
-  start_offset = offset_to_bytes (text, start_index);
-  end_offset = offset_to_bytes (text, end_index);
+  start_offset = buffer_offset_to_bytes (self, start_index);
+  end_offset = buffer_offset_to_bytes (self, end_index);
   len = end_offset - start_offset;
 
   str = g_malloc (len + 1);
@@ -5193,12 +7593,35 @@ clutter_text_set_markup (ClutterText *self,
     clutter_text_buffer_set_text (get_buffer (self), "", 0);
 }
 
+/*
+ * clutter_text_get_layout_internal:
+ * @self: a #ClutterText
+ *
+ * Like clutter_text_get_layout(), but the returned layout can be in
+ * use by other actors as well, so it must not be modified.
+ */
+static PangoLayout *
+clutter_text_get_layout_internal (ClutterText *self)
+{
+  gfloat width, height;
+
+  if (self->priv->editable && self->priv->single_line_mode)
+    return clutter_text_create_layout (self, -1, -1);
+
+  clutter_actor_get_size (CLUTTER_ACTOR (self), &width, &height);
+
+  return clutter_text_create_layout (self, width, height);
+}
+
 /**
  * clutter_text_get_layout:
  * @self: a #ClutterText
  *
  * Retrieves the current #PangoLayout used by a #ClutterText actor.
  *
+ * Actors showing the same contents may share their layouts; the
+ * layout returned by this function is never shared.
+ *
  * Return value: (transfer none): a #PangoLayout. The returned object is owned by
  *   the #ClutterText actor and should not be modified or freed
  *
@@ -5207,16 +7630,77 @@ clutter_text_set_markup (ClutterText *self,
 PangoLayout *
 clutter_text_get_layout (ClutterText *self)
 {
-  gfloat width, height;
+  ClutterTextPrivate *priv;
+  PangoLayout *layout;
+  int i;
 
   g_return_val_if_fail (CLUTTER_IS_TEXT (self), NULL);
 
-  if (self->priv->editable && self->priv->single_line_mode)
-    return clutter_text_create_layout (self, -1, -1);
+  priv = self->priv;
+  layout = clutter_text_get_layout_internal (self);
 
-  clutter_actor_get_size (CLUTTER_ACTOR (self), &width, &height);
+  /* a layout shared with other actors is replaced by a copy owned by
+   * this actor, so that changes made by the caller cannot leak into
+   * the other actors, or into the shared cache
+   */
+  for (i = 0; i < N_CACHED_LAYOUTS; i++)
+    {
+      LayoutCache *cache = priv->cached_layouts + i;
 
-  return clutter_text_create_layout (self, width, height);
+      if (cache->layout != layout || !cache->shared)
+        continue;
+
+      cache->layout = pango_layout_copy (layout);
+      cache->shared = FALSE;
+      cogl_pango_ensure_glyph_cache_for_layout (cache->layout);
+
+      g_object_unref (layout);
+
+      return cache->layout;
+    }
+
+  return layout;
+}
+
+/**
+ * clutter_text_get_shared_layout_stats:
+ * @n_layouts: (out) (allow-none): return location for the number of
+ *   layouts in the cache, or %NULL
+ * @size: (out) (allow-none): return location for the estimated size
+ *   of the layouts in the cache, in bytes, or %NULL
+ * @hits: (out) (allow-none): return location for the number of
+ *   layouts that have been found in the cache, or %NULL
+ * @misses: (out) (allow-none): return location for the number of
+ *   layouts that have been added to the cache, or %NULL
+ *
+ * Retrieves the statistics of the cache of the layouts shared by the
+ * #ClutterText actors showing the same contents with the same font
+ * and parameters.
+ *
+ * The number of hits and misses is counted since the start of the
+ * application, and it is not reset when the cache is cleared.
+ *
+ * Since: 1.16
+ */
+void
+clutter_text_get_shared_layout_stats (guint *n_layouts,
+                                      gsize *size,
+                                      guint *hits,
+                                      guint *misses)
+{
+  if (n_layouts != NULL)
+    *n_layouts = shared_layouts.layouts != NULL
+               ? g_hash_table_size (shared_layouts.layouts)
+               : 0;
+
+  if (size != NULL)
+    *size = shared_layouts.size;
+
+  if (hits != NULL)
+    *hits = shared_layouts.hits;
+
+  if (misses != NULL)
+    *misses = shared_layouts.misses;
 }
 
 /**
@@ -6204,3 +8688,216 @@ clutter_text_get_cursor_rect (ClutterText *self,
 
   *rect = self->priv->cursor_rect;
 }
+
+/**
+ * clutter_text_set_lazy_layout:
+ * @self: a #ClutterText
+ * @lazy_layout: whether the paragraphs should be laid out only when visible
+ *
+ * Sets whether @self should lay out its contents one paragraph at a
+ * time, only once each paragraph becomes visible.
+ *
+ * See #ClutterText:lazy-layout for the details.
+ *
+ * Since: 1.16
+ */
+void
+clutter_text_set_lazy_layout (ClutterText *self,
+                              gboolean     lazy_layout)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  lazy_layout = !!lazy_layout;
+
+  if (priv->lazy_layout != lazy_layout)
+    {
+      priv->lazy_layout = lazy_layout;
+
+      clutter_text_dirty_cache (self);
+
+      clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_LAZY_LAYOUT]);
+    }
+}
+
+/**
+ * clutter_text_get_lazy_layout:
+ * @self: a #ClutterText
+ *
+ * Retrieves the value set using clutter_text_set_lazy_layout().
+ *
+ * Return value: %TRUE if the paragraphs are laid out only when visible
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_text_get_lazy_layout (ClutterText *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
+
+  return self->priv->lazy_layout;
+}
+
+/**
+ * clutter_text_get_paragraph_stats:
+ * @self: a #ClutterText
+ * @n_paragraphs: (out) (allow-none): return location for the number of
+ *   paragraphs laid out separately, or %NULL
+ * @n_shaped: (out) (allow-none): return location for the number of
+ *   paragraphs currently holding a layout, or %NULL
+ * @n_shapes: (out) (allow-none): return location for the number of
+ *   paragraph layouts created so far, or %NULL
+ *
+ * Retrieves the statistics of the per-paragraph layouts used by large
+ * editable texts and by the texts using #ClutterText:lazy-layout.
+ *
+ * If @self is laid out using a single layout, the number of paragraphs
+ * and the number of shaped paragraphs are 0. The number of layouts
+ * created is counted since the creation of @self.
+ *
+ * Since: 1.16
+ */
+void
+clutter_text_get_paragraph_stats (ClutterText *self,
+                                  guint       *n_paragraphs,
+                                  guint       *n_shaped,
+                                  guint       *n_shapes)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  if (n_paragraphs != NULL)
+    *n_paragraphs = priv->paragraphs != NULL ? priv->paragraphs->len : 0;
+
+  if (n_shaped != NULL)
+    {
+      guint i, j;
+
+      *n_shaped = 0;
+
+      for (i = 0; priv->paragraphs != NULL && i < priv->paragraphs->len; i++)
+        {
+          TextParagraph *paragraph;
+
+          paragraph = &g_array_index (priv->paragraphs, TextParagraph, i);
+
+          for (j = 0; j < N_PARAGRAPH_SLOTS; j++)
+            {
+              if (paragraph->layouts[j] != NULL)
+                {
+                  *n_shaped += 1;
+                  break;
+                }
+            }
+        }
+    }
+
+  if (n_shapes != NULL)
+    *n_shapes = priv->n_paragraph_shapes;
+}
+
+/**
+ * clutter_text_set_async_layout:
+ * @self: a #ClutterText
+ * @async_layout: whether the contents should be shaped inside a
+ *   worker thread
+ *
+ * Sets whether @self should shape its contents inside a worker
+ * thread while the stage is laid out and painted.
+ *
+ * See #ClutterText:async-layout for the details.
+ *
+ * Since: 1.16
+ */
+void
+clutter_text_set_async_layout (ClutterText *self,
+                               gboolean     async_layout)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  async_layout = !!async_layout;
+
+  if (priv->async_layout != async_layout)
+    {
+      priv->async_layout = async_layout;
+
+      if (!async_layout)
+        {
+          clutter_text_clear_shape_requests (self);
+          clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+        }
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_ASYNC_LAYOUT]);
+    }
+}
+
+/**
+ * clutter_text_get_async_layout:
+ * @self: a #ClutterText
+ *
+ * Retrieves the value set using clutter_text_set_async_layout().
+ *
+ * Return value: %TRUE if the contents are shaped inside a worker thread
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_text_get_async_layout (ClutterText *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
+
+  return self->priv->async_layout;
+}
+
+/**
+ * clutter_text_append_text:
+ * @self: a #ClutterText
+ * @text: the text to append
+ * @length: the length of @text in bytes, or -1 if @text is
+ *   nul-terminated
+ *
+ * Appends @text to the contents of @self, regardless of the
+ * cursor position.
+ *
+ * Unlike replacing the whole contents, appending only lays out
+ * again the last paragraph of a #ClutterText using the
+ * #ClutterText:lazy-layout property, which makes this function
+ * suitable for streaming contents, like the tail of a log.
+ *
+ * Since: 1.16
+ */
+void
+clutter_text_append_text (ClutterText *self,
+                          const gchar *text,
+                          gssize       length)
+{
+  ClutterTextBuffer *buffer;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+  g_return_if_fail (text != NULL);
+
+  if (length < 0)
+    length = strlen (text);
+
+  if (length == 0)
+    return;
+
+  buffer = get_buffer (self);
+
+  clutter_text_buffer_insert_text (buffer,
+                                   clutter_text_buffer_get_length (buffer),
+                                   text,
+                                   g_utf8_strlen (text, length));
+}
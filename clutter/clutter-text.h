@@ -235,6 +235,32 @@ void                  clutter_text_get_layout_offsets   (ClutterText           *
                                                          gint                  *x,
                                                          gint                  *y);
 
+CLUTTER_AVAILABLE_IN_1_16
+void                  clutter_text_set_lazy_layout      (ClutterText          *self,
+                                                         gboolean              lazy_layout);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean              clutter_text_get_lazy_layout      (ClutterText          *self);
+CLUTTER_AVAILABLE_IN_1_16
+void                  clutter_text_get_paragraph_stats  (ClutterText          *self,
+                                                         guint                *n_paragraphs,
+                                                         guint                *n_shaped,
+                                                         guint                *n_shapes);
+CLUTTER_AVAILABLE_IN_1_16
+void                  clutter_text_append_text          (ClutterText          *self,
+                                                         const gchar          *text,
+                                                         gssize                length);
+CLUTTER_AVAILABLE_IN_1_16
+void                  clutter_text_set_async_layout     (ClutterText          *self,
+                                                         gboolean              async_layout);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean              clutter_text_get_async_layout     (ClutterText          *self);
+
+CLUTTER_AVAILABLE_IN_1_16
+void                  clutter_text_get_shared_layout_stats (guint             *n_layouts,
+                                                            gsize             *size,
+                                                            guint             *hits,
+                                                            guint             *misses);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_TEXT_H__ */
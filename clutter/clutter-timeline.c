@@ -114,6 +114,13 @@
 
 static void clutter_scriptable_iface_init (ClutterScriptableIface *iface);
 
+static gdouble clutter_timeline_progress_func (ClutterTimeline *timeline,
+                                               gdouble          elapsed,
+                                               gdouble          duration,
+                                               gpointer         user_data);
+static void clutter_timeline_clear_progress_table (ClutterTimeline *timeline);
+static ClutterEasingTable *clutter_timeline_get_progress_table (ClutterTimeline *timeline);
+
 G_DEFINE_TYPE_WITH_CODE (ClutterTimeline, clutter_timeline, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (CLUTTER_TYPE_SCRIPTABLE,
                                                 clutter_scriptable_iface_init));
@@ -158,6 +165,9 @@ struct _ClutterTimelinePrivate
   ClutterPoint cb_1;
   ClutterPoint cb_2;
 
+  /* the sampled progress function, if sampled-progress is set */
+  ClutterEasingTable *progress_table;
+
   guint is_playing         : 1;
 
   /* If we've just started playing and haven't yet gotten
@@ -165,6 +175,7 @@ struct _ClutterTimelinePrivate
    */
   guint waiting_first_tick : 1;
   guint auto_reverse       : 1;
+  guint sampled_progress   : 1;
 };
 
 typedef struct {
@@ -190,6 +201,7 @@ enum
   PROP_AUTO_REVERSE,
   PROP_REPEAT_COUNT,
   PROP_PROGRESS_MODE,
+  PROP_SAMPLED_PROGRESS,
 
   PROP_LAST
 };
@@ -475,6 +487,10 @@ clutter_timeline_set_property (GObject      *object,
       clutter_timeline_set_progress_mode (timeline, g_value_get_enum (value));
       break;
 
+    case PROP_SAMPLED_PROGRESS:
+      clutter_timeline_set_sampled_progress (timeline, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -520,6 +536,10 @@ clutter_timeline_get_property (GObject    *object,
       g_value_set_enum (value, priv->progress_mode);
       break;
 
+    case PROP_SAMPLED_PROGRESS:
+      g_value_set_boolean (value, priv->sampled_progress);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -536,6 +556,9 @@ clutter_timeline_finalize (GObject *object)
   if (priv->markers_by_name)
     g_hash_table_destroy (priv->markers_by_name);
 
+  if (priv->progress_table != NULL)
+    clutter_easing_table_unref (priv->progress_table);
+
   if (priv->is_playing)
     {
       master_clock = _clutter_master_clock_get_default ();
@@ -694,6 +717,27 @@ clutter_timeline_class_init (ClutterTimelineClass *klass)
                        CLUTTER_LINEAR,
                        CLUTTER_PARAM_READWRITE);
 
+  /**
+   * ClutterTimeline:sampled-progress:
+   *
+   * Whether the timeline should compute the progress of its
+   * #ClutterTimeline:progress-mode from a table of precomputed values,
+   * instead of evaluating the easing function at every frame.
+   *
+   * The tables are shared by all the timelines using the same progress
+   * mode; their values are within 0.001 of the easing function. Custom
+   * progress functions, the step modes, and the circular and bounce
+   * modes are always evaluated directly.
+   *
+   * Since: 1.16
+   */
+  obj_props[PROP_SAMPLED_PROGRESS] =
+    g_param_spec_boolean ("sampled-progress",
+                          P_("Sampled Progress"),
+                          P_("Whether the progress should be computed from precomputed values"),
+                          FALSE,
+                          CLUTTER_PARAM_READWRITE);
+
   object_class->dispose = clutter_timeline_dispose;
   object_class->finalize = clutter_timeline_finalize;
   object_class->set_property = clutter_timeline_set_property;
@@ -1763,6 +1807,206 @@ _clutter_timeline_do_tick (ClutterTimeline *timeline,
     }
 }
 
+/*
+ * clutter_timeline_get_easing:
+ * @timeline: a #ClutterTimeline
+ * @func: (out): return location for the easing function, or %NULL
+ *   if the timeline uses a cubic Bézier progress or a sampled table
+ * @cubic_bezier: (out) (array fixed-size=4): return location for the
+ *   control points of the cubic Bézier progress
+ * @table: (out) (transfer full): return location for the sampled
+ *   progress table, or %NULL
+ *
+ * Resolves the progress mode of @timeline into something that can be
+ * evaluated without calling clutter_timeline_get_progress().
+ *
+ * If #ClutterTimeline:sampled-progress is set and the progress mode
+ * has a table, @table is set to a reference on it, and it should be
+ * used instead of @func and @cubic_bezier.
+ *
+ * Return value: %FALSE if the timeline uses a custom progress function
+ *   or a parametrized mode other than cubic-bezier()
+ */
+static gboolean
+clutter_timeline_get_easing (ClutterTimeline     *timeline,
+                             ClutterEasingFunc   *func,
+                             gdouble             *cubic_bezier,
+                             ClutterEasingTable **table)
+{
+  ClutterTimelinePrivate *priv = timeline->priv;
+
+  *func = NULL;
+  *table = NULL;
+
+  /* short-circuit linear progress, see clutter_timeline_get_progress() */
+  if (priv->progress_func == NULL)
+    {
+      *func = clutter_linear;
+      return TRUE;
+    }
+
+  if (priv->progress_func != clutter_timeline_progress_func)
+    return FALSE;
+
+  /* same as clutter_timeline_progress_func() */
+  if (priv->sampled_progress)
+    {
+      if (priv->progress_table == NULL)
+        priv->progress_table = clutter_timeline_get_progress_table (timeline);
+
+      if (priv->progress_table != NULL)
+        {
+          *table = clutter_easing_table_ref (priv->progress_table);
+          return TRUE;
+        }
+    }
+
+  switch (priv->progress_mode)
+    {
+    case CLUTTER_STEPS:
+    case CLUTTER_STEP_START:
+    case CLUTTER_STEP_END:
+      return FALSE;
+
+    case CLUTTER_CUBIC_BEZIER:
+      cubic_bezier[0] = priv->cb_1.x;
+      cubic_bezier[1] = priv->cb_1.y;
+      cubic_bezier[2] = priv->cb_2.x;
+      cubic_bezier[3] = priv->cb_2.y;
+      break;
+
+    case CLUTTER_EASE:
+      cubic_bezier[0] = 0.25;
+      cubic_bezier[1] = 0.1;
+      cubic_bezier[2] = 0.25;
+      cubic_bezier[3] = 1.0;
+      break;
+
+    case CLUTTER_EASE_IN:
+      cubic_bezier[0] = 0.42;
+      cubic_bezier[1] = 0.0;
+      cubic_bezier[2] = 1.0;
+      cubic_bezier[3] = 1.0;
+      break;
+
+    case CLUTTER_EASE_OUT:
+      cubic_bezier[0] = 0.0;
+      cubic_bezier[1] = 0.0;
+      cubic_bezier[2] = 0.58;
+      cubic_bezier[3] = 1.0;
+      break;
+
+    case CLUTTER_EASE_IN_OUT:
+      cubic_bezier[0] = 0.42;
+      cubic_bezier[1] = 0.0;
+      cubic_bezier[2] = 0.58;
+      cubic_bezier[3] = 1.0;
+      break;
+
+    default:
+      *func = clutter_get_easing_func_for_mode (priv->progress_mode);
+      break;
+    }
+
+  return TRUE;
+}
+
+/*< private >
+ * _clutter_timeline_advance_batched:
+ * @timeline: a #ClutterTimeline
+ * @tick_time: time of advance
+ * @elapsed: (out): return location for the new elapsed time
+ * @duration: (out): return location for the duration
+ * @func: (out): return location for the easing function, or %NULL
+ * @cubic_bezier: (out) (array fixed-size=4): return location for the
+ *   cubic Bézier control points, if @func is %NULL
+ * @table: (out) (transfer full): return location for the sampled progress
+ *   table, or %NULL; if set, it is used instead of @func and @cubic_bezier,
+ *   and the caller should release it with clutter_easing_table_unref()
+ *
+ * Advances @timeline like _clutter_timeline_do_tick() would, but
+ * without emitting the #ClutterTimeline::new-frame signal. The caller
+ * is responsible for computing the progress from the returned values
+ * and applying it, or for calling _clutter_timeline_emit_new_frame().
+ *
+ * Only frames that do not have any side effect beyond the default
+ * handler of the #ClutterTimeline::new-frame signal can be advanced
+ * this way: the first frame, frames reaching the end of the timeline,
+ * timelines with markers, custom progress functions or handlers
+ * connected to the ::new-frame signal are left untouched.
+ *
+ * Return value: %TRUE if @timeline was advanced, and %FALSE if
+ *   _clutter_timeline_do_tick() should be used instead
+ */
+gboolean
+_clutter_timeline_advance_batched (ClutterTimeline   *timeline,
+                                   gint64             tick_time,
+                                   gdouble           *elapsed,
+                                   gdouble           *duration,
+                                   ClutterEasingFunc *func,
+                                   gdouble           *cubic_bezier,
+                                   ClutterEasingTable **table)
+{
+  ClutterTimelinePrivate *priv = timeline->priv;
+  gint64 msecs, elapsed_time;
+
+  if (!priv->is_playing || priv->waiting_first_tick)
+    return FALSE;
+
+  /* rolled back and stalled clocks are handled by do_tick() */
+  msecs = tick_time - priv->last_frame_time;
+  if (msecs <= 0)
+    return FALSE;
+
+  if (priv->direction == CLUTTER_TIMELINE_FORWARD)
+    {
+      elapsed_time = priv->elapsed_time + msecs;
+      if (elapsed_time >= priv->duration)
+        return FALSE;
+    }
+  else
+    {
+      elapsed_time = priv->elapsed_time - msecs;
+      if (elapsed_time <= 0)
+        return FALSE;
+    }
+
+  if (priv->markers_by_name != NULL &&
+      g_hash_table_size (priv->markers_by_name) != 0)
+    return FALSE;
+
+  if (g_signal_has_handler_pending (timeline,
+                                    timeline_signals[NEW_FRAME],
+                                    0, TRUE))
+    return FALSE;
+
+  if (!clutter_timeline_get_easing (timeline, func, cubic_bezier, table))
+    return FALSE;
+
+  priv->last_frame_time += msecs;
+  priv->msecs_delta = msecs;
+  priv->elapsed_time = elapsed_time;
+
+  *elapsed = (gdouble) priv->elapsed_time;
+  *duration = (gdouble) priv->duration;
+
+  return TRUE;
+}
+
+/*< private >
+ * _clutter_timeline_emit_new_frame:
+ * @timeline: a #ClutterTimeline
+ *
+ * Emits the #ClutterTimeline::new-frame signal for a frame that was
+ * advanced using _clutter_timeline_advance_batched() but that could
+ * not be applied in bulk.
+ */
+void
+_clutter_timeline_emit_new_frame (ClutterTimeline *timeline)
+{
+  emit_frame_signal (timeline);
+}
+
 /**
  * clutter_timeline_add_marker:
  * @timeline: a #ClutterTimeline
@@ -2219,6 +2463,8 @@ clutter_timeline_set_progress_func (ClutterTimeline             *timeline,
   priv->progress_data = data;
   priv->progress_notify = notify;
 
+  clutter_timeline_clear_progress_table (timeline);
+
   if (priv->progress_func != NULL)
     priv->progress_mode = CLUTTER_CUSTOM_MODE;
   else
@@ -2227,6 +2473,47 @@ clutter_timeline_set_progress_func (ClutterTimeline             *timeline,
   g_object_notify_by_pspec (G_OBJECT (timeline), obj_props[PROP_PROGRESS_MODE]);
 }
 
+static void
+clutter_timeline_clear_progress_table (ClutterTimeline *timeline)
+{
+  ClutterTimelinePrivate *priv = timeline->priv;
+
+  if (priv->progress_table != NULL)
+    {
+      clutter_easing_table_unref (priv->progress_table);
+      priv->progress_table = NULL;
+    }
+}
+
+static ClutterEasingTable *
+clutter_timeline_get_progress_table (ClutterTimeline *timeline)
+{
+  ClutterTimelinePrivate *priv = timeline->priv;
+
+  switch (priv->progress_mode)
+    {
+    case CLUTTER_CUBIC_BEZIER:
+      return clutter_easing_table_for_cubic_bezier (priv->cb_1.x, priv->cb_1.y,
+                                                    priv->cb_2.x, priv->cb_2.y);
+
+    case CLUTTER_EASE:
+      return clutter_easing_table_for_cubic_bezier (0.25, 0.1, 0.25, 1.0);
+
+    case CLUTTER_EASE_IN:
+      return clutter_easing_table_for_cubic_bezier (0.42, 0.0, 1.0, 1.0);
+
+    case CLUTTER_EASE_OUT:
+      return clutter_easing_table_for_cubic_bezier (0.0, 0.0, 0.58, 1.0);
+
+    case CLUTTER_EASE_IN_OUT:
+      return clutter_easing_table_for_cubic_bezier (0.42, 0.0, 0.58, 1.0);
+
+    default:
+      /* returns NULL for the modes that are not sampled */
+      return clutter_easing_table_for_mode (priv->progress_mode);
+    }
+}
+
 static gdouble
 clutter_timeline_progress_func (ClutterTimeline *timeline,
                                 gdouble          elapsed,
@@ -2235,6 +2522,17 @@ clutter_timeline_progress_func (ClutterTimeline *timeline,
 {
   ClutterTimelinePrivate *priv = timeline->priv;
 
+  if (priv->sampled_progress)
+    {
+      if (priv->progress_table == NULL)
+        priv->progress_table = clutter_timeline_get_progress_table (timeline);
+
+      if (priv->progress_table != NULL)
+        return clutter_easing_table_evaluate (priv->progress_table,
+                                              elapsed,
+                                              duration);
+    }
+
   /* parametrized easing functions need to be handled separately */
   switch (priv->progress_mode)
     {
@@ -2312,6 +2610,8 @@ clutter_timeline_set_progress_mode (ClutterTimeline      *timeline,
 
   priv->progress_mode = mode;
 
+  clutter_timeline_clear_progress_table (timeline);
+
   /* short-circuit linear progress */
   if (priv->progress_mode != CLUTTER_LINEAR)
     priv->progress_func = clutter_timeline_progress_func;
@@ -2501,6 +2801,9 @@ clutter_timeline_set_cubic_bezier_progress (ClutterTimeline    *timeline,
   priv->cb_1.x = CLAMP (priv->cb_1.x, 0.f, 1.f);
   priv->cb_2.x = CLAMP (priv->cb_2.x, 0.f, 1.f);
 
+  /* the control points may have changed even if the mode did not */
+  clutter_timeline_clear_progress_table (timeline);
+
   clutter_timeline_set_progress_mode (timeline, CLUTTER_CUBIC_BEZIER);
 }
 
@@ -2541,3 +2844,56 @@ clutter_timeline_get_cubic_bezier_progress (ClutterTimeline *timeline,
 
   return TRUE;
 }
+
+/**
+ * clutter_timeline_set_sampled_progress:
+ * @timeline: a #ClutterTimeline
+ * @sampled: whether the progress should be computed from precomputed values
+ *
+ * Sets whether @timeline should compute its progress from a table of
+ * values of its easing function precomputed at regular intervals.
+ *
+ * See #ClutterTimeline:sampled-progress.
+ *
+ * Since: 1.16
+ */
+void
+clutter_timeline_set_sampled_progress (ClutterTimeline *timeline,
+                                       gboolean         sampled)
+{
+  ClutterTimelinePrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TIMELINE (timeline));
+
+  priv = timeline->priv;
+
+  sampled = !!sampled;
+
+  if (priv->sampled_progress == sampled)
+    return;
+
+  priv->sampled_progress = sampled;
+
+  if (!priv->sampled_progress)
+    clutter_timeline_clear_progress_table (timeline);
+
+  g_object_notify_by_pspec (G_OBJECT (timeline), obj_props[PROP_SAMPLED_PROGRESS]);
+}
+
+/**
+ * clutter_timeline_get_sampled_progress:
+ * @timeline: a #ClutterTimeline
+ *
+ * Retrieves the value set by clutter_timeline_set_sampled_progress().
+ *
+ * Return value: %TRUE if the progress is computed from precomputed values
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_timeline_get_sampled_progress (ClutterTimeline *timeline)
+{
+  g_return_val_if_fail (CLUTTER_IS_TIMELINE (timeline), FALSE);
+
+  return timeline->priv->sampled_progress;
+}
@@ -190,6 +190,11 @@ CLUTTER_AVAILABLE_IN_1_12
 gboolean                        clutter_timeline_get_cubic_bezier_progress      (ClutterTimeline          *timeline,
                                                                                  ClutterPoint             *c_1,
                                                                                  ClutterPoint             *c_2);
+CLUTTER_AVAILABLE_IN_1_16
+void                            clutter_timeline_set_sampled_progress           (ClutterTimeline          *timeline,
+                                                                                 gboolean                  sampled);
+CLUTTER_AVAILABLE_IN_1_16
+gboolean                        clutter_timeline_get_sampled_progress           (ClutterTimeline          *timeline);
 
 CLUTTER_AVAILABLE_IN_1_10
 gint64                          clutter_timeline_get_duration_hint              (ClutterTimeline          *timeline);
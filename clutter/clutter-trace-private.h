@@ -0,0 +1,79 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_TRACE_PRIVATE_H__
+#define __CLUTTER_TRACE_PRIVATE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ClutterTraceCounter     ClutterTraceCounter;
+
+/* a counter reported once per frame, see _clutter_trace_flush_counters() */
+struct _ClutterTraceCounter
+{
+  const gchar *name;
+  volatile gint value;
+
+  ClutterTraceCounter *next;
+  gboolean registered;
+};
+
+/* whether a trace is being recorded; this is checked before calling
+ * any of the functions below, so that the instrumentation costs a
+ * single branch when tracing is disabled
+ */
+extern gboolean _clutter_trace_enabled;
+
+/* the tracing counterparts of the CLUTTER_STATIC_TIMER and
+ * CLUTTER_STATIC_COUNTER macros in clutter-profile.h
+ */
+#define _CLUTTER_TRACE_STATIC_TIMER(A,C) \
+  static const gchar G_PASTE (A, _trace_name)[] G_GNUC_UNUSED = C
+#define _CLUTTER_TRACE_STATIC_COUNTER(A,B) \
+  static ClutterTraceCounter G_PASTE (A, _trace_counter) G_GNUC_UNUSED = { B, 0, NULL, FALSE }
+
+#define _CLUTTER_TRACE_TIMER_START(A)                                   G_STMT_START { \
+  if (G_UNLIKELY (_clutter_trace_enabled))                                              \
+    _clutter_trace_begin (G_PASTE (A, _trace_name));                                    \
+                                                                        } G_STMT_END
+#define _CLUTTER_TRACE_TIMER_STOP(A)                                    G_STMT_START { \
+  if (G_UNLIKELY (_clutter_trace_enabled))                                              \
+    _clutter_trace_end (G_PASTE (A, _trace_name));                                      \
+                                                                        } G_STMT_END
+#define _CLUTTER_TRACE_COUNTER_ADD(A,D)                                 G_STMT_START { \
+  if (G_UNLIKELY (_clutter_trace_enabled))                                              \
+    _clutter_trace_counter_add (&G_PASTE (A, _trace_counter), (D));                     \
+                                                                        } G_STMT_END
+
+void    _clutter_trace_begin            (const gchar         *name);
+void    _clutter_trace_end              (const gchar         *name);
+void    _clutter_trace_span             (const gchar         *category,
+                                         const gchar         *name,
+                                         gint64               start_time);
+void    _clutter_trace_counter_add      (ClutterTraceCounter *counter,
+                                         gint                 delta);
+void    _clutter_trace_flush_counters   (void);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_TRACE_PRIVATE_H__ */
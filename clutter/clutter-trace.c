@@ -0,0 +1,579 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:clutter-trace
+ * @Title: Tracing
+ * @Short_Description: Recording the activity of Clutter
+ *
+ * Clutter can record a trace of its activity into a file using the
+ * JSON format of the Chrome trace viewer, which can be loaded into
+ * <literal>chrome://tracing</literal> or into Perfetto to inspect
+ * each frame, instead of the averages printed by the profiler.
+ *
+ * A trace contains:
+ * <itemizedlist>
+ *   <listitem><para>a pair of begin and end events for each run of the
+ *   timers of Clutter, like the master clock dispatch, the event
+ *   processing, the stage redraw and the picking;</para></listitem>
+ *   <listitem><para>the value of each counter of Clutter, like the
+ *   number of actors painted, once per frame;</para></listitem>
+ *   <listitem><para>the painting and the allocation of each actor that
+ *   take longer than a threshold, 500 microseconds by default.</para></listitem>
+ * </itemizedlist>
+ *
+ * A trace is recorded between the calls to clutter_trace_start() and
+ * clutter_trace_stop(), or for the whole life time of the application
+ * if the <envar>CLUTTER_TRACE</envar> environment variable is set to
+ * the name of the file to write. The threshold of the actor events
+ * can be changed using the <envar>CLUTTER_TRACE_THRESHOLD</envar>
+ * environment variable, in microseconds.
+ *
+ * The events are stored into a buffer that does not require locking,
+ * and written to the file by a separate thread. If the thread cannot
+ * keep up, some events are dropped, and a warning is printed when the
+ * trace is stopped.
+ *
+ * Tracing is available since Clutter 1.16
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "clutter-trace.h"
+#include "clutter-trace-private.h"
+
+#include "clutter-debug.h"
+#include "clutter-private.h"
+
+/* the size of the buffer of events; this must be a power of two */
+#define N_TRACE_EVENTS          (1 << 16)
+
+/* how often the events are written to the file, in microseconds */
+#define FLUSH_INTERVAL          (50 * 1000)
+
+/* the default duration above which actors are traced, in microseconds */
+#define DEFAULT_SPAN_THRESHOLD  500
+
+/* the size of the copy of the names that are not static strings,
+ * including the terminating zero
+ */
+#define TRACE_NAME_SIZE         48
+
+typedef struct _TraceEvent      TraceEvent;
+
+struct _TraceEvent
+{
+  /* the position of the event in the trace, plus one, once the
+   * event has been written; see trace_reserve()
+   */
+  volatile gint sequence;
+
+  /* 'B' and 'E' for begin and end, 'X' for complete and 'C' for counter */
+  gchar phase;
+
+  const gchar *category;
+
+  /* static strings are stored as they are, while the other names,
+   * like the ones of the actors, are copied into the event
+   */
+  const gchar *name;
+  gchar name_copy[TRACE_NAME_SIZE];
+
+  guint thread_id;
+  gint64 timestamp;
+
+  /* the duration of complete events, or the value of counters */
+  gint64 value;
+};
+
+gboolean _clutter_trace_enabled = FALSE;
+
+static TraceEvent *trace_events = NULL;
+
+/* the position of the next event to be reserved, and the position of
+ * the next event to be written to the file; both wrap around
+ */
+static volatile gint trace_write_index = 0;
+static volatile gint trace_read_index = 0;
+
+static volatile gint trace_dropped = 0;
+
+static gint64 trace_span_threshold = DEFAULT_SPAN_THRESHOLD;
+
+static GThread *trace_thread = NULL;
+static GMutex trace_lock;
+static GCond trace_cond;
+static gboolean trace_stopping = FALSE;
+static FILE *trace_file = NULL;
+static guint trace_n_written = 0;
+
+/* the counters that have been incremented since the trace started */
+static GMutex trace_counters_lock;
+static ClutterTraceCounter *trace_counters = NULL;
+
+static volatile gint trace_last_thread_id = 0;
+static GPrivate trace_thread_id;
+
+static guint
+trace_get_thread_id (void)
+{
+  guint id = GPOINTER_TO_UINT (g_private_get (&trace_thread_id));
+
+  if (G_UNLIKELY (id == 0))
+    {
+      id = g_atomic_int_add (&trace_last_thread_id, 1) + 1;
+      g_private_set (&trace_thread_id, GUINT_TO_POINTER (id));
+    }
+
+  return id;
+}
+
+/* Reserves a slot in the buffer; the slot is published once its
+ * sequence is set, so events can be recorded by any thread without
+ * locking. If the buffer is full the event is dropped.
+ */
+static TraceEvent *
+trace_reserve (guint *position)
+{
+  guint index_;
+
+  do
+    {
+      index_ = (guint) g_atomic_int_get (&trace_write_index);
+
+      if (index_ - (guint) g_atomic_int_get (&trace_read_index) >= N_TRACE_EVENTS)
+        {
+          g_atomic_int_inc (&trace_dropped);
+          return NULL;
+        }
+    }
+  while (!g_atomic_int_compare_and_exchange (&trace_write_index,
+                                             (gint) index_,
+                                             (gint) (index_ + 1)));
+
+  *position = index_;
+
+  return &trace_events[index_ & (N_TRACE_EVENTS - 1)];
+}
+
+/* copies @name into the event, truncating it on a character boundary */
+static void
+trace_copy_name (TraceEvent  *event,
+                 const gchar *name)
+{
+  gsize len;
+
+  len = g_strlcpy (event->name_copy, name, TRACE_NAME_SIZE);
+  if (len >= TRACE_NAME_SIZE)
+    {
+      len = TRACE_NAME_SIZE - 1;
+
+      while (len > 0 && ((guchar) event->name_copy[len] & 0xc0) == 0x80)
+        len -= 1;
+
+      event->name_copy[len] = '\0';
+    }
+
+  event->name = NULL;
+}
+
+static void
+trace_record (gchar        phase,
+              const gchar *category,
+              const gchar *name,
+              gboolean     copy_name,
+              gint64       timestamp,
+              gint64       value)
+{
+  TraceEvent *event;
+  guint position;
+
+  event = trace_reserve (&position);
+  if (event == NULL)
+    return;
+
+  event->phase = phase;
+  event->category = category;
+
+  if (copy_name)
+    trace_copy_name (event, name);
+  else
+    event->name = name;
+  event->thread_id = trace_get_thread_id ();
+  event->timestamp = timestamp;
+  event->value = value;
+
+  g_atomic_int_set (&event->sequence, (gint) (position + 1));
+}
+
+static void
+trace_write_string (const gchar *str)
+{
+  const gchar *p;
+
+  fputc ('"', trace_file);
+
+  for (p = str; *p != '\0'; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        fprintf (trace_file, "\\%c", *p);
+      else if ((guchar) *p < 0x20)
+        fprintf (trace_file, "\\u%04x", (guint) (guchar) *p);
+      else
+        fputc (*p, trace_file);
+    }
+
+  fputc ('"', trace_file);
+}
+
+static void
+trace_write_event (const TraceEvent *event)
+{
+#ifdef G_OS_UNIX
+  int pid = getpid ();
+#else
+  int pid = 0;
+#endif
+
+  if (trace_n_written > 0)
+    fputs (",\n", trace_file);
+
+  fputs ("{\"name\":", trace_file);
+  trace_write_string (event->name != NULL ? event->name : event->name_copy);
+  fprintf (trace_file,
+           ",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%u,"
+           "\"ts\":%" G_GINT64_FORMAT,
+           event->category,
+           event->phase,
+           pid,
+           event->thread_id,
+           event->timestamp);
+
+  if (event->phase == 'X')
+    fprintf (trace_file, ",\"dur\":%" G_GINT64_FORMAT, event->value);
+  else if (event->phase == 'C')
+    fprintf (trace_file, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}",
+             event->value);
+
+  fputc ('}', trace_file);
+
+  trace_n_written += 1;
+}
+
+/* Writes all the published events to the file; this is only called
+ * by the writer thread
+ */
+static void
+trace_flush (void)
+{
+  guint index_ = (guint) g_atomic_int_get (&trace_read_index);
+
+  while (TRUE)
+    {
+      TraceEvent *event = &trace_events[index_ & (N_TRACE_EVENTS - 1)];
+
+      if ((guint) g_atomic_int_get (&event->sequence) != index_ + 1)
+        break;
+
+      trace_write_event (event);
+
+      index_ += 1;
+
+      /* hand the slot back to the writers */
+      g_atomic_int_set (&trace_read_index, (gint) index_);
+    }
+
+  fflush (trace_file);
+}
+
+static gpointer
+trace_thread_func (gpointer data)
+{
+  gboolean stopping;
+
+  g_mutex_lock (&trace_lock);
+
+  do
+    {
+      stopping = trace_stopping;
+
+      g_mutex_unlock (&trace_lock);
+
+      trace_flush ();
+
+      g_mutex_lock (&trace_lock);
+
+      if (!stopping && !trace_stopping)
+        g_cond_wait_until (&trace_cond, &trace_lock,
+                           g_get_monotonic_time () + FLUSH_INTERVAL);
+    }
+  while (!stopping);
+
+  g_mutex_unlock (&trace_lock);
+
+  return NULL;
+}
+
+static void
+trace_stop_at_exit (void)
+{
+  clutter_trace_stop ();
+}
+
+/**
+ * clutter_trace_start:
+ * @filename: the name of the file to write the trace into
+ * @error: return location for a #GError, or %NULL
+ *
+ * Starts recording a trace of the activity of Clutter into @filename,
+ * using the JSON format of the Chrome trace viewer.
+ *
+ * If a trace is being recorded already this function does nothing.
+ *
+ * The trace is stopped by calling clutter_trace_stop(), or when the
+ * application terminates.
+ *
+ * Return value: %TRUE if the trace was started, and %FALSE otherwise
+ *
+ * Since: 1.16
+ */
+gboolean
+clutter_trace_start (const gchar  *filename,
+                     GError      **error)
+{
+  static gboolean atexit_installed = FALSE;
+  const gchar *env_string;
+
+  g_return_val_if_fail (filename != NULL, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (trace_thread != NULL)
+    return TRUE;
+
+  trace_file = g_fopen (filename, "w");
+  if (trace_file == NULL)
+    {
+      int saved_errno = errno;
+
+      g_set_error (error, G_FILE_ERROR,
+                   g_file_error_from_errno (saved_errno),
+                   "Unable to open the trace file '%s': %s",
+                   filename,
+                   g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  /* the buffer is never released, in case an event is being recorded
+   * by another thread while the trace is stopped
+   */
+  if (trace_events == NULL)
+    trace_events = g_new0 (TraceEvent, N_TRACE_EVENTS);
+  else
+    memset (trace_events, 0, sizeof (TraceEvent) * N_TRACE_EVENTS);
+
+  trace_write_index = 0;
+  trace_read_index = 0;
+  trace_dropped = 0;
+  trace_n_written = 0;
+  trace_stopping = FALSE;
+
+  env_string = g_getenv ("CLUTTER_TRACE_THRESHOLD");
+  if (env_string != NULL)
+    trace_span_threshold = MAX (g_ascii_strtoll (env_string, NULL, 10), 0);
+  else
+    trace_span_threshold = DEFAULT_SPAN_THRESHOLD;
+
+  fputs ("{\"traceEvents\":[\n", trace_file);
+
+  trace_thread = g_thread_try_new ("Clutter trace writer",
+                                   trace_thread_func,
+                                   NULL,
+                                   error);
+  if (trace_thread == NULL)
+    {
+      fclose (trace_file);
+      trace_file = NULL;
+      return FALSE;
+    }
+
+  if (!atexit_installed)
+    {
+      atexit (trace_stop_at_exit);
+      atexit_installed = TRUE;
+    }
+
+  CLUTTER_NOTE (MISC, "Tracing into '%s'", filename);
+
+  _clutter_trace_enabled = TRUE;
+
+  return TRUE;
+}
+
+/**
+ * clutter_trace_stop:
+ *
+ * Stops the trace started with clutter_trace_start(), and writes the
+ * remaining events to the file.
+ *
+ * Since: 1.16
+ */
+void
+clutter_trace_stop (void)
+{
+  ClutterTraceCounter *counter;
+  guint dropped;
+
+  if (trace_thread == NULL)
+    return;
+
+  _clutter_trace_enabled = FALSE;
+
+  g_mutex_lock (&trace_lock);
+  trace_stopping = TRUE;
+  g_cond_signal (&trace_cond);
+  g_mutex_unlock (&trace_lock);
+
+  g_thread_join (trace_thread);
+  trace_thread = NULL;
+
+  fputs ("\n]}\n", trace_file);
+  fclose (trace_file);
+  trace_file = NULL;
+
+  g_mutex_lock (&trace_counters_lock);
+
+  counter = trace_counters;
+  while (counter != NULL)
+    {
+      ClutterTraceCounter *next = counter->next;
+
+      counter->value = 0;
+      counter->next = NULL;
+      counter->registered = FALSE;
+
+      counter = next;
+    }
+
+  trace_counters = NULL;
+
+  g_mutex_unlock (&trace_counters_lock);
+
+  dropped = g_atomic_int_get (&trace_dropped);
+  if (dropped > 0)
+    g_warning ("%u trace events were dropped because they could not "
+               "be written to the file fast enough",
+               dropped);
+}
+
+void
+_clutter_trace_begin (const gchar *name)
+{
+  trace_record ('B', "clutter", name, FALSE, g_get_monotonic_time (), 0);
+}
+
+void
+_clutter_trace_end (const gchar *name)
+{
+  trace_record ('E', "clutter", name, FALSE, g_get_monotonic_time (), 0);
+}
+
+/*
+ * _clutter_trace_span:
+ * @category: the category of the span, as a static string
+ * @name: the name of the span
+ * @start_time: the monotonic time at which the span began
+ *
+ * Records a span ending now if it is longer than the threshold; @name
+ * is copied, so it does not need to outlive the call.
+ */
+void
+_clutter_trace_span (const gchar *category,
+                     const gchar *name,
+                     gint64       start_time)
+{
+  gint64 duration = g_get_monotonic_time () - start_time;
+
+  if (duration < trace_span_threshold)
+    return;
+
+  trace_record ('X', category, name, TRUE, start_time, duration);
+}
+
+void
+_clutter_trace_counter_add (ClutterTraceCounter *counter,
+                            gint                 delta)
+{
+  if (G_UNLIKELY (!counter->registered))
+    {
+      g_mutex_lock (&trace_counters_lock);
+
+      if (!counter->registered)
+        {
+          counter->next = trace_counters;
+          trace_counters = counter;
+          counter->registered = TRUE;
+        }
+
+      g_mutex_unlock (&trace_counters_lock);
+    }
+
+  g_atomic_int_add (&counter->value, delta);
+}
+
+/*
+ * _clutter_trace_flush_counters:
+ *
+ * Records the value of the counters incremented during the frame,
+ * and resets them; this is called by the master clock at the end of
+ * each frame.
+ */
+void
+_clutter_trace_flush_counters (void)
+{
+  ClutterTraceCounter *counter;
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&trace_counters_lock);
+
+  for (counter = trace_counters; counter != NULL; counter = counter->next)
+    {
+      gint value = g_atomic_int_get (&counter->value);
+
+      trace_record ('C', "clutter", counter->name, FALSE, now, value);
+
+      g_atomic_int_add (&counter->value, -value);
+    }
+
+  g_mutex_unlock (&trace_counters_lock);
+}
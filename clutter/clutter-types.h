@@ -82,6 +82,9 @@ typedef struct _ClutterGeometry                 ClutterGeometry; /* XXX:2.0 - re
 typedef struct _ClutterKnot                     ClutterKnot;
 typedef struct _ClutterMargin                   ClutterMargin;
 typedef struct _ClutterPerspective              ClutterPerspective;
+typedef struct _ClutterFrameStats               ClutterFrameStats;
+typedef struct _ClutterActorCost                ClutterActorCost;
+typedef struct _ClutterFrameCapture             ClutterFrameCapture;
 typedef struct _ClutterPoint                    ClutterPoint;
 typedef struct _ClutterRect                     ClutterRect;
 typedef struct _ClutterSize                     ClutterSize;
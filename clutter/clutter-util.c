@@ -177,6 +177,52 @@ _clutter_util_rectangle_union (const cairo_rectangle_int_t *src1,
   dest->y = dest_y;
 }
 
+/*< private >
+ * _clutter_util_rectangle_intersection:
+ * @src1: first rectangle to intersect
+ * @src2: second rectangle to intersect
+ * @dest: (out): return location for the intersected rectangle
+ *
+ * Calculates the intersection of two rectangles.
+ *
+ * If the rectangles do not intersect, @dest is set to an empty
+ * rectangle.
+ *
+ * It is allowed for @dest to be the same as either @src1 or @src2.
+ *
+ * Return value: %TRUE if the rectangles intersect
+ */
+gboolean
+_clutter_util_rectangle_intersection (const cairo_rectangle_int_t *src1,
+                                      const cairo_rectangle_int_t *src2,
+                                      cairo_rectangle_int_t       *dest)
+{
+  int x1, y1, x2, y2;
+
+  x1 = MAX (src1->x, src2->x);
+  y1 = MAX (src1->y, src2->y);
+
+  x2 = MIN (src1->x + src1->width, src2->x + src2->width);
+  y2 = MIN (src1->y + src1->height, src2->y + src2->height);
+
+  if (x1 >= x2 || y1 >= y2)
+    {
+      dest->x = 0;
+      dest->y = 0;
+      dest->width = 0;
+      dest->height = 0;
+
+      return FALSE;
+    }
+
+  dest->x = x1;
+  dest->y = y1;
+  dest->width = x2 - x1;
+  dest->height = y2 - y1;
+
+  return TRUE;
+}
+
 float
 _clutter_util_matrix_determinant (const ClutterMatrix *matrix)
 {
@@ -570,6 +616,26 @@ out:
   return res;
 }
 
+ClutterProgressFunc
+_clutter_get_progress_function (GType gtype)
+{
+  ProgressData *pdata;
+  ClutterProgressFunc res = NULL;
+
+  G_LOCK (progress_funcs);
+
+  if (progress_funcs != NULL)
+    {
+      pdata = g_hash_table_lookup (progress_funcs, g_type_name (gtype));
+      if (pdata != NULL)
+        res = pdata->func;
+    }
+
+  G_UNLOCK (progress_funcs);
+
+  return res;
+}
+
 static void
 progress_data_destroy (gpointer data_)
 {
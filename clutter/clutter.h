@@ -70,6 +70,7 @@
 #include "clutter-group.h"
 #include "clutter-image.h"
 #include "clutter-input-device.h"
+#include "clutter-input-replay.h"
 #include "clutter-interval.h"
 #include "clutter-keyframe-transition.h"
 #include "clutter-keysyms.h"
@@ -103,6 +104,7 @@
 #include "clutter-texture.h"
 #include "clutter-text.h"
 #include "clutter-timeline.h"
+#include "clutter-trace.h"
 #include "clutter-transition-group.h"
 #include "clutter-transition.h"
 #include "clutter-units.h"
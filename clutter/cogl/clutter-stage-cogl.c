@@ -80,6 +80,77 @@ clutter_stage_cogl_unrealize (ClutterStageWindow *stage_window)
     }
 }
 
+/*< private >
+ * _clutter_stage_cogl_sync:
+ * @stage_cogl: a #ClutterStageCogl
+ *
+ * Notifies @stage_cogl that a swap it requested has been processed,
+ * and that it can start drawing a new frame.
+ */
+void
+_clutter_stage_cogl_sync (ClutterStageCogl *stage_cogl)
+{
+  /* Early versions of the swap_event implementation in Mesa
+   * deliver BufferSwapComplete event when not selected for,
+   * so if we get a swap event we aren't expecting, just ignore it.
+   *
+   * https://bugs.freedesktop.org/show_bug.cgi?id=27962
+   *
+   * FIXME: This issue can be hidden inside Cogl so we shouldn't
+   * need to care about this bug here.
+   */
+  if (stage_cogl->pending_swaps > 0)
+    stage_cogl->pending_swaps--;
+}
+
+/*< private >
+ * _clutter_stage_cogl_presented:
+ * @stage_cogl: a #ClutterStageCogl
+ * @frame_counter: the counter of the presented frame
+ * @presentation_time: the time at which the frame was presented, in
+ *   the same time base as g_get_monotonic_time(), or 0 if unknown
+ * @refresh_rate: the refresh rate of the output, or 0 if unknown
+ *
+ * Notifies @stage_cogl that a frame has reached the output.
+ */
+void
+_clutter_stage_cogl_presented (ClutterStageCogl *stage_cogl,
+                               gint64            frame_counter,
+                               gint64            presentation_time,
+                               float             refresh_rate)
+{
+  if (presentation_time != 0)
+    stage_cogl->last_presentation_time = presentation_time;
+
+  stage_cogl->refresh_rate = refresh_rate;
+
+  if (presentation_time != 0)
+    {
+      guint idx = frame_counter % CLUTTER_STAGE_COGL_N_SWAP_TARGETS;
+      gint64 target = stage_cogl->swap_targets[idx];
+
+      if (refresh_rate == 0.0)
+        refresh_rate = 60.0;
+
+      /* allow for half a refresh interval of jitter in the reported
+       * presentation times before deciding we missed the target
+       */
+      if (target != -1 &&
+          stage_cogl->last_presentation_time > target + 500000 / refresh_rate)
+        {
+          stage_cogl->missed_frames += 1;
+
+          CLUTTER_NOTE (SCHEDULER,
+                        "Frame %" G_GINT64_FORMAT " missed its vblank "
+                        "by %" G_GINT64_FORMAT " usecs",
+                        frame_counter,
+                        stage_cogl->last_presentation_time - target);
+        }
+
+      stage_cogl->swap_targets[idx] = -1;
+    }
+}
+
 static void
 frame_cb (CoglOnscreen  *onscreen,
           CoglFrameEvent event,
@@ -89,22 +160,11 @@ frame_cb (CoglOnscreen  *onscreen,
   ClutterStageCogl *stage_cogl = user_data;
 
   if (event == COGL_FRAME_EVENT_SYNC)
-    {
-      /* Early versions of the swap_event implementation in Mesa
-       * deliver BufferSwapComplete event when not selected for,
-       * so if we get a swap event we aren't expecting, just ignore it.
-       *
-       * https://bugs.freedesktop.org/show_bug.cgi?id=27962
-       *
-       * FIXME: This issue can be hidden inside Cogl so we shouldn't
-       * need to care about this bug here.
-       */
-      if (stage_cogl->pending_swaps > 0)
-        stage_cogl->pending_swaps--;
-    }
+    _clutter_stage_cogl_sync (stage_cogl);
   else if (event == COGL_FRAME_EVENT_COMPLETE)
     {
       gint64 presentation_time_cogl = cogl_frame_info_get_presentation_time (info);
+      gint64 presentation_time = 0;
 
       if (presentation_time_cogl != 0)
         {
@@ -112,11 +172,14 @@ frame_cb (CoglOnscreen  *onscreen,
           gint64 current_time_cogl = cogl_get_clock_time (context);
           gint64 now = g_get_monotonic_time ();
 
-          stage_cogl->last_presentation_time =
+          presentation_time =
             now + (presentation_time_cogl - current_time_cogl) / 1000;
         }
 
-      stage_cogl->refresh_rate = cogl_frame_info_get_refresh_rate (info);
+      _clutter_stage_cogl_presented (stage_cogl,
+                                     cogl_frame_info_get_frame_counter (info),
+                                     presentation_time,
+                                     cogl_frame_info_get_refresh_rate (info));
     }
 }
 
@@ -167,6 +230,32 @@ clutter_stage_cogl_realize (ClutterStageWindow *stage_window)
   return TRUE;
 }
 
+/* Safety margin, in microseconds, added to the estimated render time;
+ * it covers the millisecond granularity of the main loop timeouts */
+#define RENDER_TIME_MARGIN      1500
+
+static gint64
+clutter_stage_cogl_get_render_time (ClutterStageCogl *stage_cogl)
+{
+  gint64 render_time = -1;
+  int i;
+
+  /* we use the worst case of the recent frames: an estimate that is too
+   * small makes us miss the vblank, while one that is too large only
+   * costs us a little bit of latency
+   */
+  for (i = 0; i < CLUTTER_STAGE_COGL_N_RENDER_TIMES; i++)
+    {
+      if (stage_cogl->render_times[i] > render_time)
+        render_time = stage_cogl->render_times[i];
+    }
+
+  if (render_time <= 0)
+    return -1;
+
+  return render_time + RENDER_TIME_MARGIN;
+}
+
 static void
 clutter_stage_cogl_schedule_update (ClutterStageWindow *stage_window,
                                     gint                sync_delay)
@@ -175,15 +264,20 @@ clutter_stage_cogl_schedule_update (ClutterStageWindow *stage_window,
   gint64 now;
   float refresh_rate;
   gint64 refresh_interval;
+  gint64 render_time;
+  gint64 next_presentation_time;
 
   if (stage_cogl->update_time != -1)
     return;
 
   now = g_get_monotonic_time ();
 
-  if (sync_delay < 0)
+  stage_cogl->update_drawn = FALSE;
+
+  if (sync_delay == CLUTTER_STAGE_WINDOW_SYNC_DELAY_NONE)
     {
       stage_cogl->update_time = now;
+      stage_cogl->presentation_time = -1;
       return;
     }
 
@@ -196,6 +290,7 @@ clutter_stage_cogl_schedule_update (ClutterStageWindow *stage_window,
       stage_cogl->last_presentation_time < now - 150000)
     {
       stage_cogl->update_time = now;
+      stage_cogl->presentation_time = -1;
       return;
     }
 
@@ -207,10 +302,55 @@ clutter_stage_cogl_schedule_update (ClutterStageWindow *stage_window,
   if (refresh_interval == 0)
     refresh_interval = 16667; /* 1/60th second */
 
-  stage_cogl->update_time = stage_cogl->last_presentation_time + 1000 * sync_delay;
+  if (sync_delay >= 0)
+    {
+      stage_cogl->update_time = stage_cogl->last_presentation_time + 1000 * sync_delay;
+
+      while (stage_cogl->update_time < now)
+        stage_cogl->update_time += refresh_interval;
+
+      stage_cogl->presentation_time =
+        stage_cogl->update_time - 1000 * sync_delay + refresh_interval;
+      return;
+    }
+
+  /* Without a sync delay we predict the next vblank we can make, given
+   * how long the recent frames took to render, and we start the frame
+   * just early enough to hit it; this way the events and the state of
+   * the animations are sampled as late as possible.
+   */
+  render_time = clutter_stage_cogl_get_render_time (stage_cogl);
+  if (render_time < 0 || render_time >= refresh_interval)
+    render_time = 0;
+
+  next_presentation_time = stage_cogl->last_presentation_time + refresh_interval;
+
+  /* Skip ahead the vblanks we missed while idle */
+  if (next_presentation_time < now)
+    next_presentation_time = now
+                           - ((now - next_presentation_time) % refresh_interval)
+                           + refresh_interval;
+
+  /* A frame still waiting to be presented is going to take the
+   * vblank we would otherwise predict, so we need to aim for the one
+   * following it
+   */
+  while (next_presentation_time < now + render_time ||
+         next_presentation_time <= stage_cogl->presentation_time)
+    next_presentation_time += refresh_interval;
+
+  if (render_time == 0)
+    stage_cogl->update_time = now;
+  else
+    stage_cogl->update_time = next_presentation_time - render_time;
+
+  stage_cogl->presentation_time = next_presentation_time;
 
-  while (stage_cogl->update_time < now)
-    stage_cogl->update_time += refresh_interval;
+  CLUTTER_NOTE (SCHEDULER,
+                "Predicted presentation in %" G_GINT64_FORMAT " usecs, "
+                "update in %" G_GINT64_FORMAT " usecs",
+                next_presentation_time - now,
+                stage_cogl->update_time - now);
 }
 
 static gint64
@@ -218,7 +358,11 @@ clutter_stage_cogl_get_update_time (ClutterStageWindow *stage_window)
 {
   ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
 
-  if (stage_cogl->pending_swaps)
+  /* If we have too many swap-buffers pending we don't want to draw, in
+   * case the driver may block the CPU while it waits for the next back
+   * buffer to become available
+   */
+  if (stage_cogl->pending_swaps >= stage_cogl->max_pending_swaps)
     return -1; /* in the future, indefinite */
 
   return stage_cogl->update_time;
@@ -229,9 +373,52 @@ clutter_stage_cogl_clear_update_time (ClutterStageWindow *stage_window)
 {
   ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
 
+  /* an update that did not draw anything leaves its vblank free for
+   * the next one
+   */
+  if (!stage_cogl->update_drawn)
+    stage_cogl->presentation_time = -1;
+
   stage_cogl->update_time = -1;
 }
 
+static gint64
+clutter_stage_cogl_get_presentation_time (ClutterStageWindow *stage_window)
+{
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+
+  /* only meaningful while an update is scheduled; the presentation
+   * time is kept afterwards to avoid targeting the same vblank twice
+   */
+  if (stage_cogl->update_time == -1)
+    return -1;
+
+  return stage_cogl->presentation_time;
+}
+
+static guint
+clutter_stage_cogl_get_missed_frames (ClutterStageWindow *stage_window)
+{
+  return CLUTTER_STAGE_COGL (stage_window)->missed_frames;
+}
+
+static gfloat
+clutter_stage_cogl_get_refresh_rate (ClutterStageWindow *stage_window)
+{
+  return CLUTTER_STAGE_COGL (stage_window)->refresh_rate;
+}
+
+static void
+clutter_stage_cogl_record_render_time (ClutterStageWindow *stage_window,
+                                       gint64              render_time)
+{
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+
+  stage_cogl->render_times[stage_cogl->render_time_index] = render_time;
+  stage_cogl->render_time_index =
+    (stage_cogl->render_time_index + 1) % CLUTTER_STAGE_COGL_N_RENDER_TIMES;
+}
+
 static ClutterActor *
 clutter_stage_cogl_get_wrapper (ClutterStageWindow *stage_window)
 {
@@ -401,7 +588,10 @@ clutter_stage_cogl_redraw (ClutterStageWindow *stage_window)
   gboolean has_buffer_age;
   ClutterActor *wrapper;
   cairo_rectangle_int_t *clip_region;
+  cairo_rectangle_int_t damage;
+  gboolean has_damage;
   gboolean force_swap;
+  guint swap_target;
 
   CLUTTER_STATIC_TIMER (painting_timer,
                         "Redrawing", /* parent */
@@ -426,6 +616,14 @@ clutter_stage_cogl_redraw (ClutterStageWindow *stage_window)
 
   CLUTTER_TIMER_START (_clutter_uprof_context, painting_timer);
 
+  /* the redraw clip may grow below to repair an older back buffer,
+   * so we keep the area that actually changed for the frame capture
+   */
+  has_damage = stage_cogl->initialized_redraw_clip &&
+               stage_cogl->bounding_redraw_clip.width != 0;
+  if (has_damage)
+    damage = stage_cogl->bounding_redraw_clip;
+
   can_blit_sub_buffer =
     cogl_clutter_winsys_has_feature (COGL_WINSYS_FEATURE_SWAP_REGION);
 
@@ -549,6 +747,10 @@ clutter_stage_cogl_redraw (ClutterStageWindow *stage_window)
         _clutter_stage_do_paint (CLUTTER_STAGE (wrapper), NULL);
     }
 
+  _clutter_stage_capture_frame (CLUTTER_STAGE (wrapper),
+                                COGL_FRAMEBUFFER (stage_cogl->onscreen),
+                                has_damage ? &damage : NULL);
+
   if (may_use_clipped_redraw &&
       G_UNLIKELY ((clutter_paint_debug_flags & CLUTTER_DEBUG_REDRAWS)))
     {
@@ -594,6 +796,14 @@ clutter_stage_cogl_redraw (ClutterStageWindow *stage_window)
 
   CLUTTER_TIMER_STOP (_clutter_uprof_context, painting_timer);
 
+  /* remember which vblank this frame was aiming for, so that we can
+   * tell whether it made it once it gets presented
+   */
+  swap_target = cogl_onscreen_get_frame_counter (stage_cogl->onscreen)
+              % CLUTTER_STAGE_COGL_N_SWAP_TARGETS;
+  stage_cogl->swap_targets[swap_target] = stage_cogl->presentation_time;
+  stage_cogl->update_drawn = TRUE;
+
   /* push on the screen */
   if (use_clipped_redraw && !force_swap)
     {
@@ -702,6 +912,10 @@ clutter_stage_window_iface_init (ClutterStageWindowIface *iface)
   iface->schedule_update = clutter_stage_cogl_schedule_update;
   iface->get_update_time = clutter_stage_cogl_get_update_time;
   iface->clear_update_time = clutter_stage_cogl_clear_update_time;
+  iface->get_presentation_time = clutter_stage_cogl_get_presentation_time;
+  iface->record_render_time = clutter_stage_cogl_record_render_time;
+  iface->get_missed_frames = clutter_stage_cogl_get_missed_frames;
+  iface->get_refresh_rate = clutter_stage_cogl_get_refresh_rate;
   iface->add_redraw_clip = clutter_stage_cogl_add_redraw_clip;
   iface->has_redraw_clips = clutter_stage_cogl_has_redraw_clips;
   iface->ignoring_redraw_clips = clutter_stage_cogl_ignoring_redraw_clips;
@@ -750,8 +964,16 @@ _clutter_stage_cogl_class_init (ClutterStageCoglClass *klass)
 static void
 _clutter_stage_cogl_init (ClutterStageCogl *stage)
 {
+  int i;
+
   stage->last_presentation_time = 0;
   stage->refresh_rate = 0.0;
 
   stage->update_time = -1;
+  stage->presentation_time = -1;
+
+  stage->max_pending_swaps = _clutter_get_max_pending_swaps ();
+
+  for (i = 0; i < CLUTTER_STAGE_COGL_N_SWAP_TARGETS; i++)
+    stage->swap_targets[i] = -1;
 }
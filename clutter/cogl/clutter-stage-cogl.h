@@ -20,6 +20,12 @@ G_BEGIN_DECLS
 #define CLUTTER_IS_STAGE_COGL_CLASS(klass)       (G_TYPE_CHECK_CLASS_TYPE ((klass), CLUTTER_TYPE_STAGE_COGL))
 #define CLUTTER_STAGE_COGL_GET_CLASS(obj)        (G_TYPE_INSTANCE_GET_CLASS ((obj), CLUTTER_TYPE_STAGE_COGL, ClutterStageCoglClass))
 
+/* number of frames used to estimate the time needed to render a frame */
+#define CLUTTER_STAGE_COGL_N_RENDER_TIMES       16
+
+/* number of swaps whose target presentation time we keep track of */
+#define CLUTTER_STAGE_COGL_N_SWAP_TARGETS       4
+
 typedef struct _ClutterStageCogl         ClutterStageCogl;
 typedef struct _ClutterStageCoglClass    ClutterStageCoglClass;
 
@@ -39,7 +45,24 @@ struct _ClutterStageCogl
   float refresh_rate;
 
   gint64 update_time;
+  gint64 presentation_time;
   gint pending_swaps;
+
+  /* the number of swaps we allow in flight before we stop drawing;
+   * backends knowing that the onscreen is N buffered can change it
+   */
+  gint max_pending_swaps;
+
+  /* the predicted presentation time of the swaps in flight, indexed
+   * by frame counter, and the number of frames that missed it
+   */
+  gint64 swap_targets[CLUTTER_STAGE_COGL_N_SWAP_TARGETS];
+  guint missed_frames;
+
+  /* ring buffer of the most recent render times, in microseconds */
+  gint64 render_times[CLUTTER_STAGE_COGL_N_RENDER_TIMES];
+  guint render_time_index;
+
   CoglFrameClosure *frame_closure;
 
   /* We only enable clipped redraws after 2 frames, since we've seen
@@ -55,6 +78,10 @@ struct _ClutterStageCogl
      case bounding_redraw_clip specifies the the bounds. */
   guint using_clipped_redraw : 1;
 
+  /* TRUE if a frame was drawn for the scheduled update; otherwise
+     presentation_time is not taken by any swap */
+  guint update_drawn : 1;
+
   guint dirty_backbuffer     : 1;
 
   /* Stores a list of previous damaged areas */
@@ -68,6 +95,12 @@ struct _ClutterStageCoglClass
 
 GType _clutter_stage_cogl_get_type (void) G_GNUC_CONST;
 
+void _clutter_stage_cogl_sync      (ClutterStageCogl *stage_cogl);
+void _clutter_stage_cogl_presented (ClutterStageCogl *stage_cogl,
+                                    gint64            frame_counter,
+                                    gint64            presentation_time,
+                                    float             refresh_rate);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_STAGE_COGL_H__ */
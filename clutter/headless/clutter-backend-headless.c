@@ -0,0 +1,222 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include "clutter-headless.h"
+#include "clutter-backend-headless.h"
+#include "clutter-stage-headless.h"
+
+#include "clutter-backend-private.h"
+#include "clutter-debug.h"
+#include "clutter-main.h"
+#include "clutter-private.h"
+
+#include <cogl/cogl.h>
+
+#define clutter_backend_headless_get_type     _clutter_backend_headless_get_type
+
+G_DEFINE_TYPE (ClutterBackendHeadless, clutter_backend_headless, CLUTTER_TYPE_BACKEND);
+
+/* set before the backend is created, for instance by the test suites */
+static gfloat _headless_refresh_rate = -1.f;
+
+static void
+clutter_backend_headless_dispose (GObject *gobject)
+{
+  ClutterBackendHeadless *backend_headless = CLUTTER_BACKEND_HEADLESS (gobject);
+
+  _clutter_backend_headless_events_uninit (CLUTTER_BACKEND (gobject));
+
+  if (backend_headless->device_manager != NULL)
+    {
+      g_object_unref (backend_headless->device_manager);
+      backend_headless->device_manager = NULL;
+    }
+
+  G_OBJECT_CLASS (clutter_backend_headless_parent_class)->dispose (gobject);
+}
+
+static void
+clutter_backend_headless_finalize (GObject *gobject)
+{
+  ClutterBackendHeadless *backend_headless = CLUTTER_BACKEND_HEADLESS (gobject);
+
+  if (backend_headless->event_timer != NULL)
+    g_timer_destroy (backend_headless->event_timer);
+
+  G_OBJECT_CLASS (clutter_backend_headless_parent_class)->finalize (gobject);
+}
+
+static gboolean
+clutter_backend_headless_post_parse (ClutterBackend  *backend,
+                                     GError         **error)
+{
+  ClutterBackendHeadless *backend_headless = CLUTTER_BACKEND_HEADLESS (backend);
+  const gchar *env;
+
+  if (_headless_refresh_rate >= 0.f)
+    {
+      backend_headless->refresh_rate = _headless_refresh_rate;
+      return TRUE;
+    }
+
+  env = g_getenv ("CLUTTER_HEADLESS_REFRESH_RATE");
+  if (env != NULL && *env != '\0')
+    {
+      gchar *end = NULL;
+      gdouble refresh_rate = g_ascii_strtod (env, &end);
+
+      /* 0 disables the emulated vertical blanking */
+      if (end != env && *end == '\0' && refresh_rate >= 0)
+        backend_headless->refresh_rate = refresh_rate;
+      else
+        g_warning ("Invalid refresh rate '%s' in the environment variable "
+                   "CLUTTER_HEADLESS_REFRESH_RATE", env);
+    }
+
+  CLUTTER_NOTE (BACKEND, "Emulating a refresh rate of %.2f Hz",
+                backend_headless->refresh_rate);
+
+  return TRUE;
+}
+
+static CoglDisplay *
+clutter_backend_headless_get_display (ClutterBackend  *backend,
+                                      CoglRenderer    *renderer,
+                                      CoglSwapChain   *swap_chain,
+                                      GError         **error)
+{
+  CLUTTER_NOTE (BACKEND, "Creating a display without onscreen template");
+
+  /* we never create an onscreen framebuffer, so there is no reason to
+   * check whether the window system can provide the one in the
+   * template; we only need a GL context
+   */
+  return cogl_display_new (renderer, NULL);
+}
+
+static ClutterFeatureFlags
+clutter_backend_headless_get_features (ClutterBackend *backend)
+{
+  /* the stages are offscreen framebuffers, so we can have as many as
+   * we want, and we emulate the vblank and the swap events
+   */
+  return CLUTTER_FEATURE_STAGE_MULTIPLE
+       | CLUTTER_FEATURE_SYNC_TO_VBLANK
+       | CLUTTER_FEATURE_SWAP_EVENTS;
+}
+
+static void
+clutter_backend_headless_class_init (ClutterBackendHeadlessClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  ClutterBackendClass *backend_class = CLUTTER_BACKEND_CLASS (klass);
+
+  gobject_class->dispose = clutter_backend_headless_dispose;
+  gobject_class->finalize = clutter_backend_headless_finalize;
+
+  backend_class->stage_window_type = CLUTTER_TYPE_STAGE_HEADLESS;
+
+  backend_class->post_parse = clutter_backend_headless_post_parse;
+  backend_class->get_display = clutter_backend_headless_get_display;
+  backend_class->get_features = clutter_backend_headless_get_features;
+}
+
+static void
+clutter_backend_headless_init (ClutterBackendHeadless *backend_headless)
+{
+  backend_headless->refresh_rate = CLUTTER_HEADLESS_DEFAULT_REFRESH_RATE;
+  backend_headless->event_timer = g_timer_new ();
+}
+
+/**
+ * clutter_headless_set_refresh_rate:
+ * @refresh_rate: the refresh rate of the emulated output, in Hz, or 0
+ *
+ * Sets the refresh rate of the output emulated by the headless backend.
+ *
+ * A refresh rate of 0 disables the emulated vertical blanking, and
+ * the frames are presented as soon as they have been drawn.
+ *
+ * This function can be called before clutter_init(), in which case it
+ * overrides the <envar>CLUTTER_HEADLESS_REFRESH_RATE</envar> environment
+ * variable.
+ *
+ * Since: 1.16
+ */
+void
+clutter_headless_set_refresh_rate (gfloat refresh_rate)
+{
+  ClutterBackend *backend;
+
+  g_return_if_fail (refresh_rate >= 0.f);
+
+  if (_clutter_context_is_initialized ())
+    {
+      backend = clutter_get_default_backend ();
+
+      if (!CLUTTER_IS_BACKEND_HEADLESS (backend))
+        {
+          g_critical ("The Clutter backend is not the headless backend");
+          return;
+        }
+
+      CLUTTER_BACKEND_HEADLESS (backend)->refresh_rate = refresh_rate;
+    }
+  else
+    _headless_refresh_rate = refresh_rate;
+}
+
+/**
+ * clutter_headless_get_refresh_rate:
+ *
+ * Retrieves the refresh rate of the output emulated by the headless
+ * backend.
+ *
+ * Return value: the refresh rate, in Hz, or 0 if the vertical blanking
+ *   is not emulated
+ *
+ * Since: 1.16
+ */
+gfloat
+clutter_headless_get_refresh_rate (void)
+{
+  ClutterBackend *backend;
+
+  if (!_clutter_context_is_initialized ())
+    {
+      if (_headless_refresh_rate >= 0.f)
+        return _headless_refresh_rate;
+
+      return CLUTTER_HEADLESS_DEFAULT_REFRESH_RATE;
+    }
+
+  backend = clutter_get_default_backend ();
+  if (!CLUTTER_IS_BACKEND_HEADLESS (backend))
+    return 0.f;
+
+  return CLUTTER_BACKEND_HEADLESS (backend)->refresh_rate;
+}
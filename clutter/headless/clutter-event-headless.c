@@ -0,0 +1,480 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include "clutter-headless.h"
+#include "clutter-backend-headless.h"
+#include "clutter-device-manager-headless.h"
+
+#include "clutter-backend.h"
+#include "clutter-debug.h"
+#include "clutter-device-manager-private.h"
+#include "clutter-event-private.h"
+#include "clutter-keysyms.h"
+#include "clutter-main.h"
+#include "clutter-private.h"
+#include "clutter-stage-private.h"
+
+static gboolean clutter_event_prepare  (GSource     *source,
+                                        gint        *timeout);
+static gboolean clutter_event_check    (GSource     *source);
+static gboolean clutter_event_dispatch (GSource     *source,
+                                        GSourceFunc  callback,
+                                        gpointer     user_data);
+
+static GSourceFuncs event_funcs = {
+  clutter_event_prepare,
+  clutter_event_check,
+  clutter_event_dispatch,
+  NULL
+};
+
+void
+_clutter_backend_headless_events_init (ClutterBackend *backend)
+{
+  ClutterBackendHeadless *backend_headless = CLUTTER_BACKEND_HEADLESS (backend);
+  GSource *source;
+
+  if (backend_headless->device_manager != NULL)
+    return;
+
+  CLUTTER_NOTE (EVENT, "Creating the device manager");
+
+  backend->device_manager = backend_headless->device_manager =
+    g_object_new (CLUTTER_TYPE_DEVICE_MANAGER_HEADLESS,
+                  "backend", backend,
+                  NULL);
+
+  CLUTTER_NOTE (EVENT, "Starting timer");
+  g_timer_start (backend_headless->event_timer);
+
+  /* there is nothing to poll: the source only dispatches the events
+   * that have been injected in the queue
+   */
+  source = g_source_new (&event_funcs, sizeof (GSource));
+  g_source_set_priority (source, CLUTTER_PRIORITY_EVENTS);
+  g_source_set_can_recurse (source, TRUE);
+  g_source_attach (source, NULL);
+
+  backend_headless->event_source = source;
+}
+
+void
+_clutter_backend_headless_events_uninit (ClutterBackend *backend)
+{
+  ClutterBackendHeadless *backend_headless = CLUTTER_BACKEND_HEADLESS (backend);
+
+  if (backend_headless->event_timer != NULL)
+    {
+      CLUTTER_NOTE (EVENT, "Stopping the timer");
+      g_timer_stop (backend_headless->event_timer);
+    }
+
+  if (backend_headless->event_source != NULL)
+    {
+      CLUTTER_NOTE (EVENT, "Destroying the event source");
+      g_source_destroy (backend_headless->event_source);
+      g_source_unref (backend_headless->event_source);
+      backend_headless->event_source = NULL;
+    }
+}
+
+static gboolean
+clutter_event_prepare (GSource *source,
+                       gint    *timeout)
+{
+  gboolean retval;
+
+  _clutter_threads_acquire_lock ();
+
+  *timeout = -1;
+  retval = clutter_events_pending ();
+
+  _clutter_threads_release_lock ();
+
+  return retval;
+}
+
+static gboolean
+clutter_event_check (GSource *source)
+{
+  gboolean retval;
+
+  _clutter_threads_acquire_lock ();
+
+  retval = clutter_events_pending ();
+
+  _clutter_threads_release_lock ();
+
+  return retval;
+}
+
+static gboolean
+clutter_event_dispatch (GSource     *source,
+                        GSourceFunc  callback,
+                        gpointer     user_data)
+{
+  ClutterEvent *event;
+
+  _clutter_threads_acquire_lock ();
+
+  /* Pop an event off the queue if any */
+  event = clutter_event_get ();
+
+  if (event)
+    {
+      /* forward the event into clutter for emission etc. */
+      clutter_do_event (event);
+      clutter_event_free (event);
+    }
+
+  _clutter_threads_release_lock ();
+
+  return TRUE;
+}
+
+static ClutterBackendHeadless *
+get_backend_headless (void)
+{
+  ClutterBackend *backend = clutter_get_default_backend ();
+
+  if (!CLUTTER_IS_BACKEND_HEADLESS (backend))
+    {
+      g_critical ("The Clutter backend is not the headless backend");
+      return NULL;
+    }
+
+  return CLUTTER_BACKEND_HEADLESS (backend);
+}
+
+static guint32
+get_event_time (ClutterBackendHeadless *backend_headless,
+                guint32                 time_)
+{
+  if (time_ != CLUTTER_CURRENT_TIME)
+    return time_;
+
+  return g_timer_elapsed (backend_headless->event_timer, NULL) * 1000;
+}
+
+static ClutterInputDevice *
+get_core_device (ClutterBackendHeadless *backend_headless,
+                 ClutterInputDeviceType  device_type)
+{
+  if (backend_headless->device_manager == NULL)
+    return NULL;
+
+  return clutter_device_manager_get_core_device (backend_headless->device_manager,
+                                                 device_type);
+}
+
+/* makes sure that the pointer is on @stage before an event for @stage
+ * is queued, emitting the crossing events a windowing system would
+ */
+static void
+ensure_pointer_stage (ClutterBackendHeadless *backend_headless,
+                      ClutterInputDevice     *device,
+                      ClutterStage           *stage,
+                      guint32                 time_)
+{
+  ClutterStage *old_stage;
+  ClutterEvent *event;
+
+  old_stage = clutter_input_device_get_pointer_stage (device);
+  if (old_stage == stage)
+    return;
+
+  if (old_stage != NULL)
+    {
+      event = clutter_event_new (CLUTTER_LEAVE);
+      event->crossing.stage = old_stage;
+      event->crossing.time = time_;
+      event->crossing.x = backend_headless->pointer_x;
+      event->crossing.y = backend_headless->pointer_y;
+      event->crossing.source = CLUTTER_ACTOR (old_stage);
+      clutter_event_set_device (event, device);
+
+      _clutter_event_push (event, FALSE);
+    }
+
+  _clutter_input_device_set_stage (device, stage);
+
+  event = clutter_event_new (CLUTTER_ENTER);
+  event->crossing.stage = stage;
+  event->crossing.time = time_;
+  event->crossing.x = backend_headless->pointer_x;
+  event->crossing.y = backend_headless->pointer_y;
+  event->crossing.source = CLUTTER_ACTOR (stage);
+  clutter_event_set_device (event, device);
+
+  _clutter_event_push (event, FALSE);
+}
+
+/**
+ * clutter_headless_inject_motion:
+ * @stage: a #ClutterStage
+ * @time_: the time of the event, in milliseconds, or %CLUTTER_CURRENT_TIME
+ * @x: the X coordinate of the pointer, relative to the stage
+ * @y: the Y coordinate of the pointer, relative to the stage
+ *
+ * Queues a motion event of the core pointer on @stage.
+ *
+ * If the pointer was not on @stage already, a %CLUTTER_ENTER event
+ * is queued before the motion event.
+ *
+ * Since: 1.16
+ */
+void
+clutter_headless_inject_motion (ClutterStage *stage,
+                                guint32       time_,
+                                gfloat        x,
+                                gfloat        y)
+{
+  ClutterBackendHeadless *backend_headless;
+  ClutterInputDevice *device;
+  ClutterEvent *event;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  backend_headless = get_backend_headless ();
+  if (backend_headless == NULL)
+    return;
+
+  device = get_core_device (backend_headless, CLUTTER_POINTER_DEVICE);
+  if (device == NULL)
+    return;
+
+  time_ = get_event_time (backend_headless, time_);
+
+  backend_headless->pointer_x = x;
+  backend_headless->pointer_y = y;
+
+  ensure_pointer_stage (backend_headless, device, stage, time_);
+
+  event = clutter_event_new (CLUTTER_MOTION);
+  event->motion.stage = stage;
+  event->motion.time = time_;
+  event->motion.x = x;
+  event->motion.y = y;
+  event->motion.modifier_state = backend_headless->modifier_state;
+  clutter_event_set_device (event, device);
+
+  _clutter_event_push (event, FALSE);
+}
+
+/**
+ * clutter_headless_inject_button:
+ * @stage: a #ClutterStage
+ * @time_: the time of the event, in milliseconds, or %CLUTTER_CURRENT_TIME
+ * @button: the button number, starting from 1
+ * @pressed: %TRUE for a button press, %FALSE for a button release
+ *
+ * Queues a button event of the core pointer on @stage, at the
+ * position of the last injected motion.
+ *
+ * Since: 1.16
+ */
+void
+clutter_headless_inject_button (ClutterStage *stage,
+                                guint32       time_,
+                                guint         button,
+                                gboolean      pressed)
+{
+  ClutterBackendHeadless *backend_headless;
+  ClutterModifierType button_mask = 0;
+  ClutterInputDevice *device;
+  ClutterEvent *event;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+  g_return_if_fail (button > 0);
+
+  backend_headless = get_backend_headless ();
+  if (backend_headless == NULL)
+    return;
+
+  device = get_core_device (backend_headless, CLUTTER_POINTER_DEVICE);
+  if (device == NULL)
+    return;
+
+  time_ = get_event_time (backend_headless, time_);
+
+  ensure_pointer_stage (backend_headless, device, stage, time_);
+
+  event = clutter_event_new (pressed ? CLUTTER_BUTTON_PRESS
+                                     : CLUTTER_BUTTON_RELEASE);
+  event->button.stage = stage;
+  event->button.time = time_;
+  event->button.x = backend_headless->pointer_x;
+  event->button.y = backend_headless->pointer_y;
+  event->button.button = button;
+  clutter_event_set_device (event, device);
+
+  /* like in X11, the state is the one before the event */
+  event->button.modifier_state = backend_headless->modifier_state;
+
+  if (button <= 5)
+    button_mask = CLUTTER_BUTTON1_MASK << (button - 1);
+
+  if (pressed)
+    backend_headless->modifier_state |= button_mask;
+  else
+    backend_headless->modifier_state &= ~button_mask;
+
+  _clutter_event_push (event, FALSE);
+}
+
+/**
+ * clutter_headless_inject_scroll:
+ * @stage: a #ClutterStage
+ * @time_: the time of the event, in milliseconds, or %CLUTTER_CURRENT_TIME
+ * @dx: the horizontal scroll delta
+ * @dy: the vertical scroll delta
+ *
+ * Queues a smooth scroll event of the core pointer on @stage, at the
+ * position of the last injected motion.
+ *
+ * Since: 1.16
+ */
+void
+clutter_headless_inject_scroll (ClutterStage *stage,
+                                guint32       time_,
+                                gdouble       dx,
+                                gdouble       dy)
+{
+  ClutterBackendHeadless *backend_headless;
+  ClutterInputDevice *device;
+  ClutterEvent *event;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  backend_headless = get_backend_headless ();
+  if (backend_headless == NULL)
+    return;
+
+  device = get_core_device (backend_headless, CLUTTER_POINTER_DEVICE);
+  if (device == NULL)
+    return;
+
+  time_ = get_event_time (backend_headless, time_);
+
+  ensure_pointer_stage (backend_headless, device, stage, time_);
+
+  event = clutter_event_new (CLUTTER_SCROLL);
+  event->scroll.stage = stage;
+  event->scroll.time = time_;
+  event->scroll.x = backend_headless->pointer_x;
+  event->scroll.y = backend_headless->pointer_y;
+  event->scroll.direction = CLUTTER_SCROLL_SMOOTH;
+  event->scroll.modifier_state = backend_headless->modifier_state;
+  clutter_event_set_scroll_delta (event, dx, dy);
+  clutter_event_set_device (event, device);
+
+  _clutter_event_push (event, FALSE);
+}
+
+static ClutterModifierType
+get_modifier_for_keyval (guint keyval)
+{
+  switch (keyval)
+    {
+    case CLUTTER_KEY_Shift_L:
+    case CLUTTER_KEY_Shift_R:
+      return CLUTTER_SHIFT_MASK;
+
+    case CLUTTER_KEY_Control_L:
+    case CLUTTER_KEY_Control_R:
+      return CLUTTER_CONTROL_MASK;
+
+    case CLUTTER_KEY_Alt_L:
+    case CLUTTER_KEY_Alt_R:
+      return CLUTTER_MOD1_MASK;
+
+    case CLUTTER_KEY_Super_L:
+    case CLUTTER_KEY_Super_R:
+      return CLUTTER_SUPER_MASK;
+
+    default:
+      return 0;
+    }
+}
+
+/**
+ * clutter_headless_inject_key:
+ * @stage: a #ClutterStage
+ * @time_: the time of the event, in milliseconds, or %CLUTTER_CURRENT_TIME
+ * @keyval: the key symbol, for instance %CLUTTER_KEY_a
+ * @hardware_keycode: the hardware key code, or 0
+ * @pressed: %TRUE for a key press, %FALSE for a key release
+ *
+ * Queues a key event of the core keyboard on @stage.
+ *
+ * The state of the Shift, Control, Alt and Super modifiers follows
+ * the injected key events, and it is applied to all the following
+ * events.
+ *
+ * Since: 1.16
+ */
+void
+clutter_headless_inject_key (ClutterStage *stage,
+                             guint32       time_,
+                             guint         keyval,
+                             guint16       hardware_keycode,
+                             gboolean      pressed)
+{
+  ClutterBackendHeadless *backend_headless;
+  ClutterModifierType modifier;
+  ClutterInputDevice *device;
+  ClutterEvent *event;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+
+  backend_headless = get_backend_headless ();
+  if (backend_headless == NULL)
+    return;
+
+  device = get_core_device (backend_headless, CLUTTER_KEYBOARD_DEVICE);
+  if (device == NULL)
+    return;
+
+  time_ = get_event_time (backend_headless, time_);
+
+  event = clutter_event_new (pressed ? CLUTTER_KEY_PRESS : CLUTTER_KEY_RELEASE);
+  event->key.stage = stage;
+  event->key.time = time_;
+  event->key.keyval = keyval;
+  event->key.hardware_keycode = hardware_keycode;
+  event->key.unicode_value = clutter_keysym_to_unicode (keyval);
+  event->key.modifier_state = backend_headless->modifier_state;
+  clutter_event_set_device (event, device);
+
+  modifier = get_modifier_for_keyval (keyval);
+  if (pressed)
+    backend_headless->modifier_state |= modifier;
+  else
+    backend_headless->modifier_state &= ~modifier;
+
+  _clutter_event_push (event, FALSE);
+}
@@ -0,0 +1,84 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:clutter-headless
+ * @short_description: Headless specific API
+ *
+ * The headless backend renders every stage into an offscreen
+ * framebuffer, so it can be used on machines without a display,
+ * like continuous integration builders and render servers; a
+ * software implementation of OpenGL, like the llvmpipe driver of
+ * Mesa, is enough. The Cogl window system used to create the GL
+ * context can be selected using the <envar>COGL_RENDERER</envar>
+ * environment variable.
+ *
+ * The backend emulates the vertical blanking of an output with a
+ * configurable refresh rate, and it does not read input from any
+ * device: events are injected using the functions documented here.
+ *
+ * The headless backend is selected by setting the
+ * <envar>CLUTTER_BACKEND</envar> environment variable to
+ * <literal>headless</literal>.
+ *
+ * You need to include
+ * <filename class="headerfile">&lt;clutter/headless/clutter-headless.h&gt;</filename>
+ * to have access to the functions documented here.
+ */
+
+#ifndef __CLUTTER_HEADLESS_H__
+#define __CLUTTER_HEADLESS_H__
+
+#include <glib.h>
+#include <clutter/clutter.h>
+
+G_BEGIN_DECLS
+
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_headless_set_refresh_rate       (gfloat        refresh_rate);
+CLUTTER_AVAILABLE_IN_1_16
+gfloat          clutter_headless_get_refresh_rate       (void);
+
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_headless_inject_motion          (ClutterStage *stage,
+                                                         guint32       time_,
+                                                         gfloat        x,
+                                                         gfloat        y);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_headless_inject_button          (ClutterStage *stage,
+                                                         guint32       time_,
+                                                         guint         button,
+                                                         gboolean      pressed);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_headless_inject_scroll          (ClutterStage *stage,
+                                                         guint32       time_,
+                                                         gdouble       dx,
+                                                         gdouble       dy);
+CLUTTER_AVAILABLE_IN_1_16
+void            clutter_headless_inject_key             (ClutterStage *stage,
+                                                         guint32       time_,
+                                                         guint         keyval,
+                                                         guint16       hardware_keycode,
+                                                         gboolean      pressed);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_HEADLESS_H__ */
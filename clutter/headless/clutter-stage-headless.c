@@ -0,0 +1,457 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include "clutter-headless.h"
+#include "clutter-backend-headless.h"
+#include "clutter-stage-headless.h"
+
+#include "clutter-backend-private.h"
+#include "clutter-debug.h"
+#include "clutter-feature.h"
+#include "clutter-main.h"
+#include "clutter-private.h"
+#include "clutter-stage-private.h"
+#include "clutter-stage-window.h"
+
+#include <cogl/cogl.h>
+
+/* an emulated swap, waiting for its vblank */
+typedef struct _HeadlessFrame
+{
+  gint64 frame_counter;
+
+  /* the time of the vblank presenting the frame, or 0 if the frames
+   * are not throttled to the emulated vblank
+   */
+  gint64 presentation_time;
+
+  gfloat refresh_rate;
+} HeadlessFrame;
+
+static ClutterStageWindowIface *clutter_stage_window_parent_iface = NULL;
+
+static void clutter_stage_window_iface_init (ClutterStageWindowIface *iface);
+
+#define clutter_stage_headless_get_type _clutter_stage_headless_get_type
+
+G_DEFINE_TYPE_WITH_CODE (ClutterStageHeadless,
+                         clutter_stage_headless,
+                         CLUTTER_TYPE_STAGE_COGL,
+                         G_IMPLEMENT_INTERFACE (CLUTTER_TYPE_STAGE_WINDOW,
+                                                clutter_stage_window_iface_init));
+
+static void clutter_stage_headless_schedule_vblank (ClutterStageHeadless *stage_headless,
+                                                    gint64                now);
+
+static gboolean
+clutter_stage_headless_allocate_offscreen (ClutterStageHeadless  *stage_headless,
+                                           GError               **error)
+{
+  ClutterBackend *backend = CLUTTER_STAGE_COGL (stage_headless)->backend;
+  CoglTexture2D *texture;
+  CoglOffscreen *offscreen;
+
+  CLUTTER_NOTE (BACKEND, "Allocating a %dx%d offscreen for stage [%p]",
+                stage_headless->width,
+                stage_headless->height,
+                stage_headless);
+
+  texture = cogl_texture_2d_new_with_size (backend->cogl_context,
+                                           stage_headless->width,
+                                           stage_headless->height,
+                                           COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                           error);
+  if (texture == NULL)
+    return FALSE;
+
+  /* the offscreen keeps a reference on the texture */
+  offscreen = cogl_offscreen_new_to_texture (COGL_TEXTURE (texture));
+  cogl_object_unref (texture);
+
+  if (!cogl_framebuffer_allocate (COGL_FRAMEBUFFER (offscreen), error))
+    {
+      cogl_object_unref (offscreen);
+      return FALSE;
+    }
+
+  if (stage_headless->offscreen != NULL)
+    cogl_object_unref (stage_headless->offscreen);
+
+  stage_headless->offscreen = offscreen;
+
+  return TRUE;
+}
+
+static gboolean
+clutter_stage_headless_realize (ClutterStageWindow *stage_window)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+  GError *error = NULL;
+
+  CLUTTER_NOTE (BACKEND, "Realizing headless stage [%p]", stage_headless);
+
+  /* we do not chain up: the parent implementation would create an
+   * onscreen framebuffer, which is what we are trying to avoid
+   */
+  if (!clutter_stage_headless_allocate_offscreen (stage_headless, &error))
+    {
+      g_warning ("Failed to allocate stage: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+clutter_stage_headless_unrealize (ClutterStageWindow *stage_window)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+  HeadlessFrame *frame;
+
+  CLUTTER_NOTE (BACKEND, "Unrealizing headless stage [%p]", stage_headless);
+
+  if (stage_headless->vblank_id != 0)
+    {
+      g_source_remove (stage_headless->vblank_id);
+      stage_headless->vblank_id = 0;
+    }
+
+  while ((frame = g_queue_pop_head (&stage_headless->pending_frames)) != NULL)
+    g_slice_free (HeadlessFrame, frame);
+
+  stage_cogl->pending_swaps = 0;
+
+  if (stage_headless->offscreen != NULL)
+    {
+      cogl_object_unref (stage_headless->offscreen);
+      stage_headless->offscreen = NULL;
+    }
+
+  clutter_stage_window_parent_iface->unrealize (stage_window);
+}
+
+static void
+clutter_stage_headless_get_geometry (ClutterStageWindow    *stage_window,
+                                     cairo_rectangle_int_t *geometry)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+
+  if (geometry != NULL)
+    {
+      geometry->x = geometry->y = 0;
+      geometry->width = stage_headless->width;
+      geometry->height = stage_headless->height;
+    }
+}
+
+static void
+clutter_stage_headless_resize (ClutterStageWindow *stage_window,
+                               gint                width,
+                               gint                height)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+  GError *error = NULL;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  if (stage_headless->width == width && stage_headless->height == height)
+    return;
+
+  stage_headless->width = width;
+  stage_headless->height = height;
+
+  if (stage_headless->offscreen == NULL)
+    return;
+
+  if (!clutter_stage_headless_allocate_offscreen (stage_headless, &error))
+    {
+      g_warning ("Failed to resize stage: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  /* the contents of the old framebuffer are gone */
+  stage_cogl->dirty_backbuffer = TRUE;
+
+  clutter_stage_ensure_viewport (stage_cogl->wrapper);
+}
+
+static gboolean
+clutter_stage_headless_vblank (gpointer data)
+{
+  ClutterStageHeadless *stage_headless = data;
+  ClutterStageCogl *stage_cogl = data;
+  HeadlessFrame *frame;
+  gint64 now;
+
+  stage_headless->vblank_id = 0;
+
+  now = g_get_monotonic_time ();
+
+  /* the main loop timeouts have a millisecond granularity, so we
+   * present every frame whose vblank falls within the current one
+   */
+  while ((frame = g_queue_peek_head (&stage_headless->pending_frames)) != NULL)
+    {
+      if (frame->presentation_time > now + 1000)
+        break;
+
+      g_queue_pop_head (&stage_headless->pending_frames);
+
+      CLUTTER_NOTE (SCHEDULER,
+                    "Emulated vblank for frame %" G_GINT64_FORMAT,
+                    frame->frame_counter);
+
+      _clutter_stage_cogl_sync (stage_cogl);
+      _clutter_stage_cogl_presented (stage_cogl,
+                                     frame->frame_counter,
+                                     frame->presentation_time,
+                                     frame->refresh_rate);
+
+      g_slice_free (HeadlessFrame, frame);
+    }
+
+  if (!g_queue_is_empty (&stage_headless->pending_frames))
+    clutter_stage_headless_schedule_vblank (stage_headless, now);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+clutter_stage_headless_schedule_vblank (ClutterStageHeadless *stage_headless,
+                                        gint64                now)
+{
+  HeadlessFrame *frame;
+  guint interval = 0;
+
+  if (stage_headless->vblank_id != 0)
+    return;
+
+  frame = g_queue_peek_head (&stage_headless->pending_frames);
+  if (frame == NULL)
+    return;
+
+  /* round up to the millisecond, so that we never wake up early */
+  if (frame->presentation_time > now)
+    interval = (frame->presentation_time - now + 999) / 1000;
+
+  /* the emulated swap events are delivered with the same priority
+   * Cogl uses for the events of the onscreen framebuffers
+   */
+  stage_headless->vblank_id =
+    clutter_threads_add_timeout_full (G_PRIORITY_DEFAULT,
+                                      interval,
+                                      clutter_stage_headless_vblank,
+                                      stage_headless,
+                                      NULL);
+}
+
+static void
+clutter_stage_headless_queue_frame (ClutterStageHeadless *stage_headless)
+{
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_headless);
+  HeadlessFrame *frame;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+
+  frame = g_slice_new (HeadlessFrame);
+  frame->frame_counter = stage_headless->frame_counter++;
+  frame->refresh_rate = clutter_headless_get_refresh_rate ();
+  frame->presentation_time = 0;
+
+  if (_clutter_get_sync_to_vblank () && frame->refresh_rate > 0)
+    {
+      gint64 refresh_interval;
+      gint64 vblank;
+
+      refresh_interval = (gint64) (0.5 + 1000000 / frame->refresh_rate);
+      if (refresh_interval == 0)
+        refresh_interval = 1;
+
+      /* the emulated output refreshes on a fixed grid, like a real
+       * one would; a frame takes the first vblank that was not already
+       * taken by the frames before it
+       */
+      vblank = (now / refresh_interval + 1) * refresh_interval;
+      while (vblank <= stage_headless->last_vblank_time)
+        vblank += refresh_interval;
+
+      frame->presentation_time = vblank;
+      stage_headless->last_vblank_time = vblank;
+    }
+
+  stage_cogl->swap_targets[frame->frame_counter % CLUTTER_STAGE_COGL_N_SWAP_TARGETS] =
+    stage_cogl->presentation_time;
+
+  if (clutter_feature_available (CLUTTER_FEATURE_SWAP_EVENTS))
+    stage_cogl->pending_swaps++;
+
+  g_queue_push_tail (&stage_headless->pending_frames, frame);
+
+  clutter_stage_headless_schedule_vblank (stage_headless, now);
+}
+
+static void
+clutter_stage_headless_redraw (ClutterStageWindow *stage_window)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+  ClutterStage *wrapper = stage_cogl->wrapper;
+  cairo_rectangle_int_t *clip_region;
+  gboolean use_clipped_redraw;
+  gboolean has_damage;
+
+  if (stage_headless->offscreen == NULL)
+    return;
+
+  /* unlike the back buffer of an onscreen framebuffer, the offscreen
+   * keeps its contents between frames, so we only need to repaint the
+   * damaged region, unless something else (like picking) drew into it
+   */
+  clip_region = &stage_cogl->bounding_redraw_clip;
+  use_clipped_redraw =
+    _clutter_stage_window_can_clip_redraws (stage_window) &&
+    stage_cogl->initialized_redraw_clip &&
+    clip_region->width != 0 &&
+    stage_cogl->frame_count > 0 &&
+    !stage_cogl->dirty_backbuffer &&
+    G_LIKELY (!(clutter_paint_debug_flags &
+                CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS));
+
+  if (use_clipped_redraw)
+    {
+      CLUTTER_NOTE (CLIPPING,
+                    "Stage clip pushed: x=%d, y=%d, width=%d, height=%d\n",
+                    clip_region->x,
+                    clip_region->y,
+                    clip_region->width,
+                    clip_region->height);
+
+      stage_cogl->using_clipped_redraw = TRUE;
+
+      cogl_clip_push_window_rectangle (clip_region->x,
+                                       clip_region->y,
+                                       clip_region->width,
+                                       clip_region->height);
+      _clutter_stage_do_paint (wrapper, clip_region);
+      cogl_clip_pop ();
+
+      stage_cogl->using_clipped_redraw = FALSE;
+    }
+  else
+    {
+      CLUTTER_NOTE (CLIPPING, "Unclipped stage paint\n");
+
+      _clutter_stage_do_paint (wrapper, NULL);
+    }
+
+  has_damage = stage_cogl->initialized_redraw_clip &&
+               clip_region->width != 0;
+  _clutter_stage_capture_frame (wrapper,
+                                COGL_FRAMEBUFFER (stage_headless->offscreen),
+                                has_damage ? clip_region : NULL);
+
+  /* there is no swap to wait on, so we wait for the GPU instead; this
+   * keeps the render times recorded by the stage honest
+   */
+  cogl_framebuffer_finish (COGL_FRAMEBUFFER (stage_headless->offscreen));
+
+  clutter_stage_headless_queue_frame (stage_headless);
+
+  /* reset the redraw clipping for the next paint... */
+  stage_cogl->initialized_redraw_clip = FALSE;
+
+  /* we have repaired the offscreen */
+  stage_cogl->dirty_backbuffer = FALSE;
+
+  stage_cogl->frame_count++;
+}
+
+static CoglFramebuffer *
+clutter_stage_headless_get_active_framebuffer (ClutterStageWindow *stage_window)
+{
+  ClutterStageHeadless *stage_headless = CLUTTER_STAGE_HEADLESS (stage_window);
+
+  return COGL_FRAMEBUFFER (stage_headless->offscreen);
+}
+
+static void
+clutter_stage_headless_get_dirty_pixel (ClutterStageWindow *stage_window,
+                                        int                *x,
+                                        int                *y)
+{
+  *x = 0;
+  *y = 0;
+}
+
+static void
+clutter_stage_headless_show (ClutterStageWindow *stage_window,
+                             gboolean            do_raise)
+{
+  ClutterStageCogl *stage_cogl = CLUTTER_STAGE_COGL (stage_window);
+
+  clutter_stage_window_parent_iface->show (stage_window, do_raise);
+
+  /* nothing is going to expose the stage, so we need to queue the
+   * first redraw ourselves, like the Wayland backend does
+   */
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage_cogl->wrapper));
+}
+
+static void
+clutter_stage_window_iface_init (ClutterStageWindowIface *iface)
+{
+  clutter_stage_window_parent_iface = g_type_interface_peek_parent (iface);
+
+  iface->realize = clutter_stage_headless_realize;
+  iface->unrealize = clutter_stage_headless_unrealize;
+  iface->get_geometry = clutter_stage_headless_get_geometry;
+  iface->resize = clutter_stage_headless_resize;
+  iface->show = clutter_stage_headless_show;
+  iface->redraw = clutter_stage_headless_redraw;
+  iface->get_active_framebuffer = clutter_stage_headless_get_active_framebuffer;
+  iface->get_dirty_pixel = clutter_stage_headless_get_dirty_pixel;
+}
+
+static void
+clutter_stage_headless_class_init (ClutterStageHeadlessClass *klass)
+{
+}
+
+static void
+clutter_stage_headless_init (ClutterStageHeadless *stage_headless)
+{
+  stage_headless->width = 800;
+  stage_headless->height = 600;
+
+  g_queue_init (&stage_headless->pending_frames);
+}
@@ -0,0 +1,73 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2013  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_STAGE_HEADLESS_H__
+#define __CLUTTER_STAGE_HEADLESS_H__
+
+#include <glib-object.h>
+#include <clutter/clutter-stage.h>
+
+#include "cogl/clutter-stage-cogl.h"
+
+G_BEGIN_DECLS
+
+#define CLUTTER_TYPE_STAGE_HEADLESS                  (_clutter_stage_headless_get_type ())
+#define CLUTTER_STAGE_HEADLESS(obj)                  (G_TYPE_CHECK_INSTANCE_CAST ((obj), CLUTTER_TYPE_STAGE_HEADLESS, ClutterStageHeadless))
+#define CLUTTER_IS_STAGE_HEADLESS(obj)               (G_TYPE_CHECK_INSTANCE_TYPE ((obj), CLUTTER_TYPE_STAGE_HEADLESS))
+#define CLUTTER_STAGE_HEADLESS_CLASS(klass)          (G_TYPE_CHECK_CLASS_CAST ((klass), CLUTTER_TYPE_STAGE_HEADLESS, ClutterStageHeadlessClass))
+#define CLUTTER_IS_STAGE_HEADLESS_CLASS(klass)       (G_TYPE_CHECK_CLASS_TYPE ((klass), CLUTTER_TYPE_STAGE_HEADLESS))
+#define CLUTTER_STAGE_HEADLESS_GET_CLASS(obj)        (G_TYPE_INSTANCE_GET_CLASS ((obj), CLUTTER_TYPE_STAGE_HEADLESS, ClutterStageHeadlessClass))
+
+typedef struct _ClutterStageHeadless         ClutterStageHeadless;
+typedef struct _ClutterStageHeadlessClass    ClutterStageHeadlessClass;
+
+struct _ClutterStageHeadless
+{
+  ClutterStageCogl parent_instance;
+
+  /* the framebuffer the stage is painted into, instead of the
+   * onscreen used by the other Cogl based stages
+   */
+  CoglOffscreen *offscreen;
+
+  gint width;
+  gint height;
+
+  /* the frames waiting for their emulated vblank, in order */
+  GQueue pending_frames;
+  guint vblank_id;
+
+  /* the time of the last emulated vblank */
+  gint64 last_vblank_time;
+
+  gint64 frame_counter;
+};
+
+struct _ClutterStageHeadlessClass
+{
+  ClutterStageCoglClass parent_class;
+};
+
+GType _clutter_stage_headless_get_type (void) G_GNUC_CONST;
+
+G_END_DECLS
+
+#endif /* __CLUTTER_STAGE_HEADLESS_H__ */
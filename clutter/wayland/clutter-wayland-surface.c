@@ -42,6 +42,8 @@
 #include "clutter-wayland-surface.h"
 
 #include "clutter-actor-private.h"
+#include "clutter-debug.h"
+#include "clutter-main.h"
 #include "clutter-marshal.h"
 #include "clutter-paint-volume-private.h"
 #include "clutter-private.h"
@@ -56,6 +58,7 @@ enum
   PROP_SURFACE_WIDTH,
   PROP_SURFACE_HEIGHT,
   PROP_COGL_TEXTURE,
+  PROP_RELEASE_BUFFERS,
   PROP_LAST
 };
 
@@ -76,6 +79,31 @@ struct _ClutterWaylandSurfacePrivate
   CoglTexture2D *buffer;
   int width, height;
   CoglPipeline *pipeline;
+
+  /* The contents of SHM buffers are copied alternately into two
+   * textures, so that we never write into the texture the GPU may
+   * still be sampling from; buffer is a reference on the front one
+   */
+  CoglTexture2D *shm_textures[2];
+  CoglPixelFormat shm_format;
+  guint shm_front;
+
+  /* the SHM buffer waiting to be copied, and the damage accumulated
+   * since the last copy; the copy happens once per frame, right
+   * before painting
+   */
+  struct wl_buffer *pending_buffer;
+  struct wl_listener pending_buffer_destroy_listener;
+  cairo_rectangle_int_t pending_damage;
+  guint damage_repaint_id;
+
+  /* the damage of the last copy, which the back texture is missing */
+  cairo_rectangle_int_t back_damage;
+
+  /* whether we release SHM buffers ourselves, which allows deferring
+   * the copy until the next frame
+   */
+  guint release_buffers : 1;
 };
 
 G_DEFINE_TYPE (ClutterWaylandSurface,
@@ -170,11 +198,74 @@ clutter_wayland_surface_init (ClutterWaylandSurface *self)
   g_signal_connect (self, "notify::opacity", G_CALLBACK (opacity_change_cb), NULL);
 }
 
+static void
+pending_buffer_destroyed (struct wl_listener *listener,
+                          void               *data)
+{
+  ClutterWaylandSurfacePrivate *priv =
+    wl_container_of (listener, priv, pending_buffer_destroy_listener);
+
+  /* the client went away before we could copy the contents */
+  priv->pending_buffer = NULL;
+}
+
+static void
+set_pending_buffer (ClutterWaylandSurface *self,
+                    struct wl_buffer      *buffer)
+{
+  ClutterWaylandSurfacePrivate *priv = self->priv;
+
+  if (priv->pending_buffer == buffer)
+    return;
+
+  if (priv->pending_buffer != NULL)
+    {
+      wl_list_remove (&priv->pending_buffer_destroy_listener.link);
+
+      /* the contents of the buffer have been copied, or superseded
+       * before we copied them, so the client can have it back
+       */
+      if (priv->release_buffers)
+        wl_buffer_send_release (&priv->pending_buffer->resource);
+    }
+
+  priv->pending_buffer = buffer;
+
+  if (buffer != NULL)
+    {
+      priv->pending_buffer_destroy_listener.notify = pending_buffer_destroyed;
+      wl_signal_add (&buffer->resource.destroy_signal,
+                     &priv->pending_buffer_destroy_listener);
+    }
+}
+
+static void
+clear_pending_damage (ClutterWaylandSurface *self)
+{
+  ClutterWaylandSurfacePrivate *priv = self->priv;
+
+  if (priv->damage_repaint_id != 0)
+    {
+      clutter_threads_remove_repaint_func (priv->damage_repaint_id);
+      priv->damage_repaint_id = 0;
+    }
+
+  set_pending_buffer (self, NULL);
+}
+
 static void
 free_surface_buffers (ClutterWaylandSurface *self)
 {
   ClutterWaylandSurfacePrivate *priv = self->priv;
 
+  if (priv->shm_textures[0])
+    {
+      cogl_object_unref (priv->shm_textures[0]);
+      cogl_object_unref (priv->shm_textures[1]);
+      priv->shm_textures[0] = NULL;
+      priv->shm_textures[1] = NULL;
+    }
+
   if (priv->buffer)
     {
       cogl_object_unref (priv->buffer);
@@ -189,6 +280,7 @@ clutter_wayland_surface_dispose (GObject *object)
   ClutterWaylandSurface *self = CLUTTER_WAYLAND_SURFACE (object);
   ClutterWaylandSurfacePrivate *priv = self->priv;
 
+  clear_pending_damage (self);
   free_pipeline (self);
   free_surface_buffers (self);
   priv->surface = NULL;
@@ -258,6 +350,7 @@ clutter_wayland_surface_set_surface (ClutterWaylandSurface *self,
 
   if (priv->surface)
     {
+      clear_pending_damage (self);
       free_pipeline (self);
       free_surface_buffers (self);
       g_signal_emit (self, signals[QUEUE_DAMAGE_REDRAW],
@@ -289,6 +382,10 @@ clutter_wayland_surface_set_property (GObject *object,
     case PROP_SURFACE:
       clutter_wayland_surface_set_surface (self, g_value_get_pointer (value));
       break;
+    case PROP_RELEASE_BUFFERS:
+      clutter_wayland_surface_set_release_buffers (self,
+                                                   g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -315,6 +412,9 @@ clutter_wayland_surface_get_property (GObject *object,
     case PROP_SURFACE_HEIGHT:
       g_value_set_uint (value, priv->height);
       break;
+    case PROP_RELEASE_BUFFERS:
+      g_value_set_boolean (value, priv->release_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -453,6 +553,28 @@ clutter_wayland_surface_class_init (ClutterWaylandSurfaceClass *klass)
   obj_props[PROP_COGL_TEXTURE] = pspec;
   g_object_class_install_property (object_class, PROP_COGL_TEXTURE, pspec);
 
+  /**
+   * ClutterWaylandSurface:release-buffers:
+   *
+   * Whether the actor releases the SHM buffers attached to it.
+   *
+   * By default, the contents of a SHM buffer are copied as soon as
+   * it is damaged, and the compositor is responsible for releasing
+   * the buffer. If this property is set to %TRUE, the damage is
+   * accumulated and copied once per frame, right before painting,
+   * after which the actor releases the buffer; the compositor must
+   * not release SHM buffers itself in that case.
+   *
+   * Since: 1.16
+   */
+  pspec = g_param_spec_boolean ("release-buffers",
+                                P_("Release Buffers"),
+                                P_("Whether the actor releases the SHM buffers attached to it"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  obj_props[PROP_RELEASE_BUFFERS] = pspec;
+  g_object_class_install_property (object_class, PROP_RELEASE_BUFFERS, pspec);
+
   /**
    * ClutterWaylandSurface::queue-damage-redraw:
    * @texture: the object which received the signal
@@ -512,6 +634,198 @@ clutter_wayland_surface_new (struct wl_surface *surface)
   return actor;
 }
 
+static CoglPixelFormat
+get_shm_buffer_format (struct wl_buffer *buffer)
+{
+  switch (wl_shm_buffer_get_format (buffer))
+    {
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+      case WL_SHM_FORMAT_ARGB8888:
+        return COGL_PIXEL_FORMAT_ARGB_8888_PRE;
+      case WL_SHM_FORMAT_XRGB8888:
+        return COGL_PIXEL_FORMAT_ARGB_8888;
+#elif G_BYTE_ORDER == G_LITTLE_ENDIAN
+      case WL_SHM_FORMAT_ARGB8888:
+        return COGL_PIXEL_FORMAT_BGRA_8888_PRE;
+      case WL_SHM_FORMAT_XRGB8888:
+        return COGL_PIXEL_FORMAT_BGRA_8888;
+#endif
+      default:
+        g_warn_if_reached ();
+        return COGL_PIXEL_FORMAT_ARGB_8888;
+    }
+}
+
+static void
+flush_shm_damage (ClutterWaylandSurface *self)
+{
+  ClutterWaylandSurfacePrivate *priv = self->priv;
+  cairo_rectangle_int_t damage = priv->pending_damage;
+  cairo_rectangle_int_t bounds = { 0, 0, priv->width, priv->height };
+
+  if (priv->pending_buffer != NULL && priv->shm_textures[0] != NULL)
+    {
+      struct wl_buffer *buffer = priv->pending_buffer;
+      guint back = 1 - priv->shm_front;
+      cairo_rectangle_int_t area;
+
+      /* the back texture was last written two copies ago, so it is
+       * also missing the damage of the previous copy
+       */
+      _clutter_util_rectangle_union (&damage, &priv->back_damage, &area);
+      area.width = MIN (area.x + area.width, bounds.width);
+      area.height = MIN (area.y + area.height, bounds.height);
+      area.x = MAX (area.x, 0);
+      area.y = MAX (area.y, 0);
+      area.width -= area.x;
+      area.height -= area.y;
+
+      CLUTTER_NOTE (TEXTURE,
+                    "Copying x=%d, y=%d, width=%d, height=%d of the buffer "
+                    "of surface [%p] into texture %u",
+                    area.x, area.y, area.width, area.height,
+                    self, back);
+
+      if (area.width > 0 && area.height > 0)
+        cogl_texture_set_region (COGL_TEXTURE (priv->shm_textures[back]),
+                                 area.x, area.y,
+                                 area.x, area.y,
+                                 area.width, area.height,
+                                 area.width, area.height,
+                                 priv->shm_format,
+                                 wl_shm_buffer_get_stride (buffer),
+                                 wl_shm_buffer_get_data (buffer));
+
+      /* the data has been copied, so the client can reuse the buffer */
+      set_pending_buffer (self, NULL);
+
+      priv->back_damage = damage;
+      priv->shm_front = back;
+
+      cogl_object_unref (priv->buffer);
+      priv->buffer = cogl_object_ref (priv->shm_textures[back]);
+
+      if (priv->pipeline != NULL)
+        cogl_pipeline_set_layer_texture (priv->pipeline, 0,
+                                         COGL_TEXTURE (priv->buffer));
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_COGL_TEXTURE]);
+    }
+
+  g_signal_emit (self, signals[QUEUE_DAMAGE_REDRAW],
+                 0,
+                 damage.x, damage.y, damage.width, damage.height);
+}
+
+static gboolean
+flush_pending_damage (gpointer data)
+{
+  ClutterWaylandSurface *self = data;
+
+  self->priv->damage_repaint_id = 0;
+
+  flush_shm_damage (self);
+
+  /* the next damage will add the function back */
+  return FALSE;
+}
+
+static void
+queue_shm_damage (ClutterWaylandSurface       *self,
+                  const cairo_rectangle_int_t *damage)
+{
+  ClutterWaylandSurfacePrivate *priv = self->priv;
+
+  if (priv->damage_repaint_id != 0)
+    {
+      _clutter_util_rectangle_union (&priv->pending_damage, damage,
+                                     &priv->pending_damage);
+      return;
+    }
+
+  priv->pending_damage = *damage;
+
+  /* the compositor may release the buffer as soon as we return, so
+   * unless we release it ourselves we have to copy it right away
+   */
+  if (!priv->release_buffers)
+    {
+      flush_shm_damage (self);
+      return;
+    }
+
+  priv->damage_repaint_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT |
+                                           CLUTTER_REPAINT_FLAGS_QUEUE_REDRAW_ON_ADD,
+                                           flush_pending_damage,
+                                           self,
+                                           NULL);
+}
+
+static gboolean
+attach_shm_buffer (ClutterWaylandSurface *self,
+                   struct wl_buffer      *buffer,
+                   GError               **error)
+{
+  ClutterWaylandSurfacePrivate *priv = self->priv;
+  CoglPixelFormat format = get_shm_buffer_format (buffer);
+
+  if (priv->shm_textures[0] == NULL ||
+      priv->shm_format != format ||
+      priv->width != buffer->width ||
+      priv->height != buffer->height)
+    {
+      ClutterBackend *backend = clutter_get_default_backend ();
+      CoglContext *context = clutter_backend_get_cogl_context (backend);
+      cairo_rectangle_int_t full = { 0, 0, buffer->width, buffer->height };
+      int i;
+
+      free_surface_buffers (self);
+
+      for (i = 0; i < 2; i++)
+        {
+          priv->shm_textures[i] =
+            cogl_texture_2d_new_with_size (context,
+                                           buffer->width,
+                                           buffer->height,
+                                           format,
+                                           error);
+
+          if (priv->shm_textures[i] == NULL)
+            {
+              if (i == 1)
+                cogl_object_unref (priv->shm_textures[0]);
+
+              priv->shm_textures[0] = NULL;
+              set_size (self, buffer->width, buffer->height);
+              g_object_notify_by_pspec (G_OBJECT (self),
+                                        obj_props[PROP_COGL_TEXTURE]);
+              return FALSE;
+            }
+        }
+
+      priv->shm_format = format;
+      priv->shm_front = 0;
+      priv->buffer = cogl_object_ref (priv->shm_textures[0]);
+
+      set_size (self, buffer->width, buffer->height);
+      set_pending_buffer (self, buffer);
+
+      /* neither texture has any content yet */
+      priv->back_damage = full;
+      queue_shm_damage (self, &full);
+
+      g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_COGL_TEXTURE]);
+
+      return TRUE;
+    }
+
+  set_size (self, buffer->width, buffer->height);
+  set_pending_buffer (self, buffer);
+
+  return TRUE;
+}
+
 /**
  * clutter_wayland_surface_attach_buffer:
  * @self: A #ClutterWaylandSurface actor
@@ -522,6 +836,10 @@ clutter_wayland_surface_new (struct wl_surface *surface)
  * actor @self. This will automatically result in @self being re-drawn
  * with the new buffer contents.
  *
+ * The contents of SHM buffers are copied when they are damaged; see
+ * #ClutterWaylandSurface:release-buffers for deferring the copy until
+ * the next frame.
+ *
  * Since: 1.8
  * Stability: unstable
  */
@@ -538,6 +856,10 @@ clutter_wayland_surface_attach_buffer (ClutterWaylandSurface *self,
 
   priv = self->priv;
 
+  if (wl_buffer_is_shm (buffer))
+    return attach_shm_buffer (self, buffer, error);
+
+  clear_pending_damage (self);
   free_surface_buffers (self);
 
   set_size (self, buffer->width, buffer->height);
@@ -572,7 +894,10 @@ clutter_wayland_surface_attach_buffer (ClutterWaylandSurface *self,
  * region of the actor @self being redrawn.
  *
  * If multiple regions are changed then this should be called multiple
- * times with different damage rectangles.
+ * times with different damage rectangles; for SHM buffers, if
+ * #ClutterWaylandSurface:release-buffers is set, the damage is
+ * accumulated and the damaged area is copied and redrawn once, when
+ * the next frame is painted.
  *
  * Since: 1.8
  * Stability: unstable
@@ -591,40 +916,16 @@ clutter_wayland_surface_damage_buffer (ClutterWaylandSurface *self,
 
   priv = self->priv;
 
-  if (priv->buffer && wl_buffer_is_shm (buffer))
+  if (priv->shm_textures[0] && wl_buffer_is_shm (buffer))
     {
-      CoglPixelFormat format;
+      cairo_rectangle_int_t damage = { x, y, width, height };
 
-      switch (wl_shm_buffer_get_format (buffer))
-        {
-#if G_BYTE_ORDER == G_BIG_ENDIAN
-          case WL_SHM_FORMAT_ARGB8888:
-            format = COGL_PIXEL_FORMAT_ARGB_8888_PRE;
-            break;
-          case WL_SHM_FORMAT_XRGB8888:
-            format = COGL_PIXEL_FORMAT_ARGB_8888;
-            break;
-#elif G_BYTE_ORDER == G_LITTLE_ENDIAN
-          case WL_SHM_FORMAT_ARGB8888:
-            format = COGL_PIXEL_FORMAT_BGRA_8888_PRE;
-            break;
-          case WL_SHM_FORMAT_XRGB8888:
-            format = COGL_PIXEL_FORMAT_BGRA_8888;
-            break;
-#endif
-          default:
-            g_warn_if_reached ();
-            format = COGL_PIXEL_FORMAT_ARGB_8888;
-        }
-
-      cogl_texture_set_region (COGL_TEXTURE (priv->buffer),
-                               x, y,
-                               x, y,
-                               width, height,
-                               width, height,
-                               format,
-                               wl_shm_buffer_get_stride (buffer),
-                               wl_shm_buffer_get_data (buffer));
+      /* damage on a buffer that was not attached again since its last
+       * copy still needs to be copied from it
+       */
+      set_pending_buffer (self, buffer);
+      queue_shm_damage (self, &damage);
+      return;
     }
 
   g_signal_emit (self, signals[QUEUE_DAMAGE_REDRAW],
@@ -649,3 +950,65 @@ clutter_wayland_surface_get_cogl_texture (ClutterWaylandSurface *self)
 
   return COGL_TEXTURE (self->priv->buffer);
 }
+
+/**
+ * clutter_wayland_surface_set_release_buffers:
+ * @self: a #ClutterWaylandSurface
+ * @release_buffers: whether the actor releases the SHM buffers
+ *
+ * Sets whether @self releases the SHM buffers attached to it, which
+ * lets it defer copying their contents until the next frame. See
+ * #ClutterWaylandSurface:release-buffers.
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+void
+clutter_wayland_surface_set_release_buffers (ClutterWaylandSurface *self,
+                                             gboolean               release_buffers)
+{
+  ClutterWaylandSurfacePrivate *priv;
+
+  g_return_if_fail (CLUTTER_WAYLAND_IS_SURFACE (self));
+
+  priv = self->priv;
+
+  release_buffers = !!release_buffers;
+
+  if (priv->release_buffers == release_buffers)
+    return;
+
+  /* when the compositor takes back the release of the buffers, we
+   * copy the pending damage and release the buffer we were holding
+   */
+  if (priv->damage_repaint_id != 0)
+    {
+      clutter_threads_remove_repaint_func (priv->damage_repaint_id);
+      priv->damage_repaint_id = 0;
+
+      flush_shm_damage (self);
+    }
+
+  priv->release_buffers = release_buffers;
+
+  g_object_notify_by_pspec (G_OBJECT (self), obj_props[PROP_RELEASE_BUFFERS]);
+}
+
+/**
+ * clutter_wayland_surface_get_release_buffers:
+ * @self: a #ClutterWaylandSurface
+ *
+ * Retrieves the value set with clutter_wayland_surface_set_release_buffers().
+ *
+ * Return value: %TRUE if @self releases the SHM buffers attached to it
+ *
+ * Since: 1.16
+ * Stability: unstable
+ */
+gboolean
+clutter_wayland_surface_get_release_buffers (ClutterWaylandSurface *self)
+{
+  g_return_val_if_fail (CLUTTER_WAYLAND_IS_SURFACE (self), FALSE);
+
+  return self->priv->release_buffers;
+}
@@ -105,6 +105,10 @@ void          clutter_wayland_surface_damage_buffer     (ClutterWaylandSurface *
                                                          gint32 height);
 CoglTexture  *clutter_wayland_surface_get_cogl_texture  (ClutterWaylandSurface *self);
 
+void          clutter_wayland_surface_set_release_buffers (ClutterWaylandSurface *self,
+                                                           gboolean release_buffers);
+gboolean      clutter_wayland_surface_get_release_buffers (ClutterWaylandSurface *self);
+
 G_END_DECLS
 
 #endif
@@ -50,9 +50,12 @@
 #include "clutter-backend-x11.h"
 
 #include "clutter-actor-private.h"
+#include "clutter-debug.h"
+#include "clutter-main.h"
 #include "clutter-marshal.h"
 #include "clutter-paint-volume-private.h"
 #include "clutter-private.h"
+#include "clutter-profile.h"
 
 #include <cogl/cogl.h>
 
@@ -121,6 +124,18 @@ struct _ClutterX11TexturePixmapPrivate
 
   Damage        damage;
 
+  /* the bounding box of the damage reported since the last frame,
+   * valid while damage_repaint_id is set
+   */
+  cairo_rectangle_int_t pending_damage;
+  guint         damage_repaint_id;
+
+  /* the number of damage events received, and the number of redraws
+   * they have been coalesced into
+   */
+  guint         n_raw_damage;
+  guint         n_coalesced_damage;
+
   gint          window_x, window_y;
   gint          window_width, window_height;
 
@@ -160,18 +175,96 @@ check_extensions (ClutterX11TexturePixmap *texture)
   return TRUE;
 }
 
-static void
-process_damage_event (ClutterX11TexturePixmap *texture,
-                      XDamageNotifyEvent *damage_event)
+static gboolean
+flush_pending_damage (gpointer data)
 {
+  ClutterX11TexturePixmap *texture = data;
+  ClutterX11TexturePixmapPrivate *priv = texture->priv;
+  cairo_rectangle_int_t area = priv->pending_damage;
+
+  CLUTTER_STATIC_COUNTER (coalesced_damage_counter,
+                          "Coalesced damage counter",
+                          "Increments for each redraw queued for the "
+                          "damage of a texture pixmap",
+                          0);
+
+  priv->damage_repaint_id = 0;
+  priv->n_coalesced_damage += 1;
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, coalesced_damage_counter);
+
+  CLUTTER_NOTE (TEXTURE,
+                "Flushing damage x=%d, y=%d, width=%d, height=%d "
+                "(damage events: %u, redraws: %u)",
+                area.x, area.y, area.width, area.height,
+                priv->n_raw_damage,
+                priv->n_coalesced_damage);
+
   /* Cogl will deal with updating the texture and subtracting from the
      damage region so we only need to queue a redraw */
   g_signal_emit (texture, signals[QUEUE_DAMAGE_REDRAW],
                  0,
-                 damage_event->area.x,
-                 damage_event->area.y,
-                 damage_event->area.width,
-                 damage_event->area.height);
+                 area.x,
+                 area.y,
+                 area.width,
+                 area.height);
+
+  /* the next damage event will add the function back */
+  return FALSE;
+}
+
+static void
+clear_pending_damage (ClutterX11TexturePixmap *texture)
+{
+  ClutterX11TexturePixmapPrivate *priv = texture->priv;
+
+  if (priv->damage_repaint_id != 0)
+    {
+      clutter_threads_remove_repaint_func (priv->damage_repaint_id);
+      priv->damage_repaint_id = 0;
+    }
+}
+
+static void
+process_damage_event (ClutterX11TexturePixmap *texture,
+                      XDamageNotifyEvent *damage_event)
+{
+  ClutterX11TexturePixmapPrivate *priv = texture->priv;
+  cairo_rectangle_int_t area;
+
+  CLUTTER_STATIC_COUNTER (raw_damage_counter,
+                          "Raw damage counter",
+                          "Increments for each damage event received "
+                          "by a texture pixmap",
+                          0);
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, raw_damage_counter);
+  priv->n_raw_damage += 1;
+
+  area.x = damage_event->area.x;
+  area.y = damage_event->area.y;
+  area.width = damage_event->area.width;
+  area.height = damage_event->area.height;
+
+  /* A busy client can send many damage events per frame; queueing a
+   * clipped redraw for each one of them means transforming the paint
+   * volume every time, so we accumulate the damage and queue a single
+   * redraw right before the next frame is painted
+   */
+  if (priv->damage_repaint_id != 0)
+    {
+      _clutter_util_rectangle_union (&priv->pending_damage, &area,
+                                     &priv->pending_damage);
+      return;
+    }
+
+  priv->pending_damage = area;
+  priv->damage_repaint_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT |
+                                           CLUTTER_REPAINT_FLAGS_QUEUE_REDRAW_ON_ADD,
+                                           flush_pending_damage,
+                                           texture,
+                                           NULL);
 }
 
 static ClutterX11FilterReturn
@@ -324,6 +417,8 @@ free_damage_resources (ClutterX11TexturePixmap *texture)
 
       clutter_x11_remove_filter (on_x_event_filter, (gpointer)texture);
 
+      clear_pending_damage (texture);
+
       update_pixmap_damage_object (texture);
     }
 }
@@ -416,6 +511,7 @@ clutter_x11_texture_pixmap_dispose (GObject *object)
   ClutterX11TexturePixmap *texture = CLUTTER_X11_TEXTURE_PIXMAP (object);
 
   free_damage_resources (texture);
+  clear_pending_damage (texture);
 
   clutter_x11_remove_filter (on_x_event_filter_too, (gpointer)texture);
   clutter_x11_texture_pixmap_set_pixmap (texture, None);
@@ -683,6 +779,10 @@ clutter_x11_texture_pixmap_class_init (ClutterX11TexturePixmapClass *klass)
    * clutter_x11_texture_pixmap_update_area). This usually means a
    * redraw needs to be queued for the actor.
    *
+   * The automatic damage updates received between two frames are
+   * coalesced, and the signal is emitted once, before the next frame
+   * is painted, with the bounding box of the damaged areas.
+   *
    * The default handler will queue a clipped redraw in response to
    * the damage, using the assumption that the pixmap is being painted
    * to a rectangle covering the transformed allocation of the actor.
@@ -0,0 +1,404 @@
+#include <math.h>
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+#define STAGE_WIDTH     400
+#define STAGE_HEIGHT    200
+#define HALF_WIDTH      (STAGE_WIDTH / 2)
+#define ACTOR_SIZE      100
+#define DURATION        250
+
+/* a subclass of ClutterInterval without any override; the property
+ * transitions only take the fast path for ClutterInterval itself, so
+ * this forces the generic path through clutter_interval_compute()
+ */
+typedef struct _TestInterval      TestInterval;
+typedef struct _TestIntervalClass TestIntervalClass;
+
+struct _TestInterval
+{
+  ClutterInterval parent_instance;
+};
+
+struct _TestIntervalClass
+{
+  ClutterIntervalClass parent_class;
+};
+
+#define TYPE_TEST_INTERVAL      (test_interval_get_type ())
+
+G_DEFINE_TYPE (TestInterval, test_interval, CLUTTER_TYPE_INTERVAL)
+
+static void
+test_interval_class_init (TestIntervalClass *klass)
+{
+}
+
+static void
+test_interval_init (TestInterval *self)
+{
+}
+
+typedef struct {
+  ClutterActor *stage;
+
+  /* the first actor is animated through the fast path, the second
+   * one through the generic path; the second actor is placed in the
+   * right half of the stage, at the same position as the first one
+   */
+  ClutterActor *actors[2];
+
+  /* the notifications received by an undetailed handler, and by a
+   * detailed handler that is blocked during the first frames
+   */
+  guint n_notifies[2];
+  guint n_opacity_notifies[2];
+  gulong opacity_handlers[2];
+
+  guint n_transitions;
+  guint n_stopped;
+  guint n_frames;
+  guint n_painted;
+} FastData;
+
+static const gchar *properties[] = {
+  "opacity",
+  "rotation-angle-z",
+  "scale-x",
+  "translation-x",
+  "background-color",
+};
+
+static ClutterInterval *
+make_interval (const gchar *property)
+{
+  if (g_str_equal (property, "opacity"))
+    return clutter_interval_new (G_TYPE_UINT, 255, 64);
+
+  if (g_str_equal (property, "rotation-angle-z"))
+    return clutter_interval_new (G_TYPE_DOUBLE, 0.0, 45.0);
+
+  if (g_str_equal (property, "scale-x"))
+    return clutter_interval_new (G_TYPE_DOUBLE, 1.0, 0.5);
+
+  if (g_str_equal (property, "translation-x"))
+    return clutter_interval_new (G_TYPE_FLOAT, 0.f, 20.f);
+
+  if (g_str_equal (property, "background-color"))
+    return clutter_interval_new (CLUTTER_TYPE_COLOR,
+                                 CLUTTER_COLOR_Red,
+                                 CLUTTER_COLOR_Blue);
+
+  g_assert_not_reached ();
+
+  return NULL;
+}
+
+static ClutterInterval *
+make_generic_interval (ClutterInterval *interval)
+{
+  ClutterInterval *res;
+
+  res = g_object_new (TYPE_TEST_INTERVAL,
+                      "value-type", clutter_interval_get_value_type (interval),
+                      NULL);
+
+  clutter_interval_set_initial_value (res,
+                                      clutter_interval_peek_initial_value (interval));
+  clutter_interval_set_final_value (res,
+                                    clutter_interval_peek_final_value (interval));
+
+  return res;
+}
+
+static void
+on_new_frame (ClutterTimeline *timeline,
+              gint             msecs,
+              FastData        *data)
+{
+  /* connecting a handler keeps the transitions out of the batch, so
+   * that both of them go through compute_value()
+   */
+}
+
+static void
+on_notify (ClutterActor *actor,
+           GParamSpec   *pspec,
+           FastData     *data)
+{
+  data->n_notifies[actor == data->actors[0] ? 0 : 1] += 1;
+}
+
+static void
+on_notify_opacity (ClutterActor *actor,
+                   GParamSpec   *pspec,
+                   FastData     *data)
+{
+  data->n_opacity_notifies[actor == data->actors[0] ? 0 : 1] += 1;
+}
+
+static void
+compare_notifies (FastData *data)
+{
+  if (g_test_verbose ())
+    g_print ("frame %u: %u notifies, %u opacity notifies (fast), "
+             "%u notifies, %u opacity notifies (generic)\n",
+             data->n_frames,
+             data->n_notifies[0], data->n_opacity_notifies[0],
+             data->n_notifies[1], data->n_opacity_notifies[1]);
+
+  g_assert_cmpuint (data->n_notifies[0], ==, data->n_notifies[1]);
+  g_assert_cmpuint (data->n_opacity_notifies[0], ==, data->n_opacity_notifies[1]);
+}
+
+static void
+on_stopped (ClutterTimeline *timeline,
+            gboolean         is_finished,
+            FastData        *data)
+{
+  data->n_stopped += 1;
+
+  if (data->n_stopped == data->n_transitions)
+    clutter_main_quit ();
+}
+
+static void
+compare_values (FastData *data)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (properties); i++)
+    {
+      GParamSpec *pspec;
+      GValue values[2] = { G_VALUE_INIT, G_VALUE_INIT };
+      guint j;
+
+      pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (data->actors[0]),
+                                            properties[i]);
+
+      for (j = 0; j < 2; j++)
+        {
+          g_value_init (&values[j], G_PARAM_SPEC_VALUE_TYPE (pspec));
+          g_object_get_property (G_OBJECT (data->actors[j]),
+                                 properties[i],
+                                 &values[j]);
+        }
+
+      if (G_VALUE_HOLDS (&values[0], CLUTTER_TYPE_COLOR))
+        {
+          const ClutterColor *color_0 = clutter_value_get_color (&values[0]);
+          const ClutterColor *color_1 = clutter_value_get_color (&values[1]);
+
+          g_assert (clutter_color_equal (color_0, color_1));
+        }
+      else
+        {
+          GValue res[2] = { G_VALUE_INIT, G_VALUE_INIT };
+
+          for (j = 0; j < 2; j++)
+            {
+              g_value_init (&res[j], G_TYPE_DOUBLE);
+              g_value_transform (&values[j], &res[j]);
+            }
+
+          if (g_test_verbose ())
+            g_print ("frame %u: %s = %.6f (fast), %.6f (generic)\n",
+                     data->n_frames,
+                     properties[i],
+                     g_value_get_double (&res[0]),
+                     g_value_get_double (&res[1]));
+
+          g_assert_cmpfloat (fabs (g_value_get_double (&res[0]) -
+                                   g_value_get_double (&res[1])), <, 0.001);
+        }
+
+      for (j = 0; j < 2; j++)
+        g_value_unset (&values[j]);
+    }
+}
+
+static void
+on_paint (ClutterActor *stage,
+          FastData     *data)
+{
+  guchar *pixels;
+  gint x, y;
+
+  /* both halves of the stage paint the same */
+  pixels = clutter_stage_read_pixels (CLUTTER_STAGE (stage),
+                                      0, 0,
+                                      STAGE_WIDTH, STAGE_HEIGHT);
+
+  for (y = 0; y < STAGE_HEIGHT; y++)
+    {
+      for (x = 0; x < HALF_WIDTH; x++)
+        {
+          const guchar *fast = pixels + (y * STAGE_WIDTH + x) * 4;
+          const guchar *generic = fast + HALF_WIDTH * 4;
+          gint i;
+
+          for (i = 0; i < 3; i++)
+            g_assert_cmpint (ABS ((gint) fast[i] - (gint) generic[i]), <=, 1);
+        }
+    }
+
+  g_free (pixels);
+
+  data->n_painted += 1;
+}
+
+static gboolean
+on_paint_done (gpointer user_data)
+{
+  FastData *data = user_data;
+  gint x, y;
+  guint i;
+
+  compare_values (data);
+  compare_notifies (data);
+
+  /* a handler unblocked while the transitions are running receives
+   * the following notifications from both paths
+   */
+  if (data->n_frames == 2)
+    {
+      for (i = 0; i < 2; i++)
+        g_signal_handler_unblock (data->actors[i], data->opacity_handlers[i]);
+    }
+
+  /* both halves of the stage pick the same */
+  for (y = 5; y < STAGE_HEIGHT; y += 10)
+    {
+      for (x = 5; x < HALF_WIDTH; x += 10)
+        {
+          ClutterActor *fast, *generic;
+
+          fast = clutter_stage_get_actor_at_pos (CLUTTER_STAGE (data->stage),
+                                                 CLUTTER_PICK_ALL,
+                                                 x, y);
+          generic = clutter_stage_get_actor_at_pos (CLUTTER_STAGE (data->stage),
+                                                    CLUTTER_PICK_ALL,
+                                                    x + HALF_WIDTH, y);
+
+          if (fast == data->actors[0])
+            g_assert (generic == data->actors[1]);
+          else
+            {
+              g_assert (fast == data->stage);
+              g_assert (generic == data->stage);
+            }
+        }
+    }
+
+  data->n_frames += 1;
+
+  return TRUE;
+}
+
+void
+actor_fast_transitions (TestConformSimpleFixture *fixture,
+                        gconstpointer             dummy)
+{
+  FastData data = { NULL, };
+  guint repaint_id, i, j;
+
+  data.stage = clutter_stage_new ();
+  clutter_actor_set_size (data.stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_actor_set_background_color (data.stage, CLUTTER_COLOR_Black);
+
+  for (i = 0; i < 2; i++)
+    {
+      data.actors[i] = clutter_actor_new ();
+      clutter_actor_set_background_color (data.actors[i], CLUTTER_COLOR_Red);
+      clutter_actor_set_size (data.actors[i], ACTOR_SIZE, ACTOR_SIZE);
+      clutter_actor_set_position (data.actors[i],
+                                  (HALF_WIDTH - ACTOR_SIZE) / 2 + i * HALF_WIDTH,
+                                  (STAGE_HEIGHT - ACTOR_SIZE) / 2);
+      clutter_actor_set_pivot_point (data.actors[i], 0.5f, 0.5f);
+      clutter_actor_set_reactive (data.actors[i], TRUE);
+      clutter_actor_add_child (data.stage, data.actors[i]);
+
+      g_signal_connect (data.actors[i], "notify",
+                        G_CALLBACK (on_notify),
+                        &data);
+
+      data.opacity_handlers[i] =
+        g_signal_connect (data.actors[i], "notify::opacity",
+                          G_CALLBACK (on_notify_opacity),
+                          &data);
+      g_signal_handler_block (data.actors[i], data.opacity_handlers[i]);
+    }
+
+  g_signal_connect_after (data.stage, "paint",
+                          G_CALLBACK (on_paint),
+                          &data);
+
+  repaint_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                           on_paint_done,
+                                           &data,
+                                           NULL);
+
+  clutter_actor_show (data.stage);
+
+  for (i = 0; i < G_N_ELEMENTS (properties); i++)
+    {
+      ClutterInterval *interval = make_interval (properties[i]);
+
+      for (j = 0; j < 2; j++)
+        {
+          ClutterTransition *transition;
+
+          transition = clutter_property_transition_new (properties[i]);
+
+          if (j == 0)
+            clutter_transition_set_interval (transition, interval);
+          else
+            {
+              ClutterInterval *generic = make_generic_interval (interval);
+
+              clutter_transition_set_interval (transition, generic);
+              g_object_unref (generic);
+            }
+
+          clutter_timeline_set_duration (CLUTTER_TIMELINE (transition), DURATION);
+          clutter_timeline_set_progress_mode (CLUTTER_TIMELINE (transition),
+                                              CLUTTER_EASE_IN_OUT_QUAD);
+
+          g_signal_connect (transition, "new-frame",
+                            G_CALLBACK (on_new_frame),
+                            &data);
+          g_signal_connect (transition, "stopped",
+                            G_CALLBACK (on_stopped),
+                            &data);
+
+          clutter_actor_add_transition (data.actors[j], properties[i], transition);
+          data.n_transitions += 1;
+
+          g_object_unref (transition);
+        }
+
+      g_object_unref (interval);
+    }
+
+  clutter_main ();
+
+  clutter_threads_remove_repaint_func (repaint_id);
+
+  if (g_test_verbose ())
+    g_print ("%u frames, %u painted\n", data.n_frames, data.n_painted);
+
+  g_assert_cmpuint (data.n_stopped, ==, data.n_transitions);
+  g_assert_cmpuint (data.n_frames, >, 2);
+  g_assert_cmpuint (data.n_painted, >, 2);
+
+  /* the final state matches as well */
+  compare_values (&data);
+  compare_notifies (&data);
+
+  g_assert_cmpuint (data.n_notifies[0], >, 0);
+  g_assert_cmpuint (data.n_opacity_notifies[0], >, 0);
+
+  clutter_actor_destroy (data.stage);
+}
@@ -0,0 +1,146 @@
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <clutter/clutter.h>
+#include <clutter/clutter-keysyms.h>
+
+#include "test-conform-common.h"
+
+#define N_EVENTS        4
+
+typedef struct {
+  ClutterEventType types[N_EVENTS * 2];
+  gfloat x[N_EVENTS * 2];
+  gfloat y[N_EVENTS * 2];
+  guint n_events;
+} ReplayData;
+
+static gboolean
+on_captured_event (ClutterActor *stage,
+                   ClutterEvent *event,
+                   ReplayData   *data)
+{
+  switch (clutter_event_type (event))
+    {
+    case CLUTTER_MOTION:
+    case CLUTTER_BUTTON_PRESS:
+    case CLUTTER_BUTTON_RELEASE:
+    case CLUTTER_KEY_PRESS:
+      g_assert_cmpuint (data->n_events, <, N_EVENTS * 2);
+
+      data->types[data->n_events] = clutter_event_type (event);
+      clutter_event_get_coords (event,
+                                &data->x[data->n_events],
+                                &data->y[data->n_events]);
+      data->n_events += 1;
+
+      /* the recorded events, then the replayed ones */
+      if (data->n_events == N_EVENTS * 2)
+        clutter_main_quit ();
+      break;
+
+    default:
+      break;
+    }
+
+  return CLUTTER_EVENT_PROPAGATE;
+}
+
+static void
+inject_event (ClutterActor       *stage,
+              ClutterEventType    type,
+              ClutterInputDevice *device,
+              gfloat              x,
+              gfloat              y)
+{
+  ClutterEvent *event;
+
+  event = clutter_event_new (type);
+  clutter_event_set_stage (event, CLUTTER_STAGE (stage));
+  clutter_event_set_device (event, device);
+  clutter_event_set_time (event, CLUTTER_CURRENT_TIME);
+  clutter_event_set_coords (event, x, y);
+
+  if (type == CLUTTER_BUTTON_PRESS || type == CLUTTER_BUTTON_RELEASE)
+    clutter_event_set_button (event, CLUTTER_BUTTON_PRIMARY);
+
+  if (type == CLUTTER_KEY_PRESS)
+    clutter_event_set_key_symbol (event, CLUTTER_KEY_a);
+
+  clutter_do_event (event);
+  clutter_event_free (event);
+}
+
+void
+input_replay (TestConformSimpleFixture *fixture,
+              gconstpointer             dummy)
+{
+  ClutterDeviceManager *manager = clutter_device_manager_get_default ();
+  ClutterInputDevice *pointer, *keyboard;
+  ReplayData data = { { 0, }, };
+  ClutterActor *stage;
+  GError *error = NULL;
+  gchar *filename;
+  gint fd;
+  guint i;
+
+  pointer = clutter_device_manager_get_core_device (manager,
+                                                    CLUTTER_POINTER_DEVICE);
+  keyboard = clutter_device_manager_get_core_device (manager,
+                                                     CLUTTER_KEYBOARD_DEVICE);
+  if (pointer == NULL || keyboard == NULL)
+    {
+      if (g_test_verbose ())
+        g_print ("No core devices, skipping the test\n");
+
+      return;
+    }
+
+  fd = g_file_open_tmp ("clutter-input-XXXXXX", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  stage = clutter_stage_new ();
+  g_signal_connect (stage, "captured-event",
+                    G_CALLBACK (on_captured_event),
+                    &data);
+  clutter_actor_show (stage);
+
+  g_assert (clutter_input_record_start (filename, &error));
+  g_assert_no_error (error);
+
+  inject_event (stage, CLUTTER_MOTION, pointer, 10, 20);
+  inject_event (stage, CLUTTER_BUTTON_PRESS, pointer, 10, 20);
+  inject_event (stage, CLUTTER_BUTTON_RELEASE, pointer, 30, 40);
+  inject_event (stage, CLUTTER_KEY_PRESS, keyboard, 0, 0);
+
+  clutter_input_record_stop ();
+
+  /* the replay is queued behind the recorded events */
+  g_assert (clutter_input_replay_start (CLUTTER_STAGE (stage),
+                                        filename,
+                                        FALSE,
+                                        NULL, NULL, NULL,
+                                        &error));
+  g_assert_no_error (error);
+
+  clutter_main ();
+
+  for (i = 0; i < N_EVENTS; i++)
+    {
+      if (g_test_verbose ())
+        g_print ("event %u: type %d at (%.0f, %.0f), replayed at (%.0f, %.0f)\n",
+                 i,
+                 data.types[i],
+                 data.x[i], data.y[i],
+                 data.x[i + N_EVENTS], data.y[i + N_EVENTS]);
+
+      g_assert_cmpint (data.types[i], ==, data.types[i + N_EVENTS]);
+      g_assert_cmpfloat (data.x[i], ==, data.x[i + N_EVENTS]);
+      g_assert_cmpfloat (data.y[i], ==, data.y[i + N_EVENTS]);
+    }
+
+  clutter_actor_destroy (stage);
+
+  g_unlink (filename);
+  g_free (filename);
+}
@@ -545,6 +545,89 @@ path_test_get_position (CallbackData *data)
   return TRUE;
 }
 
+static gboolean
+path_test_get_point (CallbackData *data)
+{
+  static const float values[] = { 0.125f, 16.0f, 16.0f, 1.0f,
+                                  0.375f, 48.0f, 48.0f, 1.0f,
+                                  0.625f, 80.0f, 48.0f, -1.0f,
+                                  0.875f, 112.0f, 16.0f, -1.0f };
+  ClutterPoint forward[65], backward[65];
+  gint i;
+
+  set_triangle_path (data);
+
+  for (i = 0; i < G_N_ELEMENTS (values); i += 4)
+    {
+      ClutterPoint pos, tangent, normal;
+
+      clutter_path_get_point (data->path,
+                              values[i],
+                              &pos,
+                              &tangent,
+                              &normal);
+
+      if (!float_fuzzy_equals (values[i + 1], pos.x)
+          || !float_fuzzy_equals (values[i + 2], pos.y))
+        return FALSE;
+
+      /* the path goes down and then up, at 45 degrees */
+      if (fabsf (tangent.x - (float) M_SQRT1_2) > 0.01f ||
+          fabsf (tangent.y - values[i + 3] * (float) M_SQRT1_2) > 0.01f)
+        return FALSE;
+
+      if (fabsf (normal.x + tangent.y) > 0.0001f ||
+          fabsf (normal.y - tangent.x) > 0.0001f)
+        return FALSE;
+    }
+
+  /* the lookups give the same results regardless of their order */
+  for (i = 0; i <= 64; i++)
+    clutter_path_get_point (data->path, i / 64.0, forward + i, NULL, NULL);
+
+  for (i = 64; i >= 0; i--)
+    clutter_path_get_point (data->path, i / 64.0, backward + i, NULL, NULL);
+
+  for (i = 0; i <= 64; i++)
+    if (!clutter_point_equals (forward + i, backward + i))
+      return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+path_test_constant_speed (CallbackData *data)
+{
+  ClutterPoint points[33];
+  gint i;
+
+  /* an arch whose parameter advances much slower at the ends than in
+   * the middle; its length is 200
+   */
+  clutter_path_set_description (data->path, "M 0 0 C 0 100 100 100 100 0");
+
+  for (i = 0; i <= 32; i++)
+    clutter_path_get_point (data->path, i / 32.0, points + i, NULL, NULL);
+
+  /* equal steps in progress should move equal distances along the curve */
+  for (i = 0; i < 32; i++)
+    {
+      float step = clutter_point_distance (points + i, points + i + 1,
+                                           NULL, NULL);
+
+      if (fabsf (step - 200.f / 32.f) > 0.02f * 200.f / 32.f)
+        {
+          if (g_test_verbose ())
+            g_print ("Step %d is %g long, expected %g\n",
+                     i, step, 200.f / 32.f);
+
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
 static gboolean
 path_test_get_length (CallbackData *data)
 {
@@ -655,6 +738,8 @@ path_tests[] =
     { "Convert to cairo path and back", path_test_convert_to_cairo_path },
     { "Clear", path_test_clear },
     { "Get position", path_test_get_position },
+    { "Get point", path_test_get_point },
+    { "Constant speed along curves", path_test_constant_speed },
     { "Check node boxed type", path_test_boxed_type },
     { "Get length", path_test_get_length }
   };
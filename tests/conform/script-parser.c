@@ -1,5 +1,8 @@
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <utime.h>
+#include <glib/gstdio.h>
 #include <clutter/clutter.h>
 
 #include "test-conform-common.h"
@@ -109,9 +112,12 @@ test_group_class_init (TestGroupClass *klass)
 {
 }
 
+static guint test_group_n_instances = 0;
+
 static void
 test_group_init (TestGroup *self)
 {
+  test_group_n_instances += 1;
 }
 
 void
@@ -399,6 +405,182 @@ script_layout_property (TestConformSimpleFixture *fixture,
   g_object_unref (script);
 }
 
+static void
+script_cache_check_layout (ClutterScript *script)
+{
+  GObject *manager, *container, *actor1, *actor2;
+  gboolean x_fill, expand;
+  ClutterBoxAlignment y_align;
+
+  manager = container = actor1 = actor2 = NULL;
+  clutter_script_get_objects (script,
+                              "manager", &manager,
+                              "container", &container,
+                              "actor-1", &actor1,
+                              "actor-2", &actor2,
+                              NULL);
+
+  g_assert (CLUTTER_IS_LAYOUT_MANAGER (manager));
+  g_assert (CLUTTER_IS_CONTAINER (container));
+  g_assert (CLUTTER_IS_ACTOR (actor1));
+  g_assert (CLUTTER_IS_ACTOR (actor2));
+  g_assert (clutter_actor_get_parent (CLUTTER_ACTOR (actor1)) == CLUTTER_ACTOR (container));
+
+  x_fill = FALSE;
+  y_align = CLUTTER_BOX_ALIGNMENT_START;
+  expand = FALSE;
+  clutter_layout_manager_child_get (CLUTTER_LAYOUT_MANAGER (manager),
+                                    CLUTTER_CONTAINER (container),
+                                    CLUTTER_ACTOR (actor1),
+                                    "x-fill", &x_fill,
+                                    "y-align", &y_align,
+                                    "expand", &expand,
+                                    NULL);
+
+  g_assert (x_fill);
+  g_assert (y_align == CLUTTER_BOX_ALIGNMENT_CENTER);
+  g_assert (expand);
+}
+
+void
+script_cache (TestConformSimpleFixture *fixture,
+              gconstpointer dummy G_GNUC_UNUSED)
+{
+  ClutterScript *script;
+  GError *error = NULL;
+  gchar *test_file, *cache_dir;
+  const gchar *cache_file;
+  GDir *dir;
+
+  test_file = clutter_test_get_data_file ("test-script-layout-property.json");
+  cache_dir = g_dir_make_tmp ("clutter-script-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  /* the first load parses the file and fills the cache */
+  script = clutter_script_new ();
+  clutter_script_set_cache_directory (script, cache_dir);
+  clutter_script_load_from_file (script, test_file, &error);
+  g_assert_no_error (error);
+  script_cache_check_layout (script);
+  g_object_unref (script);
+
+  dir = g_dir_open (cache_dir, 0, &error);
+  g_assert_no_error (error);
+  cache_file = g_dir_read_name (dir);
+  g_assert (cache_file != NULL && g_str_has_suffix (cache_file, ".cache"));
+  g_dir_close (dir);
+
+  /* the second load builds the same objects from the cache */
+  script = clutter_script_new ();
+  clutter_script_set_cache_directory (script, cache_dir);
+  clutter_script_load_from_file (script, test_file, &error);
+  g_assert_no_error (error);
+  script_cache_check_layout (script);
+  g_object_unref (script);
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  while ((cache_file = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *path = g_build_filename (cache_dir, cache_file, NULL);
+
+      g_unlink (path);
+      g_free (path);
+    }
+  g_dir_close (dir);
+  g_rmdir (cache_dir);
+
+  g_free (cache_dir);
+  g_free (test_file);
+}
+
+static void
+script_cache_write_file (const gchar *filename,
+                         gfloat       x,
+                         time_t       mtime)
+{
+  struct utimbuf times;
+  GError *error = NULL;
+  gchar *data;
+
+  data = g_strdup_printf ("[ { \"id\" : \"actor\", "
+                          "\"type\" : \"ClutterActor\", "
+                          "\"x\" : %.1f } ]",
+                          x);
+  g_file_set_contents (filename, data, -1, &error);
+  g_assert_no_error (error);
+  g_free (data);
+
+  times.actime = mtime;
+  times.modtime = mtime;
+  g_assert_cmpint (g_utime (filename, &times), ==, 0);
+}
+
+static gfloat
+script_cache_load_x (const gchar *filename,
+                     const gchar *cache_dir)
+{
+  ClutterScript *script;
+  GError *error = NULL;
+  GObject *actor;
+  gfloat x;
+
+  script = clutter_script_new ();
+  clutter_script_set_cache_directory (script, cache_dir);
+  clutter_script_load_from_file (script, filename, &error);
+  g_assert_no_error (error);
+
+  actor = clutter_script_get_object (script, "actor");
+  g_assert (CLUTTER_IS_ACTOR (actor));
+  x = clutter_actor_get_x (CLUTTER_ACTOR (actor));
+
+  g_object_unref (script);
+
+  return x;
+}
+
+void
+script_cache_modified (TestConformSimpleFixture *fixture,
+                       gconstpointer dummy G_GNUC_UNUSED)
+{
+  GError *error = NULL;
+  gchar *cache_dir, *filename;
+  const gchar *name;
+  time_t mtime;
+  GDir *dir;
+
+  cache_dir = g_dir_make_tmp ("clutter-script-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  filename = g_build_filename (cache_dir, "script.json", NULL);
+
+  /* a modification time after the cache is written, as if the file
+   * was edited again within the resolution of the timestamps
+   */
+  mtime = time (NULL) + 100;
+
+  script_cache_write_file (filename, 10.f, mtime);
+  g_assert_cmpfloat (script_cache_load_x (filename, cache_dir), ==, 10.f);
+  g_assert_cmpfloat (script_cache_load_x (filename, cache_dir), ==, 10.f);
+
+  /* same size and same modification time, different contents */
+  script_cache_write_file (filename, 20.f, mtime);
+  g_assert_cmpfloat (script_cache_load_x (filename, cache_dir), ==, 20.f);
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *path = g_build_filename (cache_dir, name, NULL);
+
+      g_unlink (path);
+      g_free (path);
+    }
+  g_dir_close (dir);
+  g_rmdir (cache_dir);
+
+  g_free (filename);
+  g_free (cache_dir);
+}
+
 void
 script_margin (TestConformSimpleFixture *fixture,
                gpointer                  dummy)
@@ -442,3 +624,59 @@ script_margin (TestConformSimpleFixture *fixture,
   g_object_unref (script);
   g_free (test_file);
 }
+
+void
+script_lazy (TestConformSimpleFixture *fixture,
+             gconstpointer             dummy)
+{
+  ClutterScript *script = clutter_script_new ();
+  GObject *container, *actor;
+  gboolean focus_ret;
+  gchar *test_file;
+  GError *error = NULL;
+
+  clutter_script_set_lazy_construction (script, TRUE);
+
+  test_group_n_instances = 0;
+
+  test_file = clutter_test_get_data_file ("test-script-child.json");
+  clutter_script_load_from_file (script, test_file, &error);
+  if (g_test_verbose () && error)
+    g_print ("Error: %s", error->message);
+
+  g_assert_no_error (error);
+
+  /* nothing has been requested yet */
+  g_assert_cmpuint (test_group_n_instances, ==, 0);
+
+  /* constructing a child does not construct its container */
+  actor = clutter_script_get_object (script, "test-rect-1");
+  g_assert (CLUTTER_IS_RECTANGLE (actor));
+  g_assert_cmpfloat (clutter_actor_get_width (CLUTTER_ACTOR (actor)), ==, 100.0f);
+  g_assert (clutter_actor_get_parent (CLUTTER_ACTOR (actor)) == NULL);
+  g_assert_cmpuint (test_group_n_instances, ==, 0);
+
+  container = clutter_script_get_object (script, "test-group");
+  g_assert (TEST_IS_GROUP (container));
+  g_assert_cmpuint (test_group_n_instances, ==, 1);
+
+  g_assert (clutter_actor_get_parent (CLUTTER_ACTOR (actor)) == CLUTTER_ACTOR (container));
+
+  focus_ret = FALSE;
+  clutter_container_child_get (CLUTTER_CONTAINER (container),
+                               CLUTTER_ACTOR (actor),
+                               "focus", &focus_ret,
+                               NULL);
+  g_assert (focus_ret);
+
+  /* the other child has been constructed along with its container */
+  actor = clutter_script_get_object (script, "test-rect-2");
+  g_assert (CLUTTER_IS_RECTANGLE (actor));
+  g_assert (clutter_actor_get_parent (CLUTTER_ACTOR (actor)) == CLUTTER_ACTOR (container));
+  g_assert_cmpfloat (clutter_actor_get_height (CLUTTER_ACTOR (actor)), ==, 100.0f);
+
+  g_assert_cmpuint (test_group_n_instances, ==, 1);
+
+  g_object_unref (script);
+  g_free (test_file);
+}
@@ -0,0 +1,241 @@
+#define CLUTTER_ENABLE_EXPERIMENTAL_API
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+#define STAGE_WIDTH     64
+#define STAGE_HEIGHT    48
+#define N_FRAMES        6
+
+typedef struct {
+  guint n_frames;
+  gint64 last_frame_time;
+  gboolean notified;
+} CaptureData;
+
+static void
+on_capture (ClutterStage              *stage,
+            const ClutterFrameCapture *frame,
+            gpointer                   user_data)
+{
+  CaptureData *data = user_data;
+  const guint32 *pixel;
+
+  if (g_test_verbose ())
+    g_print ("frame %u: area (%d, %d) %dx%d, damage (%d, %d) %dx%d\n",
+             data->n_frames,
+             frame->area.x, frame->area.y,
+             frame->area.width, frame->area.height,
+             frame->damage.x, frame->damage.y,
+             frame->damage.width, frame->damage.height);
+
+  /* the frames are delivered in order */
+  g_assert_cmpint (frame->frame_time, >=, data->last_frame_time);
+  data->last_frame_time = frame->frame_time;
+
+  g_assert_cmpint (frame->area.width, ==, STAGE_WIDTH);
+  g_assert_cmpint (frame->area.height, ==, STAGE_HEIGHT);
+  g_assert_cmpint (frame->stride, >=, frame->area.width * 4);
+  g_assert (frame->data != NULL);
+
+  /* the stage is cleared to opaque red */
+  pixel = (const guint32 *) (frame->data
+                             + (STAGE_HEIGHT / 2) * frame->stride
+                             + (STAGE_WIDTH / 2) * 4);
+  g_assert_cmphex (*pixel, ==, 0xffff0000);
+
+  data->n_frames += 1;
+
+  /* stopping the capture delivers the frames still pending */
+  if (data->n_frames == 1)
+    clutter_main_quit ();
+}
+
+static void
+on_capture_notify (gpointer user_data)
+{
+  CaptureData *data = user_data;
+
+  data->notified = TRUE;
+}
+
+void
+stage_capture (TestConformSimpleFixture *fixture,
+               gconstpointer             dummy)
+{
+  CaptureData data = { 0, };
+  ClutterActor *stage;
+
+  stage = clutter_stage_new ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_actor_set_background_color (stage, CLUTTER_COLOR_Red);
+
+  clutter_stage_set_capture_callback (CLUTTER_STAGE (stage),
+                                      FALSE,
+                                      on_capture,
+                                      &data,
+                                      on_capture_notify);
+
+  clutter_actor_show (stage);
+
+  /* the last frame is delivered once the stage stops painting */
+  clutter_main ();
+
+  g_assert_cmpuint (data.n_frames, >=, 1);
+  g_assert (!data.notified);
+
+  clutter_stage_set_capture_callback (CLUTTER_STAGE (stage),
+                                      FALSE,
+                                      NULL, NULL, NULL);
+  g_assert (data.notified);
+
+  clutter_actor_destroy (stage);
+}
+
+typedef struct {
+  ClutterActor *stage;
+  guint n_paints;
+  guint n_frames;
+  guint n_frames_at_stop;
+  gboolean stopping;
+  gboolean notified;
+} StopData;
+
+static void
+on_capture_stop_notify (gpointer user_data)
+{
+  StopData *data = user_data;
+
+  data->notified = TRUE;
+}
+
+static void
+on_capture_stop (ClutterStage              *stage,
+                 const ClutterFrameCapture *frame,
+                 gpointer                   user_data)
+{
+  StopData *data = user_data;
+
+  g_assert (!data->notified);
+  g_assert (frame->data != NULL);
+
+  data->n_frames += 1;
+
+  /* stopping the capture delivers the pending frames from within
+   * this callback, while the buffer of this frame is still mapped
+   */
+  if (data->stopping)
+    return;
+
+  data->stopping = TRUE;
+  clutter_stage_set_capture_callback (stage, FALSE, NULL, NULL, NULL);
+  g_assert (data->notified);
+
+  data->n_frames_at_stop = data->n_frames;
+}
+
+static gboolean
+on_paint_stop_capture (gpointer user_data)
+{
+  StopData *data = user_data;
+
+  /* the repaint functions run from the most recently added, so this
+   * runs before the one of the capture, which cannot be removed while
+   * the repaint functions are running
+   */
+  if (data->n_paints == 2)
+    {
+      data->stopping = TRUE;
+      clutter_stage_set_capture_callback (CLUTTER_STAGE (data->stage),
+                                          FALSE,
+                                          NULL, NULL, NULL);
+      g_assert (data->notified);
+
+      data->n_frames_at_stop = data->n_frames;
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+on_paint_count (gpointer user_data)
+{
+  StopData *data = user_data;
+
+  data->n_paints += 1;
+
+  if (data->n_paints == N_FRAMES)
+    {
+      clutter_main_quit ();
+      return FALSE;
+    }
+
+  clutter_actor_queue_redraw (data->stage);
+
+  return TRUE;
+}
+
+static void
+run_frames (StopData *data)
+{
+  data->n_paints = 0;
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_count,
+                                         data,
+                                         NULL);
+  clutter_actor_queue_redraw (data->stage);
+
+  clutter_main ();
+}
+
+void
+stage_capture_stop (TestConformSimpleFixture *fixture,
+                    gconstpointer             dummy)
+{
+  StopData data = { NULL, };
+
+  data.stage = clutter_stage_new ();
+  clutter_actor_set_size (data.stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_actor_show (data.stage);
+
+  /* the callback stops the capture */
+  clutter_stage_set_capture_callback (CLUTTER_STAGE (data.stage),
+                                      FALSE,
+                                      on_capture_stop,
+                                      &data,
+                                      on_capture_stop_notify);
+  run_frames (&data);
+
+  if (g_test_verbose ())
+    g_print ("stopped from the callback after %u frames\n",
+             data.n_frames_at_stop);
+
+  g_assert (data.notified);
+  g_assert_cmpuint (data.n_frames, >=, 1);
+  g_assert_cmpuint (data.n_frames, ==, data.n_frames_at_stop);
+
+  /* another repaint function stops the capture */
+  data.n_frames = 0;
+  data.n_frames_at_stop = 0;
+  data.stopping = FALSE;
+  data.notified = FALSE;
+
+  clutter_stage_set_capture_callback (CLUTTER_STAGE (data.stage),
+                                      FALSE,
+                                      on_capture_stop,
+                                      &data,
+                                      on_capture_stop_notify);
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_stop_capture,
+                                         &data,
+                                         NULL);
+  run_frames (&data);
+
+  g_assert (data.notified);
+  g_assert_cmpuint (data.n_frames, ==, data.n_frames_at_stop);
+
+  clutter_actor_destroy (data.stage);
+}
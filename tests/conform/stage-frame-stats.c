@@ -0,0 +1,190 @@
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+#define N_ACTORS        4
+#define N_FRAMES        3
+
+typedef struct {
+  ClutterActor *stage;
+  guint n_frames;
+} FrameStatsData;
+
+static gboolean
+on_paint_done (gpointer data)
+{
+  FrameStatsData *d = data;
+
+  d->n_frames += 1;
+
+  if (d->n_frames == N_FRAMES)
+    {
+      clutter_main_quit ();
+      return FALSE;
+    }
+
+  clutter_actor_queue_redraw (d->stage);
+
+  return TRUE;
+}
+
+void
+stage_frame_stats (TestConformSimpleFixture *fixture,
+                   gconstpointer             dummy)
+{
+  ClutterFrameStats stats[N_FRAMES + 1];
+  FrameStatsData data = { NULL, 0 };
+  guint i, n_stats;
+
+  data.stage = clutter_stage_new ();
+
+  /* a new stage has no statistics */
+  n_stats = clutter_stage_get_frame_stats (CLUTTER_STAGE (data.stage),
+                                           stats,
+                                           G_N_ELEMENTS (stats));
+  g_assert_cmpuint (n_stats, ==, 0);
+
+  for (i = 0; i < N_ACTORS; i++)
+    {
+      ClutterActor *actor = clutter_actor_new ();
+
+      clutter_actor_set_background_color (actor, CLUTTER_COLOR_Red);
+      clutter_actor_set_position (actor, i * 20, 0);
+      clutter_actor_set_size (actor, 10, 10);
+      clutter_actor_add_child (data.stage, actor);
+    }
+
+  clutter_actor_show (data.stage);
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_done,
+                                         &data,
+                                         NULL);
+
+  clutter_main ();
+
+  n_stats = clutter_stage_get_frame_stats (CLUTTER_STAGE (data.stage),
+                                           stats,
+                                           G_N_ELEMENTS (stats));
+  g_assert_cmpuint (n_stats, >, 0);
+
+  for (i = 0; i < n_stats; i++)
+    {
+      if (g_test_verbose ())
+        g_print ("frame %u: time %" G_GINT64_FORMAT ", "
+                 "paint %" G_GINT64_FORMAT " usecs, "
+                 "painted %u, culled %u\n",
+                 i,
+                 stats[i].frame_time,
+                 stats[i].paint,
+                 stats[i].n_actors_painted,
+                 stats[i].n_actors_culled);
+
+      /* the stage and its children are either painted or culled */
+      g_assert_cmpuint (stats[i].n_actors_painted + stats[i].n_actors_culled,
+                        >=,
+                        1);
+      g_assert_cmpint (stats[i].paint, >=, 0);
+
+      /* the frames are returned from the oldest */
+      if (i > 0)
+        g_assert_cmpint (stats[i].frame_time, >=, stats[i - 1].frame_time);
+    }
+
+  /* a full redraw paints every actor */
+  g_assert_cmpuint (stats[0].n_actors_painted, ==, N_ACTORS + 1);
+
+  /* asking for fewer frames returns the most recent ones */
+  n_stats = clutter_stage_get_frame_stats (CLUTTER_STAGE (data.stage),
+                                           stats,
+                                           1);
+  g_assert_cmpuint (n_stats, ==, 1);
+
+  clutter_actor_destroy (data.stage);
+}
+
+void
+stage_actor_costs (TestConformSimpleFixture *fixture,
+                   gconstpointer             dummy)
+{
+  ClutterActorCost costs[N_ACTORS + 2];
+  FrameStatsData data = { NULL, 0 };
+  ClutterActor *container;
+  guint i, n_costs;
+
+  data.stage = clutter_stage_new ();
+
+  /* the costs are not accounted by default */
+  g_assert (!clutter_stage_get_actor_costs_enabled (CLUTTER_STAGE (data.stage)));
+  clutter_stage_set_actor_costs_enabled (CLUTTER_STAGE (data.stage), TRUE);
+  g_assert (clutter_stage_get_actor_costs_enabled (CLUTTER_STAGE (data.stage)));
+
+  container = clutter_actor_new ();
+  clutter_actor_set_layout_manager (container,
+                                    clutter_box_layout_new ());
+  clutter_actor_add_child (data.stage, container);
+
+  for (i = 0; i < N_ACTORS; i++)
+    {
+      ClutterActor *actor = clutter_actor_new ();
+
+      clutter_actor_set_background_color (actor, CLUTTER_COLOR_Blue);
+      clutter_actor_set_size (actor, 10, 10);
+      clutter_actor_add_child (container, actor);
+    }
+
+  clutter_actor_show (data.stage);
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_done,
+                                         &data,
+                                         NULL);
+
+  clutter_main ();
+
+  n_costs = clutter_stage_get_actor_costs (CLUTTER_STAGE (data.stage),
+                                           costs,
+                                           G_N_ELEMENTS (costs));
+
+  /* at least the stage and the container have been painted */
+  g_assert_cmpuint (n_costs, >=, 2);
+
+  for (i = 0; i < n_costs; i++)
+    {
+      gint64 exclusive;
+
+      if (g_test_verbose ())
+        g_print ("actor %s: paint %" G_GINT64_FORMAT "/%" G_GINT64_FORMAT ", "
+                 "allocate %" G_GINT64_FORMAT "/%" G_GINT64_FORMAT " usecs\n",
+                 G_OBJECT_TYPE_NAME (costs[i].actor),
+                 costs[i].paint_exclusive,
+                 costs[i].paint_inclusive,
+                 costs[i].allocate_exclusive,
+                 costs[i].allocate_inclusive);
+
+      g_assert (CLUTTER_IS_ACTOR (costs[i].actor));
+      g_assert_cmpint (costs[i].paint_exclusive, <=, costs[i].paint_inclusive);
+      g_assert_cmpint (costs[i].allocate_exclusive, <=, costs[i].allocate_inclusive);
+      g_assert_cmpint (costs[i].preferred_size_exclusive, <=,
+                       costs[i].preferred_size_inclusive);
+
+      exclusive = costs[i].paint_exclusive
+                + costs[i].allocate_exclusive
+                + costs[i].preferred_size_exclusive;
+
+      /* the actors are sorted from the most expensive */
+      if (i > 0)
+        g_assert_cmpint (exclusive, <=,
+                         costs[i - 1].paint_exclusive
+                         + costs[i - 1].allocate_exclusive
+                         + costs[i - 1].preferred_size_exclusive);
+    }
+
+  clutter_stage_set_actor_costs_enabled (CLUTTER_STAGE (data.stage), FALSE);
+  n_costs = clutter_stage_get_actor_costs (CLUTTER_STAGE (data.stage),
+                                           costs,
+                                           G_N_ELEMENTS (costs));
+  g_assert_cmpuint (n_costs, ==, 0);
+
+  clutter_actor_destroy (data.stage);
+}
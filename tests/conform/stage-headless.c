@@ -0,0 +1,97 @@
+#include <clutter/clutter.h>
+
+#ifdef CLUTTER_WINDOWING_HEADLESS
+#include <clutter/headless/clutter-headless.h>
+#endif
+
+#include "test-conform-common.h"
+
+#define N_FRAMES        10
+
+typedef struct {
+  ClutterActor *stage;
+  guint n_frames;
+} RefreshRateData;
+
+static gboolean
+on_paint_done (gpointer user_data)
+{
+  RefreshRateData *data = user_data;
+
+  data->n_frames += 1;
+
+  if (data->n_frames == N_FRAMES)
+    {
+      clutter_main_quit ();
+      return FALSE;
+    }
+
+  clutter_actor_queue_redraw (data->stage);
+
+  return TRUE;
+}
+
+void
+stage_headless_refresh_rate (TestConformSimpleFixture *fixture,
+                             gconstpointer             dummy)
+{
+#ifdef CLUTTER_WINDOWING_HEADLESS
+  ClutterFrameStats stats[N_FRAMES];
+  RefreshRateData data = { NULL, 0 };
+  guint i, n_stats;
+
+  if (!clutter_check_windowing_backend (CLUTTER_WINDOWING_HEADLESS))
+    {
+      if (g_test_verbose ())
+        g_print ("Skipping the headless backend test\n");
+
+      return;
+    }
+
+  /* test-conform-main.c disables the emulated vertical blanking
+   * through the environment, unless it is already set
+   */
+  if (g_strcmp0 (g_getenv ("CLUTTER_HEADLESS_REFRESH_RATE"), "0") == 0)
+    g_assert_cmpfloat (clutter_headless_get_refresh_rate (), ==, 0.f);
+
+  clutter_headless_set_refresh_rate (30.f);
+  g_assert_cmpfloat (clutter_headless_get_refresh_rate (), ==, 30.f);
+
+  clutter_headless_set_refresh_rate (0.f);
+  g_assert_cmpfloat (clutter_headless_get_refresh_rate (), ==, 0.f);
+
+  data.stage = clutter_stage_new ();
+  clutter_actor_show (data.stage);
+
+  /* without a refresh rate each frame is presented as soon as it has
+   * been drawn; the stage would stop drawing if it was not
+   */
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_done,
+                                         &data,
+                                         NULL);
+
+  clutter_main ();
+
+  g_assert_cmpuint (data.n_frames, ==, N_FRAMES);
+
+  n_stats = clutter_stage_get_frame_stats (CLUTTER_STAGE (data.stage),
+                                           stats,
+                                           G_N_ELEMENTS (stats));
+  g_assert_cmpuint (n_stats, >, 0);
+
+  for (i = 0; i < n_stats; i++)
+    {
+      if (g_test_verbose ())
+        g_print ("frame %u: time %" G_GINT64_FORMAT ", "
+                 "swap %" G_GINT64_FORMAT " usecs\n",
+                 i,
+                 stats[i].frame_time,
+                 stats[i].swap);
+
+      g_assert_cmpint (stats[i].swap, >=, 0);
+    }
+
+  clutter_actor_destroy (data.stage);
+#endif /* CLUTTER_WINDOWING_HEADLESS */
+}
@@ -105,6 +105,11 @@ clutter_test_init (gint    *argc,
    */
   g_setenv ("CLUTTER_VBLANK", "none", FALSE);
 
+  /* For the same reason, the headless backend does not emulate the
+   * refresh rate of an output.
+   */
+  g_setenv ("CLUTTER_HEADLESS_REFRESH_RATE", "0", FALSE);
+
   g_test_init (argc, argv, NULL);
 
   g_test_bug_base ("http://bugzilla.gnome.org/show_bug.cgi?id=%s");
@@ -146,6 +151,7 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/actor", actor_margin_layout);
   TEST_CONFORM_SIMPLE ("/actor", actor_offscreen_redirect);
   TEST_CONFORM_SIMPLE ("/actor", actor_shader_effect);
+  TEST_CONFORM_SIMPLE ("/actor", actor_fast_transitions);
 
   TEST_CONFORM_SIMPLE ("/actor/iter", actor_iter_traverse_children);
   TEST_CONFORM_SIMPLE ("/actor/iter", actor_iter_traverse_remove);
@@ -168,6 +174,13 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/actor/opacity", opacity_rectangle);
   TEST_CONFORM_SIMPLE ("/actor/opacity", opacity_paint);
 
+  TEST_CONFORM_SIMPLE ("/stage", stage_frame_stats);
+  TEST_CONFORM_SIMPLE ("/stage", stage_headless_refresh_rate);
+  TEST_CONFORM_SIMPLE ("/stage", stage_actor_costs);
+  TEST_CONFORM_SIMPLE ("/stage", input_replay);
+  TEST_CONFORM_SIMPLE ("/stage", stage_capture);
+  TEST_CONFORM_SIMPLE ("/stage", stage_capture_stop);
+
   TEST_CONFORM_SIMPLE ("/text", text_utf8_validation);
   TEST_CONFORM_SIMPLE ("/text", text_set_empty);
   TEST_CONFORM_SIMPLE ("/text", text_set_text);
@@ -176,10 +189,20 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/text", text_insert);
   TEST_CONFORM_SIMPLE ("/text", text_delete_chars);
   TEST_CONFORM_SIMPLE ("/text", text_delete_text);
+  TEST_CONFORM_SIMPLE ("/text", text_buffer_edits);
+  TEST_CONFORM_SIMPLE ("/text", text_paragraphs);
+  TEST_CONFORM_SIMPLE ("/text", text_lazy_layout);
+  TEST_CONFORM_SIMPLE ("/text", text_lazy_layout_visible);
+  TEST_CONFORM_SIMPLE ("/text", text_async_layout);
+  TEST_CONFORM_SIMPLE ("/text", text_async_layout_shaped);
+  TEST_CONFORM_SIMPLE ("/text", text_async_layout_idle);
   TEST_CONFORM_SIMPLE ("/text", text_cursor);
+  TEST_CONFORM_SIMPLE ("/text", text_lazy_layout_cursor);
   TEST_CONFORM_SIMPLE ("/text", text_event);
   TEST_CONFORM_SIMPLE ("/text", text_get_chars);
   TEST_CONFORM_SIMPLE ("/text", text_cache);
+  TEST_CONFORM_SIMPLE ("/text", text_shared_layouts);
+  TEST_CONFORM_SIMPLE ("/text", text_shared_layouts_eviction);
   TEST_CONFORM_SIMPLE ("/text", text_password_char);
   TEST_CONFORM_SIMPLE ("/text", text_idempotent_use_markup);
 
@@ -227,6 +250,11 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/script", animator_multi_properties);
   TEST_CONFORM_SIMPLE ("/script", state_base);
   TEST_CONFORM_SIMPLE ("/script", script_margin);
+  TEST_CONFORM_SIMPLE ("/script", script_cache);
+  TEST_CONFORM_SIMPLE ("/script", script_cache_modified);
+  TEST_CONFORM_SIMPLE ("/script", script_lazy);
+
+  TEST_CONFORM_SIMPLE ("/trace", trace_frames);
 
   TEST_CONFORM_SIMPLE ("/timeline", timeline_base);
   TEST_CONFORM_SIMPLE ("/timeline", timeline_markers_from_script);
@@ -234,6 +262,9 @@ main (int argc, char **argv)
   TEST_CONFORM_SKIP (g_test_slow (), "/timeline", timeline_rewind);
   TEST_CONFORM_SIMPLE ("/timeline", timeline_progress_mode);
   TEST_CONFORM_SIMPLE ("/timeline", timeline_progress_step);
+  TEST_CONFORM_SIMPLE ("/timeline", timeline_progress_sampled);
+  TEST_CONFORM_SIMPLE ("/timeline", transition_batch);
+  TEST_CONFORM_SIMPLE ("/timeline", transition_batch_sampled);
 
   TEST_CONFORM_SIMPLE ("/score", score_base);
 
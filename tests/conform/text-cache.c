@@ -295,3 +295,140 @@ text_cache (void)
     g_assert (data.test_failed != TRUE);
 }
 
+static ClutterActor *
+make_shared_label (ClutterActor *stage,
+                   const gchar  *contents)
+{
+  ClutterActor *label = clutter_text_new_with_text (TEST_FONT, contents);
+
+  /* the stage owns the label, and destroys it along with itself */
+  clutter_actor_add_child (stage, label);
+
+  /* shapes the layout outside of a relayout, through the shared cache */
+  clutter_actor_get_preferred_width (label, -1, NULL, NULL);
+
+  return label;
+}
+
+void
+text_shared_layouts (void)
+{
+  const gchar *contents = "A label shown by more than one actor";
+  ClutterActor *stage = clutter_stage_new ();
+  ClutterActor *first, *second, *third;
+  PangoLayout *first_layout, *second_layout;
+  guint hits, misses, n_hits, n_misses;
+
+  clutter_text_get_shared_layout_stats (NULL, NULL, &hits, &misses);
+
+  /* the second actor finds the layout of the first one */
+  first = make_shared_label (stage, contents);
+  clutter_text_get_shared_layout_stats (NULL, NULL, &n_hits, &n_misses);
+  g_assert_cmpuint (n_misses, ==, misses + 1);
+  g_assert_cmpuint (n_hits, ==, hits);
+
+  second = make_shared_label (stage, contents);
+  clutter_text_get_shared_layout_stats (NULL, NULL, &n_hits, &n_misses);
+  g_assert_cmpuint (n_misses, ==, misses + 1);
+  g_assert_cmpuint (n_hits, ==, hits + 1);
+
+  /* the public getter never returns a shared layout, so changing it
+   * does not affect the other actors
+   */
+  first_layout = clutter_text_get_layout (CLUTTER_TEXT (first));
+  second_layout = clutter_text_get_layout (CLUTTER_TEXT (second));
+  g_assert (first_layout != second_layout);
+
+  g_assert (clutter_text_get_layout (CLUTTER_TEXT (first)) == first_layout);
+
+  pango_layout_set_text (first_layout, "Changed", -1);
+  g_assert_cmpstr (pango_layout_get_text (second_layout), ==, contents);
+
+  /* nor the layouts in the cache */
+  clutter_text_get_shared_layout_stats (NULL, NULL, &hits, &misses);
+  third = make_shared_label (stage, contents);
+  clutter_text_get_shared_layout_stats (NULL, NULL, &n_hits, &n_misses);
+  g_assert_cmpuint (n_hits, ==, hits + 1);
+  g_assert_cmpuint (n_misses, ==, misses);
+  g_assert_cmpstr (pango_layout_get_text (clutter_text_get_layout (CLUTTER_TEXT (third))),
+                   ==,
+                   contents);
+
+  clutter_actor_destroy (stage);
+}
+
+#define EVICTION_TEXT_LENGTH    16000
+#define EVICTION_MAX_LABELS     64
+
+static gchar *
+make_eviction_text (gint i)
+{
+  GString *str = g_string_new (NULL);
+
+  g_string_printf (str, "Label %d:", i);
+  while (str->len < EVICTION_TEXT_LENGTH)
+    g_string_append (str, " lorem ipsum");
+
+  return g_string_free (str, FALSE);
+}
+
+void
+text_shared_layouts_eviction (void)
+{
+  ClutterActor *stage = clutter_stage_new ();
+  guint n_layouts, prev_n_layouts = 0;
+  guint hits, misses, n_hits, n_misses;
+  gsize size, max_size = 0;
+  gchar *contents;
+  gint i, last;
+
+  /* large labels fill the cache in a few steps, after which adding a
+   * layout evicts the least recently used ones
+   */
+  for (i = 0; i < EVICTION_MAX_LABELS; i++)
+    {
+      contents = make_eviction_text (i);
+      make_shared_label (stage, contents);
+      g_free (contents);
+
+      clutter_text_get_shared_layout_stats (&n_layouts, &size, NULL, NULL);
+
+      if (g_test_verbose ())
+        g_print ("label %d: %u layouts, %" G_GSIZE_FORMAT " bytes\n",
+                 i, n_layouts, size);
+
+      if (i > 0 && n_layouts <= prev_n_layouts)
+        break;
+
+      prev_n_layouts = n_layouts;
+      max_size = MAX (max_size, size);
+    }
+
+  g_assert_cmpint (i, <, EVICTION_MAX_LABELS);
+  last = i;
+
+  /* evicting keeps the cache within the size it had when it was full */
+  g_assert_cmpuint (size, <=, max_size);
+
+  clutter_text_get_shared_layout_stats (NULL, NULL, &hits, &misses);
+
+  /* the most recent label is still in the cache */
+  contents = make_eviction_text (last);
+  make_shared_label (stage, contents);
+  g_free (contents);
+
+  clutter_text_get_shared_layout_stats (NULL, NULL, &n_hits, &n_misses);
+  g_assert_cmpuint (n_hits, ==, hits + 1);
+  g_assert_cmpuint (n_misses, ==, misses);
+
+  /* while the first one was evicted */
+  contents = make_eviction_text (0);
+  make_shared_label (stage, contents);
+  g_free (contents);
+
+  clutter_text_get_shared_layout_stats (NULL, NULL, &n_hits, &n_misses);
+  g_assert_cmpuint (n_hits, ==, hits + 1);
+  g_assert_cmpuint (n_misses, ==, misses + 1);
+
+  clutter_actor_destroy (stage);
+}
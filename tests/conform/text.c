@@ -282,6 +282,586 @@ text_delete_text (void)
   clutter_actor_destroy (CLUTTER_ACTOR (text));
 }
 
+void
+text_buffer_edits (void)
+{
+  ClutterTextBuffer *buffer = clutter_text_buffer_new ();
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new_with_buffer (buffer));
+  GString *expected = g_string_new (NULL);
+  GRand *rand = g_rand_new_with_seed (42);
+  int i;
+
+  /* mix edits at random positions, spanning more than one
+   * entry of the offset index of the buffer
+   */
+  for (i = 0; i < 2000; i++)
+    {
+      const TestData *t = &test_text_data[i % G_N_ELEMENTS (test_text_data)];
+      guint n_chars = g_utf8_strlen (expected->str, -1);
+      guint position = g_rand_int_range (rand, 0, n_chars + 1);
+
+      if (n_chars > 0 && g_rand_int_range (rand, 0, 3) == 0)
+        {
+          guint len = g_rand_int_range (rand, 1, MIN (n_chars - position, 8) + 2);
+          gchar *start, *end;
+
+          len = clutter_text_buffer_delete_text (buffer, position, len);
+
+          start = g_utf8_offset_to_pointer (expected->str, position);
+          end = g_utf8_offset_to_pointer (start, len);
+          g_string_erase (expected, start - expected->str, end - start);
+        }
+      else
+        {
+          gchar *chars = g_strdup_printf ("%sx%s", t->bytes, t->bytes);
+          gchar *at;
+
+          clutter_text_buffer_insert_text (buffer, position, chars, 3);
+
+          at = g_utf8_offset_to_pointer (expected->str, position);
+          g_string_insert (expected, at - expected->str, chars);
+
+          g_free (chars);
+        }
+
+      if (i % 50 == 0)
+        {
+          gchar *chars;
+
+          /* laying out the text copies the contents around the gap,
+           * before retrieving them moves the gap to the end
+           */
+          g_assert_cmpstr (pango_layout_get_text (clutter_text_get_layout (text)),
+                           ==,
+                           expected->str);
+
+          g_assert_cmpstr (clutter_text_buffer_get_text (buffer), ==, expected->str);
+          g_assert_cmpint (clutter_text_buffer_get_bytes (buffer), ==, expected->len);
+
+          n_chars = g_utf8_strlen (expected->str, -1);
+          g_assert_cmpint (clutter_text_buffer_get_length (buffer), ==, n_chars);
+
+          position = g_rand_int_range (rand, 0, n_chars + 1);
+          chars = clutter_text_get_chars (text, position, n_chars);
+          g_assert_cmpstr (chars, ==, g_utf8_offset_to_pointer (expected->str, position));
+          g_free (chars);
+        }
+    }
+
+  g_assert_cmpstr (clutter_text_buffer_get_text (buffer), ==, expected->str);
+
+  g_rand_free (rand);
+  g_string_free (expected, TRUE);
+  clutter_actor_destroy (CLUTTER_ACTOR (text));
+  g_object_unref (buffer);
+}
+
+static void
+check_paragraph_coords_at (ClutterText *text,
+                           guint        position)
+{
+  PangoLayout *layout = clutter_text_get_layout (text);
+  const gchar *contents = clutter_text_get_text (text);
+  PangoRectangle rect;
+  gfloat x, y, line_height;
+  gint index_;
+
+  index_ = g_utf8_offset_to_pointer (contents, position) - contents;
+  pango_layout_get_cursor_pos (layout, index_, &rect, NULL);
+
+  g_assert (clutter_text_position_to_coords (text, position,
+                                             &x, &y,
+                                             &line_height));
+
+  g_assert_cmpfloat (x, ==, rect.x / 1024.0f);
+  g_assert_cmpfloat (y, ==, rect.y / 1024.0f);
+  g_assert_cmpfloat (line_height, ==, rect.height / 1024.0f);
+
+  g_assert_cmpint (clutter_text_coords_to_position (text, x + 1, y + 1),
+                   ==,
+                   index_);
+}
+
+static void
+check_paragraph_coords (ClutterText *text)
+{
+  guint n_chars = g_utf8_strlen (clutter_text_get_text (text), -1);
+  guint position;
+
+  for (position = 0; position <= n_chars; position += 7)
+    check_paragraph_coords_at (text, position);
+}
+
+void
+text_paragraphs (void)
+{
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new ());
+  GString *contents = g_string_new (NULL);
+  int i;
+
+  /* enough paragraphs to lay them out one at a time */
+  for (i = 0; i < 64; i++)
+    g_string_append_printf (contents, "Paragraph %d, long enough to wrap "
+                                      "over more than one line\n", i);
+
+  clutter_text_set_editable (text, TRUE);
+  clutter_text_set_line_wrap (text, TRUE);
+  clutter_text_set_text (text, contents->str);
+  clutter_actor_set_size (CLUTTER_ACTOR (text), 200, 2000);
+
+  check_paragraph_coords (text);
+
+  /* splitting and merging paragraphs */
+  clutter_text_insert_text (text, "one\ntwo\nthree", 40);
+  check_paragraph_coords (text);
+
+  clutter_text_delete_text (text, 30, 120);
+  check_paragraph_coords (text);
+
+  clutter_text_insert_text (text, "appended", -1);
+  check_paragraph_coords (text);
+
+  g_string_free (contents, TRUE);
+  clutter_actor_destroy (CLUTTER_ACTOR (text));
+}
+
+void
+text_lazy_layout (void)
+{
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new ());
+  GString *contents = g_string_new (NULL);
+  guint n_paragraphs, n_shaped, n_shapes;
+  gfloat x, y, line_height;
+  gint position;
+  int i;
+
+  clutter_text_set_lazy_layout (text, TRUE);
+  g_assert (clutter_text_get_lazy_layout (text));
+
+  clutter_actor_set_size (CLUTTER_ACTOR (text), 400, 200);
+
+  /* streaming contents, one line at a time */
+  for (i = 0; i < 1000; i++)
+    {
+      gchar *line = g_strdup_printf ("line %d\n", i);
+
+      clutter_text_append_text (text, line, -1);
+      g_string_append (contents, line);
+
+      g_free (line);
+    }
+
+  clutter_text_append_text (text, "partial", 4);
+  g_string_append (contents, "part");
+
+  g_assert_cmpstr (clutter_text_get_text (text), ==, contents->str);
+
+  /* the first paragraph is laid out like the whole contents */
+  check_paragraph_coords_at (text, 3);
+
+  /* only the paragraph that has been queried is shaped */
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_paragraphs, ==, 1001);
+  g_assert_cmpuint (n_shaped, ==, 1);
+  g_assert_cmpuint (n_shapes, ==, 1);
+
+  /* positions far from the visible area still round-trip */
+  position = g_utf8_strlen (contents->str, -1) - 2;
+  g_assert (clutter_text_position_to_coords (text, position,
+                                             &x, &y,
+                                             &line_height));
+  g_assert_cmpfloat (y, >, 0);
+  g_assert_cmpint (clutter_text_coords_to_position (text, x + 1, y + 1),
+                   ==,
+                   g_utf8_offset_to_pointer (contents->str, position) - contents->str);
+
+  clutter_text_get_paragraph_stats (text, NULL, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_shaped, ==, 2);
+  g_assert_cmpuint (n_shapes, ==, 2);
+
+  /* appending to the last paragraph only drops its layout */
+  clutter_text_append_text (text, "ial", -1);
+  g_string_append (contents, "ial");
+
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_paragraphs, ==, 1001);
+  g_assert_cmpuint (n_shaped, ==, 1);
+  g_assert_cmpuint (n_shapes, ==, 2);
+
+  /* and only the last paragraph is shaped again */
+  check_paragraph_coords_at (text, 3);
+  g_assert (clutter_text_position_to_coords (text, -1, &x, &y, NULL));
+
+  clutter_text_get_paragraph_stats (text, NULL, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_shaped, ==, 2);
+  g_assert_cmpuint (n_shapes, ==, 3);
+
+  /* a newline splits the last paragraph */
+  clutter_text_append_text (text, "\nline 1001", -1);
+  g_string_append (contents, "\nline 1001");
+
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_paragraphs, ==, 1002);
+  g_assert_cmpuint (n_shaped, ==, 1);
+  g_assert_cmpuint (n_shapes, ==, 3);
+
+  g_assert (clutter_text_position_to_coords (text, -1, &x, &y, NULL));
+
+  clutter_text_get_paragraph_stats (text, NULL, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_shaped, ==, 2);
+  g_assert_cmpuint (n_shapes, ==, 4);
+
+  g_string_free (contents, TRUE);
+  clutter_actor_destroy (CLUTTER_ACTOR (text));
+}
+
+void
+text_async_layout (void)
+{
+  ClutterActor *text = clutter_text_new_with_text ("Sans 12px", "Hello");
+  ClutterActor *sync_text = clutter_text_new_with_text ("Sans 12px", "Hello");
+  PangoLayout *layout;
+  gfloat width, sync_width;
+
+  clutter_text_set_async_layout (CLUTTER_TEXT (text), TRUE);
+  g_assert (clutter_text_get_async_layout (CLUTTER_TEXT (text)));
+
+  clutter_text_set_text (CLUTTER_TEXT (text), "Hello, world");
+  clutter_text_set_text (CLUTTER_TEXT (sync_text), "Hello, world");
+
+  /* outside of the paint cycle the contents are shaped synchronously */
+  layout = clutter_text_get_layout (CLUTTER_TEXT (text));
+  g_assert_cmpstr (pango_layout_get_text (layout), ==, "Hello, world");
+
+  clutter_actor_get_preferred_width (text, -1, NULL, &width);
+  clutter_actor_get_preferred_width (sync_text, -1, NULL, &sync_width);
+  g_assert_cmpfloat (width, ==, sync_width);
+
+  clutter_actor_destroy (text);
+  clutter_actor_destroy (sync_text);
+}
+
+#define ASYNC_MAX_FRAMES        1000
+
+typedef struct {
+  ClutterActor *stage;
+  ClutterActor *text;
+
+  /* the allocation of the text at the last relayout */
+  gfloat width;
+  gfloat height;
+
+  /* the width of the text before the contents changed */
+  gfloat initial_width;
+
+  /* the smallest and largest width allocated before the end */
+  gfloat min_width;
+  gfloat max_width;
+
+  guint n_frames;
+
+  /* the contents to set after the first frame, while the previous
+   * contents are being shaped
+   */
+  const gchar *next_text;
+
+  gboolean (* done) (gpointer data);
+} AsyncLayoutData;
+
+static void
+on_async_allocation_changed (ClutterActor           *actor,
+                             const ClutterActorBox  *box,
+                             ClutterAllocationFlags  flags,
+                             AsyncLayoutData        *data)
+{
+  data->width = clutter_actor_box_get_width (box);
+  data->height = clutter_actor_box_get_height (box);
+}
+
+static gboolean
+on_async_frame (gpointer user_data)
+{
+  AsyncLayoutData *data = user_data;
+
+  data->n_frames += 1;
+
+  if (data->done (data) || data->n_frames == ASYNC_MAX_FRAMES)
+    {
+      clutter_main_quit ();
+      return FALSE;
+    }
+
+  data->min_width = MIN (data->min_width, data->width);
+  data->max_width = MAX (data->max_width, data->width);
+
+  if (data->n_frames == 1 && data->next_text != NULL)
+    clutter_text_set_text (CLUTTER_TEXT (data->text), data->next_text);
+
+  clutter_actor_queue_redraw (data->stage);
+
+  return TRUE;
+}
+
+static void
+run_async_layout (AsyncLayoutData *data,
+                  const gchar     *contents,
+                  const gchar     *next_text,
+                  gboolean       (* done) (gpointer data))
+{
+  data->n_frames = 0;
+  data->initial_width = data->width;
+  data->min_width = G_MAXFLOAT;
+  data->max_width = 0;
+  data->next_text = next_text;
+  data->done = done;
+
+  clutter_text_set_text (CLUTTER_TEXT (data->text), contents);
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_async_frame,
+                                         data,
+                                         NULL);
+  clutter_actor_queue_redraw (data->stage);
+
+  clutter_main ();
+
+  if (g_test_verbose ())
+    g_print ("async layout: %.0fx%.0f after %u frames\n",
+             data->width, data->height,
+             data->n_frames);
+
+  g_assert_cmpuint (data->n_frames, <, ASYNC_MAX_FRAMES);
+}
+
+static void
+check_async_layout_size (AsyncLayoutData *data,
+                         const gchar     *contents)
+{
+  ClutterActor *sync_text;
+  gfloat width, height;
+
+  sync_text = clutter_text_new_with_text ("Sans 12px", contents);
+  clutter_actor_get_preferred_size (sync_text, NULL, NULL, &width, &height);
+
+  g_assert_cmpfloat (data->width, ==, width);
+  g_assert_cmpfloat (data->height, ==, height);
+
+  clutter_actor_destroy (sync_text);
+}
+
+static gboolean
+async_layout_has_contents (gpointer user_data)
+{
+  AsyncLayoutData *data = user_data;
+
+  /* the placeholder shown until the first layout arrives is empty */
+  return data->width > 0;
+}
+
+static gboolean
+async_layout_shrunk (gpointer user_data)
+{
+  AsyncLayoutData *data = user_data;
+
+  /* the most recent contents are shorter than the previous ones */
+  return data->width > 0 && data->width < data->initial_width;
+}
+
+void
+text_async_layout_shaped (void)
+{
+  const gchar *first = "The layout of this text is shaped in a worker thread";
+  const gchar *second = "The layout of this text is shaped in a worker thread, "
+                        "and replaced before it arrives";
+  const gchar *third = "Replaced";
+  AsyncLayoutData data = { NULL, };
+  gfloat first_width;
+
+  data.stage = clutter_stage_new ();
+  clutter_actor_show (data.stage);
+
+  data.text = clutter_text_new_with_text ("Sans 12px", NULL);
+  clutter_text_set_async_layout (CLUTTER_TEXT (data.text), TRUE);
+  g_signal_connect (data.text, "allocation-changed",
+                    G_CALLBACK (on_async_allocation_changed),
+                    &data);
+  clutter_actor_add_child (data.stage, data.text);
+
+  /* the stage allocates the placeholder, then the shaped layout */
+  run_async_layout (&data, first, NULL, async_layout_has_contents);
+
+  g_assert_cmpfloat (data.min_width, ==, 0);
+  check_async_layout_size (&data, first);
+  first_width = data.width;
+
+  /* the contents change again while the previous ones are being
+   * shaped; the outdated layout can be shown, but the first contents
+   * are shown until then, and the final size is the one of the most
+   * recent contents
+   */
+  run_async_layout (&data, second, third, async_layout_shrunk);
+
+  g_assert_cmpfloat (data.min_width, >=, first_width);
+  check_async_layout_size (&data, third);
+
+  clutter_actor_destroy (data.stage);
+}
+
+static void
+on_idle_allocation_changed (ClutterActor           *actor,
+                            const ClutterActorBox  *box,
+                            ClutterAllocationFlags  flags,
+                            AsyncLayoutData        *data)
+{
+  on_async_allocation_changed (actor, box, flags, data);
+
+  if (data->width > 0)
+    clutter_main_quit ();
+}
+
+static gboolean
+on_idle_timeout (gpointer user_data)
+{
+  AsyncLayoutData *data = user_data;
+
+  data->n_frames = ASYNC_MAX_FRAMES;
+  clutter_main_quit ();
+
+  return FALSE;
+}
+
+void
+text_async_layout_idle (void)
+{
+  const gchar *contents = "The layout of this text is shaped while the stage is idle";
+  AsyncLayoutData data = { NULL, };
+  guint timeout_id;
+
+  data.stage = clutter_stage_new ();
+  clutter_actor_show (data.stage);
+
+  data.text = clutter_text_new_with_text ("Sans 12px", NULL);
+  clutter_text_set_async_layout (CLUTTER_TEXT (data.text), TRUE);
+  clutter_actor_add_child (data.stage, data.text);
+
+  g_signal_connect (data.text, "allocation-changed",
+                    G_CALLBACK (on_idle_allocation_changed),
+                    &data);
+
+  /* nothing else redraws the stage: the frame allocating the
+   * placeholder queues the job, and the shaped layout must wake up
+   * the main loop on its own
+   */
+  clutter_text_set_text (CLUTTER_TEXT (data.text), contents);
+
+  timeout_id = g_timeout_add (5000, on_idle_timeout, &data);
+
+  clutter_main ();
+
+  if (data.n_frames != ASYNC_MAX_FRAMES)
+    g_source_remove (timeout_id);
+
+  if (g_test_verbose ())
+    g_print ("async layout: %.0fx%.0f without redraws\n",
+             data.width, data.height);
+
+  g_assert_cmpuint (data.n_frames, <, ASYNC_MAX_FRAMES);
+  check_async_layout_size (&data, contents);
+
+  clutter_actor_destroy (data.stage);
+}
+
+static gboolean
+on_lazy_frame (gpointer data)
+{
+  clutter_main_quit ();
+
+  return FALSE;
+}
+
+static void
+paint_lazy_frame (ClutterActor *stage)
+{
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_lazy_frame,
+                                         NULL,
+                                         NULL);
+  clutter_actor_queue_redraw (stage);
+
+  clutter_main ();
+}
+
+void
+text_lazy_layout_visible (void)
+{
+  ClutterActor *stage = clutter_stage_new ();
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new ());
+  guint n_paragraphs, n_shaped, n_shapes, n_visible;
+  int i;
+
+  clutter_text_set_font_name (text, "Sans 12px");
+  clutter_text_set_lazy_layout (text, TRUE);
+
+  /* the paint is limited to the allocation of the text */
+  clutter_actor_set_size (CLUTTER_ACTOR (text), 400, 200);
+  clutter_actor_add_child (stage, CLUTTER_ACTOR (text));
+  clutter_actor_show (stage);
+
+  for (i = 0; i < 1000; i++)
+    {
+      gchar *line = g_strdup_printf ("line %d\n", i);
+
+      clutter_text_append_text (text, line, -1);
+
+      g_free (line);
+    }
+
+  paint_lazy_frame (stage);
+
+  /* only the visible paragraphs, and the ones surrounding them, are
+   * shaped; a paragraph is at least 12 pixels high, so about 20 of
+   * them are visible
+   */
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+
+  if (g_test_verbose ())
+    g_print ("lazy layout: %u of %u paragraphs shaped\n",
+             n_shaped, n_paragraphs);
+
+  g_assert_cmpuint (n_paragraphs, ==, 1001);
+  g_assert_cmpuint (n_shaped, >, 0);
+  g_assert_cmpuint (n_shaped, <, 50);
+  g_assert_cmpuint (n_shapes, ==, n_shaped);
+
+  n_visible = n_shaped;
+
+  /* appending outside of the visible area does not shape anything */
+  for (i = 0; i < 10; i++)
+    clutter_text_append_text (text, "appended line\n", -1);
+
+  paint_lazy_frame (stage);
+
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_paragraphs, ==, 1011);
+  g_assert_cmpuint (n_shaped, ==, n_visible);
+  g_assert_cmpuint (n_shapes, ==, n_visible);
+
+  /* painting a selection spanning all the contents only shapes the
+   * visible paragraphs as well
+   */
+  clutter_text_set_editable (text, TRUE);
+  clutter_stage_set_key_focus (CLUTTER_STAGE (stage), CLUTTER_ACTOR (text));
+  clutter_text_set_selection (text, 0, -1);
+
+  paint_lazy_frame (stage);
+
+  clutter_text_get_paragraph_stats (text, &n_paragraphs, &n_shaped, &n_shapes);
+  g_assert_cmpuint (n_shaped, ==, n_visible);
+  g_assert_cmpuint (n_shapes, ==, n_visible);
+
+  clutter_actor_destroy (stage);
+}
+
 void
 text_password_char (void)
 {
@@ -385,6 +965,62 @@ text_cursor (void)
   clutter_actor_destroy (CLUTTER_ACTOR (text));
 }
 
+void
+text_lazy_layout_cursor (void)
+{
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new ());
+  guint n_shaped;
+  gint line_499, line_500, line_501;
+  int i;
+
+  clutter_text_set_editable (text, TRUE);
+  clutter_text_set_lazy_layout (text, TRUE);
+  clutter_actor_set_size (CLUTTER_ACTOR (text), 400, 200);
+
+  for (i = 0; i < 1000; i++)
+    {
+      gchar *line = g_strdup_printf ("line %d\n", i);
+
+      clutter_text_append_text (text, line, -1);
+
+      g_free (line);
+    }
+
+  /* "line N\n" is 7 characters long below 10, 8 below 100, and 9
+   * below 1000
+   */
+  line_499 = 10 * 7 + 90 * 8 + 399 * 9;
+  line_500 = line_499 + 9;
+  line_501 = line_500 + 9;
+
+  clutter_text_set_cursor_position (text, line_500 + 2);
+
+  /* moving between lines crosses the paragraph boundaries */
+  send_keyval (text, CLUTTER_KEY_Down);
+  g_assert_cmpint (clutter_text_get_cursor_position (text), ==, line_501 + 2);
+
+  send_keyval (text, CLUTTER_KEY_Up);
+  send_keyval (text, CLUTTER_KEY_Up);
+  g_assert_cmpint (clutter_text_get_cursor_position (text), ==, line_499 + 2);
+
+  send_keyval (text, CLUTTER_KEY_End);
+  g_assert_cmpint (clutter_text_get_cursor_position (text), ==, line_499 + 8);
+
+  send_keyval (text, CLUTTER_KEY_Home);
+  g_assert_cmpint (clutter_text_get_cursor_position (text), ==, line_499);
+
+  /* only the paragraphs around the cursor have been shaped */
+  clutter_text_get_paragraph_stats (text, NULL, &n_shaped, NULL);
+
+  if (g_test_verbose ())
+    g_print ("lazy cursor: %u paragraphs shaped\n", n_shaped);
+
+  g_assert_cmpuint (n_shaped, >, 0);
+  g_assert_cmpuint (n_shaped, <=, 3);
+
+  clutter_actor_destroy (CLUTTER_ACTOR (text));
+}
+
 void
 text_event (void)
 {
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <glib.h>
 #include <clutter/clutter.h>
 #include "test-conform-common.h"
@@ -108,3 +109,76 @@ timeline_progress_mode (TestConformSimpleFixture *fixture G_GNUC_UNUSED,
 
   g_object_unref (timeline);
 }
+
+static gdouble
+timeline_progress_error (ClutterTimeline *timeline)
+{
+  gdouble max_error = 0.0;
+  guint i;
+
+  for (i = 0; i <= 1000; i++)
+    {
+      gdouble analytic, sampled;
+
+      clutter_timeline_advance (timeline, i);
+
+      clutter_timeline_set_sampled_progress (timeline, FALSE);
+      analytic = clutter_timeline_get_progress (timeline);
+
+      clutter_timeline_set_sampled_progress (timeline, TRUE);
+      sampled = clutter_timeline_get_progress (timeline);
+
+      max_error = MAX (max_error, fabs (analytic - sampled));
+    }
+
+  return max_error;
+}
+
+void
+timeline_progress_sampled (TestConformSimpleFixture *fixture G_GNUC_UNUSED,
+                           gconstpointer dummy G_GNUC_UNUSED)
+{
+  ClutterTimeline *timeline;
+  ClutterPoint c_1, c_2;
+  gdouble error;
+  gint mode;
+
+  timeline = clutter_timeline_new (1000);
+  g_assert (!clutter_timeline_get_sampled_progress (timeline));
+
+  for (mode = CLUTTER_LINEAR; mode < CLUTTER_ANIMATION_LAST; mode++)
+    {
+      if (mode == CLUTTER_STEPS ||
+          mode == CLUTTER_STEP_START ||
+          mode == CLUTTER_STEP_END)
+        continue;
+
+      clutter_timeline_set_progress_mode (timeline, mode);
+      error = timeline_progress_error (timeline);
+
+      if (g_test_verbose ())
+        g_print ("mode: %d, max error: %g\n", mode, error);
+
+      g_assert_cmpfloat (error, <, 0.001);
+    }
+
+  /* changing the control points while the mode is unchanged
+   * must not keep using the previous table
+   */
+  clutter_point_init (&c_1, 0.1, 0.9);
+  clutter_point_init (&c_2, 0.9, 0.1);
+  clutter_timeline_set_cubic_bezier_progress (timeline, &c_1, &c_2);
+  g_assert_cmpfloat (timeline_progress_error (timeline), <, 0.001);
+
+  clutter_point_init (&c_1, 0.9, 0.1);
+  clutter_point_init (&c_2, 0.1, 0.9);
+  clutter_timeline_set_cubic_bezier_progress (timeline, &c_1, &c_2);
+  g_assert_cmpfloat (timeline_progress_error (timeline), <, 0.001);
+
+  /* the step modes are evaluated exactly */
+  clutter_timeline_set_step_progress (timeline, 3, CLUTTER_STEP_MODE_END);
+  clutter_timeline_advance (timeline, 1000 / 3 - 1);
+  g_assert_cmpint (clutter_timeline_get_progress (timeline) * 1000, ==, 0);
+
+  g_object_unref (timeline);
+}
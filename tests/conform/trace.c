@@ -0,0 +1,193 @@
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+#define N_FRAMES        3
+
+/* longer than the names copied into the trace events */
+#define ACTOR_NAME      "a traced actor with a name longer than the trace buffer allows"
+
+#define PAINT_COUNTER   "Actor real-paint counter"
+
+typedef struct {
+  ClutterActor *stage;
+  guint n_frames;
+} TraceData;
+
+static gboolean
+on_paint_done (gpointer user_data)
+{
+  TraceData *data = user_data;
+
+  data->n_frames += 1;
+
+  if (data->n_frames == N_FRAMES)
+    {
+      clutter_main_quit ();
+      return FALSE;
+    }
+
+  clutter_actor_queue_redraw (data->stage);
+
+  return TRUE;
+}
+
+static void
+check_trace (const gchar *filename)
+{
+  JsonParser *parser = json_parser_new ();
+  GHashTable *stacks, *counter_times;
+  GError *error = NULL;
+  JsonObject *root;
+  JsonArray *events;
+  GHashTableIter iter;
+  gpointer value;
+  guint i, n_spans;
+
+  json_parser_load_from_file (parser, filename, &error);
+  g_assert_no_error (error);
+
+  root = json_node_get_object (json_parser_get_root (parser));
+  events = json_object_get_array_member (root, "traceEvents");
+  g_assert (events != NULL);
+  g_assert_cmpuint (json_array_get_length (events), >, 0);
+
+  /* the names of the open B events of each thread */
+  stacks = g_hash_table_new_full (NULL, NULL,
+                                  NULL,
+                                  (GDestroyNotify) g_ptr_array_unref);
+
+  /* the times at which the paint counter was reported */
+  counter_times = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                         g_free,
+                                         NULL);
+
+  n_spans = 0;
+
+  for (i = 0; i < json_array_get_length (events); i++)
+    {
+      JsonObject *event = json_array_get_object_element (events, i);
+      const gchar *phase, *name;
+      GPtrArray *stack;
+      gint64 tid, ts;
+
+      g_assert (json_object_has_member (event, "tid"));
+      g_assert (json_object_has_member (event, "ts"));
+
+      tid = json_object_get_int_member (event, "tid");
+      ts = json_object_get_int_member (event, "ts");
+      phase = json_object_get_string_member (event, "ph");
+      name = json_object_get_string_member (event, "name");
+
+      g_assert_cmpint (tid, >, 0);
+      g_assert_cmpint (ts, >, 0);
+      g_assert (name != NULL);
+
+      stack = g_hash_table_lookup (stacks, GINT_TO_POINTER ((gint) tid));
+      if (stack == NULL)
+        {
+          stack = g_ptr_array_new ();
+          g_hash_table_insert (stacks, GINT_TO_POINTER ((gint) tid), stack);
+        }
+
+      if (strcmp (phase, "B") == 0)
+        g_ptr_array_add (stack, (gpointer) name);
+      else if (strcmp (phase, "E") == 0)
+        {
+          /* every end event closes the innermost begin event */
+          g_assert_cmpuint (stack->len, >, 0);
+          g_assert_cmpstr (g_ptr_array_index (stack, stack->len - 1), ==, name);
+          g_ptr_array_remove_index (stack, stack->len - 1);
+        }
+      else if (strcmp (phase, "C") == 0)
+        {
+          if (strcmp (name, PAINT_COUNTER) == 0)
+            {
+              gint64 *key = g_memdup (&ts, sizeof (ts));
+
+              g_hash_table_replace (counter_times, key, key);
+            }
+        }
+      else if (strcmp (phase, "X") == 0)
+        {
+          g_assert (json_object_has_member (event, "dur"));
+
+          /* the actor names are copied, and truncated */
+          if (g_str_has_prefix (ACTOR_NAME, name))
+            {
+              g_assert_cmpuint (strlen (name), <, strlen (ACTOR_NAME));
+              n_spans += 1;
+            }
+        }
+      else
+        g_assert_not_reached ();
+    }
+
+  g_hash_table_iter_init (&iter, stacks);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_assert_cmpuint (((GPtrArray *) value)->len, ==, 0);
+
+  if (g_test_verbose ())
+    g_print ("%u events, paint counter reported %u times, %u actor spans\n",
+             json_array_get_length (events),
+             g_hash_table_size (counter_times),
+             n_spans);
+
+  /* the counters are reported at the end of each frame */
+  g_assert_cmpuint (g_hash_table_size (counter_times), >=, N_FRAMES);
+  g_assert_cmpuint (n_spans, >, 0);
+
+  g_hash_table_unref (counter_times);
+  g_hash_table_unref (stacks);
+  g_object_unref (parser);
+}
+
+void
+trace_frames (TestConformSimpleFixture *fixture,
+              gconstpointer             dummy)
+{
+  TraceData data = { NULL, 0 };
+  ClutterActor *actor;
+  GError *error = NULL;
+  gchar *filename;
+  gint fd;
+
+  fd = g_file_open_tmp ("clutter-trace-XXXXXX.json", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  /* trace every actor */
+  g_setenv ("CLUTTER_TRACE_THRESHOLD", "0", TRUE);
+
+  data.stage = clutter_stage_new ();
+
+  actor = clutter_actor_new ();
+  clutter_actor_set_name (actor, ACTOR_NAME);
+  clutter_actor_set_background_color (actor, CLUTTER_COLOR_Red);
+  clutter_actor_set_size (actor, 50, 50);
+  clutter_actor_add_child (data.stage, actor);
+
+  g_assert (clutter_trace_start (filename, &error));
+  g_assert_no_error (error);
+
+  clutter_actor_show (data.stage);
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT,
+                                         on_paint_done,
+                                         &data,
+                                         NULL);
+
+  clutter_main ();
+
+  clutter_trace_stop ();
+
+  check_trace (filename);
+
+  clutter_actor_destroy (data.stage);
+
+  g_unlink (filename);
+  g_free (filename);
+}
@@ -0,0 +1,220 @@
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+#define DURATION        250
+#define FINAL_X         300.f
+#define FINAL_OPACITY   32
+
+typedef struct {
+  ClutterActor *stage;
+
+  const gchar *property;
+
+  /* the transition of the first actor is advanced in bulk by the
+   * master clock, while the second one goes through ::new-frame
+   */
+  ClutterActor *actors[2];
+  ClutterTransition *transitions[2];
+
+  guint n_frames;
+  guint n_notifies[2];
+  guint n_completed[2];
+  guint n_stopped;
+} BatchData;
+
+static void
+on_new_frame (ClutterTimeline *timeline,
+              gint             msecs,
+              BatchData       *data)
+{
+  /* connecting a handler is enough to take the transition out of
+   * the batch
+   */
+}
+
+static gdouble
+get_value (ClutterActor *actor,
+           const gchar  *property)
+{
+  GValue value = G_VALUE_INIT;
+  GValue res = G_VALUE_INIT;
+  GParamSpec *pspec;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (actor), property);
+
+  g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+  g_value_init (&res, G_TYPE_DOUBLE);
+
+  g_object_get_property (G_OBJECT (actor), property, &value);
+  g_value_transform (&value, &res);
+
+  g_value_unset (&value);
+
+  return g_value_get_double (&res);
+}
+
+static void
+on_notify (ClutterActor *actor,
+           GParamSpec   *pspec,
+           BatchData    *data)
+{
+  data->n_notifies[actor == data->actors[0] ? 0 : 1] += 1;
+}
+
+static void
+on_completed (ClutterTimeline *timeline,
+              BatchData       *data)
+{
+  data->n_completed[timeline == CLUTTER_TIMELINE (data->transitions[0]) ? 0 : 1] += 1;
+}
+
+static void
+on_stopped (ClutterTimeline *timeline,
+            gboolean         is_finished,
+            BatchData       *data)
+{
+  data->n_stopped += 1;
+
+  if (data->n_stopped == 2)
+    clutter_main_quit ();
+}
+
+static gboolean
+on_pre_paint (gpointer user_data)
+{
+  BatchData *data = user_data;
+  gdouble value_0, value_1;
+
+  /* both transitions have been advanced to the same time */
+  value_0 = get_value (data->actors[0], data->property);
+  value_1 = get_value (data->actors[1], data->property);
+
+  if (g_test_verbose ())
+    g_print ("frame %u: batched %s = %.6f, unbatched %s = %.6f\n",
+             data->n_frames,
+             data->property, value_0,
+             data->property, value_1);
+
+  g_assert_cmpfloat (value_0, ==, value_1);
+
+  /* the batched transition notifies the property at each frame */
+  g_assert_cmpuint (data->n_notifies[0], ==, data->n_notifies[1]);
+
+  data->n_frames += 1;
+
+  return data->n_stopped < 2;
+}
+
+static void
+run_transitions (const gchar          *property,
+                 ClutterAnimationMode  mode,
+                 gboolean              sampled)
+{
+  BatchData data = { NULL, };
+  gchar *signal_name;
+  gdouble final;
+  guint i;
+
+  data.stage = clutter_stage_new ();
+  data.property = property;
+
+  signal_name = g_strconcat ("notify::", property, NULL);
+
+  for (i = 0; i < 2; i++)
+    {
+      ClutterTimeline *timeline;
+
+      data.actors[i] = clutter_actor_new ();
+      clutter_actor_set_size (data.actors[i], 50, 50);
+      clutter_actor_add_child (data.stage, data.actors[i]);
+      g_signal_connect (data.actors[i], signal_name,
+                        G_CALLBACK (on_notify),
+                        &data);
+
+      data.transitions[i] = clutter_property_transition_new (property);
+
+      if (g_str_equal (property, "opacity"))
+        {
+          clutter_transition_set_from (data.transitions[i], G_TYPE_UINT, 255);
+          clutter_transition_set_to (data.transitions[i], G_TYPE_UINT, FINAL_OPACITY);
+        }
+      else
+        {
+          clutter_transition_set_from (data.transitions[i], G_TYPE_FLOAT, 0.f);
+          clutter_transition_set_to (data.transitions[i], G_TYPE_FLOAT, FINAL_X);
+        }
+
+      timeline = CLUTTER_TIMELINE (data.transitions[i]);
+      clutter_timeline_set_duration (timeline, DURATION);
+      clutter_timeline_set_progress_mode (timeline, mode);
+      clutter_timeline_set_sampled_progress (timeline, sampled);
+
+      g_signal_connect (timeline, "completed",
+                        G_CALLBACK (on_completed),
+                        &data);
+      g_signal_connect (timeline, "stopped",
+                        G_CALLBACK (on_stopped),
+                        &data);
+    }
+
+  g_signal_connect (data.transitions[1], "new-frame",
+                    G_CALLBACK (on_new_frame),
+                    &data);
+
+  clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT,
+                                         on_pre_paint,
+                                         &data,
+                                         NULL);
+
+  clutter_actor_show (data.stage);
+
+  for (i = 0; i < 2; i++)
+    clutter_actor_add_transition (data.actors[i], property, data.transitions[i]);
+
+  clutter_main ();
+
+  if (g_test_verbose ())
+    g_print ("%s: %u frames, notifies: %u batched, %u unbatched\n",
+             property,
+             data.n_frames,
+             data.n_notifies[0],
+             data.n_notifies[1]);
+
+  g_assert_cmpuint (data.n_frames, >, 2);
+
+  final = g_str_equal (property, "opacity") ? FINAL_OPACITY : FINAL_X;
+  g_assert_cmpfloat (get_value (data.actors[0], property), ==, final);
+  g_assert_cmpfloat (get_value (data.actors[1], property), ==, final);
+
+  g_assert_cmpuint (data.n_notifies[0], ==, data.n_notifies[1]);
+  g_assert_cmpuint (data.n_completed[0], ==, 1);
+  g_assert_cmpuint (data.n_completed[1], ==, 1);
+
+  for (i = 0; i < 2; i++)
+    g_object_unref (data.transitions[i]);
+
+  clutter_actor_destroy (data.stage);
+
+  g_free (signal_name);
+}
+
+void
+transition_batch (TestConformSimpleFixture *fixture,
+                  gconstpointer             dummy)
+{
+  /* an easing function, a cubic bezier mode and an integer property */
+  run_transitions ("x", CLUTTER_LINEAR, FALSE);
+  run_transitions ("x", CLUTTER_EASE_OUT_QUAD, FALSE);
+  run_transitions ("x", CLUTTER_EASE_IN_OUT, FALSE);
+  run_transitions ("opacity", CLUTTER_EASE_IN_CUBIC, FALSE);
+}
+
+void
+transition_batch_sampled (TestConformSimpleFixture *fixture,
+                          gconstpointer             dummy)
+{
+  /* a cubic bezier mode, and a mode with a sampled easing function */
+  run_transitions ("x", CLUTTER_EASE_IN_OUT, TRUE);
+  run_transitions ("x", CLUTTER_EASE_OUT_ELASTIC, TRUE);
+}
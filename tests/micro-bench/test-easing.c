@@ -0,0 +1,127 @@
+#include <clutter/clutter.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+#define DURATION        10000
+#define N_ITERATIONS    100
+
+static gint n_iterations = N_ITERATIONS;
+
+static GOptionEntry entries[] = {
+  {
+    "iterations", 'i',
+    0,
+    G_OPTION_ARG_INT, &n_iterations,
+    "Number of passes over the timeline for each mode", "N"
+  },
+  { NULL }
+};
+
+/* evaluates the progress at each millisecond of the timeline, and
+ * returns the number of nanoseconds per evaluation
+ */
+static gdouble
+time_progress (ClutterTimeline *timeline,
+               gdouble         *values)
+{
+  GTimer *timer;
+  gdouble elapsed;
+  gint i, msecs;
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      for (msecs = 0; msecs <= DURATION; msecs++)
+        {
+          clutter_timeline_advance (timeline, msecs);
+          values[msecs] = clutter_timeline_get_progress (timeline);
+        }
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return elapsed * 1e9 / ((gdouble) n_iterations * (DURATION + 1));
+}
+
+static void
+compare_progress (ClutterTimeline *timeline,
+                  const gchar     *name)
+{
+  gdouble *analytic, *sampled;
+  gdouble analytic_ns, sampled_ns;
+  gdouble max_error = 0.0;
+  gint msecs;
+
+  analytic = g_new (gdouble, DURATION + 1);
+  sampled = g_new (gdouble, DURATION + 1);
+
+  clutter_timeline_set_sampled_progress (timeline, FALSE);
+  analytic_ns = time_progress (timeline, analytic);
+
+  clutter_timeline_set_sampled_progress (timeline, TRUE);
+  sampled_ns = time_progress (timeline, sampled);
+
+  for (msecs = 0; msecs <= DURATION; msecs++)
+    max_error = MAX (max_error, fabs (analytic[msecs] - sampled[msecs]));
+
+  g_print ("%-20s %12.2f %12.2f %10.2fx %12.2e\n",
+           name,
+           analytic_ns,
+           sampled_ns,
+           analytic_ns / sampled_ns,
+           max_error);
+
+  g_free (analytic);
+  g_free (sampled);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterTimeline *timeline;
+  GEnumClass *enum_class;
+  ClutterPoint c_1, c_2;
+  GError *error = NULL;
+  gint mode;
+
+  if (clutter_init_with_args (&argc, &argv,
+                              NULL,
+                              entries,
+                              NULL,
+                              &error) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Unable to initialize Clutter: %s\n",
+                  error != NULL ? error->message : "unknown error");
+      return EXIT_FAILURE;
+    }
+
+  timeline = clutter_timeline_new (DURATION);
+  enum_class = g_type_class_ref (CLUTTER_TYPE_ANIMATION_MODE);
+
+  g_print ("%-20s %12s %12s %11s %12s\n",
+           "mode", "analytic ns", "sampled ns", "speedup", "max error");
+
+  for (mode = CLUTTER_LINEAR + 1; mode < CLUTTER_ANIMATION_LAST; mode++)
+    {
+      GEnumValue *value = g_enum_get_value (enum_class, mode);
+
+      if (value == NULL || mode == CLUTTER_CUBIC_BEZIER)
+        continue;
+
+      clutter_timeline_set_progress_mode (timeline, mode);
+      compare_progress (timeline, value->value_nick);
+    }
+
+  clutter_point_init (&c_1, 0.1, 0.9);
+  clutter_point_init (&c_2, 0.9, 0.1);
+  clutter_timeline_set_cubic_bezier_progress (timeline, &c_1, &c_2);
+  compare_progress (timeline, "cubic-bezier");
+
+  g_type_class_unref (enum_class);
+  g_object_unref (timeline);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,439 @@
+/* Times the layout managers shipped with Clutter
+ *
+ * For each layout manager, and for an increasing number of children,
+ * a container is filled with children of mixed preferred sizes, expand
+ * and fill flags and spans; then the size negotiation and the
+ * allocation of the container are timed separately for:
+ *
+ *  - the initial layout of the container
+ *  - the resize of a single child
+ *  - the insertion of a new child
+ *  - the resize of the container
+ *
+ * The container is added to a stage that is never shown, so nothing
+ * is ever painted and the results only measure the layout code.
+ *
+ * The results are printed as JSON, in the same format used by
+ * tests/performance/test-perf-suite: times are in microseconds.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <clutter/clutter.h>
+#include <json-glib/json-glib.h>
+
+#define CONTAINER_WIDTH         1024.f
+#define CONTAINER_HEIGHT        768.f
+
+typedef enum {
+  LAYOUT_BOX,
+  LAYOUT_FLOW,
+  LAYOUT_GRID,
+  LAYOUT_TABLE,
+  LAYOUT_BIN
+} LayoutType;
+
+/* clutter_table_layout_pack() walks all the children of the container
+ * every time it is called, so filling a table is quadratic in the number
+ * of children; the largest tables are skipped to keep the run time sane
+ */
+static const struct {
+  const gchar *name;
+  LayoutType type;
+  guint max_children;
+} layouts[] = {
+  { "box", LAYOUT_BOX, G_MAXUINT },
+  { "flow", LAYOUT_FLOW, G_MAXUINT },
+  { "grid", LAYOUT_GRID, G_MAXUINT },
+  { "table", LAYOUT_TABLE, 10000 },
+  { "bin", LAYOUT_BIN, G_MAXUINT },
+};
+
+typedef enum {
+  STEP_INITIAL,
+  STEP_CHILD_RESIZE,
+  STEP_CHILD_INSERT,
+  STEP_CONTAINER_RESIZE,
+
+  N_STEPS
+} Step;
+
+static const gchar *step_names[N_STEPS] = {
+  "initial",
+  "child-resize",
+  "child-insert",
+  "container-resize",
+};
+
+typedef struct {
+  LayoutType type;
+
+  ClutterActor *container;
+  ClutterLayoutManager *manager;
+
+  guint n_columns;
+  guint n_children;
+
+  /* one array of gint64 for each step, with a sample per iteration */
+  GArray *preferred_size[N_STEPS];
+  GArray *allocate[N_STEPS];
+} Bench;
+
+static gint n_iterations = 5;
+static gint max_children = 100000;
+static gchar *output_file = NULL;
+static gchar *layout_filter = NULL;
+
+static GOptionEntry entries[] = {
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations,
+    "Number of times each container is laid out", "N" },
+  { "max-children", 'm', 0, G_OPTION_ARG_INT, &max_children,
+    "Maximum number of children of the containers", "N" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file,
+    "Write the results to FILE instead of the standard output", "FILE" },
+  { "layout", 'l', 0, G_OPTION_ARG_STRING, &layout_filter,
+    "Only run the benchmarks of the layout manager NAME", "NAME" },
+  { NULL }
+};
+
+static ClutterLayoutManager *
+bench_create_manager (LayoutType type)
+{
+  switch (type)
+    {
+    case LAYOUT_BOX:
+      return clutter_box_layout_new ();
+
+    case LAYOUT_FLOW:
+      return clutter_flow_layout_new (CLUTTER_FLOW_HORIZONTAL);
+
+    case LAYOUT_GRID:
+      return clutter_grid_layout_new ();
+
+    case LAYOUT_TABLE:
+      return clutter_table_layout_new ();
+
+    case LAYOUT_BIN:
+      return clutter_bin_layout_new (CLUTTER_BIN_ALIGNMENT_START,
+                                     CLUTTER_BIN_ALIGNMENT_START);
+    }
+
+  g_assert_not_reached ();
+
+  return NULL;
+}
+
+/* Adds a child at @index_; the size, the flags and the span of the
+ * child are derived from @seed, so that every run builds the same
+ * containers
+ */
+static ClutterActor *
+bench_add_child (Bench *bench,
+                 guint  index_,
+                 guint  seed)
+{
+  ClutterActor *child;
+  guint column, row;
+
+  child = clutter_actor_new ();
+  clutter_actor_set_size (child, 16 + (seed * 7) % 48, 16 + (seed * 13) % 32);
+
+  /* a third of the children expand, and half of those fill */
+  if (seed % 3 == 0)
+    {
+      clutter_actor_set_x_expand (child, TRUE);
+
+      if (seed % 2 == 0)
+        clutter_actor_set_x_align (child, CLUTTER_ACTOR_ALIGN_FILL);
+      else
+        clutter_actor_set_x_align (child, CLUTTER_ACTOR_ALIGN_CENTER);
+    }
+
+  column = seed % bench->n_columns;
+  row = seed / bench->n_columns;
+
+  switch (bench->type)
+    {
+    case LAYOUT_GRID:
+      clutter_grid_layout_attach (CLUTTER_GRID_LAYOUT (bench->manager),
+                                  child,
+                                  column, row,
+                                  seed % 5 == 0 ? 2 : 1,
+                                  seed % 11 == 0 ? 2 : 1);
+      clutter_actor_set_child_at_index (bench->container, child, index_);
+      break;
+
+    case LAYOUT_TABLE:
+      clutter_table_layout_pack (CLUTTER_TABLE_LAYOUT (bench->manager),
+                                 child,
+                                 column, row);
+      clutter_actor_set_child_at_index (bench->container, child, index_);
+      clutter_table_layout_set_span (CLUTTER_TABLE_LAYOUT (bench->manager),
+                                     child,
+                                     seed % 5 == 0 ? 2 : 1,
+                                     seed % 11 == 0 ? 2 : 1);
+      clutter_table_layout_set_expand (CLUTTER_TABLE_LAYOUT (bench->manager),
+                                       child,
+                                       seed % 3 == 0, FALSE);
+      clutter_table_layout_set_fill (CLUTTER_TABLE_LAYOUT (bench->manager),
+                                     child,
+                                     seed % 6 == 0, FALSE);
+      break;
+
+    default:
+      clutter_actor_insert_child_at_index (bench->container, child, index_);
+      break;
+    }
+
+  bench->n_children += 1;
+
+  return child;
+}
+
+static gint64
+bench_time_preferred_size (Bench  *bench,
+                           gfloat  for_width)
+{
+  gfloat min_width, nat_width, min_height, nat_height;
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+
+  clutter_actor_get_preferred_width (bench->container, -1,
+                                     &min_width,
+                                     &nat_width);
+  clutter_actor_get_preferred_height (bench->container, for_width,
+                                      &min_height,
+                                      &nat_height);
+
+  return g_get_monotonic_time () - start;
+}
+
+static gint64
+bench_time_allocate (Bench  *bench,
+                     gfloat  width,
+                     gfloat  height)
+{
+  ClutterActorBox box = { 0, 0, width, height };
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+
+  clutter_actor_allocate (bench->container, &box, CLUTTER_ALLOCATION_NONE);
+
+  return g_get_monotonic_time () - start;
+}
+
+static void
+bench_measure (Bench  *bench,
+               Step    step,
+               gfloat  width,
+               gfloat  height)
+{
+  gint64 sample;
+
+  sample = bench_time_preferred_size (bench, width);
+  g_array_append_val (bench->preferred_size[step], sample);
+
+  sample = bench_time_allocate (bench, width, height);
+  g_array_append_val (bench->allocate[step], sample);
+}
+
+static void
+bench_run_iteration (Bench        *bench,
+                     ClutterActor *stage,
+                     guint         n_children)
+{
+  ClutterActor *child;
+  guint i;
+
+  bench->manager = bench_create_manager (bench->type);
+  bench->container = clutter_actor_new ();
+  clutter_actor_set_layout_manager (bench->container, bench->manager);
+  clutter_actor_add_child (stage, bench->container);
+
+  bench->n_children = 0;
+  bench->n_columns = MAX (1, (guint) ceil (sqrt (n_children)));
+
+  for (i = 0; i < n_children; i++)
+    bench_add_child (bench, i, i);
+
+  bench_measure (bench, STEP_INITIAL, CONTAINER_WIDTH, CONTAINER_HEIGHT);
+
+  child = clutter_actor_get_child_at_index (bench->container, n_children / 2);
+  clutter_actor_set_size (child, 80, 60);
+  bench_measure (bench, STEP_CHILD_RESIZE, CONTAINER_WIDTH, CONTAINER_HEIGHT);
+
+  bench_add_child (bench, n_children / 2, n_children);
+  bench_measure (bench, STEP_CHILD_INSERT, CONTAINER_WIDTH, CONTAINER_HEIGHT);
+
+  bench_measure (bench, STEP_CONTAINER_RESIZE,
+                 CONTAINER_WIDTH * 0.75f,
+                 CONTAINER_HEIGHT * 1.25f);
+
+  clutter_actor_destroy (bench->container);
+  bench->container = NULL;
+  bench->manager = NULL;
+}
+
+static gint
+compare_samples (gconstpointer a,
+                 gconstpointer b)
+{
+  gint64 sample_a = *(const gint64 *) a;
+  gint64 sample_b = *(const gint64 *) b;
+
+  return sample_a < sample_b ? -1 : sample_a > sample_b ? 1 : 0;
+}
+
+static void
+add_metric (JsonBuilder *builder,
+            const gchar *step,
+            const gchar *phase,
+            GArray      *samples)
+{
+  gchar *name;
+
+  g_array_sort (samples, compare_samples);
+
+  name = g_strconcat (step, "-", phase, NULL);
+  json_builder_set_member_name (builder, name);
+  g_free (name);
+
+  json_builder_begin_object (builder);
+  json_builder_set_member_name (builder, "median");
+  json_builder_add_int_value (builder,
+                              g_array_index (samples, gint64,
+                                             (samples->len - 1) / 2));
+  json_builder_set_member_name (builder, "p95");
+  json_builder_add_int_value (builder,
+                              g_array_index (samples, gint64,
+                                             (samples->len - 1) * 95 / 100));
+  json_builder_end_object (builder);
+}
+
+static void
+bench_run (LayoutType    type,
+           const gchar  *layout_name,
+           guint         n_children,
+           ClutterActor *stage,
+           JsonBuilder  *builder)
+{
+  Bench bench = { type, };
+  gchar *name;
+  guint i;
+
+  for (i = 0; i < N_STEPS; i++)
+    {
+      bench.preferred_size[i] = g_array_new (FALSE, FALSE, sizeof (gint64));
+      bench.allocate[i] = g_array_new (FALSE, FALSE, sizeof (gint64));
+    }
+
+  for (i = 0; i < (guint) n_iterations; i++)
+    bench_run_iteration (&bench, stage, n_children);
+
+  name = g_strdup_printf ("%s-%u", layout_name, n_children);
+  json_builder_set_member_name (builder, name);
+  g_free (name);
+
+  json_builder_begin_object (builder);
+
+  for (i = 0; i < N_STEPS; i++)
+    {
+      add_metric (builder, step_names[i], "preferred-size",
+                  bench.preferred_size[i]);
+      add_metric (builder, step_names[i], "allocate",
+                  bench.allocate[i]);
+
+      g_array_free (bench.preferred_size[i], TRUE);
+      g_array_free (bench.allocate[i], TRUE);
+    }
+
+  json_builder_end_object (builder);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  JsonBuilder *builder;
+  JsonGenerator *generator;
+  JsonNode *results;
+  ClutterActor *stage;
+  GError *error = NULL;
+  guint i, n_children;
+
+  if (clutter_init_with_args (&argc, &argv,
+                              "- Layout managers benchmark",
+                              entries,
+                              NULL,
+                              &error) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Unable to initialize Clutter: %s\n",
+                  error != NULL ? error->message : "unknown error");
+      return EXIT_FAILURE;
+    }
+
+  n_iterations = MAX (n_iterations, 1);
+
+  /* the stage is never shown, so that nothing is painted */
+  stage = clutter_stage_new ();
+
+  builder = json_builder_new ();
+  json_builder_begin_object (builder);
+
+  json_builder_set_member_name (builder, "iterations");
+  json_builder_add_int_value (builder, n_iterations);
+
+  json_builder_set_member_name (builder, "scenes");
+  json_builder_begin_object (builder);
+
+  for (i = 0; i < G_N_ELEMENTS (layouts); i++)
+    {
+      if (layout_filter != NULL && strcmp (layouts[i].name, layout_filter) != 0)
+        continue;
+
+      for (n_children = 10;
+           n_children <= MIN ((guint) max_children, layouts[i].max_children);
+           n_children *= 10)
+        bench_run (layouts[i].type, layouts[i].name, n_children, stage, builder);
+    }
+
+  json_builder_end_object (builder);
+  json_builder_end_object (builder);
+
+  results = json_builder_get_root (builder);
+
+  generator = json_generator_new ();
+  json_generator_set_pretty (generator, TRUE);
+  json_generator_set_root (generator, results);
+
+  if (output_file != NULL)
+    {
+      if (!json_generator_to_file (generator, output_file, &error))
+        {
+          g_printerr ("Unable to write the results to '%s': %s\n",
+                      output_file,
+                      error->message);
+          g_error_free (error);
+          return EXIT_FAILURE;
+        }
+    }
+  else
+    {
+      gchar *data = json_generator_to_data (generator, NULL);
+
+      g_print ("%s\n", data);
+      g_free (data);
+    }
+
+  json_node_free (results);
+  g_object_unref (generator);
+  g_object_unref (builder);
+
+  clutter_actor_destroy (stage);
+
+  return EXIT_SUCCESS;
+}
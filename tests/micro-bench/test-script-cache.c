@@ -0,0 +1,167 @@
+#include <clutter/clutter.h>
+
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_ACTORS        2000
+#define N_RUNS          10
+
+static gint n_actors = N_ACTORS;
+static gint n_runs = N_RUNS;
+
+static GOptionEntry entries[] = {
+  {
+    "actors", 'n',
+    0,
+    G_OPTION_ARG_INT, &n_actors,
+    "Number of actors in the UI definition", "ACTORS"
+  },
+  {
+    "runs", 'r',
+    0,
+    G_OPTION_ARG_INT, &n_runs,
+    "Number of loads to average", "RUNS"
+  },
+  { NULL }
+};
+
+/* a flat list of containers, each with a few children without an id */
+static gchar *
+generate_definition (void)
+{
+  GString *buffer = g_string_new ("[\n");
+  gint i;
+
+  for (i = 0; i < n_actors; i++)
+    {
+      g_string_append_printf (buffer,
+        "  {\n"
+        "    \"id\" : \"actor-%d\", \"type\" : \"ClutterActor\",\n"
+        "    \"x\" : %d, \"y\" : %d, \"width\" : 100, \"height\" : 20,\n"
+        "    \"background-color\" : \"#%06x\", \"opacity\" : 200,\n"
+        "    \"reactive\" : true, \"name\" : \"Actor %d\",\n"
+        "    \"layout-manager\" : { \"type\" : \"ClutterBoxLayout\", \"spacing\" : 6 },\n"
+        "    \"children\" : [\n"
+        "      { \"type\" : \"ClutterText\", \"text\" : \"Label %d\", \"color\" : \"white\" },\n"
+        "      { \"type\" : \"ClutterActor\", \"width\" : 16, \"height\" : 16 }\n"
+        "    ],\n"
+        "    \"signals\" : [ { \"name\" : \"button-press-event\", \"handler\" : \"on_press\" } ]\n"
+        "  }%s\n",
+        i, (i % 10) * 100, (i / 10) * 20, (i * 2654435761u) & 0xffffff,
+        i, i,
+        i < n_actors - 1 ? "," : "");
+    }
+
+  g_string_append (buffer, "]\n");
+
+  return g_string_free (buffer, FALSE);
+}
+
+/* returns the average time of a load, in milliseconds */
+static gdouble
+time_load (const gchar *filename,
+           const gchar *cache_dir,
+           gint         runs)
+{
+  GTimer *timer = g_timer_new ();
+  gdouble total = 0.0;
+  gint i;
+
+  for (i = 0; i < runs; i++)
+    {
+      ClutterScript *script = clutter_script_new ();
+      GError *error = NULL;
+
+      clutter_script_set_cache_directory (script, cache_dir);
+
+      g_timer_start (timer);
+      clutter_script_load_from_file (script, filename, &error);
+      total += g_timer_elapsed (timer, NULL);
+
+      if (error != NULL)
+        g_error ("Unable to load '%s': %s", filename, error->message);
+
+      g_object_unref (script);
+    }
+
+  g_timer_destroy (timer);
+
+  return total * 1000.0 / runs;
+}
+
+static void
+remove_directory (const gchar *path)
+{
+  GDir *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  while (dir != NULL && (name = g_dir_read_name (dir)) != NULL)
+    {
+      gchar *file = g_build_filename (path, name, NULL);
+
+      g_unlink (file);
+      g_free (file);
+    }
+
+  if (dir != NULL)
+    g_dir_close (dir);
+
+  g_rmdir (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gchar *tmp_dir, *cache_dir, *filename, *definition;
+  gdouble uncached, first, cached;
+  GError *error = NULL;
+
+  if (clutter_init_with_args (&argc, &argv,
+                              NULL,
+                              entries,
+                              NULL,
+                              &error) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Unable to initialize Clutter: %s\n",
+                  error != NULL ? error->message : "unknown error");
+      return EXIT_FAILURE;
+    }
+
+  tmp_dir = g_dir_make_tmp ("test-script-cache-XXXXXX", &error);
+  if (tmp_dir == NULL)
+    g_error ("Unable to create a temporary directory: %s", error->message);
+
+  filename = g_build_filename (tmp_dir, "ui.json", NULL);
+  cache_dir = g_build_filename (tmp_dir, "cache", NULL);
+
+  definition = generate_definition ();
+  if (!g_file_set_contents (filename, definition, -1, &error))
+    g_error ("Unable to write '%s': %s", filename, error->message);
+
+  /* the first load also registers the types, so that the cold start
+   * cost of the type lookups does not skew the other loads
+   */
+  time_load (filename, NULL, 1);
+
+  uncached = time_load (filename, NULL, n_runs);
+  first = time_load (filename, cache_dir, 1);
+  cached = time_load (filename, cache_dir, n_runs);
+
+  g_print ("definition: %d actors, %" G_GSIZE_FORMAT " bytes\n",
+           n_actors, strlen (definition));
+  g_print ("without cache:  %8.2f ms\n", uncached);
+  g_print ("filling cache:  %8.2f ms\n", first);
+  g_print ("with cache:     %8.2f ms (%.2fx)\n", cached, uncached / cached);
+
+  remove_directory (cache_dir);
+  g_unlink (filename);
+  g_rmdir (tmp_dir);
+
+  g_free (definition);
+  g_free (filename);
+  g_free (cache_dir);
+  g_free (tmp_dir);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define N_INSERTS       2000
+#define INSERT_POSITION 16
+
+static gint n_inserts = N_INSERTS;
+static gboolean with_text = FALSE;
+
+static GOptionEntry entries[] = {
+  {
+    "inserts", 'n',
+    0,
+    G_OPTION_ARG_INT, &n_inserts,
+    "Number of characters to insert", "INSERTS"
+  },
+  {
+    "text", 't',
+    0,
+    G_OPTION_ARG_NONE, &with_text,
+    "Lay out a ClutterText showing the buffer after each insertion", NULL
+  },
+  { NULL }
+};
+
+static gchar *
+generate_contents (gsize n_bytes)
+{
+  GString *buffer = g_string_sized_new (n_bytes + 64);
+  gint line = 0;
+
+  while (buffer->len < n_bytes)
+    g_string_append_printf (buffer,
+                            "This is line %d of a long, editable text\n",
+                            line++);
+
+  return g_string_free (buffer, FALSE);
+}
+
+/* returns the average time of an insertion near the start of a
+ * buffer of @n_bytes bytes, in microseconds
+ */
+static gdouble
+time_inserts (gsize n_bytes)
+{
+  ClutterTextBuffer *buffer;
+  ClutterActor *text = NULL;
+  GTimer *timer;
+  gchar *contents;
+  gdouble elapsed;
+  gint i;
+
+  contents = generate_contents (n_bytes);
+  buffer = clutter_text_buffer_new_with_text (contents, -1);
+  g_free (contents);
+
+  if (with_text)
+    {
+      text = clutter_text_new_with_buffer (buffer);
+      clutter_text_set_editable (CLUTTER_TEXT (text), TRUE);
+      clutter_text_set_line_wrap (CLUTTER_TEXT (text), TRUE);
+      clutter_actor_get_preferred_height (text, 400, NULL, NULL);
+    }
+
+  /* the first insertion moves the gap to the edited position */
+  clutter_text_buffer_insert_text (buffer, INSERT_POSITION, "x", 1);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_inserts; i++)
+    {
+      clutter_text_buffer_insert_text (buffer, INSERT_POSITION + i + 1, "x", 1);
+
+      /* the length queries must not move the gap away */
+      clutter_text_buffer_get_bytes (buffer);
+      clutter_text_buffer_get_length (buffer);
+
+      if (text != NULL)
+        clutter_actor_get_preferred_height (text, 400, NULL, NULL);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  if (text != NULL)
+    clutter_actor_destroy (text);
+
+  g_object_unref (buffer);
+
+  return elapsed * 1000000.0 / n_inserts;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const gsize sizes[] = {
+    64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024
+  };
+  GError *error = NULL;
+  guint i;
+
+  if (clutter_init_with_args (&argc, &argv,
+                              NULL,
+                              entries,
+                              NULL,
+                              &error) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Unable to initialize Clutter: %s\n",
+                  error != NULL ? error->message : "unknown error");
+      return EXIT_FAILURE;
+    }
+
+  g_print ("%d insertions at offset %d%s\n",
+           n_inserts, INSERT_POSITION,
+           with_text ? ", laying out a ClutterText" : "");
+
+  /* the time of each insertion in the buffer should not depend on
+   * its size; the layout of the ClutterText still scans the text that
+   * follows the edited paragraph
+   */
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    g_print ("%8" G_GSIZE_FORMAT " KiB: %8.3f us per insertion\n",
+             sizes[i] / 1024,
+             time_inserts (sizes[i]));
+
+  return EXIT_SUCCESS;
+}
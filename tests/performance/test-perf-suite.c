@@ -0,0 +1,575 @@
+/* A deterministic benchmark runner
+ *
+ * Each scene is built from a few parameters (number of actors, depth
+ * of the actors tree, effects and text), then animated for a fixed
+ * number of frames using a simulated clock: the position of every
+ * actor is a function of the frame number, not of the wall clock, so
+ * every run draws exactly the same frames.
+ *
+ * The timings of each phase of the frames are read from the stage
+ * with clutter_stage_get_frame_stats(), and the results are printed
+ * as JSON, with the median and 95th percentile of each metric. The
+ * results can be compared with a baseline file produced by an earlier
+ * run, in which case the program fails if any metric regressed by
+ * more than the given threshold.
+ *
+ * The headless backend is used by default, so that no display is
+ * needed and the results do not depend on the window system; it is
+ * only built with --enable-headless-backend, and the CLUTTER_BACKEND
+ * environment variable selects another backend.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CLUTTER_ENABLE_EXPERIMENTAL_API
+#include <clutter/clutter.h>
+#include <json-glib/json-glib.h>
+
+#define STAGE_WIDTH     800
+#define STAGE_HEIGHT    600
+
+/* the simulated time between two frames, in microseconds */
+#define FRAME_INTERVAL  16667
+
+/* timings below this many microseconds are considered noise */
+#define NOISE_FLOOR     20
+
+typedef struct {
+  const gchar *name;
+  guint n_actors;
+  guint depth;
+  gboolean effects;
+  gboolean text;
+} SceneParams;
+
+static const SceneParams scenes[] = {
+  { "flat-100",            100, 1, FALSE, FALSE },
+  { "flat-1000",          1000, 1, FALSE, FALSE },
+  { "deep-1000",          1000, 6, FALSE, FALSE },
+  { "effects-100",         100, 2, TRUE,  FALSE },
+  { "text-200",            200, 1, FALSE, TRUE  },
+  { "mixed-500",           500, 3, TRUE,  TRUE  },
+};
+
+typedef enum {
+  METRIC_EVENTS,
+  METRIC_RELAYOUT,
+  METRIC_PAINT,
+  METRIC_PICK,
+  METRIC_SWAP,
+  METRIC_TOTAL,
+  METRIC_ACTORS_PAINTED,
+  METRIC_ACTORS_CULLED,
+  METRIC_ALLOCATIONS,
+  METRIC_PICKS,
+
+  N_METRICS
+} Metric;
+
+static const struct {
+  const gchar *name;
+  gboolean is_time;
+} metrics[N_METRICS] = {
+  { "event-processing", TRUE },
+  { "relayout", TRUE },
+  { "paint", TRUE },
+  { "pick", TRUE },
+  { "swap", TRUE },
+  { "total", TRUE },
+  { "actors-painted", FALSE },
+  { "actors-culled", FALSE },
+  { "allocations", FALSE },
+  { "picks", FALSE },
+};
+
+typedef struct {
+  const SceneParams *params;
+
+  ClutterActor *stage;
+  GPtrArray *leaves;
+
+  guint n_allocations;
+  gboolean painted;
+
+  /* one array of gint64 for each metric, with a value per frame */
+  GArray *samples[N_METRICS];
+} Scene;
+
+static gint n_frames = 300;
+static gint n_warmup = 30;
+static gchar *output_file = NULL;
+static gchar *baseline_file = NULL;
+static gdouble threshold = 10.0;
+static gchar *scene_filter = NULL;
+
+static GOptionEntry entries[] = {
+  { "frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+    "Number of frames measured for each scene", "FRAMES" },
+  { "warmup", 'w', 0, G_OPTION_ARG_INT, &n_warmup,
+    "Number of frames drawn before measuring", "FRAMES" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file,
+    "Write the results to FILE instead of the standard output", "FILE" },
+  { "baseline", 'b', 0, G_OPTION_ARG_FILENAME, &baseline_file,
+    "Compare the results with the results stored in FILE", "FILE" },
+  { "threshold", 't', 0, G_OPTION_ARG_DOUBLE, &threshold,
+    "Percentage above the baseline considered a regression", "PERCENT" },
+  { "scene", 's', 0, G_OPTION_ARG_STRING, &scene_filter,
+    "Only run the scenes whose name contains NAME", "NAME" },
+  { NULL }
+};
+
+static void
+on_allocation_changed (ClutterActor *actor,
+                       gpointer      box,
+                       guint         flags,
+                       Scene        *scene)
+{
+  scene->n_allocations += 1;
+}
+
+static ClutterActor *
+scene_add_leaf (Scene        *scene,
+                ClutterActor *parent,
+                guint         index_)
+{
+  ClutterColor color = { 0, 0, 0, 255 };
+  ClutterActor *leaf;
+
+  /* the colors are derived from the index, for reproducibility */
+  color.red = (index_ * 37) % 256;
+  color.green = (index_ * 101) % 256;
+  color.blue = (index_ * 197) % 256;
+
+  if (scene->params->text && index_ % 2 == 0)
+    {
+      gchar *str = g_strdup_printf ("Label %u", index_);
+
+      leaf = clutter_text_new_full ("Sans 12px", str, &color);
+      g_free (str);
+    }
+  else
+    {
+      leaf = clutter_actor_new ();
+      clutter_actor_set_background_color (leaf, &color);
+      clutter_actor_set_size (leaf, 24, 24);
+    }
+
+  g_signal_connect (leaf, "allocation-changed",
+                    G_CALLBACK (on_allocation_changed),
+                    scene);
+
+  clutter_actor_add_child (parent, leaf);
+  g_ptr_array_add (scene->leaves, leaf);
+
+  return leaf;
+}
+
+/* Builds a tree of groups @depth levels deep, with the leaves split
+ * evenly among the groups of the last level
+ */
+static void
+scene_build (Scene *scene)
+{
+  const SceneParams *params = scene->params;
+  ClutterActor *parent = scene->stage;
+  GPtrArray *groups;
+  guint level, i;
+
+  groups = g_ptr_array_new ();
+  g_ptr_array_add (groups, parent);
+
+  for (level = 1; level < params->depth; level++)
+    {
+      GPtrArray *children = g_ptr_array_new ();
+
+      for (i = 0; i < groups->len; i++)
+        {
+          guint j;
+
+          /* two children per group, so the tree stays balanced */
+          for (j = 0; j < 2; j++)
+            {
+              ClutterActor *group = clutter_actor_new ();
+
+              clutter_actor_set_position (group, j * 8, j * 8);
+
+              if (params->effects && level == 1)
+                clutter_actor_add_effect (group,
+                                          clutter_desaturate_effect_new (0.5));
+
+              clutter_actor_add_child (g_ptr_array_index (groups, i), group);
+              g_ptr_array_add (children, group);
+            }
+        }
+
+      g_ptr_array_free (groups, TRUE);
+      groups = children;
+    }
+
+  for (i = 0; i < params->n_actors; i++)
+    scene_add_leaf (scene, g_ptr_array_index (groups, i % groups->len), i);
+
+  g_ptr_array_free (groups, TRUE);
+}
+
+/* Places every leaf as a function of the simulated time */
+static void
+scene_update (Scene  *scene,
+              gint64  time_us)
+{
+  gdouble t = time_us / 1000000.0;
+  guint i;
+
+  for (i = 0; i < scene->leaves->len; i++)
+    {
+      ClutterActor *leaf = g_ptr_array_index (scene->leaves, i);
+      gdouble phase = i * 0.1;
+      gfloat x, y;
+
+      x = (STAGE_WIDTH - 40) * (0.5 + 0.5 * sin (t + phase));
+      y = (STAGE_HEIGHT - 40) * (0.5 + 0.5 * cos (t * 0.7 + phase));
+
+      clutter_actor_set_position (leaf, x, y);
+
+      if (scene->params->effects)
+        clutter_actor_set_rotation_angle (leaf, CLUTTER_Z_AXIS,
+                                          fmod (t * 90.0 + i, 360.0));
+    }
+}
+
+static void
+on_stage_painted (ClutterStage *stage,
+                  gpointer      data)
+{
+  Scene *scene = data;
+
+  scene->painted = TRUE;
+}
+
+static void
+scene_run_frame (Scene    *scene,
+                 guint     frame,
+                 gboolean  measure)
+{
+  ClutterFrameStats stats;
+  gint64 values[N_METRICS];
+  guint i;
+
+  scene_update (scene, (gint64) frame * FRAME_INTERVAL);
+  scene->n_allocations = 0;
+
+  /* a deterministic pick per frame, as pointer motion would do */
+  clutter_stage_get_actor_at_pos (CLUTTER_STAGE (scene->stage),
+                                  CLUTTER_PICK_REACTIVE,
+                                  (frame * 7) % STAGE_WIDTH,
+                                  (frame * 13) % STAGE_HEIGHT);
+
+  scene->painted = FALSE;
+  clutter_actor_queue_redraw (scene->stage);
+
+  while (!scene->painted)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* the statistics are stored at the end of the master clock
+   * iteration that painted the stage, which has returned by now
+   */
+  if (!measure ||
+      clutter_stage_get_frame_stats (CLUTTER_STAGE (scene->stage),
+                                     &stats, 1) != 1)
+    return;
+
+  values[METRIC_EVENTS] = stats.event_processing;
+  values[METRIC_RELAYOUT] = stats.relayout;
+  values[METRIC_PAINT] = stats.paint;
+  values[METRIC_PICK] = stats.pick;
+  values[METRIC_SWAP] = stats.swap;
+  values[METRIC_TOTAL] = stats.event_processing
+                       + stats.relayout
+                       + stats.paint
+                       + stats.pick
+                       + stats.swap;
+  values[METRIC_ACTORS_PAINTED] = stats.n_actors_painted;
+  values[METRIC_ACTORS_CULLED] = stats.n_actors_culled;
+  values[METRIC_ALLOCATIONS] = scene->n_allocations;
+  values[METRIC_PICKS] = stats.n_picks;
+
+  for (i = 0; i < N_METRICS; i++)
+    g_array_append_val (scene->samples[i], values[i]);
+}
+
+static gint
+compare_samples (gconstpointer a,
+                 gconstpointer b)
+{
+  gint64 sample_a = *(const gint64 *) a;
+  gint64 sample_b = *(const gint64 *) b;
+
+  return sample_a < sample_b ? -1 : sample_a > sample_b ? 1 : 0;
+}
+
+static gint64
+get_percentile (GArray *sorted,
+                guint   percentile)
+{
+  guint index_;
+
+  if (sorted->len == 0)
+    return 0;
+
+  index_ = (sorted->len - 1) * percentile / 100;
+
+  return g_array_index (sorted, gint64, index_);
+}
+
+static void
+scene_run (const SceneParams *params,
+           JsonBuilder       *builder)
+{
+  Scene scene = { params, };
+  guint i;
+
+  scene.leaves = g_ptr_array_new ();
+  for (i = 0; i < N_METRICS; i++)
+    scene.samples[i] = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  scene.stage = clutter_stage_new ();
+  clutter_actor_set_size (scene.stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_paint_callback (CLUTTER_STAGE (scene.stage),
+                                    on_stage_painted,
+                                    &scene,
+                                    NULL);
+
+  scene_build (&scene);
+
+  clutter_actor_show (scene.stage);
+
+  for (i = 0; i < (guint) n_warmup; i++)
+    scene_run_frame (&scene, i, FALSE);
+
+  for (i = 0; i < (guint) n_frames; i++)
+    scene_run_frame (&scene, n_warmup + i, TRUE);
+
+  json_builder_set_member_name (builder, params->name);
+  json_builder_begin_object (builder);
+
+  for (i = 0; i < N_METRICS; i++)
+    {
+      GArray *samples = scene.samples[i];
+
+      g_array_sort (samples, compare_samples);
+
+      json_builder_set_member_name (builder, metrics[i].name);
+      json_builder_begin_object (builder);
+      json_builder_set_member_name (builder, "median");
+      json_builder_add_int_value (builder, get_percentile (samples, 50));
+      json_builder_set_member_name (builder, "p95");
+      json_builder_add_int_value (builder, get_percentile (samples, 95));
+      json_builder_end_object (builder);
+
+      g_array_free (samples, TRUE);
+    }
+
+  json_builder_end_object (builder);
+
+  clutter_actor_destroy (scene.stage);
+  g_ptr_array_free (scene.leaves, TRUE);
+}
+
+static gboolean
+check_value (const gchar *scene,
+             guint        metric,
+             const gchar *statistic,
+             JsonObject  *baseline,
+             JsonObject  *result)
+{
+  gint64 old_value, new_value, limit;
+
+  if (!json_object_has_member (baseline, statistic) ||
+      !json_object_has_member (result, statistic))
+    return TRUE;
+
+  old_value = json_object_get_int_member (baseline, statistic);
+  new_value = json_object_get_int_member (result, statistic);
+
+  limit = old_value + old_value * threshold / 100.0;
+
+  /* small timings are dominated by noise */
+  if (metrics[metric].is_time)
+    limit = MAX (limit, old_value + NOISE_FLOOR);
+
+  if (new_value <= limit)
+    return TRUE;
+
+  g_printerr ("REGRESSION: %s: %s %s went from %" G_GINT64_FORMAT
+              " to %" G_GINT64_FORMAT "%s\n",
+              scene,
+              metrics[metric].name,
+              statistic,
+              old_value,
+              new_value,
+              metrics[metric].is_time ? " usecs" : "");
+
+  return FALSE;
+}
+
+/* Returns the number of regressions with respect to the baseline */
+static guint
+compare_with_baseline (JsonNode *results)
+{
+  JsonObject *baseline_scenes, *result_scenes;
+  JsonParser *parser;
+  GError *error = NULL;
+  GList *names, *l;
+  guint n_regressions = 0;
+
+  parser = json_parser_new ();
+  if (!json_parser_load_from_file (parser, baseline_file, &error))
+    {
+      g_printerr ("Unable to load the baseline '%s': %s\n",
+                  baseline_file,
+                  error->message);
+      g_error_free (error);
+      g_object_unref (parser);
+      return 1;
+    }
+
+  baseline_scenes =
+    json_object_get_object_member (json_node_get_object (json_parser_get_root (parser)),
+                                   "scenes");
+  result_scenes =
+    json_object_get_object_member (json_node_get_object (results), "scenes");
+
+  names = json_object_get_members (result_scenes);
+  for (l = names; l != NULL; l = l->next)
+    {
+      JsonObject *baseline_scene, *result_scene;
+      guint i;
+
+      if (baseline_scenes == NULL ||
+          !json_object_has_member (baseline_scenes, l->data))
+        continue;
+
+      baseline_scene = json_object_get_object_member (baseline_scenes, l->data);
+      result_scene = json_object_get_object_member (result_scenes, l->data);
+
+      for (i = 0; i < N_METRICS; i++)
+        {
+          JsonObject *old_metric, *new_metric;
+
+          if (!json_object_has_member (baseline_scene, metrics[i].name))
+            continue;
+
+          old_metric = json_object_get_object_member (baseline_scene,
+                                                      metrics[i].name);
+          new_metric = json_object_get_object_member (result_scene,
+                                                      metrics[i].name);
+
+          if (!check_value (l->data, i, "median", old_metric, new_metric))
+            n_regressions += 1;
+
+          if (!check_value (l->data, i, "p95", old_metric, new_metric))
+            n_regressions += 1;
+        }
+    }
+
+  g_list_free (names);
+  g_object_unref (parser);
+
+  return n_regressions;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  JsonBuilder *builder;
+  JsonGenerator *generator;
+  JsonNode *results;
+  GError *error = NULL;
+  gboolean forced_backend;
+  guint i, n_regressions = 0;
+
+  /* render offscreen, as fast as possible */
+  forced_backend = g_getenv ("CLUTTER_BACKEND") == NULL;
+  g_setenv ("CLUTTER_BACKEND", "headless", FALSE);
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("vblank_mode", "0", FALSE);
+
+  if (clutter_init_with_args (&argc, &argv,
+                              "- Clutter performance suite",
+                              entries,
+                              NULL,
+                              &error) != CLUTTER_INIT_SUCCESS)
+    {
+      g_printerr ("Unable to initialize Clutter: %s\n",
+                  error != NULL ? error->message : "unknown error");
+
+      if (forced_backend)
+        g_printerr ("The performance suite uses the headless backend, which "
+                    "must be enabled with --enable-headless-backend; set "
+                    "CLUTTER_BACKEND to run it on another backend\n");
+
+      return EXIT_FAILURE;
+    }
+
+  n_frames = MAX (n_frames, 1);
+  n_warmup = MAX (n_warmup, 0);
+
+  builder = json_builder_new ();
+  json_builder_begin_object (builder);
+
+  json_builder_set_member_name (builder, "frames");
+  json_builder_add_int_value (builder, n_frames);
+  json_builder_set_member_name (builder, "frame-interval");
+  json_builder_add_int_value (builder, FRAME_INTERVAL);
+
+  json_builder_set_member_name (builder, "scenes");
+  json_builder_begin_object (builder);
+
+  for (i = 0; i < G_N_ELEMENTS (scenes); i++)
+    {
+      if (scene_filter != NULL && strstr (scenes[i].name, scene_filter) == NULL)
+        continue;
+
+      scene_run (&scenes[i], builder);
+    }
+
+  json_builder_end_object (builder);
+  json_builder_end_object (builder);
+
+  results = json_builder_get_root (builder);
+
+  generator = json_generator_new ();
+  json_generator_set_pretty (generator, TRUE);
+  json_generator_set_root (generator, results);
+
+  if (output_file != NULL)
+    {
+      if (!json_generator_to_file (generator, output_file, &error))
+        {
+          g_printerr ("Unable to write the results to '%s': %s\n",
+                      output_file,
+                      error->message);
+          g_error_free (error);
+          return EXIT_FAILURE;
+        }
+    }
+  else
+    {
+      gchar *data = json_generator_to_data (generator, NULL);
+
+      g_print ("%s\n", data);
+      g_free (data);
+    }
+
+  if (baseline_file != NULL)
+    n_regressions = compare_with_baseline (results);
+
+  json_node_free (results);
+  g_object_unref (generator);
+  g_object_unref (builder);
+
+  return n_regressions == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}